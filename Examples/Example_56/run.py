@@ -1,5 +1,6 @@
 #!/usr/bin/env python
 
+import csv
 import glob
 import os
 import sys
@@ -18,5 +19,32 @@ print("samples2 =", samples2)
 
 oreex.run("Input/ore.xml")
 
+oreex.print_headline("Run ORE to produce AMC CG bump and revalue sensitivities")
+os.makedirs(os.path.join("Output", "bump"), exist_ok=True)
+oreex.run("Input/ore_bump.xml")
+
 os.environ["OVERWRITE_SCENARIOGENERATOR_SAMPLES"]=samples1
 
+# Finite difference check of the AAD xva sensitivities: the credit curve and recovery rate shifts do not change the
+# exposures, the CVA / DVA are linear in the default probabilities and LGDs, so AAD and bump must agree. The other
+# factors differ by the effects listed in the Readme, we only print the largest difference for them.
+
+def read_sensis(subdir):
+    with open(os.path.join("Output", subdir, "xvacg-cva-sensi-scenario.csv")) as f:
+        rows = list(csv.reader(f))
+    return {(r[0], r[1], r[2]): float(r[7]) for r in rows[1:]}
+
+if not oreex.dry:
+    aad, bump = read_sensis(""), read_sensis("bump")
+    if aad.keys() != bump.keys():
+        raise Exception("AAD and bump sensitivity reports have different rows")
+    maxOtherDiff = 0.0
+    for key in sorted(aad.keys()):
+        diff = abs(aad[key] - bump[key])
+        if key[1].startswith("SurvivalProbability/") or key[1].startswith("RecoveryRate/"):
+            if diff > 0.02:
+                raise Exception("AAD and bump sensitivity differ for " + ",".join(key) + ": " + str(aad[key]) +
+                                " vs " + str(bump[key]))
+        else:
+            maxOtherDiff = max(maxOtherDiff, diff)
+    print("AAD and bump credit sensitivities agree, max difference for other factors is", maxOtherDiff)
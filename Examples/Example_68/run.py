@@ -2,6 +2,7 @@
 
 import sys
 import os
+import csv
 sys.path.append('../')
 from ore_examples_helper import OreExample
 
@@ -18,5 +19,33 @@ oreex.print_headline("Run ORE to produce XVA Stresstest with AMC")
 oreex.run("Input/ore_amc.xml")
 #oreex.get_times("Output/log.txt")
 
+# The credit curve shifts do not touch the exposure simulation market, with reuseSimulation the XVA sensitivity
+# analytic post-processes the base cube for them. Check that this yields the same XVA as a full simulation.
+
+oreex.print_headline("Run ORE to produce XVA Sensitivities with and without reusing the base simulation")
+for subdir in ["reuse", "fullsim"]:
+    os.makedirs(os.path.join("Output", subdir), exist_ok=True)
+oreex.run("Input/ore_reuse.xml")
+oreex.run("Input/ore_fullsim.xml")
+
+def read_rows(subdir):
+    with open(os.path.join("Output", subdir, "xva.csv")) as f:
+        return list(csv.reader(f))
+
+if not oreex.dry:
+    reuse, fullsim = read_rows("reuse"), read_rows("fullsim")
+    if len(reuse) != len(fullsim):
+        raise Exception("xva.csv differs in the number of rows: " + str(len(reuse)) + " vs " + str(len(fullsim)))
+    for r, f in zip(reuse, fullsim):
+        for a, b in zip(r, f):
+            try:
+                equal = abs(float(a) - float(b)) <= 1E-6 * max(1.0, abs(float(b)))
+            except ValueError:
+                equal = a == b
+            if not equal:
+                raise Exception("xva.csv differs between reuse and full simulation:\n" + ",".join(r) + "\n" +
+                                ",".join(f))
+    print("XVA sensitivities with and without reusing the base simulation agree")
+
 if "OVERWRITE_SCENARIOGENERATOR_SAMPLES" in os.environ.keys():
     os.environ["OVERWRITE_SCENARIOGENERATOR_SAMPLES"]=samples1
\ No newline at end of file
@@ -32,6 +32,9 @@
 #include <ql/math/distributions/normaldistribution.hpp>
 #include <ql/time/daycounters/actualactual.hpp>
 
+#include <atomic>
+#include <future>
+
 using namespace QuantLib;
 using namespace QuantExt;
 
@@ -55,21 +58,19 @@ CreditMigrationHelper::CreditMigrationHelper(const QuantLib::ext::shared_ptr<Cre
       bucketing_(distributionLowerBound, distributionUpperBound, buckets) {
 
     rescaledTransitionMatrices_.resize(cube_->numDates());
+    transitionThresholds_.resize(cube_->numDates());
     init();
-    if (evaluation_ == Evaluation::TerminalSimulation)
-        initEntityStateSimulation();
 } // CreditMigrationHelper()
 
 namespace {
 
-Real conditionalProb(const Real p, const Real m, const Real v) {
+// conditional probability given the normal inverse icnP of the unconditional probability p
+Real conditionalProb(const Real p, const Real icnP, const Real m, const Real v) {
     QuantLib::CumulativeNormalDistribution nd;
-    QuantLib::InverseCumulativeNormal icn;
     if (close_enough(p, 0.0))
         return 0.0;
     if (close_enough(p, 1.0))
         return 1.0;
-    Real icnP = icn(p);
     if (close_enough(v, 1.0))
         return icnP >= m ? 1.0 : 0.0;
     return nd((icnP - m) / std::sqrt(1.0 - v));
@@ -82,68 +83,121 @@ Real prob_tauA_lt_tauB_lt_T(const Real pa, const Real pb, const Real T) {
     return res;
 }
 
+// run job(i) for i = 0, ..., n - 1 on nThreads threads, exceptions from the jobs are rethrown
+template <class Job> void runParallel(const Size n, const Size nThreads, const Job& job) {
+    if (nThreads <= 1 || n <= 1) {
+        for (Size i = 0; i < n; ++i)
+            job(i);
+        return;
+    }
+    std::atomic<Size> next(0);
+    std::vector<std::future<void>> results;
+    for (Size t = 0; t < std::min(n, nThreads); ++t) {
+        results.push_back(std::async(std::launch::async, [&next, n, &job]() {
+            for (Size i = next++; i < n; i = next++)
+                job(i);
+        }));
+    }
+    for (auto& r : results)
+        r.wait();
+    for (auto& r : results)
+        r.get();
+}
+
 } // anonymous namespace
 
-std::map<string, Matrix> CreditMigrationHelper::rescaledTransitionMatrices(const Size date) {
+const std::map<string, Matrix>& CreditMigrationHelper::rescaledTransitionMatrices(const Size date) {
 
-    std::map<string, Matrix> transMat; // rescaled transition matrix per (matrix) name
+    QL_REQUIRE(date < cube_->numDates(),
+               "date index " << date << " outside range, cube has " << cube_->numDates() << " dates.");
 
     // have we computed the result for the date index already?
-    if (!rescaledTransitionMatrices_[date].empty()) {
-        transMat = rescaledTransitionMatrices_[date];
-    } else {
-        Time t = cubeTimes_[date];
+    std::map<string, Matrix>& transMat = rescaledTransitionMatrices_[date]; // rescaled transition matrix per name
+    if (!transMat.empty())
+        return transMat;
+
+    Time t = cubeTimes_[date];
 
-        const std::vector<string>& entities = parameters_->entities();
-        const std::vector<string>& matrixNames = parameters_->transitionMatrices();
+    const std::vector<string>& entities = parameters_->entities();
+    const std::vector<string>& matrixNames = parameters_->transitionMatrices();
 
-        for (Size i = 0; i < entities.size(); ++i) {
-            if (transMat.count(matrixNames[i]) > 0) {
-                DLOG("Transition matrix for " << entities[i] << " (" << matrixNames[i] << ") cached, nothing to do.");
+    for (Size i = 0; i < entities.size(); ++i) {
+        if (transMat.count(matrixNames[i]) > 0) {
+            DLOG("Transition matrix for " << entities[i] << " (" << matrixNames[i] << ") cached, nothing to do.");
+        } else {
+            QL_REQUIRE(parameters_->transitionMatrix().count(parameters_->transitionMatrices()[i]) > 0,
+                       "No transition matrix defined for " << parameters_->entities()[i] << " / "
+                                                           << parameters_->transitionMatrices()[i]);
+            Matrix m = parameters_->transitionMatrix().at(parameters_->transitionMatrices()[i]);
+            DLOG("Transition matrix (1y) for " << parameters_->entities()[i] << " is "
+                                               << parameters_->transitionMatrices()[i] << ":");
+            DLOGGERSTREAM(m);
+            if (n_ == Null<Size>()) {
+                n_ = m.rows();
             } else {
-                QL_REQUIRE(parameters_->transitionMatrix().count(parameters_->transitionMatrices()[i]) > 0,
-                           "No transition matrix defined for " << parameters_->entities()[i] << " / "
-                                                               << parameters_->transitionMatrices()[i]);
-                Matrix m = parameters_->transitionMatrix().at(parameters_->transitionMatrices()[i]);
-                DLOG("Transition matrix (1y) for " << parameters_->entities()[i] << " is "
-                                                   << parameters_->transitionMatrices()[i] << ":");
-                DLOGGERSTREAM(m);
-                if (n_ == Null<Size>()) {
-                    n_ = m.rows();
-                } else {
-                    QL_REQUIRE(m.rows() == n_, "Found transition matrix with different dimension "
-                                                   << m.rows() << "x" << m.columns() << " expected " << n_ << "x" << n_
-                                                   << " for " << parameters_->entities()[i] << " / "
-                                                   << parameters_->transitionMatrices()[i]);
-                }
-                QL_REQUIRE(date < cube_->numDates(),
-                           "date index " << date << " outside range, cube has " << cube_->numDates() << " dates.");
-                sanitiseTransitionMatrix(m);
-                DLOG("Sanitised transition matrix:");
-                DLOGGERSTREAM(m);
-                Matrix g = QuantExt::generator(m);
-                DLOG("Generator matrix:")
-                DLOGGERSTREAM(g);
-                checkGeneratorMatrix(g);
-                Matrix mt = QuantExt::Expm(t * g);
-                DLOG("Scaled transition matrix (t=" << t << "):");
-                DLOGGERSTREAM(mt);
-                checkTransitionMatrix(mt);
-                Matrix mcheck = m;
-                for (Size c = 1; c < static_cast<Size>(std::round(t)); ++c) {
-                    mcheck = mcheck * m;
-                }
-                DLOG("Elementary transition matrix (t=" << std::round(t) << ", just for plausibility):");
-                DLOGGERSTREAM(mcheck);
-                transMat[matrixNames[i]] = mt;
+                QL_REQUIRE(m.rows() == n_, "Found transition matrix with different dimension "
+                                               << m.rows() << "x" << m.columns() << " expected " << n_ << "x" << n_
+                                               << " for " << parameters_->entities()[i] << " / "
+                                               << parameters_->transitionMatrices()[i]);
             }
+            sanitiseTransitionMatrix(m);
+            DLOG("Sanitised transition matrix:");
+            DLOGGERSTREAM(m);
+            Matrix g = QuantExt::generator(m);
+            DLOG("Generator matrix:")
+            DLOGGERSTREAM(g);
+            checkGeneratorMatrix(g);
+            Matrix mt = QuantExt::Expm(t * g);
+            DLOG("Scaled transition matrix (t=" << t << "):");
+            DLOGGERSTREAM(mt);
+            checkTransitionMatrix(mt);
+            Matrix mcheck = m;
+            for (Size c = 1; c < static_cast<Size>(std::round(t)); ++c) {
+                mcheck = mcheck * m;
+            }
+            DLOG("Elementary transition matrix (t=" << std::round(t) << ", just for plausibility):");
+            DLOGGERSTREAM(mcheck);
+            transMat[matrixNames[i]] = mt;
         }
-        rescaledTransitionMatrices_[date] = transMat;
     }
 
     return transMat;
 } // rescaledTransitionMatrices
 
+const std::vector<CreditMigrationHelper::TransitionThresholds>&
+CreditMigrationHelper::transitionThresholds(const Size date) {
+
+    std::vector<TransitionThresholds>& res = transitionThresholds_[date];
+    if (!res.empty())
+        return res;
+
+    const std::map<string, Matrix>& transMat = rescaledTransitionMatrices(date);
+    const std::vector<string>& matrixNames = parameters_->transitionMatrices();
+
+    // compute the thresholds once per matrix name and copy them to the entities using the matrix
+    QuantLib::InverseCumulativeNormal icn;
+    std::map<string, TransitionThresholds> byName;
+    for (auto const& [name, m] : transMat) {
+        TransitionThresholds th{Matrix(m.rows(), m.columns(), 0.0), Matrix(m.rows(), m.columns(), 0.0)};
+        for (Size ii = 0; ii < m.rows(); ++ii) {
+            Real p = 0.0;
+            for (Size jj = 0; jj < m.columns(); ++jj) {
+                p += m[ii][jj];
+                th.cumulativeProb[ii][jj] = p;
+                // the inverse is not used if p is close to 0 or 1, see conditionalProb()
+                if (!close_enough(p, 0.0) && !close_enough(p, 1.0))
+                    th.inverseCumulativeProb[ii][jj] = icn(p);
+            }
+        }
+        byName[name] = th;
+    }
+
+    for (Size i = 0; i < matrixNames.size(); ++i)
+        res.push_back(byName.at(matrixNames[i]));
+
+    return res;
+} // transitionThresholds
+
 void CreditMigrationHelper::init() {
 
     LOG("CreditMigrationHelper Init");
@@ -197,32 +251,19 @@ void CreditMigrationHelper::init() {
 
 } // init
 
-void CreditMigrationHelper::initEntityStateSimulation() {
-
-    LOG("Init entity state simulation");
-
-    simulatedEntityState_ =
-        std::vector<std::vector<Size>>(parameters_->entities().size(), std::vector<Size>(cube_->samples()));
-
-    LOG("Init entity state simulation done.");
-
-} // initEntityStatesSimulation
-
-std::vector<Matrix> CreditMigrationHelper::initEntityStateSimulation(const Size date, const Size path) {
+std::vector<Matrix> CreditMigrationHelper::initEntityStateSimulation(const Size date, const Size path,
+                                                                     const std::vector<TransitionThresholds>& th) const {
     std::vector<Matrix> res = std::vector<Matrix>(parameters_->entities().size(), Matrix(n_, n_, 0.0));
 
-    const std::vector<string>& matrixNames = parameters_->transitionMatrices();
-
     // build terminal matrices conditional on global states
     Size numWarnings = 0;
-    auto transMat = rescaledTransitionMatrices(date);
     for (Size i = 0; i < parameters_->entities().size(); ++i) {
-        const Matrix& m = transMat.at(matrixNames[i]);
-        for (Size ii = 0; ii < m.rows(); ++ii) {
-            Real p = 0.0, condProb0 = 0.0;
-            for (Size jj = 0; jj < m.columns(); ++jj) {
-                p += m[ii][jj];
-                Real condProb = conditionalProb(p, globalStates_[date][i][path], globalVar_[i]);
+        const Matrix& p = th[i].cumulativeProb;
+        const Matrix& icnP = th[i].inverseCumulativeProb;
+        for (Size ii = 0; ii < p.rows(); ++ii) {
+            Real condProb0 = 0.0;
+            for (Size jj = 0; jj < p.columns(); ++jj) {
+                Real condProb = conditionalProb(p[ii][jj], icnP[ii][jj], globalStates_[date][i][path], globalVar_[i]);
                 res[i][ii][jj] = condProb - condProb0;
                 condProb0 = condProb;
             }
@@ -253,98 +294,106 @@ std::vector<Matrix> CreditMigrationHelper::initEntityStateSimulation(const Size
     return res;
 }
 
-void CreditMigrationHelper::simulateEntityStates(const std::vector<Matrix>& cond, const Size path,
-                                                 const MersenneTwisterUniformRng& mt) {
+void CreditMigrationHelper::simulateEntityStates(const std::vector<Matrix>& cond, const MersenneTwisterUniformRng& mt,
+                                                 std::vector<Size>& states) const {
 
     QL_REQUIRE(evaluation_ != Evaluation::Analytic,
                "CreditMigrationHelper::simulateEntityStates() unexpected call, not in simulation mode");
 
     for (Size i = 0; i < parameters_->entities().size(); ++i) {
         Size initialState = parameters_->initialStates()[i];
-            Real tmp = mt.next().value;
-            Size entityState =
-                std::lower_bound(cond[i].row_begin(initialState), cond[i].row_end(initialState), tmp) -
-                cond[i].row_begin(initialState);
-            entityState = std::min(entityState, cond[i].columns() - 1); // play safe
-            simulatedEntityState_[i][path] = entityState;
-            initialState = entityState;
+        Real tmp = mt.next().value;
+        Size entityState = std::lower_bound(cond[i].row_begin(initialState), cond[i].row_end(initialState), tmp) -
+                           cond[i].row_begin(initialState);
+        entityState = std::min(entityState, cond[i].columns() - 1); // play safe
+        states[i] = entityState;
     }
 
 } // simulateEntityStates
 
-Size CreditMigrationHelper::simulatedEntityState(const Size i, const Size path) const {
-    QL_REQUIRE(evaluation_ != Evaluation::Analytic,
-               "CreditMigrationHelper::simulatedEntityState() unexpected call, not in simulation mode");
-    return simulatedEntityState_[i][path];
-} // simulatedEntityState
-
-Real CreditMigrationHelper::generateMigrationPnl(const Size date, const Size path, const Size n) const {
+void CreditMigrationHelper::migrationPnlAddends(const Size date, const Size path,
+                                                std::vector<std::vector<std::vector<Real>>>& addends) const {
 
     QL_REQUIRE(!parameters_->doubleDefault(),
                "CreditMigrationHelper::generateMigrationPnl() does not support double default");
 
     const std::vector<string>& entities = parameters_->entities();
-    Real pnl = 0.0;
+    addends.resize(entities.size());
 
     for (Size i = 0; i < entities.size(); ++i) {
-        // compute credit state of entitiy
-        // issuer migration risk
-        Size simEntityState = simulatedEntityState(i, path);
-        for (auto const& tradeId : issuerTradeIds_[i]) {
-            try {
-                Size tid = cube_->idsAndIndexes().at(tradeId);
-                Real baseValue = cube_->get(tid, date, path, 0);
-                Real stateValue = cube_->get(tid, date, path, cubeIndexStateNpvs_ + simEntityState);
-                if (loanExposureMode_ == LoanExposureMode::Notional) {
-                    if (tradeNotionals_.find(tradeId) != tradeNotionals_.end()) {
-                        // this is a bond
-                        string tradeCcy = tradeCurrencies_.at(tradeId);
-                        string ccypair = tradeCcy + baseCurrency_;
-                        Real fx = 1.0;
-                        if (tradeCcy != baseCurrency_) {
-                            QL_REQUIRE(aggData_->has(AggregationScenarioDataType::FXSpot, ccypair),
-                                       "FX spot data not found in aggregation data for currency pair " << ccypair);
-                            fx = aggData_->get(date, path, AggregationScenarioDataType::FXSpot, ccypair);
+        addends[i].assign(n_, std::vector<Real>());
+        for (Size simEntityState = 0; simEntityState < n_; ++simEntityState) {
+            std::vector<Real>& a = addends[i][simEntityState];
+            // issuer migration risk
+            for (auto const& tradeId : issuerTradeIds_[i]) {
+                try {
+                    Size tid = cube_->idsAndIndexes().at(tradeId);
+                    Real baseValue = cube_->get(tid, date, path, 0);
+                    Real stateValue = cube_->get(tid, date, path, cubeIndexStateNpvs_ + simEntityState);
+                    if (loanExposureMode_ == LoanExposureMode::Notional) {
+                        if (tradeNotionals_.find(tradeId) != tradeNotionals_.end()) {
+                            // this is a bond
+                            string tradeCcy = tradeCurrencies_.at(tradeId);
+                            string ccypair = tradeCcy + baseCurrency_;
+                            Real fx = 1.0;
+                            if (tradeCcy != baseCurrency_) {
+                                QL_REQUIRE(aggData_->has(AggregationScenarioDataType::FXSpot, ccypair),
+                                           "FX spot data not found in aggregation data for currency pair "
+                                               << ccypair);
+                                fx = aggData_->get(date, path, AggregationScenarioDataType::FXSpot, ccypair);
+                            }
+                            // FIXME: We actually need the correct current notional as of the future horizon date,
+                            // but we have the current notional as of today
+                            baseValue = tradeNotionals_.at(tradeId) * fx;
+                            // FIXME: get the bond's recovery rate
+                            Real rr = 0.0;
+                            stateValue = simEntityState == n_ - 1 ? rr * baseValue : baseValue;
+                        }
+                        if (tradeCdsCptyIdx_.find(tradeId) != tradeCdsCptyIdx_.end()) {
+                            // this is a cds
+                            baseValue = 0.0;
+                            if (simEntityState < n_ - 1)
+                                stateValue = 0.0;
+                            else
+                                stateValue *= aggData_->get(date, path, AggregationScenarioDataType::Numeraire);
                         }
-                        // FIXME: We actually need the correct current notional as of the future horizon date,
-                        // but we have the current notional as of today
-                        baseValue = tradeNotionals_.at(tradeId) * fx;
-                        // FIXME: get the bond's recovery rate
-                        Real rr = 0.0;
-                        stateValue = simEntityState == n - 1 ? rr * baseValue : baseValue;
                     }
-                    if (tradeCdsCptyIdx_.find(tradeId) != tradeCdsCptyIdx_.end()) {
-                        // this is a cds
-                        baseValue = 0.0;
-                        if (simEntityState < n - 1)
-                            stateValue = 0.0;
-                        else
-                            stateValue *= aggData_->get(date, path, AggregationScenarioDataType::Numeraire);
+                    if (creditMode_ == CreditMode::Default && simEntityState < n_ - 1) {
+                        stateValue = baseValue;
                     }
+                    a.push_back(stateValue - baseValue);
+                } catch (const std::exception& e) {
+                    ALOG("can not get state npv for trade " << tradeId << " (reason:" << e.what() << "), state "
+                                                            << simEntityState
+                                                            << ", assume zero credit migration pnl");
                 }
-                if (creditMode_ == CreditMode::Default && simEntityState < n - 1) {
-                    stateValue = baseValue;
-                }
-                pnl += stateValue - baseValue;
-            } catch (const std::exception& e) {
-                ALOG("can not get state npv for trade " << tradeId << " (reason:" << e.what() << "), state "
-                                                        << simEntityState << ", assume zero credit migration pnl");
+            }
+            // default risk for derivative exposure
+            // TODO, assuming a zero recovery here...
+            for (auto const& nettingSetId : cptyNettingSetIds_[i]) {
+                Size nid = nettedCube_->idsAndIndexes().at(nettingSetId);
+                QL_REQUIRE(nettedCube_, "empty netted cube");
+                if (simEntityState == n_ - 1)
+                    a.push_back(-std::max(nettedCube_->get(nid, date, path), 0.0));
             }
         }
-        // default risk for derivative exposure
-        // TODO, assuming a zero recovery here...
-        for (auto const& nettingSetId : cptyNettingSetIds_[i]) {
-            Size nid = nettedCube_->idsAndIndexes().at(nettingSetId);
-            QL_REQUIRE(nettedCube_, "empty netted cube");
-            if (simEntityState == n - 1)
-                pnl -= std::max(nettedCube_->get(nid, date, path), 0.0);
-        }
+    }
+} // migrationPnlAddends
+
+Real CreditMigrationHelper::generateMigrationPnl(const std::vector<std::vector<std::vector<Real>>>& addends,
+                                                 const std::vector<Size>& states) const {
+    // sum up in the same order as the addends were generated
+    Real pnl = 0.0;
+    for (Size i = 0; i < addends.size(); ++i) {
+        for (auto const& a : addends[i][states[i]])
+            pnl += a;
     }
     return pnl;
 } // generateMigrationPnl
 
 void CreditMigrationHelper::generateConditionalMigrationPnl(const Size date, const Size path,
                                                             const std::map<string, Matrix>& transMat,
+                                                            const std::vector<TransitionThresholds>& th,
                                                             std::vector<Array>& condProbs,
                                                             std::vector<Array>& pnl) const {
 
@@ -356,11 +405,11 @@ void CreditMigrationHelper::generateConditionalMigrationPnl(const Size date, con
     for (Size i = 0; i < entities.size(); ++i) {
         // compute conditional migration prob
         Size initialState = parameters_->initialStates()[i];
-        Real p = 0.0, condProb0 = 0.0;
-        const Matrix& m = transMat.at(matrixNames[i]);
+        Real condProb0 = 0.0;
         for (Size j = 0; j < n_; ++j) {
-            p += m[initialState][j];
-            Real condProb = conditionalProb(p, globalStates_[date][i][path], globalVar_[i]);
+            Real condProb =
+                conditionalProb(th[i].cumulativeProb[initialState][j], th[i].inverseCumulativeProb[initialState][j],
+                                globalStates_[date][i][path], globalVar_[i]);
             condProbs[i][j] = condProb - condProb0;
             condProb0 = condProb;
         }
@@ -444,6 +493,49 @@ void CreditMigrationHelper::generateConditionalMigrationPnl(const Size date, con
     }
 } // generateConditionalMigrationPnl
 
+Real CreditMigrationHelper::marketPnl(const Size date, const Size path) const {
+
+    const std::set<std::string>& tradeIds = cube_->ids();
+    Real cash = 0.0;
+
+    for (Size j = 0; j <= date + 1; ++j) {
+        for (auto const& tradeId : tradeIds) {
+            Size i = cube_->idsAndIndexes().at(tradeId);
+            // get cumulative survival probability on the path
+            Real sp = 1.0;
+            //Real rr = 0.0;
+            // FIXME 1
+            // Methodology question: Do we need/want to multiply with the stochastic discount factor
+            // here if we do an explicit credit default simulation at horizon?
+            // FIXME 2
+            // make CDS PnL neutral bei weighting flows with surv prob and generating protection flow
+            // with default prob
+            if (parameters_->zeroMarketPnl() && j > 0 &&
+                tradeCreditCurves_.find(tradeId) != tradeCreditCurves_.end()) {
+                string creditCurve = tradeCreditCurves_.at(tradeId);
+                sp = aggData_->get(j - 1, path, AggregationScenarioDataType::SurvivalWeight, creditCurve);
+                //rr = aggData_->get(j - 1, path, AggregationScenarioDataType::RecoveryRate, creditCurve);
+            }
+            if (j == 0) {
+                // at t0 we flip the sign of the npvs to get the initial cash balance
+                cash -= cube_->getT0(i, 0);
+                // collect intermediate cashflows
+                if (cubeIndexCashflows_ != Null<Size>())
+                    cash += cube_->getT0(i, cubeIndexCashflows_);
+            } else if (j <= date) {
+                // collect intermediate cashflows
+                if (cubeIndexCashflows_ != Null<Size>())
+                    cash += sp * cube_->get(i, j - 1, path, cubeIndexCashflows_);
+            } else {
+                // at the horizon date we realise the npv
+                cash += sp * cube_->get(i, j - 1, path, 0);
+            }
+        }
+    } // for data
+
+    return cash;
+} // marketPnl
+
 Array CreditMigrationHelper::pnlDistribution(const Size date) {
 
     // FIXME if we ask this method for more than one time step, it might be more efficient to
@@ -454,19 +546,18 @@ Array CreditMigrationHelper::pnlDistribution(const Size date) {
     QL_REQUIRE(date < cube_->numDates(), "date index " << date << " out of range 0..." << cube_->numDates() - 1);
     const std::vector<string>& entities = parameters_->entities();
 
-    // 1 get transition matrices for entities and rescale them to horizon
-
-    std::map<string, Matrix> transMat; // rescaled transition matrix per (matrix) name
+    // 1 get transition matrices for entities rescaled to the horizon and the derived thresholds, both are cached
+    //   by date, so that they are computed once and can be shared read-only between the threads below
 
-    // 1 get transition matrices for time step and compute variance of global factors for each entiity
-
-    if (parameters_->creditRisk()) {
-        transMat = rescaledTransitionMatrices(date);
-    }
+    static const std::map<string, Matrix> noTransMat;
+    static const std::vector<TransitionThresholds> noThresholds;
+    const std::map<string, Matrix>& transMat =
+        parameters_->creditRisk() ? rescaledTransitionMatrices(date) : noTransMat;
+    const std::vector<TransitionThresholds>& th =
+        parameters_->creditRisk() ? transitionThresholds(date) : noThresholds;
 
     // 2 compute conditional pnl distributions and average over paths
 
-    const std::set<std::string>& tradeIds = cube_->ids();
     Array res(bucketing_.buckets(), 0.0);
 
     Size numPaths = cube_->samples();
@@ -476,74 +567,43 @@ Array CreditMigrationHelper::pnlDistribution(const Size date) {
 
     MersenneTwisterUniformRng mt(parameters_->seed());
 
-    for (Size path = 0; path < numPaths; ++path) {
-
-        // 2a market pnl (t0 to horizon date, over whole cube)
-
-        Real cash = 0.0;
-
-        if (parameters_->marketRisk()) {
-            for (Size j = 0; j <= date + 1; ++j) {
-                for (auto const& tradeId : tradeIds) {
-                    Size i = cube_->idsAndIndexes().at(tradeId);
-                    // get cumulative survival probability on the path
-                    Real sp = 1.0;
-                    //Real rr = 0.0;
-                    // FIXME 1
-                    // Methodology question: Do we need/want to multiply with the stochastic discount factor
-                    // here if we do an explicit credit default simulation at horizon?
-                    // FIXME 2
-                    // make CDS PnL neutral bei weighting flows with surv prob and generating protection flow
-                    // with default prob
-                    if (parameters_->zeroMarketPnl() && j > 0 &&
-                        tradeCreditCurves_.find(tradeId) != tradeCreditCurves_.end()) {
-                        string creditCurve = tradeCreditCurves_.at(tradeId);
-                        sp = aggData_->get(j - 1, path, AggregationScenarioDataType::SurvivalWeight, creditCurve);
-                        //rr = aggData_->get(j - 1, path, AggregationScenarioDataType::RecoveryRate, creditCurve);
-                    }
-                    if (j == 0) {
-                        // at t0 we flip the sign of the npvs to get the initial cash balance
-                        cash -= cube_->getT0(i, 0);
-                        // collect intermediate cashflows
-                        if (cubeIndexCashflows_ != Null<Size>())
-                            cash += cube_->getT0(i, cubeIndexCashflows_);
-                    } else if (j <= date) {
-                        // collect intermediate cashflows
-                        if (cubeIndexCashflows_ != Null<Size>())
-                            cash += sp * cube_->get(i, j - 1, path, cubeIndexCashflows_);
-                    } else {
-                        // at the horizon date we realise the npv
-                        cash += sp * cube_->get(i, j - 1, path, 0);
-                    }
-                }
-            } // for data
-        }     // if market risk
-
-        if (!parameters_->creditRisk()) {
-            // if we just add scalar market pnl realisations, we don't really need
-            // the bucketing algorithm to do that, we just update the result
-            // distribution directly
-            res[hwBucketing.index(cash)] += 1.0 / static_cast<Real>(numPaths);
-            continue;
-        }
+    /* The paths are processed in chunks. Within a chunk everything that does not depend on the inner path RNG is
+       computed in parallel, then the results are aggregated sequentially in path order. The inner path simulation
+       draws from a single RNG and is therefore done in the sequential part. The result is identical to a
+       sequential run. */
+
+    Size nThreads = std::max<Size>(parameters_->threads(), 1);
+    Size chunkSize = 64 * nThreads;
+    std::vector<PathData> pathData;
+    std::vector<Size> states(entities.size());
+
+    for (Size chunkStart = 0; chunkStart < numPaths; chunkStart += chunkSize) {
 
-        // 2b credit migration pnl (at horizon date, over entities specified in credit simulation parameters)
-
-        std::vector<Array> condProbs, pnl;
-
-        if (evaluation_ != Evaluation::Analytic) {
-            // 2b-1 generate pnl on the path using simulated idiosyncratic factors
-            condProbs.resize(1, Array(parameters_->paths(), 1.0 / static_cast<Real>(parameters_->paths())));
-            // we could build the distribution more efficiently here, but later in 2c we add the market pnl
-            // maybe extend the hw bucketing so that we can feed precomputed distributions and just update
-            // these with additional data?
-            pnl.resize(1, Array(parameters_->paths(), 0.0));
-            auto cond = initEntityStateSimulation(date, path);
-            for (Size path2 = 0; path2 < parameters_->paths(); ++path2) {
-                simulateEntityStates(cond, path, mt);
-                pnl[0][path2] = generateMigrationPnl(date, path, n_);
+        Size chunkEnd = std::min(chunkStart + chunkSize, numPaths);
+        pathData.assign(chunkEnd - chunkStart, PathData());
+
+        runParallel(chunkEnd - chunkStart, nThreads, [this, chunkStart, date, &pathData, &transMat, &th,
+                                                       &entities](const Size p) {
+            Size path = chunkStart + p;
+            PathData& d = pathData[p];
+
+            // 2a market pnl (t0 to horizon date, over whole cube)
+
+            d.cash = parameters_->marketRisk() ? marketPnl(date, path) : 0.0;
+
+            if (!parameters_->creditRisk())
+                return;
+
+            // 2b credit migration pnl (at horizon date, over entities specified in credit simulation parameters)
+
+            if (evaluation_ != Evaluation::Analytic) {
+                // 2b-1 conditional transition matrices and pnl by entity state on the path, the simulation of the
+                // idiosyncratic factors is done below
+                d.cond = initEntityStateSimulation(date, path, th);
+                migrationPnlAddends(date, path, d.addends);
+                return;
             }
-        } else {
+
             // 2b-2 generate pnl distribution without simulation of idiosyncratic factors using the conditional
             // independence of migration on the path / systemic factors
 
@@ -556,26 +616,64 @@ Array CreditMigrationHelper::pnlDistribution(const Size date) {
             // in total, we only have to distinguish i)+ii) and iii), i.e. we need one
             // additional state
 
-            condProbs.resize(entities.size(), Array(n_ + 1, 0.0));
-            pnl.resize(entities.size(), Array(n_ + 1, 0.0));
-            generateConditionalMigrationPnl(date, path, transMat, condProbs, pnl);
-        }
+            std::vector<Array> condProbs(entities.size(), Array(n_ + 1, 0.0));
+            std::vector<Array> pnl(entities.size(), Array(n_ + 1, 0.0));
+            generateConditionalMigrationPnl(date, path, transMat, th, condProbs, pnl);
 
-        // 2c aggregate market pnl and credit migration pnl
+            // 2c aggregate market pnl and credit migration pnl
 
-        if (parameters_->marketRisk()) {
-            condProbs.push_back(Array(1, 1.0));
-            pnl.push_back(Array(1, cash));
-        }
+            if (parameters_->marketRisk()) {
+                condProbs.push_back(Array(1, 1.0));
+                pnl.push_back(Array(1, d.cash));
+            }
 
-        hwBucketing.computeMultiState(condProbs.begin(), condProbs.end(), pnl.begin());
+            HullWhiteBucketing hw(bucketing_.upperBucketBound().begin(), bucketing_.upperBucketBound().end());
+            hw.computeMultiState(condProbs.begin(), condProbs.end(), pnl.begin());
+            d.probability = hw.probability();
+        });
 
-        // 2d add pnl contribution of path to result distribution
-        res += hwBucketing.probability() / static_cast<Real>(numPaths);
-        // average market risk pnl
-        avgCash += cash / static_cast<Real>(numPaths);
+        for (Size path = chunkStart; path < chunkEnd; ++path) {
+            PathData& d = pathData[path - chunkStart];
+
+            if (!parameters_->creditRisk()) {
+                // if we just add scalar market pnl realisations, we don't really need
+                // the bucketing algorithm to do that, we just update the result
+                // distribution directly
+                res[hwBucketing.index(d.cash)] += 1.0 / static_cast<Real>(numPaths);
+                continue;
+            }
+
+            if (evaluation_ != Evaluation::Analytic) {
+                // 2b-1 generate pnl on the path using simulated idiosyncratic factors
+                std::vector<Array> condProbs(
+                    1, Array(parameters_->paths(), 1.0 / static_cast<Real>(parameters_->paths())));
+                // we could build the distribution more efficiently here, but later in 2c we add the market pnl
+                // maybe extend the hw bucketing so that we can feed precomputed distributions and just update
+                // these with additional data?
+                std::vector<Array> pnl(1, Array(parameters_->paths(), 0.0));
+                for (Size path2 = 0; path2 < parameters_->paths(); ++path2) {
+                    simulateEntityStates(d.cond, mt, states);
+                    pnl[0][path2] = generateMigrationPnl(d.addends, states);
+                }
+
+                // 2c aggregate market pnl and credit migration pnl
+
+                if (parameters_->marketRisk()) {
+                    condProbs.push_back(Array(1, 1.0));
+                    pnl.push_back(Array(1, d.cash));
+                }
+
+                hwBucketing.computeMultiState(condProbs.begin(), condProbs.end(), pnl.begin());
+                d.probability = hwBucketing.probability();
+            }
+
+            // 2d add pnl contribution of path to result distribution
+            res += d.probability / static_cast<Real>(numPaths);
+            // average market risk pnl
+            avgCash += d.cash / static_cast<Real>(numPaths);
+        }
 
-    } // for path
+    } // for chunk
 
     DLOG("Expected Market Risk PnL at date " << date << ": " << avgCash);
     return res;
@@ -69,11 +69,29 @@ public:
     Array pnlDistribution(const Size date);
 
 private:
+    //! Cumulative transition probabilities by row and their normal inverse
+    struct TransitionThresholds {
+        Matrix cumulativeProb;
+        Matrix inverseCumulativeProb;
+    };
+
+    //! Per path data prepared in parallel and aggregated sequentially in pnlDistribution()
+    struct PathData {
+        Real cash = 0.0;
+        Array probability;
+        std::vector<Matrix> cond;
+        std::vector<std::vector<std::vector<Real>>> addends;
+    };
+
     /*! Get the transition matrix from today to date by entity,
       sanitise the annual transition matrix input,
       rescale to the desired horizon/date using the generator,
       cache the result so that we do the sanitising/rescaling only once */
-    std::map<string, Matrix> rescaledTransitionMatrices(const Size date);
+    const std::map<string, Matrix>& rescaledTransitionMatrices(const Size date);
+
+    /*! Get the cumulative rescaled transition probabilities and their normal inverse by entity,
+      cache the result so that the inversion is done only once per date and not once per path */
+    const std::vector<TransitionThresholds>& transitionThresholds(const Size date);
 
     /*! Initialise
       - the variance of the global part Y_i of entity state X_i, for all entities
@@ -81,30 +99,35 @@ private:
         using the simulated global state paths stored in the aggregation scenario data object */
     void init();
 
-    //! Allocate 3d storage for the simulated idiosyncratic factors by entity, date and sample
-    void initEntityStateSimulation();
-
     /*! Initialise the entity state simulationn for a given date for
         Evaluation = TerminalSimulation:
         Return transition matrix for each entity for the given date,
         conditional on the global terminal state on the given path */
-    std::vector<Matrix> initEntityStateSimulation(const Size date, const Size path);
+    std::vector<Matrix> initEntityStateSimulation(const Size date, const Size path,
+                                                  const std::vector<TransitionThresholds>& th) const;
 
-    /*! Generate one entity state sample path for all entities given the global state path
-        and given the conditional transition matrices for all entities at the terminal date. */
-    void simulateEntityStates(const std::vector<Matrix>& cond, const Size path, const MersenneTwisterUniformRng& mt);
+    /*! Generate one entity state sample for all entities given the conditional transition matrices
+        for all entities at the terminal date. */
+    void simulateEntityStates(const std::vector<Matrix>& cond, const MersenneTwisterUniformRng& mt,
+                              std::vector<Size>& states) const;
 
-    //! Look up the simulated entity credit state for the given entity, date and path
-    Size simulatedEntityState(const Size i, const Size path) const;
+    /*! Precompute the PnL contributions by entity and entity state on the given global path due to credit
+      migration or default of Bond/CDS issuers and default of netting set counterparties */
+    void migrationPnlAddends(const Size date, const Size path,
+                             std::vector<std::vector<std::vector<Real>>>& addends) const;
 
-    /*! Return a single PnL impact due to credit migration or default of Bond/CDS issuers and default of
-      netting set counterparties on the given global path */
-    Real generateMigrationPnl(const Size date, const Size path, const Size n) const;
+    //! Return a single PnL impact for the given entity states using the precomputed contributions
+    Real generateMigrationPnl(const std::vector<std::vector<std::vector<Real>>>& addends,
+                              const std::vector<Size>& states) const;
 
     /*! Return a vector of PnL impacts and associated conditional probabilities for the specified global path,
       due to credit migration or default of Bond/CDS issuers and default of netting set counterparties */
     void generateConditionalMigrationPnl(const Size date, const Size path, const std::map<string, Matrix>& transMat,
-                                         std::vector<Array>& condProbs, std::vector<Array>& pnl) const;
+                                         const std::vector<TransitionThresholds>& th, std::vector<Array>& condProbs,
+                                         std::vector<Array>& pnl) const;
+
+    //! Return the market PnL from t0 to the given date on the given path
+    Real marketPnl(const Size date, const Size path) const;
 
     QuantLib::ext::shared_ptr<CreditSimulationParameters> parameters_;
     QuantLib::ext::shared_ptr<NPVCube> cube_, nettedCube_;
@@ -131,12 +154,9 @@ private:
     // Transition matrix rows
     Size n_;
     std::vector<std::map<string, Matrix>> rescaledTransitionMatrices_;
+    std::vector<std::vector<TransitionThresholds>> transitionThresholds_;
     // Variance of the systemic part (Y_i) of entity state X_i
     std::vector<Real> globalVar_;
-    // Storage for the simulated idiosyncratic factors Z by entity, sample number
-    std::vector<std::vector<Size>> simulatedEntityState_;
-
-    std::vector<std::vector<Matrix>> entityStateSimulationMatrices_;
     // Systemic part (Y_i) of entity state X_i by date index, entity index, sample number
     std::vector<std::vector<std::vector<Real>>> globalStates_;
 };
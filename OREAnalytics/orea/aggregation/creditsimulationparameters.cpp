@@ -76,6 +76,7 @@ void CreditSimulationParameters::fromXML(XMLNode* root) {
     doubleDefault_ = XMLUtils::getChildValueAsBool(node, "DoubleDefault", true);
     seed_ = XMLUtils::getChildValueAsInt(node, "Seed", true);
     paths_ = XMLUtils::getChildValueAsInt(node, "Paths", true);
+    threads_ = XMLUtils::getChildValueAsInt(node, "Threads", false, 1);
     creditMode_ = XMLUtils::getChildValue(node, "CreditMode", true);
     loanExposureMode_ = XMLUtils::getChildValue(node, "LoanExposureMode", true);
 
@@ -28,14 +28,18 @@
 #include <ql/methods/montecarlo/lsmbasissystem.hpp>
 #include <ql/time/daycounters/actualactual.hpp>
 
-#include <qle/math/nadarayawatson.hpp>
-#include <qle/math/stabilisedglls.hpp>
+#include <qle/math/randomvariablelsmbasissystem.hpp>
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/error_of_mean.hpp>
 #include <boost/accumulators/statistics/mean.hpp>
 #include <boost/accumulators/statistics/stats.hpp>
 
+#include <atomic>
+#include <future>
+#include <numeric>
+#include <thread>
+
 using namespace std;
 using namespace QuantLib;
 
@@ -50,15 +54,16 @@ RegressionDynamicInitialMarginCalculator::RegressionDynamicInitialMarginCalculat
     const QuantLib::ext::shared_ptr<CubeInterpretation>& cubeInterpretation,
     const QuantLib::ext::shared_ptr<AggregationScenarioData>& scenarioData, Real quantile, Size horizonCalendarDays,
     Size regressionOrder, std::vector<std::string> regressors, Size localRegressionEvaluations,
-    Real localRegressionBandWidth, const std::map<std::string, Real>& currentIM)
+    Real localRegressionBandWidth, const std::map<std::string, Real>& currentIM, Size nThreads)
 : DynamicInitialMarginCalculator(inputs, portfolio, cube, cubeInterpretation, scenarioData, quantile, horizonCalendarDays,
                                  currentIM),
       regressionOrder_(regressionOrder), regressors_(regressors),
-      localRegressionEvaluations_(localRegressionEvaluations), localRegressionBandWidth_(localRegressionBandWidth) {
+      localRegressionEvaluations_(localRegressionEvaluations), localRegressionBandWidth_(localRegressionBandWidth),
+      nThreads_(std::max<Size>(nThreads, 1)) {
     Size dates = cube_->dates().size();
     Size samples = cube_->samples();
     for (const auto& nettingSetId : nettingSetIds_) {
-        regressorArray_[nettingSetId] = vector<vector<Array>>(dates, vector<Array>(samples));
+        regressorValues_[nettingSetId] = vector<vector<QuantExt::RandomVariable>>(dates);
         nettingSetLocalDIM_[nettingSetId] = vector<vector<Real>>(dates, vector<Real>(samples, 0.0));
         nettingSetZeroOrderDIM_[nettingSetId] = vector<Real>(dates, 0.0);
         nettingSetSimpleDIMh_[nettingSetId] = vector<Real>(dates, 0.0);
@@ -95,6 +100,37 @@ const vector<Real>& RegressionDynamicInitialMarginCalculator::simpleResultsLower
         QL_FAIL("netting set " << nettingSet << " not found in Simple DIM (c) results");
 }
 
+namespace {
+
+// Nadaraya-Watson estimate of the conditional standard deviation of y given x with a Gaussian kernel. The x values
+// must be sorted, only the samples within the window where the kernel weight is not negligible are summed up.
+Real localStandardDeviation(const vector<Real>& x, const vector<Real>& y, Real x0, const GaussianKernel& kernel,
+                            Real window) {
+    auto begin = std::lower_bound(x.begin(), x.end(), x0 - window);
+    auto end = std::upper_bound(begin, x.end(), x0 + window);
+    Real tmp1 = 0.0, tmp1b = 0.0, tmp2 = 0.0;
+    for (auto it = begin; it != end; ++it) {
+        Size i = it - x.begin();
+        Real tmp = kernel(x0 - x[i]);
+        tmp1 += y[i] * tmp;
+        tmp1b += y[i] * y[i] * tmp;
+        tmp2 += tmp;
+    }
+    return QuantLib::close_enough(tmp2, 0.0) ? 0.0 : std::sqrt(tmp1b / tmp2 - (tmp1 * tmp1) / (tmp2 * tmp2));
+}
+
+// Subtract the mean and divide by the (population) standard deviation, a zero variance leaves the scale unchanged
+void meanStdDevTransform(const QuantExt::RandomVariable& x, Real& shift, Real& multiplier) {
+    accumulator_set<double, stats<boost::accumulators::tag::mean, boost::accumulators::tag::variance>> acc;
+    for (Size k = 0; k < x.size(); ++k)
+        acc(x[k]);
+    shift = -mean(acc);
+    Real var = boost::accumulators::variance(acc);
+    multiplier = QuantLib::close_enough(var, 0.0) ? 1.0 : 1.0 / std::sqrt(var);
+}
+
+} // namespace
+
 void RegressionDynamicInitialMarginCalculator::build() {
     LOG("DIM Analysis by polynomial regression");
 
@@ -103,19 +139,15 @@ void RegressionDynamicInitialMarginCalculator::build() {
     Size stopDatesLoop = datesLoopSize_;
     Size samples = cube_->samples();
 
-    Size polynomOrder = regressionOrder_;
     LOG("DIM regression polynom order = " << regressionOrder_);
-    LsmBasisSystem::PolynomialType polynomType = LsmBasisSystem::Monomial;
     Size regressionDimension = regressors_.empty() ? 1 : regressors_.size();
     LOG("DIM regression dimension = " << regressionDimension);
-    std::vector<ext::function<Real(Array)>> v(
-        LsmBasisSystem::multiPathBasisSystem(regressionDimension, polynomOrder, polynomType));
-    Real confidenceLevel = QuantLib::InverseCumulativeNormal()(quantile_);
-    LOG("DIM confidence level " << confidenceLevel);
-
-    Size simple_dim_index_h = Size(floor(quantile_ * (samples - 1) + 0.5));
-    Size simple_dim_index_p = Size(floor((1.0 - quantile_) * (samples - 1) + 0.5));
+    auto basis = RandomVariableLsmBasisSystem::multiPathBasisSystem(regressionDimension, regressionOrder_,
+                                                                    LsmBasisSystem::Monomial);
 
+    // Determine the netting sets that need a regression and their scaling, this is done sequentially
+    vector<pair<string, Size>> regressionNettingSets;
+    vector<Real> dimScaling;
     Size nettingSetCount = 0;
     for (auto n : nettingSetIds_) {
         LOG("Process netting set " << n);
@@ -152,6 +184,7 @@ void RegressionDynamicInitialMarginCalculator::build() {
                 }
                 WLOG("Overriding DIM for netting set " << n << " succeeded");
                 // continue to the next netting set
+                nettingSetCount++;
                 continue;
             }
         }
@@ -170,149 +203,223 @@ void RegressionDynamicInitialMarginCalculator::build() {
             nettingSetScaling_.find(n) == nettingSetScaling_.end() ? 1.0 : nettingSetScaling_[n];
         LOG("Netting set DIM scaling factor: " << nettingSetDimScaling);
 
-        for (Size j = 0; j < stopDatesLoop; ++j) {
-            accumulator_set<double, stats<boost::accumulators::tag::mean, boost::accumulators::tag::variance>> accDiff;
-            accumulator_set<double, stats<boost::accumulators::tag::mean>> accOneOverNumeraire;
-            for (Size k = 0; k < samples; ++k) {
-                Real numDefault =
-                    cubeInterpretation_->getDefaultAggregationScenarioData(AggregationScenarioDataType::Numeraire, j, k);
-                Real numCloseOut =
-                    cubeInterpretation_->getCloseOutAggregationScenarioData(AggregationScenarioDataType::Numeraire, j, k);
-                Real npvDefault = nettingSetNPV_[n][j][k];
-                Real flow = nettingSetFLOW_[n][j][k];
-                Real npvCloseOut = nettingSetCloseOutNPV_[n][j][k];
-                accDiff((npvCloseOut * numCloseOut) + (flow * numDefault) - (npvDefault * numDefault));
-                accOneOverNumeraire(1.0 / numDefault);
-            }
+        regressionNettingSets.push_back(std::make_pair(n, nettingSetCount));
+        dimScaling.push_back(nettingSetDimScaling);
+        nettingSetCount++;
+    }
+
+    QL_REQUIRE(regressionNettingSets.empty() || samples > basis.size(),
+               "not enough points for regression with polynom order " << regressionOrder_);
+
+    // Run the regressions, the netting sets are distributed dynamically over the worker threads
+    Size nThreads = std::min(nThreads_, regressionNettingSets.size());
+    LOG("DIM regression for " << regressionNettingSets.size() << " netting sets using " << nThreads << " threads");
+    if (nThreads <= 1) {
+        for (Size i = 0; i < regressionNettingSets.size(); ++i)
+            buildNettingSet(regressionNettingSets[i].first, regressionNettingSets[i].second, dimScaling[i], basis);
+    } else {
+        std::atomic<Size> next(0);
+        auto job = [this, &next, &regressionNettingSets, &dimScaling, &basis]() {
+            for (Size i = next++; i < regressionNettingSets.size(); i = next++)
+                buildNettingSet(regressionNettingSets[i].first, regressionNettingSets[i].second, dimScaling[i],
+                                basis);
+        };
+        std::vector<std::future<void>> results;
+        for (Size t = 0; t < nThreads; ++t)
+            results.push_back(std::async(std::launch::async, job));
+        // propagate the first exception thrown in a worker, after all workers have finished
+        for (auto& r : results)
+            r.wait();
+        for (auto& r : results)
+            r.get();
+    }
+
+    LOG("DIM by polynomial regression done");
+}
+
+void RegressionDynamicInitialMarginCalculator::buildNettingSet(
+    const string& n, Size nettingSetIndex, Real nettingSetDimScaling,
+    const std::vector<std::function<QuantExt::RandomVariable(const std::vector<const QuantExt::RandomVariable*>&)>>&
+        basis) {
+
+    // Only use at() on the result maps here, the entries exist and the maps are shared between threads
+    const auto& npv = nettingSetNPV_.at(n);
+    const auto& flow = nettingSetFLOW_.at(n);
+    const auto& closeOutNpv = nettingSetCloseOutNPV_.at(n);
+    auto& deltaNpv = nettingSetDeltaNPV_.at(n);
+    auto& dim = nettingSetDIM_.at(n);
+    auto& localDim = nettingSetLocalDIM_.at(n);
+    auto& expectedDim = nettingSetExpectedDIM_.at(n);
+    auto& zeroOrderDim = nettingSetZeroOrderDIM_.at(n);
+    auto& simpleDimH = nettingSetSimpleDIMh_.at(n);
+    auto& simpleDimP = nettingSetSimpleDIMp_.at(n);
+    auto& regValues = regressorValues_.at(n);
+
+    Size samples = cube_->samples();
+    Real confidenceLevel = QuantLib::InverseCumulativeNormal()(quantile_);
+    Size simple_dim_index_h = Size(floor(quantile_ * (samples - 1) + 0.5));
+    Size simple_dim_index_p = Size(floor((1.0 - quantile_) * (samples - 1) + 0.5));
+    GaussianKernel kernel(0.0, localRegressionBandWidth_);
+    // beyond 10 band widths the Gaussian kernel weights are below 1E-21 relative to the centre
+    Real localRegressionWindow = 10.0 * localRegressionBandWidth_;
+
+    vector<Real> numDefault(samples), rx0(samples), ry1(samples);
+    QuantExt::RandomVariable ry2(samples);
+    ry2.expand();
+
+    for (Size j = 0; j < datesLoopSize_; ++j) {
+        accumulator_set<double, stats<boost::accumulators::tag::mean, boost::accumulators::tag::variance>> accDiff;
+        accumulator_set<double, stats<boost::accumulators::tag::mean>> accOneOverNumeraire;
+        for (Size k = 0; k < samples; ++k) {
+            numDefault[k] =
+                cubeInterpretation_->getDefaultAggregationScenarioData(AggregationScenarioDataType::Numeraire, j, k);
+            Real numCloseOut =
+                cubeInterpretation_->getCloseOutAggregationScenarioData(AggregationScenarioDataType::Numeraire, j, k);
+            Real x = npv[j][k] * numDefault[k];
+            Real f = flow[j][k] * numDefault[k];
+            Real y = closeOutNpv[j][k] * numCloseOut;
+            Real z = (y + f - x);
+            accDiff(z);
+            accOneOverNumeraire(1.0 / numDefault[k]);
+            ry1[k] = z;              // for local regression
+            ry2.data()[k] = z * z;   // for least squares regression
+            deltaNpv[j][k] = z;
+        }
 
-            Size mporCalendarDays = cubeInterpretation_->getMporCalendarDays(cube_, j);
-            Real horizonScaling = sqrt(1.0 * horizonCalendarDays_ / mporCalendarDays);
+        Size mporCalendarDays = cubeInterpretation_->getMporCalendarDays(cube_, j);
+        Real horizonScaling = sqrt(1.0 * horizonCalendarDays_ / mporCalendarDays);
 
-            Real stdevDiff = sqrt(boost::accumulators::variance(accDiff));
-            Real E_OneOverNumeraire =
-                mean(accOneOverNumeraire); // "re-discount" (the stdev is calculated on non-discounted deltaNPVs)
+        Real stdevDiff = sqrt(boost::accumulators::variance(accDiff));
+        Real E_OneOverNumeraire =
+            mean(accOneOverNumeraire); // "re-discount" (the stdev is calculated on non-discounted deltaNPVs)
 
-            nettingSetZeroOrderDIM_[n][j] = stdevDiff * horizonScaling * confidenceLevel;
-            nettingSetZeroOrderDIM_[n][j] *= E_OneOverNumeraire;
+        zeroOrderDim[j] = stdevDiff * horizonScaling * confidenceLevel;
+        zeroOrderDim[j] *= E_OneOverNumeraire;
 
-            vector<Real> rx0(samples, 0.0);
-            vector<Array> rx(samples, Array());
-            vector<Real> ry1(samples, 0.0);
-            vector<Real> ry2(samples, 0.0);
+        regValues[j] = regressorValues(n, j);
+        const vector<QuantExt::RandomVariable>& rx = regValues[j];
+        for (Size k = 0; k < samples; ++k)
+            rx0[k] = rx[0][k];
+
+        vector<Real> delNpvVec_copy = deltaNpv[j];
+        sort(delNpvVec_copy.begin(), delNpvVec_copy.end());
+        Real simpleDim_h = delNpvVec_copy[simple_dim_index_h];
+        Real simpleDim_p = delNpvVec_copy[simple_dim_index_p];
+        simpleDim_h *= horizonScaling;                   // the usual scaling factors
+        simpleDim_p *= horizonScaling;                   // the usual scaling factors
+        simpleDimH[j] = simpleDim_h * E_OneOverNumeraire; // discounted DIM
+        simpleDimP[j] = simpleDim_p * E_OneOverNumeraire; // discounted DIM
+
+        if (close_enough(stdevDiff, 0.0)) {
+            LOG("DIM: Zero std dev estimation at step " << j);
+            // Skip IM calculation if all samples have zero NPV (e.g. after latest maturity)
             for (Size k = 0; k < samples; ++k) {
-                Real numDefault =
-                    cubeInterpretation_->getDefaultAggregationScenarioData(AggregationScenarioDataType::Numeraire, j, k);
-                Real numCloseOut =
-                    cubeInterpretation_->getCloseOutAggregationScenarioData(AggregationScenarioDataType::Numeraire, j, k);
-                Real x = nettingSetNPV_[n][j][k] * numDefault;
-                Real f = nettingSetFLOW_[n][j][k] * numDefault;
-                Real y = nettingSetCloseOutNPV_[n][j][k] * numCloseOut;
-                Real z = (y + f - x);
-                rx[k] = regressors_.empty() ? Array(1, nettingSetNPV_[n][j][k]) : regressorArray(n, j, k);
-                rx0[k] = rx[k][0];
-                ry1[k] = z;     // for local regression
-                ry2[k] = z * z; // for least squares regression
-                nettingSetDeltaNPV_[n][j][k] = z;
-                regressorArray_[n][j][k] = rx[k];
-            }
-            vector<Real> delNpvVec_copy = nettingSetDeltaNPV_[n][j];
-            sort(delNpvVec_copy.begin(), delNpvVec_copy.end());
-            Real simpleDim_h = delNpvVec_copy[simple_dim_index_h];
-            Real simpleDim_p = delNpvVec_copy[simple_dim_index_p];
-            simpleDim_h *= horizonScaling;                                  // the usual scaling factors
-            simpleDim_p *= horizonScaling;                                  // the usual scaling factors
-            nettingSetSimpleDIMh_[n][j] = simpleDim_h * E_OneOverNumeraire; // discounted DIM
-            nettingSetSimpleDIMp_[n][j] = simpleDim_p * E_OneOverNumeraire; // discounted DIM
-
-            QL_REQUIRE(rx.size() > v.size(), "not enough points for regression with polynom order " << polynomOrder);
-            if (close_enough(stdevDiff, 0.0)) {
-                LOG("DIM: Zero std dev estimation at step " << j);
-                // Skip IM calculation if all samples have zero NPV (e.g. after latest maturity)
-                for (Size k = 0; k < samples; ++k) {
-                    nettingSetDIM_[n][j][k] = 0.0;
-                    nettingSetLocalDIM_[n][j][k] = 0.0;
-                }
-            } else {
-                // Least squares polynomial regression with specified polynom order
-                QuantExt::StabilisedGLLS ls(rx, ry2, v, QuantExt::StabilisedGLLS::MeanStdDev);
-                LOG("DIM data normalisation at time step "
-                    << j << ": " << scientific << setprecision(6) << " x-shift = " << ls.xShift() << " x-multiplier = "
-                    << ls.xMultiplier() << " y-shift = " << ls.yShift() << " y-multiplier = " << ls.yMultiplier());
-                LOG("DIM regression coefficients at time step " << j << ": " << fixed << setprecision(6)
-                                                                << ls.transformedCoefficients());
-
-                // Local regression versus first regression variable (i.e. we do not perform a
-                // multidimensional local regression):
-                // We evaluate this at a limited number of samples only for validation purposes.
-                // Note that computational effort scales quadratically with number of samples.
-                // NadarayaWatson needs a large number of samples for good results.
-                QuantExt::NadarayaWatson lr(rx0.begin(), rx0.end(), ry1.begin(),
-                                            GaussianKernel(0.0, localRegressionBandWidth_));
-                Size localRegressionSamples = samples;
-                if (localRegressionEvaluations_ > 0)
-                    localRegressionSamples = Size(floor(1.0 * samples / localRegressionEvaluations_ + .5));
-
-                // Evaluate regression function to compute DIM for each scenario
-                for (Size k = 0; k < samples; ++k) {
-                    // Real num1 = scenarioData_->get(j, k, AggregationScenarioDataType::Numeraire);
-                    Real numDefault = cubeInterpretation_->getDefaultAggregationScenarioData(
-                        AggregationScenarioDataType::Numeraire, j, k);
-                    Array regressor = regressors_.empty() ? Array(1, nettingSetNPV_[n][j][k]) : regressorArray(n, j, k);
-                    Real e = ls.eval(regressor, v);
-                    if (e < 0.0)
-                        LOG("Negative variance regression for date " << j << ", sample " << k
-                                                                     << ", regressor = " << regressor);
-
-                    // Note:
-                    // 1) We assume vanishing mean of "z", because the drift over a MPOR is usually small,
-                    //    and to avoid a second regression for the conditional mean
-                    // 2) In particular the linear regression function can yield negative variance values in
-                    //    extreme scenarios where an exact analytical or delta VaR calculation would yield a
-                    //    variance approaching zero. We correct this here by taking the positive part.
-                    Real std = sqrt(std::max(e, 0.0));
-                    Real scalingFactor = horizonScaling * confidenceLevel * nettingSetDimScaling;
-                    // Real dim = std * scalingFactor / num1;
-                    Real dim = std * scalingFactor / numDefault;
-                    dimCube_->set(dim, nettingSetCount, j, k);
-                    nettingSetDIM_[n][j][k] = dim;
-                    nettingSetExpectedDIM_[n][j] += dim / samples;
-
-                    // Evaluate the Kernel regression for a subset of the samples only (performance)
-                    if (localRegressionEvaluations_ > 0 && (k % localRegressionSamples == 0))
-                        // nettingSetLocalDIM_[n][j][k] = lr.standardDeviation(regressor[0]) * scalingFactor / num1;
-                        nettingSetLocalDIM_[n][j][k] = lr.standardDeviation(regressor[0]) * scalingFactor / numDefault;
-                    else
-                        nettingSetLocalDIM_[n][j][k] = 0.0;
-                }
+                dim[j][k] = 0.0;
+                localDim[j][k] = 0.0;
             }
+            continue;
         }
 
-        nettingSetCount++;
+        // Least squares polynomial regression with specified polynom order on data normalised by mean and std dev
+        vector<QuantExt::RandomVariable> rxTransformed(rx.size());
+        Array xShift(rx.size()), xMultiplier(rx.size());
+        for (Size i = 0; i < rx.size(); ++i) {
+            meanStdDevTransform(rx[i], xShift[i], xMultiplier[i]);
+            rxTransformed[i] = (rx[i] + QuantExt::RandomVariable(samples, xShift[i])) *
+                               QuantExt::RandomVariable(samples, xMultiplier[i]);
+        }
+        Real yShift, yMultiplier;
+        meanStdDevTransform(ry2, yShift, yMultiplier);
+        QuantExt::RandomVariable ry2Transformed =
+            (ry2 + QuantExt::RandomVariable(samples, yShift)) * QuantExt::RandomVariable(samples, yMultiplier);
+
+        auto rxPtr = vec2vecptr(rxTransformed);
+        Array coefficients = regressionCoefficients(ry2Transformed, rxPtr, basis, Filter(),
+                                                    RandomVariableRegressionMethod::SVD);
+        LOG("DIM data normalisation at time step "
+            << j << ": " << scientific << setprecision(6) << " x-shift = " << xShift << " x-multiplier = "
+            << xMultiplier << " y-shift = " << yShift << " y-multiplier = " << yMultiplier);
+        LOG("DIM regression coefficients at time step " << j << ": " << fixed << setprecision(6) << coefficients);
+
+        // Evaluate the regression function in terms of the original y
+        QuantExt::RandomVariable e = conditionalExpectation(rxPtr, basis, coefficients);
+        e = e / QuantExt::RandomVariable(samples, yMultiplier) - QuantExt::RandomVariable(samples, yShift);
+
+        // Local regression versus first regression variable (i.e. we do not perform a
+        // multidimensional local regression):
+        // We evaluate this at a limited number of samples only for validation purposes.
+        // The samples are sorted once, each evaluation then only visits the samples in its kernel window.
+        vector<Real> xSorted, ySorted;
+        Size localRegressionSamples = samples;
+        if (localRegressionEvaluations_ > 0) {
+            localRegressionSamples = Size(floor(1.0 * samples / localRegressionEvaluations_ + .5));
+            vector<Size> p(samples);
+            std::iota(p.begin(), p.end(), 0);
+            std::sort(p.begin(), p.end(), [&rx0](Size a, Size b) { return rx0[a] < rx0[b]; });
+            xSorted = apply_permutation(rx0, p);
+            ySorted = apply_permutation(ry1, p);
+        }
+
+        Real scalingFactor = horizonScaling * confidenceLevel * nettingSetDimScaling;
+
+        // Evaluate regression function to compute DIM for each scenario
+        for (Size k = 0; k < samples; ++k) {
+            if (e[k] < 0.0)
+                LOG("Negative variance regression for date " << j << ", sample " << k << ", regressor = " << rx0[k]);
+
+            // Note:
+            // 1) We assume vanishing mean of "z", because the drift over a MPOR is usually small,
+            //    and to avoid a second regression for the conditional mean
+            // 2) In particular the linear regression function can yield negative variance values in
+            //    extreme scenarios where an exact analytical or delta VaR calculation would yield a
+            //    variance approaching zero. We correct this here by taking the positive part.
+            Real std = sqrt(std::max(e[k], 0.0));
+            Real d = std * scalingFactor / numDefault[k];
+            dimCube_->set(d, nettingSetIndex, j, k);
+            dim[j][k] = d;
+            expectedDim[j] += d / samples;
+
+            // Evaluate the Kernel regression for a subset of the samples only (performance)
+            if (localRegressionEvaluations_ > 0 && (k % localRegressionSamples == 0))
+                localDim[j][k] =
+                    localStandardDeviation(xSorted, ySorted, rx0[k], kernel, localRegressionWindow) * scalingFactor /
+                    numDefault[k];
+            else
+                localDim[j][k] = 0.0;
+        }
     }
-    LOG("DIM by polynomial regression done");
 }
 
-Array RegressionDynamicInitialMarginCalculator::regressorArray(string nettingSet, Size dateIndex,
-                                                                           Size sampleIndex) {
-    Array a(regressors_.size());
+vector<QuantExt::RandomVariable> RegressionDynamicInitialMarginCalculator::regressorValues(const string& nettingSet,
+                                                                                           Size dateIndex) const {
+    Size samples = cube_->samples();
+    const auto& npv = nettingSetNPV_.at(nettingSet)[dateIndex];
+    if (regressors_.empty())
+        return {QuantExt::RandomVariable(npv)};
+
+    vector<QuantExt::RandomVariable> result;
     for (Size i = 0; i < regressors_.size(); ++i) {
         string variable = regressors_[i];
-        if (boost::to_upper_copy(variable) ==
-            "NPV") // this allows possibility to include NPV as a regressor alongside more fundamental risk factors
-            a[i] = nettingSetNPV_[nettingSet][dateIndex][sampleIndex];
-        else if (scenarioData_->has(AggregationScenarioDataType::IndexFixing, variable))
-            a[i] = cubeInterpretation_->getDefaultAggregationScenarioData(AggregationScenarioDataType::IndexFixing,
-                                                                      dateIndex, sampleIndex, variable);
+        if (boost::to_upper_copy(variable) == "NPV") {
+            // this allows possibility to include NPV as a regressor alongside more fundamental risk factors
+            result.push_back(QuantExt::RandomVariable(npv));
+            continue;
+        }
+        AggregationScenarioDataType type;
+        if (scenarioData_->has(AggregationScenarioDataType::IndexFixing, variable))
+            type = AggregationScenarioDataType::IndexFixing;
         else if (scenarioData_->has(AggregationScenarioDataType::FXSpot, variable))
-            a[i] = cubeInterpretation_->getDefaultAggregationScenarioData(AggregationScenarioDataType::FXSpot, dateIndex,
-                                                                      sampleIndex, variable);
+            type = AggregationScenarioDataType::FXSpot;
         else if (scenarioData_->has(AggregationScenarioDataType::Generic, variable))
-            a[i] = cubeInterpretation_->getDefaultAggregationScenarioData(AggregationScenarioDataType::Generic, dateIndex,
-                                                                      sampleIndex, variable);
+            type = AggregationScenarioDataType::Generic;
         else
             QL_FAIL("scenario data does not provide data for " << variable);
+        vector<Real> values(samples);
+        for (Size k = 0; k < samples; ++k)
+            values[k] = cubeInterpretation_->getDefaultAggregationScenarioData(type, dateIndex, k, variable);
+        result.push_back(QuantExt::RandomVariable(values));
     }
-    return a;
+    return result;
 }
 
 map<string, Real> RegressionDynamicInitialMarginCalculator::unscaledCurrentDIM() {
@@ -467,8 +574,11 @@ void RegressionDynamicInitialMarginCalculator::exportDimRegression(
             numeraires[k] =
                 cubeInterpretation_->getDefaultAggregationScenarioData(AggregationScenarioDataType::Numeraire, timeStep, k);
 
-        auto p = sort_permutation(regressorArray_[nettingSet][timeStep], lessThan);
-        vector<Array> reg = apply_permutation(regressorArray_[nettingSet][timeStep], p);
+        const vector<QuantExt::RandomVariable>& regValues = regressorValues_[nettingSet][timeStep];
+        QL_REQUIRE(!regValues.empty(), "no regressors for netting set " << nettingSet << " and time step " << timeStep);
+        vector<Size> p(samples);
+        std::iota(p.begin(), p.end(), 0);
+        std::sort(p.begin(), p.end(), [&regValues](Size a, Size b) { return regValues[0][a] < regValues[0][b]; });
         vector<Real> dim = apply_permutation(nettingSetDIM_[nettingSet][timeStep], p);
         vector<Real> ldim = apply_permutation(nettingSetLocalDIM_[nettingSet][timeStep], p);
         vector<Real> delta = apply_permutation(nettingSetDeltaNPV_[nettingSet][timeStep], p);
@@ -476,7 +586,7 @@ void RegressionDynamicInitialMarginCalculator::exportDimRegression(
 
         QuantLib::ext::shared_ptr<ore::data::Report> regReport = dimRegReports[ii];
         regReport->addColumn("Sample", Size());
-        for (Size k = 0; k < reg[0].size(); ++k) {
+        for (Size k = 0; k < regValues.size(); ++k) {
             ostringstream o;
             o << "Regressor_" << k << "_";
             o << (regressors_.empty() ? "NPV" : regressors_[k]);
@@ -493,10 +603,10 @@ void RegressionDynamicInitialMarginCalculator::exportDimRegression(
         // but ExpectedDIM, ZeroOrderDIM and SimpleDIM _are_ reduced by the numeraire.
         // This is so that the regression formula can be manually validated
 
-        for (Size j = 0; j < reg.size(); ++j) {
+        for (Size j = 0; j < samples; ++j) {
             regReport->next().add(j);
-            for (Size k = 0; k < reg[j].size(); ++k)
-                regReport->add(reg[j][k]);
+            for (Size k = 0; k < regValues.size(); ++k)
+                regReport->add(regValues[k][p[j]]);
             regReport->add(dim[j] * num[j])
                 .add(ldim[j] * num[j])
                 .add(nettingSetExpectedDIM_[nettingSet][timeStep])
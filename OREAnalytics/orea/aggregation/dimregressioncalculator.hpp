@@ -25,6 +25,8 @@
 
 #include <orea/aggregation/dimcalculator.hpp>
 
+#include <qle/math/randomvariable.hpp>
+
 namespace ore {
 namespace analytics {
 using namespace QuantLib;
@@ -36,6 +38,11 @@ using namespace std;
 /*!
   Dynamic IM is estimated using polynomial and local regression methods applied to the NPV moves over simulation time
   steps across all paths.
+
+  The regressors are held as one RandomVariable per regression variable and date, i.e. contiguous over the samples,
+  and the regression is performed on RandomVariables. Netting sets are processed in parallel if more than one
+  thread is given. The local regression sorts the samples once per date and restricts the kernel sums to the
+  samples within a window of the evaluation point where the kernel weights are not negligible.
 */
 class RegressionDynamicInitialMarginCalculator : public DynamicInitialMarginCalculator {
 public:
@@ -63,7 +70,9 @@ public:
         //! Local regression band width in standard deviations of the regression variable
         Real localRegressionBandWidth = 0,
 	//! Actual t0 IM by netting set used to scale the DIM evolution, no scaling if the argument is omitted
-	const std::map<std::string, Real>& currentIM = std::map<std::string, Real>());
+	const std::map<std::string, Real>& currentIM = std::map<std::string, Real>(),
+        //! Number of threads used to process the netting sets
+        Size nThreads = 1);
 
     map<string, Real> unscaledCurrentDIM() override;
     void build() override;
@@ -78,16 +87,22 @@ public:
     const vector<Real>& simpleResultsLower(const string& nettingSet);
 
 private:
-    //! Compile the array of DIM regressors for the specified netting set, date and sample index
-    Array regressorArray(string nettingSet, Size dateIndex, Size sampleIndex);
+    //! Compile the DIM regressors for the specified netting set and date, one random variable per regressor
+    vector<QuantExt::RandomVariable> regressorValues(const string& nettingSet, Size dateIndex) const;
+    //! Perform the DIM regression for one netting set, this is called concurrently for different netting sets
+    void buildNettingSet(
+        const string& nettingSet, Size nettingSetIndex, Real nettingSetDimScaling,
+        const std::vector<std::function<QuantExt::RandomVariable(const std::vector<const QuantExt::RandomVariable*>&)>>&
+            basis);
 
     Size regressionOrder_;
     vector<string> regressors_;
     Size localRegressionEvaluations_;
     Real localRegressionBandWidth_;
+    Size nThreads_;
 
-    // For each netting set: Array of regressor values by date and sample
-    map<string, vector<vector<Array>>> regressorArray_;
+    // For each netting set: regressor values by date and regressor, each holding all samples
+    map<string, vector<vector<QuantExt::RandomVariable>>> regressorValues_;
     // For each netting set: local regression DIM estimate by date and sample
     map<string, vector<vector<Real>>> nettingSetLocalDIM_;
     // For each netting set: vector of values by date, aggregated over trades and samples
@@ -37,6 +37,7 @@
 #include <ored/portfolio/builders/multilegoption.hpp>
 #include <ored/portfolio/builders/swaption.hpp>
 #include <ored/portfolio/structuredtradeerror.hpp>
+#include <ored/utilities/profiler.hpp>
 
 #include <boost/timer/timer.hpp>
 
@@ -179,6 +180,7 @@ void Analytic::buildMarket(const QuantLib::ext::shared_ptr<ore::data::InMemoryLo
                            const bool marketRequired) {
     LOG("Analytic::buildMarket called");    
     cpu_timer mtimer;
+    ScopedProfileTimer profileTimer("market build");
 
     QL_REQUIRE(loader, "market data loader not set");
     QL_REQUIRE(configurations().curveConfig, "curve configurations not set");
@@ -236,7 +238,10 @@ void Analytic::buildPortfolio() {
 
         LOG("Build the portfolio");
         QuantLib::ext::shared_ptr<EngineFactory> factory = impl()->engineFactory();
-        portfolio()->build(factory, "analytic/" + label());
+        // a parallel build is opt-in and requires a market that is not built lazily
+        Size nThreads =
+            inputs()->parallelPortfolioBuild() && !inputs()->lazyMarketBuilding() ? inputs()->nThreads() : 1;
+        portfolio()->build(factory, "analytic/" + label(), true, nThreads);
 
         // remove dates that will have matured
         Date maturityDate = inputs()->asof();
@@ -122,6 +122,7 @@ public:
     const QuantLib::ext::shared_ptr<ore::data::Portfolio>& portfolio() const { return portfolio_; };
     void setInputs(const QuantLib::ext::shared_ptr<InputParameters>& inputs) { inputs_ = inputs; }
     void setMarket(const QuantLib::ext::shared_ptr<ore::data::Market>& market) { market_ = market; };
+    void setLoader(const QuantLib::ext::shared_ptr<ore::data::Loader>& loader) { loader_ = loader; };
     void setPortfolio(const QuantLib::ext::shared_ptr<ore::data::Portfolio>& portfolio) { portfolio_ = portfolio; };
     std::vector<QuantLib::ext::shared_ptr<ore::data::TodaysMarketParameters>> todaysMarketParams();
     const QuantLib::ext::shared_ptr<ore::data::Loader>& loader() const { return loader_; };
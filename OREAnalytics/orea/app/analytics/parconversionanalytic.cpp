@@ -19,8 +19,8 @@
 #include <orea/app/analytics/parconversionanalytic.hpp>
 #include <orea/app/reportwriter.hpp>
 #include <orea/app/structuredanalyticserror.hpp>
+#include <orea/engine/columnarsensitivitystream.hpp>
 #include <orea/engine/parsensitivityanalysis.hpp>
-#include <orea/engine/sensitivityinmemorystream.hpp>
 #include <orea/scenario/deltascenariofactory.hpp>
 #include <orea/scenario/scenario.hpp>
 #include <orea/scenario/shiftscenariogenerator.hpp>
@@ -181,7 +181,7 @@ void ParConversionAnalyticImpl::runAnalytic(const QuantLib::ext::shared_ptr<ore:
             }
         }
 
-        auto ss = QuantLib::ext::make_shared<SensitivityInMemoryStream>(results.begin(), results.end());
+        auto ss = QuantLib::ext::make_shared<ColumnarSensitivityStream>(results.begin(), results.end());
         QuantLib::ext::shared_ptr<InMemoryReport> report = QuantLib::ext::make_shared<InMemoryReport>();
         ReportWriter(inputs_->reportNaString()).writeSensitivityReport(*report, ss, inputs_->parConversionThreshold());
         analytic()->reports()["PARCONVERSION"]["parConversionSensitivity"] = report;
@@ -164,6 +164,7 @@ void PricingAnalyticImpl::runAnalytic(
                     inputs_->refDataManager(), *inputs_->iborFallbackConfig(), true, inputs_->dryRun());
                 LOG("Multi-threaded sensi analysis created");
             }
+            sensiAnalysis->setScenarioResultStore(inputs_->scenarioResultStore());
             // FIXME: Why are these disabled?
             set<RiskFactorKey::KeyType> typesDisabled{RiskFactorKey::KeyType::OptionletVolatility};
             QuantLib::ext::shared_ptr<ParSensitivityAnalysis> parAnalysis = nullptr;
@@ -22,7 +22,9 @@
 #include <orea/app/reportwriter.hpp>
 #include <orea/app/structuredanalyticserror.hpp>
 #include <orea/app/structuredanalyticswarning.hpp>
+#include <orea/cube/incrementalcube.hpp>
 #include <orea/cube/jointnpvcube.hpp>
+#include <orea/cube/quantisedinmemorycube.hpp>
 #include <orea/engine/amcvaluationengine.hpp>
 #include <orea/engine/cptycalculator.hpp>
 #include <orea/engine/mporcalculator.hpp>
@@ -35,6 +37,7 @@
 
 #include <ored/model/crossassetmodelbuilder.hpp>
 #include <ored/portfolio/structuredtradeerror.hpp>
+#include <ored/utilities/profiler.hpp>
 
 using namespace ore::data;
 using namespace boost::filesystem;
@@ -42,6 +45,23 @@ using namespace boost::filesystem;
 namespace ore {
 namespace analytics {
 
+namespace {
+QuantLib::ext::shared_ptr<NPVCube> createNpvCube(const Date& asof, const std::set<std::string>& ids,
+                                                 const std::vector<Date>& dates, Size samples, Size depth,
+                                                 Size quantisationBits, Real quantisationTolerance) {
+    if (quantisationBits == 16)
+        return QuantLib::ext::make_shared<QuantisedInMemoryCube16>(asof, ids, dates, samples, depth,
+                                                                   quantisationTolerance);
+    if (quantisationBits == 8)
+        return QuantLib::ext::make_shared<QuantisedInMemoryCube8>(asof, ids, dates, samples, depth,
+                                                                  quantisationTolerance);
+    QL_REQUIRE(quantisationBits == 0, "cube quantisation bits must be 0, 8 or 16, got " << quantisationBits);
+    if (depth == 1)
+        return QuantLib::ext::make_shared<SinglePrecisionInMemoryCube>(asof, ids, dates, samples, 0.0f);
+    return QuantLib::ext::make_shared<SinglePrecisionInMemoryCubeN>(asof, ids, dates, samples, depth, 0.0f);
+}
+} // namespace
+
 /******************************************************************************
  * XVA Analytic: EXPOSURE, CVA, DVA, FVA, KVA, COLVA, COLLATERALFLOOR, DIM, MVA
  ******************************************************************************/
@@ -147,18 +167,7 @@ void XvaAnalyticImpl::buildScenarioSimMarket() {
             *analytic()->configurations().todaysMarketParams, inputs_->continueOnError(), true, true, false,
             *inputs_->iborFallbackConfig(), false, offsetScenario_);
 
-        // Create a third market used for AMC and Postprocessor, holds a larger simmarket, e.g. default curves
-        offsetSimMarket_ = QuantLib::ext::make_shared<ScenarioSimMarket>(
-            analytic()->market(), offsetSimMarketParams_, QuantLib::ext::make_shared<FixingManager>(inputs_->asof()),
-            configuration, *inputs_->curveConfigs().get(), *analytic()->configurations().todaysMarketParams,
-            inputs_->continueOnError(), true, true, false, *inputs_->iborFallbackConfig(), false, offsetScenario_);
-
-        TLOG("XvaAnalytic: Offset Scenario used in building SimMarket");
-        TLOG("XvaAnalytic: Offset scenario is absolute = " << offsetScenario_->isAbsolute());
-        TLOG("RfKey,OffsetScenarioValue");
-        for (const auto& key : offsetScenario_->keys()) {
-            TLOG(key << " : " << offsetScenario_->get(key));
-        }
+        buildOffsetSimMarket();
     }
 
     TLOG("XvaAnalytic:Finished building Scenario SimMarket");
@@ -174,6 +183,27 @@ void XvaAnalyticImpl::buildScenarioSimMarket() {
     }
 }
 
+void XvaAnalyticImpl::buildOffsetSimMarket() {
+    // Create a third market used for AMC and Postprocessor, holds a larger simmarket, e.g. default curves
+    offsetSimMarket_ = QuantLib::ext::make_shared<ScenarioSimMarket>(
+        analytic()->market(), offsetSimMarketParams_, QuantLib::ext::make_shared<FixingManager>(inputs_->asof()),
+        inputs_->marketConfig("simulation"), *inputs_->curveConfigs().get(),
+        *analytic()->configurations().todaysMarketParams, inputs_->continueOnError(), true, true, false,
+        *inputs_->iborFallbackConfig(), false, offsetScenario_);
+
+    TLOG("XvaAnalytic: Offset Scenario used in building SimMarket");
+    TLOG("XvaAnalytic: Offset scenario is absolute = " << offsetScenario_->isAbsolute());
+    TLOG("RfKey,OffsetScenarioValue");
+    for (const auto& key : offsetScenario_->keys()) {
+        TLOG(key << " : " << offsetScenario_->get(key));
+    }
+}
+
+XvaAnalyticImpl::SimulationResults XvaAnalyticImpl::simulationResults() const {
+    return {analytic()->portfolio(), cube_, nettingSetCube_, cptyCube_,
+            scenarioData_.empty() ? nullptr : *scenarioData_};
+}
+
 void XvaAnalyticImpl::buildScenarioGenerator(const bool continueOnCalibrationError) {
     if (!model_)
         buildCrossAssetModel(continueOnCalibrationError);
@@ -222,19 +252,15 @@ void XvaAnalyticImpl::initCubeDepth() {
 }
 
 void XvaAnalyticImpl::initCube(QuantLib::ext::shared_ptr<NPVCube>& cube, const std::set<std::string>& ids,
-                               Size cubeDepth) {
+                               Size cubeDepth, Size quantisationBits, Real quantisationTolerance) {
 
     LOG("Init cube with depth " << cubeDepth);
 
     for (Size i = 0; i < grid_->valuationDates().size(); ++i)
         DLOG("initCube: grid[" << i << "]=" << io::iso_date(grid_->valuationDates()[i]));
 
-    if (cubeDepth == 1)
-        cube = QuantLib::ext::make_shared<SinglePrecisionInMemoryCube>(inputs_->asof(), ids, grid_->valuationDates(),
-                                                                       samples_, 0.0f);
-    else
-        cube = QuantLib::ext::make_shared<SinglePrecisionInMemoryCubeN>(inputs_->asof(), ids, grid_->valuationDates(),
-                                                                        samples_, cubeDepth, 0.0f);
+    cube = createNpvCube(inputs_->asof(), ids, grid_->valuationDates(), samples_, cubeDepth, quantisationBits,
+                         quantisationTolerance);
 }
 
 void XvaAnalyticImpl::initClassicRun(const QuantLib::ext::shared_ptr<Portfolio>& portfolio) {
@@ -251,10 +277,13 @@ void XvaAnalyticImpl::initClassicRun(const QuantLib::ext::shared_ptr<Portfolio>&
         simMarket_->aggregationScenarioData() = *scenarioData_;
     }
 
-    // We can skip the cube initialization if the mt val engine is used, since it builds its own cubes
+    // the mt val engine writes into this cube as well
+    if (portfolio->size() > 0)
+        initCube(cube_, portfolio->ids(), cubeDepth_, inputs_->cubeQuantisationBits(),
+                 inputs_->cubeQuantisationTolerance());
+
+    // We can skip the cpty cube initialization if the mt val engine is used, since it builds its own cubes
     if (inputs_->nThreads() == 1) {
-        if (portfolio->size() > 0)
-            initCube(cube_, portfolio->ids(), cubeDepth_);
         // not required by any calculators in ore at the moment
         nettingSetCube_ = nullptr;
         // Init counterparty cube for the storage of survival probabilities
@@ -297,17 +326,96 @@ XvaAnalyticImpl::classicRun(const QuantLib::ext::shared_ptr<Portfolio>& portfoli
     CONSOLE("OK");
     ProgressMessage(msg, 1, 1).log();
 
-    // Allocate cubes for the sub-portfolio we are processing here
-    initClassicRun(classicPortfolio_);
+    if (!incrementalClassicRun(classicPortfolio_)) {
+        // Allocate cubes for the sub-portfolio we are processing here
+        initClassicRun(classicPortfolio_);
 
-    // This is where the valuation work is done
-    buildClassicCube(classicPortfolio_);
+        // This is where the valuation work is done
+        buildClassicCube(classicPortfolio_);
+    }
 
     LOG("XVA: classicRun completed");
 
     return classicPortfolio_;
 }
 
+bool XvaAnalyticImpl::incrementalClassicRun(const QuantLib::ext::shared_ptr<Portfolio>& portfolio) {
+
+    const NPVCubeWithMetaData& previous = inputs_->previousCube();
+    if (!previous.cube || portfolio->size() == 0)
+        return false;
+
+    // check that the previous cube was generated with the same scenarios and has the same layout
+
+    initCubeDepth();
+    auto scenarioGeneratorData = analytic()->configurations().scenarioGeneratorData;
+    std::string reason;
+    if (previous.cube->asof() != inputs_->asof())
+        reason = "asof date differs";
+    else if (previous.cube->dates() != grid_->valuationDates())
+        reason = "valuation dates differ";
+    else if (previous.cube->samples() != samples_)
+        reason = "number of samples differs";
+    else if (previous.cube->depth() != cubeDepth_)
+        reason = "cube depth differs";
+    else if (!previous.scenarioGeneratorData ||
+             previous.scenarioGeneratorData->toXMLString() != scenarioGeneratorData->toXMLString())
+        reason = "scenario generator data missing or different";
+    else if (!previous.storeFlows || *previous.storeFlows != inputs_->storeFlows())
+        reason = "storeFlows missing or different";
+    else if (!previous.storeCreditStateNPVs || *previous.storeCreditStateNPVs != inputs_->storeCreditStateNPVs())
+        reason = "storeCreditStateNPVs missing or different";
+    else if (previous.tradeHashes.empty())
+        reason = "trade hashes missing";
+    else if (inputs_->storeSurvivalProbabilities())
+        reason = "storeSurvivalProbabilities is not supported";
+
+    if (!reason.empty()) {
+        WLOG("XVA: previous cube can not be reused (" << reason << "), run full simulation");
+        return false;
+    }
+
+    // determine the new or amended trades, trades missing in the previous cube are treated as new
+
+    std::set<std::string> changed = changedTrades(previous.tradeHashes, tradeHashes(*portfolio));
+    for (auto const& [tradeId, trade] : portfolio->trades()) {
+        if (previous.cube->idsAndIndexes().count(tradeId) == 0)
+            changed.insert(tradeId);
+    }
+
+    // without a previous market cube we need to run the simulation for at least one trade to get the scenario data
+    if (changed.empty() && scenarioData_.empty() && !inputs_->previousMktCube())
+        changed.insert(portfolio->trades().begin()->first);
+
+    LOG("XVA: incremental run, reuse previous cube for " << portfolio->size() - changed.size() << " trades, simulate "
+                                                          << changed.size() << " new or amended trades");
+
+    QuantLib::ext::shared_ptr<NPVCube> update;
+    if (!changed.empty()) {
+        auto changedPortfolio = QuantLib::ext::make_shared<Portfolio>(inputs_->buildFailedTrades());
+        for (auto const& tradeId : changed)
+            changedPortfolio->add(portfolio->get(tradeId));
+        initClassicRun(changedPortfolio);
+        buildClassicCube(changedPortfolio);
+        update = cube_;
+    } else {
+        if (scenarioData_.empty())
+            scenarioData_.linkTo(inputs_->previousMktCube());
+        nettingSetCube_ = nullptr;
+        cptyCube_ = nullptr;
+    }
+
+    // the spliced cube is quantised like a cube of a full run
+    cube_ = spliceCube(previous.cube, update, portfolio->ids(),
+                       [this](const Date& asof, const std::set<std::string>& ids, const std::vector<Date>& dates,
+                              Size samples, Size depth) {
+                           return createNpvCube(asof, ids, dates, samples, depth, inputs_->cubeQuantisationBits(),
+                                                inputs_->cubeQuantisationTolerance());
+                       });
+
+    return true;
+}
+
 void XvaAnalyticImpl::buildClassicCube(const QuantLib::ext::shared_ptr<Portfolio>& portfolio) {
 
     LOG("XVA::buildCube");
@@ -374,16 +482,6 @@ void XvaAnalyticImpl::buildClassicCube(const QuantLib::ext::shared_ptr<Portfolio
         /* TODO we assume no netting output cube is needed. Currently there are no valuation calculators in ore that
          * require this cube. */
 
-        auto cubeFactory = [this](const QuantLib::Date& asof, const std::set<std::string>& ids,
-                                  const std::vector<QuantLib::Date>& dates,
-                                  const Size samples) -> QuantLib::ext::shared_ptr<NPVCube> {
-            if (cubeDepth_ == 1)
-                return QuantLib::ext::make_shared<SinglePrecisionInMemoryCube>(asof, ids, dates, samples, 0.0f);
-            else
-                return QuantLib::ext::make_shared<SinglePrecisionInMemoryCubeN>(asof, ids, dates, samples, cubeDepth_,
-                                                                                0.0f);
-        };
-
         std::function<QuantLib::ext::shared_ptr<NPVCube>(const QuantLib::Date&, const std::set<std::string>&,
                                                          const std::vector<QuantLib::Date>&, const QuantLib::Size)>
             cptyCubeFactory;
@@ -404,9 +502,11 @@ void XvaAnalyticImpl::buildClassicCube(const QuantLib::ext::shared_ptr<Portfolio
             inputs_->simulationPricingEngine(), inputs_->curveConfigs().get(),
             analytic()->configurations().todaysMarketParams, inputs_->marketConfig("simulation"),
             analytic()->configurations().simMarketParams, false, false, QuantLib::ext::make_shared<ScenarioFilter>(),
-            inputs_->refDataManager(), *inputs_->iborFallbackConfig(), true, false, false, cubeFactory, {},
-            cptyCubeFactory, "xva-simulation", offsetScenario_);
+            inputs_->refDataManager(), *inputs_->iborFallbackConfig(), true, false, false, {}, {}, cptyCubeFactory,
+            "xva-simulation", offsetScenario_);
 
+        // the threads write into disjoint id ranges of the preallocated cube, so no joint cube is needed
+        engine.setOutputCube(cube_);
         engine.setAggregationScenarioData(*scenarioData_);
         engine.registerProgressIndicator(progressBar);
         engine.registerProgressIndicator(progressLog);
@@ -414,8 +514,6 @@ void XvaAnalyticImpl::buildClassicCube(const QuantLib::ext::shared_ptr<Portfolio
         engine.buildCube(portfolio, calculators, cptyCalculators,
                          analytic()->configurations().scenarioGeneratorData->withMporStickyDate());
 
-        cube_ = QuantLib::ext::make_shared<JointNPVCube>(engine.outputCubes(), portfolio->ids());
-
         if (inputs_->storeSurvivalProbabilities())
             cptyCube_ = QuantLib::ext::make_shared<JointNPVCube>(
                 engine.outputCptyCubes(), portfolio->counterparties(), false,
@@ -463,7 +561,7 @@ void XvaAnalyticImpl::buildAmcPortfolio() {
     auto factory = amcEngineFactory(model_, simDates);
 
     LOG("buildAmcPortfolio: Load Portfolio");
-    QuantLib::ext::shared_ptr<Portfolio> portfolio = inputs_->portfolio();
+    QuantLib::ext::shared_ptr<Portfolio> portfolio = simulationPortfolio();
 
     LOG("Build Portfolio with AMC Engine factory and select amc-enabled trades")
     amcPortfolio_ = QuantLib::ext::make_shared<Portfolio>();
@@ -487,6 +585,22 @@ void XvaAnalyticImpl::buildAmcPortfolio() {
     LOG("XVA: buildAmcPortfolio completed");
 }
 
+const QuantLib::ext::shared_ptr<Portfolio>& XvaAnalyticImpl::simulationPortfolio() {
+    if (simulationPortfolio_)
+        return simulationPortfolio_;
+    if (inputs_->shardCount() <= 1) {
+        simulationPortfolio_ = inputs_->portfolio();
+    } else {
+        simulationPortfolio_ = QuantLib::ext::make_shared<Portfolio>(inputs_->buildFailedTrades());
+        for (auto const& id : shardIds(inputs_->portfolio()->ids(), inputs_->shardIndex(), inputs_->shardCount()))
+            simulationPortfolio_->add(inputs_->portfolio()->get(id));
+        LOG("Simulation portfolio restricted to shard " << inputs_->shardIndex() << " of " << inputs_->shardCount()
+                                                        << ": " << simulationPortfolio_->size() << " out of "
+                                                        << inputs_->portfolio()->size() << " trades");
+    }
+    return simulationPortfolio_;
+}
+
 void XvaAnalyticImpl::amcRun(bool doClassicRun) {
 
     LOG("XVA: amcRun");
@@ -507,7 +621,8 @@ void XvaAnalyticImpl::amcRun(bool doClassicRun) {
     auto progressLog = QuantLib::ext::make_shared<ProgressLog>("XVA: Building AMC Cube...", 100, oreSeverity::notice);
 
     if (inputs_->nThreads() == 1) {
-        initCube(amcCube_, amcPortfolio_->ids(), cubeDepth_);
+        initCube(amcCube_, amcPortfolio_->ids(), cubeDepth_, inputs_->cubeQuantisationBits(),
+                 inputs_->cubeQuantisationTolerance());
         ext::shared_ptr<ore::data::Market> market =
             offsetScenario_ == nullptr ? analytic()->market() : offsetSimMarket_;
 
@@ -524,11 +639,8 @@ void XvaAnalyticImpl::amcRun(bool doClassicRun) {
         auto cubeFactory = [this](const QuantLib::Date& asof, const std::set<std::string>& ids,
                                   const std::vector<QuantLib::Date>& dates,
                                   const Size samples) -> QuantLib::ext::shared_ptr<NPVCube> {
-            if (cubeDepth_ == 1)
-                return QuantLib::ext::make_shared<SinglePrecisionInMemoryCube>(asof, ids, dates, samples, 0.0f);
-            else
-                return QuantLib::ext::make_shared<SinglePrecisionInMemoryCubeN>(asof, ids, dates, samples, cubeDepth_,
-                                                                                0.0f);
+            return createNpvCube(asof, ids, dates, samples, cubeDepth_, inputs_->cubeQuantisationBits(),
+                                 inputs_->cubeQuantisationTolerance());
         };
 
         auto simMarketParams =
@@ -560,6 +672,7 @@ void XvaAnalyticImpl::amcRun(bool doClassicRun) {
 }
 
 void XvaAnalyticImpl::runPostProcessor() {
+    ScopedProfileTimer profileTimer("post process");
     QuantLib::ext::shared_ptr<NettingSetManager> netting = inputs_->nettingSetManager();
     QuantLib::ext::shared_ptr<CollateralBalances> balances = inputs_->collateralBalances();
     map<string, bool> analytics;
@@ -626,7 +739,7 @@ void XvaAnalyticImpl::runPostProcessor() {
             dimCalculator_ = QuantLib::ext::make_shared<RegressionDynamicInitialMarginCalculator>(
                 inputs_, analytic()->portfolio(), cube_, cubeInterpreter_, *scenarioData_, dimQuantile,
                 dimHorizonCalendarDays, dimRegressionOrder, dimRegressors, dimLocalRegressionEvaluations,
-                dimLocalRegressionBandwidth, currentIM);
+                dimLocalRegressionBandwidth, currentIM, inputs_->nThreads());
         } else {
             LOG("dim calculator not set, create FlatDynamicInitialMarginCalculator");
             dimCalculator_ = QuantLib::ext::make_shared<FlatDynamicInitialMarginCalculator>(
@@ -669,11 +782,13 @@ void XvaAnalyticImpl::runAnalytic(const QuantLib::ext::shared_ptr<ore::data::InM
             inputs_->amcPricingEngine(), inputs_->crossAssetModelData(), inputs_->scenarioGeneratorData(),
             inputs_->portfolio(), inputs_->marketConfig("simulation"), inputs_->marketConfig("simulation"),
             inputs_->xvaCgSensiScenarioData(), inputs_->refDataManager(), *inputs_->iborFallbackConfig(),
-            inputs_->xvaCgBumpSensis(), inputs_->xvaCgUseExternalComputeDevice(),
-            inputs_->xvaCgExternalDeviceCompatibilityMode(), inputs_->xvaCgUseDoublePrecisionForExternalCalculation(),
-            inputs_->xvaCgExternalComputeDevice(), true, true);
+            inputs_->dvaAnalytic() ? inputs_->dvaName() : std::string(), inputs_->xvaCgBumpSensis(),
+            inputs_->xvaCgUseExternalComputeDevice(), inputs_->xvaCgExternalDeviceCompatibilityMode(),
+            inputs_->xvaCgUseDoublePrecisionForExternalCalculation(), inputs_->xvaCgExternalComputeDevice(), true, true);
 
         analytic()->reports()["XVA"]["xvacg-exposure"] = engine.exposureReport();
+        analytic()->reports()["XVA"]["xvacg-xva"] = engine.xvaReport();
+        // the report keeps its name, it contains the DVA sensitivities as well if the DVA is computed
         if (inputs_->xvaCgSensiScenarioData())
             analytic()->reports()["XVA"]["xvacg-cva-sensi-scenario"] = engine.sensiReport();
         return;
@@ -688,16 +803,25 @@ void XvaAnalyticImpl::runAnalytic(const QuantLib::ext::shared_ptr<ore::data::InM
     if (runTypes.find("XVA") != runTypes.end() || runTypes.empty())
         runXva_ = true;
 
+    QL_REQUIRE(!runSimulation_ || !runXva_ || inputs_->shardCount() <= 1,
+               "XVA analytic: a sharded simulation (shardCount = "
+                   << inputs_->shardCount()
+                   << ") produces a partial cube, run EXPOSURE only and XVA on the merged cube files");
+
     Settings::instance().evaluationDate() = inputs_->asof();
     ObservationMode::instance().setMode(inputs_->exposureObservationModel());
 
-    const string msg = "XVA: Build Today's Market";
-    LOG(msg);
-    CONSOLEW(msg);
-    ProgressMessage(msg, 0, 1).log();
-    analytic()->buildMarket(loader);
-    CONSOLE("OK");
-    ProgressMessage(msg, 1, 1).log();
+    if (analytic()->market()) {
+        LOG("XVA: Today's market was set by the caller, skip building it");
+    } else {
+        const string msg = "XVA: Build Today's Market";
+        LOG(msg);
+        CONSOLEW(msg);
+        ProgressMessage(msg, 0, 1).log();
+        analytic()->buildMarket(loader);
+        CONSOLE("OK");
+        ProgressMessage(msg, 1, 1).log();
+    }
 
     grid_ = analytic()->configurations().scenarioGeneratorData->getGrid();
     cubeInterpreter_ = QuantLib::ext::make_shared<CubeInterpretation>(
@@ -729,7 +853,7 @@ void XvaAnalyticImpl::runAnalytic(const QuantLib::ext::shared_ptr<ore::data::InM
             buildAmcPortfolio();
 
             // Build the residual portfolio for the classic cube generation, i.e. strip out the AMC part
-            for (auto const& [tradeId, trade] : inputs_->portfolio()->trades()) {
+            for (auto const& [tradeId, trade] : simulationPortfolio()->trades()) {
                 if (inputs_->amcTradeTypes().find(trade->tradeType()) == inputs_->amcTradeTypes().end())
                     residualPortfolio->add(trade);
             }
@@ -740,7 +864,7 @@ void XvaAnalyticImpl::runAnalytic(const QuantLib::ext::shared_ptr<ore::data::InM
             doAmcRun = !amcPortfolio_->trades().empty();
             doClassicRun = !residualPortfolio->trades().empty();
         } else {
-            for (const auto& [tradeId, trade] : inputs_->portfolio()->trades())
+            for (const auto& [tradeId, trade] : simulationPortfolio()->trades())
                 residualPortfolio->add(trade);
         }
 
@@ -775,6 +899,11 @@ void XvaAnalyticImpl::runAnalytic(const QuantLib::ext::shared_ptr<ore::data::InM
 
         LOG("NPV cube generation completed");
 
+        // the netting set values of a shard cover part of the netting set's trades only and can not be merged
+        QL_REQUIRE(inputs_->shardCount() <= 1 || !nettingSetCube_,
+                   "XVA analytic: a sharded simulation (shardCount = "
+                       << inputs_->shardCount() << ") does not support netting set cubes, run without sharding");
+
         /***********************************************************************
          * We may have two non-empty portfolios to be merged for post processing
          ***********************************************************************/
@@ -787,11 +916,25 @@ void XvaAnalyticImpl::runAnalytic(const QuantLib::ext::shared_ptr<ore::data::InM
         for (const auto& [tradeId, trade] : amcPortfolio_->trades())
             newPortfolio->add(trade);
         LOG("Total portfolio size " << newPortfolio->size());
-        if (newPortfolio->size() < inputs_->portfolio()->size()) {
-            ALOG("input portfolio size is " << inputs_->portfolio()->size() << ", but we have built only "
+        if (newPortfolio->size() < simulationPortfolio()->size()) {
+            ALOG("input portfolio size is " << simulationPortfolio()->size() << ", but we have built only "
                                             << newPortfolio->size() << " trades");
         }
         analytic()->setPortfolio(newPortfolio);
+    } else if (reusedSimulationResults_.cube) {
+
+        // reuse the portfolio and cubes of a previous run, the post processor only needs the trades' static data
+
+        LOG("Skip cube generation, reuse the simulation results of a previous run for XVA");
+        QL_REQUIRE(reusedSimulationResults_.portfolio && reusedSimulationResults_.scenarioData,
+                   "XVA analytic: reused simulation results require a portfolio and scenario data");
+        analytic()->setPortfolio(reusedSimulationResults_.portfolio);
+        cube_ = reusedSimulationResults_.cube;
+        scenarioData_.linkTo(reusedSimulationResults_.scenarioData);
+        nettingSetCube_ = reusedSimulationResults_.nettingSetCube;
+        cptyCube_ = reusedSimulationResults_.cptyCube;
+        if (offsetScenario_)
+            buildOffsetSimMarket();
     } else { // runSimulation_
 
         // build the portfolio linked to today's market
@@ -811,6 +954,8 @@ void XvaAnalyticImpl::runAnalytic(const QuantLib::ext::shared_ptr<ore::data::InM
             nettingSetCube_ = inputs_->nettingSetCube();
         if (inputs_->cptyCube())
             cptyCube_ = inputs_->cptyCube();
+        if (offsetScenario_)
+            buildOffsetSimMarket();
         CONSOLE("OK");
         ProgressMessage(msg, 1, 1).log();
     }
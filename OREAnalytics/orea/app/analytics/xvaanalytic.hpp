@@ -46,23 +46,42 @@ public:
 
     void checkConfigurations(const QuantLib::ext::shared_ptr<Portfolio>& portfolio);
 
+    //! Portfolio, cubes and scenario data produced by the EXPOSURE run
+    struct SimulationResults {
+        QuantLib::ext::shared_ptr<Portfolio> portfolio;
+        QuantLib::ext::shared_ptr<NPVCube> cube, nettingSetCube, cptyCube;
+        QuantLib::ext::shared_ptr<AggregationScenarioData> scenarioData;
+    };
+    SimulationResults simulationResults() const;
+    /*! Post-process the given simulation results in a run without EXPOSURE instead of the input cubes. The results
+        must stem from a run with the same scenario generator data, simulation market and portfolio, the offset
+        scenario of this analytic must only affect the market used by the post processor. */
+    void setSimulationResults(const SimulationResults& results) { reusedSimulationResults_ = results; }
+
 protected:
     QuantLib::ext::shared_ptr<ore::data::EngineFactory> engineFactory() override;
     void buildScenarioSimMarket();
+    void buildOffsetSimMarket();
     void buildCrossAssetModel(bool continueOnError);
     void buildScenarioGenerator(bool continueOnError);
 
     void initCubeDepth();
-    void initCube(QuantLib::ext::shared_ptr<NPVCube>& cube, const std::set<std::string>& ids, Size cubeDepth);
+    void initCube(QuantLib::ext::shared_ptr<NPVCube>& cube, const std::set<std::string>& ids, Size cubeDepth,
+                  Size quantisationBits = 0, Real quantisationTolerance = 0.0);
 
     void initClassicRun(const QuantLib::ext::shared_ptr<Portfolio>& portfolio);
     void buildClassicCube(const QuantLib::ext::shared_ptr<Portfolio>& portfolio);
     QuantLib::ext::shared_ptr<Portfolio> classicRun(const QuantLib::ext::shared_ptr<Portfolio>& portfolio);
+    /*! Reuse the previous cube for unchanged trades and simulate new or amended trades only, returns false if
+        the previous cube can not be reused, in which case nothing is done */
+    bool incrementalClassicRun(const QuantLib::ext::shared_ptr<Portfolio>& portfolio);
 
     QuantLib::ext::shared_ptr<EngineFactory>
     amcEngineFactory(const QuantLib::ext::shared_ptr<QuantExt::CrossAssetModel>& cam, const std::vector<Date>& grid);
     void buildAmcPortfolio();
     void amcRun(bool doClassicRun);
+    //! the input portfolio, restricted to the configured simulation shard
+    const QuantLib::ext::shared_ptr<Portfolio>& simulationPortfolio();
 
     void runPostProcessor();
 
@@ -74,7 +93,7 @@ protected:
     QuantLib::ext::shared_ptr<EngineFactory> engineFactory_;
     QuantLib::ext::shared_ptr<CrossAssetModel> model_;
     QuantLib::ext::shared_ptr<ScenarioGenerator> scenarioGenerator_;
-    QuantLib::ext::shared_ptr<Portfolio> amcPortfolio_, classicPortfolio_;
+    QuantLib::ext::shared_ptr<Portfolio> amcPortfolio_, classicPortfolio_, simulationPortfolio_;
     QuantLib::ext::shared_ptr<NPVCube> cube_, nettingSetCube_, cptyCube_, amcCube_;
     QuantLib::RelinkableHandle<AggregationScenarioData> scenarioData_;
     QuantLib::ext::shared_ptr<CubeInterpretation> cubeInterpreter_;
@@ -82,6 +101,7 @@ protected:
     QuantLib::ext::shared_ptr<PostProcess> postProcess_;
     QuantLib::ext::shared_ptr<Scenario> offsetScenario_;
     QuantLib::ext::shared_ptr<ScenarioSimMarketParameters> offsetSimMarketParams_;
+    SimulationResults reusedSimulationResults_;
     Size cubeDepth_ = 0;
     QuantLib::ext::shared_ptr<DateGrid> grid_;
     Size samples_ = 0;
@@ -21,14 +21,80 @@
 #include <orea/app/structuredanalyticserror.hpp>
 #include <orea/app/structuredanalyticswarning.hpp>
 #include <orea/cube/cube_io.hpp>
+#include <orea/cube/npvcube.hpp>
+#include <orea/engine/observationmode.hpp>
+#include <orea/scenario/aggregationscenariodata.hpp>
 #include <orea/scenario/clonescenariofactory.hpp>
 #include <orea/scenario/scenariosimmarket.hpp>
 #include <orea/scenario/sensitivityscenariogenerator.hpp>
 #include <orea/scenario/stressscenariogenerator.hpp>
+#include <ored/marketdata/clonedloader.hpp>
+#include <ored/marketdata/todaysmarket.hpp>
+#include <ored/portfolio/portfolio.hpp>
 #include <ored/report/utilities.hpp>
+
+#include <atomic>
+#include <future>
+
 namespace ore {
 namespace analytics {
 
+namespace {
+
+// Read only view on a cube shared by several post processing threads, any write is an error
+class ReadOnlyNPVCube : public NPVCube {
+public:
+    explicit ReadOnlyNPVCube(const QuantLib::ext::shared_ptr<NPVCube>& cube) : cube_(cube) {}
+    Size numIds() const override { return cube_->numIds(); }
+    Size numDates() const override { return cube_->numDates(); }
+    Size samples() const override { return cube_->samples(); }
+    Size depth() const override { return cube_->depth(); }
+    const std::map<std::string, Size>& idsAndIndexes() const override { return cube_->idsAndIndexes(); }
+    const std::vector<QuantLib::Date>& dates() const override { return cube_->dates(); }
+    QuantLib::Date asof() const override { return cube_->asof(); }
+    Real getT0(Size id, Size depth = 0) const override { return cube_->getT0(id, depth); }
+    void setT0(Real, Size, Size = 0) override { QL_FAIL("ReadOnlyNPVCube: setT0() not allowed"); }
+    Real get(Size id, Size date, Size sample, Size depth = 0) const override {
+        return cube_->get(id, date, sample, depth);
+    }
+    void set(Real, Size, Size, Size, Size = 0) override { QL_FAIL("ReadOnlyNPVCube: set() not allowed"); }
+    void remove(Size) override { QL_FAIL("ReadOnlyNPVCube: remove() not allowed"); }
+    void remove(Size, Size) override { QL_FAIL("ReadOnlyNPVCube: remove() not allowed"); }
+
+private:
+    QuantLib::ext::shared_ptr<NPVCube> cube_;
+};
+
+/* The copy for one post processing thread. The cubes are wrapped in read only views, the post processor writes
+   its results to cubes of its own. The portfolio container and the scenario data are copied, the latter is an
+   observable and linking a handle to it registers an observer. The trades themselves are shared, the post processor
+   only reads their static data (ids, envelopes, maturities) and never prices them. */
+XvaAnalyticImpl::SimulationResults threadCopy(const XvaAnalyticImpl::SimulationResults& results) {
+    auto readOnly = [](const QuantLib::ext::shared_ptr<NPVCube>& cube) -> QuantLib::ext::shared_ptr<NPVCube> {
+        return cube ? QuantLib::ext::make_shared<ReadOnlyNPVCube>(cube) : nullptr;
+    };
+    XvaAnalyticImpl::SimulationResults copy;
+    copy.portfolio = QuantLib::ext::make_shared<Portfolio>();
+    for (auto const& [id, trade] : results.portfolio->trades())
+        copy.portfolio->add(trade);
+    copy.cube = readOnly(results.cube);
+    copy.nettingSetCube = readOnly(results.nettingSetCube);
+    copy.cptyCube = readOnly(results.cptyCube);
+    if (const auto& sd = results.scenarioData) {
+        auto scenarioData =
+            QuantLib::ext::make_shared<InMemoryAggregationScenarioData>(sd->dimDates(), sd->dimSamples());
+        for (auto const& [type, qualifier] : sd->keys()) {
+            for (Size d = 0; d < sd->dimDates(); ++d)
+                for (Size s = 0; s < sd->dimSamples(); ++s)
+                    scenarioData->set(d, s, sd->get(d, s, type, qualifier), type, qualifier);
+        }
+        copy.scenarioData = scenarioData;
+    }
+    return copy;
+}
+
+} // namespace
+
 XvaSensitivityAnalyticImpl::XvaSensitivityAnalyticImpl(const QuantLib::ext::shared_ptr<InputParameters>& inputs)
     : Analytic::Impl(inputs) {
     setLabel(LABEL);
@@ -89,64 +155,149 @@ void XvaSensitivityAnalyticImpl::runSensitivity(
     const QuantLib::ext::shared_ptr<SensitivityScenarioGenerator>& scenarioGenerator,
     const QuantLib::ext::shared_ptr<ore::data::InMemoryLoader>& loader) {
 
-    std::map<std::string, std::vector<QuantLib::ext::shared_ptr<ore::data::InMemoryReport>>> xvaReports;
-    for (size_t i = 0; i < scenarioGenerator->samples(); ++i) {
-        auto scenario = scenarioGenerator->next(inputs_->asof());
-        auto desc = scenarioGenerator->scenarioDescriptions()[i];
-        const auto label = scenario->label();
-        QuantLib::ext::shared_ptr<ore::data::InMemoryReport> descReport =
-            QuantLib::ext::make_shared<ore::data::InMemoryReport>();
-
-        double shiftSize1 = 0.0;
-        auto itShiftSize1 = scenarioGenerator->shiftSizes().find(desc.key1());
-        if (itShiftSize1 != scenarioGenerator->shiftSizes().end()){
-            shiftSize1 = (itShiftSize1->second);
-        }
-        double shiftSize2 = 0.0;
-        auto itShiftSize2 = scenarioGenerator->shiftSizes().find(desc.key2());
-        if (itShiftSize2 != scenarioGenerator->shiftSizes().end()) {
-            shiftSize2 = (itShiftSize2->second);
-        }
-        descReport->addColumn("Type", string());
-        descReport->addColumn("IsPar", string());
-        descReport->addColumn("Factor_1", string());
-        descReport->addColumn("ShiftSize_1", double(), 8);
-        descReport->addColumn("Factor_2", string());
-        descReport->addColumn("ShiftSize_2", double(), 8);
-        descReport->addColumn("Currency", string());
-        descReport->next();
-        descReport->add(ore::data::to_string(desc.type()));
-        descReport->add("false");
-        descReport->add(desc.factor1());
-        descReport->add(shiftSize1);
-        descReport->add(desc.factor2());
-        descReport->add(shiftSize2);
-        descReport->add(inputs_->baseCurrency());
-        descReport->end();
-        
+    // draw all scenarios up front, so that they can be processed in any order
+
+    Size n = scenarioGenerator->samples();
+    std::vector<QuantLib::ext::shared_ptr<Scenario>> scenarios(n);
+    std::vector<QuantLib::ext::shared_ptr<ore::data::InMemoryReport>> descReports(n);
+    for (Size i = 0; i < n; ++i) {
+        scenarios[i] = scenarioGenerator->next(inputs_->asof());
+        descReports[i] = descriptionReport(scenarioGenerator, i);
+    }
+
+    /* A scenario that does not shift any risk factor of the exposure simulation market leaves the model
+       calibration, the simulated paths and the cube unchanged. For these scenarios we reuse the portfolio and cube
+       of the base run and only run the post processor, which sees the shift via its offset sim market. AMC builds
+       its pricing engines on the offset sim market, so we do not reuse cubes in that case. */
+
+    std::vector<Size> fullRuns, postProcessRuns;
+    Size baseIndex = Null<Size>();
+    bool reuse = inputs_->xvaSensiReuseSimulation() && !inputs_->amc() && !inputs_->amcCg();
+    for (Size i = 0; i < n; ++i) {
+        const auto& desc = scenarioGenerator->scenarioDescriptions()[i];
+        if (desc.type() == ShiftScenarioGenerator::ScenarioDescription::Type::Base && baseIndex == Null<Size>())
+            baseIndex = i;
+        if (reuse && desc.type() != ShiftScenarioGenerator::ScenarioDescription::Type::Base &&
+            !shiftsSimulatedRiskFactor(desc))
+            postProcessRuns.push_back(i);
+        else
+            fullRuns.push_back(i);
+    }
+    if (baseIndex == Null<Size>()) {
+        fullRuns.insert(fullRuns.end(), postProcessRuns.begin(), postProcessRuns.end());
+        std::sort(fullRuns.begin(), fullRuns.end());
+        postProcessRuns.clear();
+    }
+    LOG("XvaSensitivityAnalytic: " << fullRuns.size() << " scenarios require a simulation, " << postProcessRuns.size()
+                                   << " scenarios reuse the base cube");
+
+    std::vector<std::map<std::string, QuantLib::ext::shared_ptr<ore::data::InMemoryReport>>> scenarioReports(n);
+    XvaAnalyticImpl::SimulationResults baseResults;
+
+    auto runScenario = [this, &scenarios, &descReports, &scenarioReports,
+                        &loader](Size i, const QuantLib::ext::shared_ptr<ore::data::Market>& market,
+                                 const QuantLib::ext::shared_ptr<ore::data::Loader>& marketLoader,
+                                 const XvaAnalyticImpl::SimulationResults* simulationResults) {
+        const auto label = scenarios[i]->label();
         try {
             DLOG("Calculate XVA for scenario " << label);
             CONSOLE("XVA_SENSITIVITY: Apply scenario " << label);
             auto newAnalytic = ext::make_shared<XvaAnalytic>(
-                inputs_, (label == "BASE" ? nullptr : scenario),
+                inputs_, (label == "BASE" ? nullptr : scenarios[i]),
                 (label == "BASE" ? nullptr : analytic()->configurations().simMarketParams));
-            CONSOLE("XVA_SENSITIVITY: Calculate Exposure and XVA")
-            newAnalytic->runAnalytic(loader, {"EXPOSURE", "XVA"});
+            newAnalytic->setMarket(market);
+            newAnalytic->setLoader(marketLoader);
+            auto impl = static_cast<XvaAnalyticImpl*>(newAnalytic->impl().get());
+            std::set<std::string> runTypes = {"EXPOSURE", "XVA"};
+            if (simulationResults) {
+                impl->setSimulationResults(*simulationResults);
+                runTypes = {"XVA"};
+            }
+            CONSOLE("XVA_SENSITIVITY: Calculate " << (simulationResults ? "XVA" : "Exposure and XVA"));
+            newAnalytic->runAnalytic(loader, runTypes);
             // Collect exposure and xva reports
             for (auto& [name, rpt] : newAnalytic->reports()["XVA"]) {
                 // add scenario column to report and copy it, concat it later
                 if (boost::starts_with(name, "exposure") || boost::starts_with(name, "xva")) {
                     DLOG("Save and extend report " << name);
-                    xvaReports[name].push_back(addColumnsToExisitingReport(descReport, rpt));
+                    scenarioReports[i][name] = addColumnsToExisitingReport(descReports[i], rpt);
                 }
             }
-            // writeCubes(label, newAnalytic);
+            return impl->simulationResults();
         } catch (const std::exception& e) {
             StructuredAnalyticsErrorMessage("XvaSensitivity", "XVACalc",
                                             "Error during XVA calc under scenario " + label + ", got " + e.what() +
                                                 ". Skip it")
                 .log();
         }
+        return XvaAnalyticImpl::SimulationResults();
+    };
+
+    /* Scenarios requiring a simulation are run one after another on today's market built above. They all use the
+       same scenario generator data, i.e. the same seed and therefore common random numbers. Each run can be
+       parallelised over the portfolio by the multithreaded valuation engine. */
+
+    for (auto i : fullRuns) {
+        auto results = runScenario(i, analytic()->market(), analytic()->loader(), nullptr);
+        if (i == baseIndex)
+            baseResults = results;
+    }
+
+    if (!postProcessRuns.empty() && !baseResults.cube) {
+        WLOG("XvaSensitivityAnalytic: base run did not produce a cube, run the full simulation for all scenarios");
+        for (auto i : postProcessRuns)
+            runScenario(i, analytic()->market(), analytic()->loader(), nullptr);
+        postProcessRuns.clear();
+    }
+
+    // Post-processing only scenarios use the base cube and are processed in parallel if possible
+
+    Size nThreads = std::min<Size>(inputs_->nThreads(), postProcessRuns.size());
+#ifndef QL_ENABLE_SESSIONS
+    if (nThreads > 1)
+        DLOG("XvaSensitivityAnalytic: post processing runs in a single thread, requires QL_ENABLE_SESSIONS = ON");
+    nThreads = 1;
+#endif
+    if (nThreads <= 1) {
+        for (auto i : postProcessRuns)
+            runScenario(i, analytic()->market(), analytic()->loader(), &baseResults);
+    } else {
+        LOG("XvaSensitivityAnalytic: post process " << postProcessRuns.size() << " scenarios using " << nThreads
+                                                    << " threads");
+        // each thread builds today's market on its own clone of the market data
+        std::vector<QuantLib::ext::shared_ptr<ore::data::ClonedLoader>> loaders;
+        for (Size t = 0; t < nThreads; ++t)
+            loaders.push_back(QuantLib::ext::make_shared<ore::data::ClonedLoader>(inputs_->asof(), analytic()->loader()));
+        std::vector<XvaAnalyticImpl::SimulationResults> threadResults;
+        for (Size t = 0; t < nThreads; ++t)
+            threadResults.push_back(threadCopy(baseResults));
+        ObservationMode::Mode obsMode = ObservationMode::instance().mode();
+        std::atomic<Size> next(0);
+        std::vector<std::future<void>> results;
+        for (Size t = 0; t < nThreads; ++t) {
+            results.push_back(std::async(std::launch::async, [this, t, obsMode, &next, &loaders, &postProcessRuns,
+                                                              &threadResults, &runScenario]() {
+                // set thread local singletons
+                Settings::instance().evaluationDate() = inputs_->asof();
+                ObservationMode::instance().setMode(obsMode);
+                auto market = QuantLib::ext::make_shared<ore::data::TodaysMarket>(
+                    inputs_->asof(), analytic()->configurations().todaysMarketParams, loaders[t],
+                    analytic()->configurations().curveConfig, inputs_->continueOnError(), true,
+                    inputs_->lazyMarketBuilding(), inputs_->refDataManager(), false, *inputs_->iborFallbackConfig());
+                for (Size j = next++; j < postProcessRuns.size(); j = next++)
+                    runScenario(postProcessRuns[j], market, loaders[t], &threadResults[t]);
+            }));
+        }
+        for (auto& r : results)
+            r.get();
+    }
+
+    // concatenate the reports in scenario order
+
+    std::map<std::string, std::vector<QuantLib::ext::shared_ptr<ore::data::InMemoryReport>>> xvaReports;
+    for (Size i = 0; i < n; ++i) {
+        for (auto& [name, rpt] : scenarioReports[i])
+            xvaReports[name].push_back(rpt);
     }
     for (auto& [name, reports] : xvaReports) {
         auto report = concatenateReports(reports);
@@ -156,6 +307,52 @@ void XvaSensitivityAnalyticImpl::runSensitivity(
     }
 }
 
+bool XvaSensitivityAnalyticImpl::shiftsSimulatedRiskFactor(
+    const ShiftScenarioGenerator::ScenarioDescription& desc) const {
+    const auto& simParams = inputs_->exposureSimMarketParams();
+    QL_REQUIRE(simParams, "XvaSensitivityAnalytic: exposure sim market parameters not set");
+    for (auto const& key : {desc.key1(), desc.key2()}) {
+        if (key.keytype != RiskFactorKey::KeyType::None && simParams->hasParamsName(key.keytype, key.name))
+            return true;
+    }
+    return false;
+}
+
+QuantLib::ext::shared_ptr<ore::data::InMemoryReport> XvaSensitivityAnalyticImpl::descriptionReport(
+    const QuantLib::ext::shared_ptr<SensitivityScenarioGenerator>& scenarioGenerator, Size i) const {
+    auto desc = scenarioGenerator->scenarioDescriptions()[i];
+    QuantLib::ext::shared_ptr<ore::data::InMemoryReport> descReport =
+        QuantLib::ext::make_shared<ore::data::InMemoryReport>();
+
+    double shiftSize1 = 0.0;
+    auto itShiftSize1 = scenarioGenerator->shiftSizes().find(desc.key1());
+    if (itShiftSize1 != scenarioGenerator->shiftSizes().end()){
+        shiftSize1 = (itShiftSize1->second);
+    }
+    double shiftSize2 = 0.0;
+    auto itShiftSize2 = scenarioGenerator->shiftSizes().find(desc.key2());
+    if (itShiftSize2 != scenarioGenerator->shiftSizes().end()) {
+        shiftSize2 = (itShiftSize2->second);
+    }
+    descReport->addColumn("Type", string());
+    descReport->addColumn("IsPar", string());
+    descReport->addColumn("Factor_1", string());
+    descReport->addColumn("ShiftSize_1", double(), 8);
+    descReport->addColumn("Factor_2", string());
+    descReport->addColumn("ShiftSize_2", double(), 8);
+    descReport->addColumn("Currency", string());
+    descReport->next();
+    descReport->add(ore::data::to_string(desc.type()));
+    descReport->add("false");
+    descReport->add(desc.factor1());
+    descReport->add(shiftSize1);
+    descReport->add(desc.factor2());
+    descReport->add(shiftSize2);
+    descReport->add(inputs_->baseCurrency());
+    descReport->end();
+    return descReport;
+}
+
 void XvaSensitivityAnalyticImpl::setUpConfigurations() {
     analytic()->configurations().todaysMarketParams = inputs_->todaysMarketParams();
     analytic()->configurations().simMarketParams = inputs_->xvaSensiSimMarketParams();
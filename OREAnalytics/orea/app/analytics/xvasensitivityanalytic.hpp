@@ -40,6 +40,10 @@ public:
 private:
     void runSensitivity(const QuantLib::ext::shared_ptr<SensitivityScenarioGenerator>& scenarioGenerator,
                         const QuantLib::ext::shared_ptr<ore::data::InMemoryLoader>& loader);
+    //! true if the scenario shifts a risk factor of the exposure simulation market
+    bool shiftsSimulatedRiskFactor(const ShiftScenarioGenerator::ScenarioDescription& desc) const;
+    QuantLib::ext::shared_ptr<ore::data::InMemoryReport>
+    descriptionReport(const QuantLib::ext::shared_ptr<SensitivityScenarioGenerator>& scenarioGenerator, Size i) const;
 };
 
 class XvaSensitivityAnalytic : public Analytic {
@@ -35,6 +35,7 @@
 #include <orea/app/structuredanalyticserror.hpp>
 
 #include <ored/utilities/log.hpp>
+#include <ored/utilities/profiler.hpp>
 #include <ored/utilities/to_string.hpp>
 
 #include <ql/errors.hpp>
@@ -157,12 +158,14 @@ void AnalyticsManager::runAnalytics(const QuantLib::ext::shared_ptr<MarketCalibr
     // run requested analytics
     for (auto a : analytics_) {
         LOG("run analytic with label '" << a.first << "'");
+        ore::data::Profiler::instance().setAnalytic(a.first);
         a.second->runAnalytic(marketDataLoader_->loader(), inputs_->analytics());
         LOG("run analytic with label '" << a.first << "' finished.");
         // then populate the market calibration report if required
         if (marketCalibrationReport)
             a.second->marketCalibration(marketCalibrationReport);
     }
+    ore::data::Profiler::instance().setAnalytic(std::string());
 
     if (inputs_->portfolio()) {
         auto pricingStatsReport = QuantLib::ext::make_shared<InMemoryReport>();
@@ -171,6 +174,12 @@ void AnalyticsManager::runAnalytics(const QuantLib::ext::shared_ptr<MarketCalibr
         reports_["STATS"]["pricingstats"] = pricingStatsReport;
     }
 
+    if (ore::data::Profiler::instance().enabled()) {
+        auto profileReport = QuantLib::ext::make_shared<InMemoryReport>();
+        ReportWriter(inputs_->reportNaString()).writeProfile(*profileReport, ore::data::Profiler::instance().stats());
+        reports_["STATS"]["profile"] = profileReport;
+    }
+
     if (marketCalibrationReport) {
         auto report = marketCalibrationReport->outputCalibrationReport();
         if (report) {
@@ -157,6 +157,10 @@ void InputParameters::setMporCalendar(const std::string& s) {
     mporCalendar_ = parseCalendar(s);
 }
 
+void InputParameters::setScenarioResultStoreSize(Size s) {
+    scenarioResultStore_ = s > 0 ? QuantLib::ext::make_shared<ScenarioResultStore>(s) : nullptr;
+}
+
 void InputParameters::setSensiSimMarketParams(const std::string& xml) {
     sensiSimMarketParams_ = QuantLib::ext::make_shared<ScenarioSimMarketParameters>();
     sensiSimMarketParams_->fromXMLString(xml);
@@ -382,8 +386,21 @@ void InputParameters::setCollateralBalancesFromFile(const std::string& fileName)
     collateralBalances_->fromFile(fileName);
 }
 
-void InputParameters::setCubeFromFile(const std::string& file) {
-    auto r = ore::analytics::loadCube(file);
+void InputParameters::setSimulationShard(Size shardIndex, Size shardCount) {
+    QL_REQUIRE(shardCount > 0, "shardCount must be positive");
+    QL_REQUIRE(shardIndex < shardCount,
+               "shardIndex (" << shardIndex << ") must be less than shardCount (" << shardCount << ")");
+    shardIndex_ = shardIndex;
+    shardCount_ = shardCount;
+}
+
+void InputParameters::setCubeFromFile(const std::string& file) { setCubeFromFiles({file}); }
+
+void InputParameters::setCubeFromFiles(const std::vector<std::string>& files) {
+    std::vector<NPVCubeWithMetaData> cubes;
+    for (auto const& f : files)
+        cubes.push_back(ore::analytics::loadCube(f));
+    auto r = ore::analytics::mergeCubes(cubes);
     cube_ = r.cube;
     if(r.scenarioGeneratorData)
         scenarioGeneratorData_ = r.scenarioGeneratorData;
@@ -405,10 +422,31 @@ void InputParameters::setCptyCubeFromFile(const std::string& file) {
     cptyCube_ = ore::analytics::loadCube(file).cube;
 }
 
+void InputParameters::setCptyCubeFromFiles(const std::vector<std::string>& files) {
+    std::vector<NPVCubeWithMetaData> cubes;
+    for (auto const& f : files)
+        cubes.push_back(ore::analytics::loadCube(f));
+    // counterparties can be shared between shards, their survival probabilities agree
+    cptyCube_ = ore::analytics::mergeCubes(cubes, false, true).cube;
+}
+
 void InputParameters::setMarketCubeFromFile(const std::string& file) { mktCube_ = loadAggregationScenarioData(file); }
 
+void InputParameters::setMarketCubeFromFiles(const std::vector<std::string>& files) {
+    std::vector<QuantLib::ext::shared_ptr<AggregationScenarioData>> data;
+    for (auto const& f : files)
+        data.push_back(loadAggregationScenarioData(f));
+    mktCube_ = mergeAggregationScenarioData(data);
+}
+
 void InputParameters::setMarketCube(const QuantLib::ext::shared_ptr<AggregationScenarioData>& cube) { mktCube_ = cube; }
 
+void InputParameters::setPreviousCubeFromFile(const std::string& file) { previousCube_ = loadCube(file); }
+
+void InputParameters::setPreviousMarketCubeFromFile(const std::string& file) {
+    previousMktCube_ = loadAggregationScenarioData(file);
+}
+
 void InputParameters::setVarQuantiles(const std::string& s) {
     // parse to vector<Real>
     varQuantiles_ = parseListOfValues<Real>(s, &parseReal);
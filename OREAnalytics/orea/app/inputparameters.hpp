@@ -25,8 +25,10 @@
 #include <boost/filesystem/path.hpp>
 #include <orea/aggregation/creditsimulationparameters.hpp>
 #include <orea/app/parameters.hpp>
+#include <orea/cube/cube_io.hpp>
 #include <orea/cube/npvcube.hpp>
 #include <orea/engine/sensitivitystream.hpp>
+#include <orea/engine/scenarioresultstore.hpp>
 #include <orea/scenario/scenariogenerator.hpp>
 #include <orea/scenario/scenariogeneratorbuilder.hpp>
 #include <orea/scenario/historicalscenarioreader.hpp>
@@ -75,6 +77,7 @@ public:
     void setBaseCurrency(const std::string& s) { baseCurrency_ = s; }
     void setContinueOnError(bool b) { continueOnError_ = b; }
     void setLazyMarketBuilding(bool b) { lazyMarketBuilding_ = b; }
+    void setParallelPortfolioBuild(bool b) { parallelPortfolioBuild_ = b; }
     void setBuildFailedTrades(bool b) { buildFailedTrades_ = b; }
     void setObservationModel(const std::string& s) { observationModel_ = s; }
     void setImplyTodaysFixings(bool b) { implyTodaysFixings_ = b; }
@@ -112,6 +115,11 @@ public:
     void setMporDate(const QuantLib::Date& d) { mporDate_ = d; }
     void setMporCalendar(const std::string& s); 
     void setMporForward(bool b) { mporForward_ = b; }
+    // maximum number of trade npvs memoised across analytics, zero disables the store
+    void setScenarioResultStoreSize(Size s);
+    void setProfile(bool b) { profile_ = b; }
+    // record every n-th profiled measurement into the trace, zero disables the trace
+    void setProfileTraceSampling(Size n) { profileTraceSampling_ = n; }
 
     // Setters for npv analytics
     void setOutputAdditionalResults(bool b) { outputAdditionalResults_ = b; }
@@ -208,7 +216,15 @@ public:
     void setStoreFlows(bool b) { storeFlows_ = b; }
     void setStoreCreditStateNPVs(Size states) { storeCreditStateNPVs_ = states; }
     void setStoreSurvivalProbabilities(bool b) { storeSurvivalProbabilities_ = b; }
+    /* Store the trade NPV cube quantised to 8 or 16 bit integers with a scale per (trade, date, depth) block instead
+       of in single precision, 0 (default) disables the quantisation, see QuantisedInMemoryCube */
+    void setCubeQuantisationBits(Size bits) { cubeQuantisationBits_ = bits; }
+    // Log a warning for each block of the quantised cube whose absolute error bound exceeds this, 0 means no check
+    void setCubeQuantisationTolerance(Real tolerance) { cubeQuantisationTolerance_ = tolerance; }
     void setWriteCube(bool b) { writeCube_ = b; }
+    /* Restrict the exposure simulation to the trades of shard shardIndex out of shardCount, see shardIds() in
+       cube_io.hpp. The partial cubes written by the shards are merged by passing them all to setCubeFromFiles(). */
+    void setSimulationShard(Size shardIndex, Size shardCount);
     void setWriteScenarios(bool b) { writeScenarios_ = b; }
     void setExposureSimMarketParams(const std::string& xml);
     void setExposureSimMarketParamsFromFile(const std::string& fileName);
@@ -241,11 +257,19 @@ public:
        cube. Therefore this method should be called after setScenarioGeneratorData(), setStoreFlows(),
        setStoreCreditStateNPVs() to ensure that the overwrite takes place. */
     void setCubeFromFile(const std::string& file);
+    //! As setCubeFromFile(), the cubes from sharded simulation runs are merged, see mergeCubes() in cube_io.hpp
+    void setCubeFromFiles(const std::vector<std::string>& files);
     void setCube(const QuantLib::ext::shared_ptr<NPVCube>& cube);
     void setNettingSetCubeFromFile(const std::string& file);
     void setCptyCubeFromFile(const std::string& file);
+    void setCptyCubeFromFiles(const std::vector<std::string>& files);
     void setMarketCubeFromFile(const std::string& file);
+    void setMarketCubeFromFiles(const std::vector<std::string>& files);
     void setMarketCube(const QuantLib::ext::shared_ptr<AggregationScenarioData>& cube);
+    /* Cube and market cube of a previous run for an incremental EXPOSURE run. Unlike setCubeFromFile() the cube meta
+       data does not overwrite the current configuration, it is used to check that the previous cube can be reused. */
+    void setPreviousCubeFromFile(const std::string& file);
+    void setPreviousMarketCubeFromFile(const std::string& file);
     // QuantLib::ext::shared_ptr<AggregationScenarioData> mktCube();
     void setFlipViewXVA(bool b) { flipViewXVA_ = b; }
     void setMporCashFlowMode(const MporCashFlowMode m) { mporCashFlowMode_ = m; }
@@ -335,6 +359,7 @@ public:
     void setXvaSensiPricingEngine(const QuantLib::ext::shared_ptr<EngineData>& engineData) {
         sensiPricingEngine_ = engineData;
     }
+    void setXvaSensiReuseSimulation(bool b) { xvaSensiReuseSimulation_ = b; }
 
     // Setters for SIMM
     void setSimmVersion(const std::string& s) { simmVersion_ = s; }
@@ -433,6 +458,7 @@ public:
     const std::string& resultCurrency() const { return resultCurrency_; }
     bool continueOnError() const { return continueOnError_; }
     bool lazyMarketBuilding() const { return lazyMarketBuilding_; }
+    bool parallelPortfolioBuild() const { return parallelPortfolioBuild_; }
     bool buildFailedTrades() const { return buildFailedTrades_; }
     const std::string& observationModel() const { return observationModel_; }
     bool implyTodaysFixings() const { return implyTodaysFixings_; }
@@ -463,6 +489,9 @@ public:
     char csvSeparator() const { return csvSeparator_; }
     char csvEscapeChar() const { return csvEscapeChar_; }
     bool dryRun() const { return dryRun_; }
+    const QuantLib::ext::shared_ptr<ScenarioResultStore>& scenarioResultStore() const { return scenarioResultStore_; }
+    bool profile() const { return profile_; }
+    QuantLib::Size profileTraceSampling() const { return profileTraceSampling_; }
     QuantLib::Size mporDays() const { return mporDays_; }
     QuantLib::Date mporDate();
     const QuantLib::Calendar mporCalendar() {
@@ -581,7 +610,11 @@ public:
     bool storeFlows() const { return storeFlows_; }
     Size storeCreditStateNPVs() const { return storeCreditStateNPVs_; }
     bool storeSurvivalProbabilities() const { return storeSurvivalProbabilities_; }
+    Size cubeQuantisationBits() const { return cubeQuantisationBits_; }
+    Real cubeQuantisationTolerance() const { return cubeQuantisationTolerance_; }
     bool writeCube() const { return writeCube_; }
+    Size shardIndex() const { return shardIndex_; }
+    Size shardCount() const { return shardCount_; }
     bool writeScenarios() const { return writeScenarios_; }
     const QuantLib::ext::shared_ptr<ore::analytics::ScenarioSimMarketParameters>& exposureSimMarketParams() const { return exposureSimMarketParams_; }
     const QuantLib::ext::shared_ptr<ScenarioGeneratorData> scenarioGeneratorData() const { return scenarioGeneratorData_; }
@@ -602,6 +635,8 @@ public:
     const QuantLib::ext::shared_ptr<NPVCube>& nettingSetCube() const { return nettingSetCube_; }
     const QuantLib::ext::shared_ptr<NPVCube>& cptyCube() const { return cptyCube_; }
     const QuantLib::ext::shared_ptr<AggregationScenarioData>& mktCube() const { return mktCube_; }
+    const NPVCubeWithMetaData& previousCube() const { return previousCube_; }
+    const QuantLib::ext::shared_ptr<AggregationScenarioData>& previousMktCube() const { return previousMktCube_; }
     bool flipViewXVA() const { return flipViewXVA_; }
     MporCashFlowMode mporCashFlowMode() const { return mporCashFlowMode_; }
     bool fullInitialCollateralisation() const { return fullInitialCollateralisation_; }
@@ -755,6 +790,7 @@ public:
         return xvaSensiScenarioData_;
     }
     const QuantLib::ext::shared_ptr<ore::data::EngineData>& xvaSensiPricingEngine() const { return xvaSensiPricingEngine_; }
+    bool xvaSensiReuseSimulation() const { return xvaSensiReuseSimulation_; }
 
     /****************************
      * Getters for zero to par shift
@@ -797,6 +833,7 @@ protected:
     std::string resultCurrency_;
     bool continueOnError_ = true;
     bool lazyMarketBuilding_ = true;
+    bool parallelPortfolioBuild_ = false;
     bool buildFailedTrades_ = true;
     std::string observationModel_ = "None";
     bool implyTodaysFixings_ = false;
@@ -823,6 +860,9 @@ protected:
     char csvEscapeChar_ = '\\';
     std::string reportNaString_ = "#N/A";
     bool dryRun_ = false;
+    QuantLib::ext::shared_ptr<ScenarioResultStore> scenarioResultStore_;
+    bool profile_ = false;
+    QuantLib::Size profileTraceSampling_ = 0;
     QuantLib::Date mporDate_;
     QuantLib::Size mporDays_ = 10;
     bool mporOverlappingPeriods_ = true;
@@ -924,7 +964,10 @@ protected:
     bool storeFlows_ = false;
     Size storeCreditStateNPVs_ = 0;
     bool storeSurvivalProbabilities_ = false;
+    Size cubeQuantisationBits_ = 0;
+    Real cubeQuantisationTolerance_ = 0.0;
     bool writeCube_ = false;
+    Size shardIndex_ = 0, shardCount_ = 1;
     bool writeScenarios_ = false;
     QuantLib::ext::shared_ptr<ore::analytics::ScenarioSimMarketParameters> exposureSimMarketParams_;
     QuantLib::ext::shared_ptr<ScenarioGeneratorData> scenarioGeneratorData_;
@@ -943,6 +986,8 @@ protected:
     // intermediate results of the exposure simulation, before aggregation
     QuantLib::ext::shared_ptr<NPVCube> cube_, nettingSetCube_, cptyCube_;
     QuantLib::ext::shared_ptr<AggregationScenarioData> mktCube_;
+    NPVCubeWithMetaData previousCube_;
+    QuantLib::ext::shared_ptr<AggregationScenarioData> previousMktCube_;
     Real simulationBootstrapTolerance_ = 0.0001;
 
     /**************
@@ -1075,6 +1120,7 @@ protected:
     QuantLib::ext::shared_ptr<ore::analytics::ScenarioSimMarketParameters> xvaSensiSimMarketParams_;
     QuantLib::ext::shared_ptr<ore::analytics::SensitivityScenarioData> xvaSensiScenarioData_;
     QuantLib::ext::shared_ptr<ore::data::EngineData> xvaSensiPricingEngine_;
+    bool xvaSensiReuseSimulation_ = false;
 };
 
 inline const std::string& InputParameters::marketConfig(const std::string& context) {
@@ -32,10 +32,12 @@
 #include <orea/app/structuredanalyticserror.hpp>
 #include <orea/app/structuredanalyticswarning.hpp>
 #include <orea/cube/cube_io.hpp>
+#include <orea/cube/incrementalcube.hpp>
 #include <orea/engine/observationmode.hpp>
 
 #include <ored/report/inmemoryreport.hpp>
 #include <ored/utilities/calendaradjustmentconfig.hpp>
+#include <ored/utilities/profiler.hpp>
 #include <ored/configuration/currencyconfig.hpp>
 #include <ored/portfolio/collateralbalance.hpp>
 
@@ -50,6 +52,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/timer/timer.hpp>
 
+#include <fstream>
 #include <mutex>
 
 using namespace std;
@@ -248,8 +251,17 @@ void OREApp::analytics() {
         }
 
         // Run the requested analytics
+        Profiler::instance().reset();
+        Profiler::instance().setEnabled(inputs_->profile());
+        Profiler::instance().setTraceSampling(inputs_->profileTraceSampling());
         analyticsManager_->runAnalytics(mcr);
 
+        if (auto const& store = inputs_->scenarioResultStore()) {
+            LOG("Scenario result store: " << store->size() << " entries, " << store->hits() << " hits, "
+                                          << store->misses() << " misses, " << store->evictions() << " evictions, "
+                                          << "hit rate " << store->hitRate());
+        }
+
         // Write reports to files in the results path
         Analytic::analytic_reports reports = analyticsManager_->reports();
         analyticsManager_->toFile(reports,
@@ -257,6 +269,14 @@ void OREApp::analytics() {
                                   inputs_->csvSeparator(), inputs_->csvCommentCharacter(),
                                   inputs_->csvQuoteChar(), inputs_->reportNaString());
 
+        if (Profiler::instance().enabled() && inputs_->profileTraceSampling() > 0) {
+            std::string traceFile = (inputs_->resultsPath() / "profile_trace.json").string();
+            LOG("Writing profile trace to " << traceFile);
+            std::ofstream trace(traceFile);
+            QL_REQUIRE(trace.is_open(), "could not open profile trace file " << traceFile);
+            Profiler::instance().writeChromeTrace(trace);
+        }
+
         // Write npv cube(s)
         for (auto a : analyticsManager_->npvCubes()) {
             for (auto b : a.second) {
@@ -271,6 +291,8 @@ void OREApp::analytics() {
                     r.scenarioGeneratorData = inputs_->scenarioGeneratorData();
                     r.storeFlows = inputs_->storeFlows();
                     r.storeCreditStateNPVs = inputs_->storeCreditStateNPVs();
+                    if (inputs_->portfolio())
+                        r.tradeHashes = tradeHashes(*inputs_->portfolio());
                 }
                 saveCube(fileName, r);
             }
@@ -357,6 +379,10 @@ void OREApp::initFromParams() {
         if (!tmp.empty()) {
             structuredLogRotationSize_ = static_cast<Size>(parseInteger(tmp));
         }
+        tmp = params_->get("logging", "asyncLogging", false);
+        if (!tmp.empty()) {
+            asyncLogging_ = ore::data::parseBool(tmp);
+        }
     }
     
     setupLog(outputPath_, logFile_, logMask_, logRootPath_, progressLogFile_, progressLogRotationSize_, progressLogToConsole_,
@@ -500,8 +526,17 @@ void OREApp::run(const std::vector<std::string>& marketData,
         }
 
         // Run the requested analytics
+        Profiler::instance().reset();
+        Profiler::instance().setEnabled(inputs_->profile());
+        Profiler::instance().setTraceSampling(inputs_->profileTraceSampling());
         analyticsManager_->runAnalytics(mcr);
 
+        if (auto const& store = inputs_->scenarioResultStore()) {
+            LOG("Scenario result store: " << store->size() << " entries, " << store->hits() << " hits, "
+                                          << store->misses() << " misses, " << store->evictions() << " evictions, "
+                                          << "hit rate " << store->hitRate());
+        }
+
         MEM_LOG_USING_LEVEL(ORE_WARNING)
         // Leave any report writing to the calling aplication
     }
@@ -538,6 +573,7 @@ void OREApp::setupLog(const std::string& path, const std::string& file, Size mas
                             : logRootPath;
     Log::instance().setRootPath(oreRootPath);
     Log::instance().setMask(mask);
+    Log::instance().setAsync(asyncLogging_);
     Log::instance().switchOn();
 
     // Progress logger
@@ -559,7 +595,10 @@ void OREApp::setupLog(const std::string& path, const std::string& file, Size mas
     ore::data::Log::instance().registerIndependentLogger(eventLogger);
 }
 
-void OREApp::closeLog() { Log::instance().removeAllLoggers(); }
+void OREApp::closeLog() {
+    Log::instance().setAsync(false);
+    Log::instance().removeAllLoggers();
+}
 
 std::string OREApp::version() { return std::string(OPEN_SOURCE_RISK_VERSION); }
 
@@ -637,6 +676,18 @@ void OREAppInputParameters::loadParameters() {
     if (tmp != "")
         setThreads(parseInteger(tmp));
 
+    tmp = params_->get("setup", "scenarioResultStoreSize", false);
+    if (tmp != "")
+        setScenarioResultStoreSize(parseInteger(tmp));
+
+    tmp = params_->get("setup", "profile", false);
+    if (tmp != "")
+        setProfile(parseBool(tmp));
+
+    tmp = params_->get("setup", "profileTraceSampling", false);
+    if (tmp != "")
+        setProfileTraceSampling(parseInteger(tmp));
+
     tmp = params_->get("setup", "entireMarket", false);
     if (tmp != "")
         setEntireMarket(parseBool(tmp));
@@ -653,6 +704,10 @@ void OREAppInputParameters::loadParameters() {
     if (tmp != "")
         setLazyMarketBuilding(parseBool(tmp));
 
+    tmp = params_->get("setup", "parallelPortfolioBuild", false);
+    if (tmp != "")
+        setParallelPortfolioBuild(parseBool(tmp));
+
     tmp = params_->get("setup", "buildFailedTrades", false);
     if (tmp != "")
         setBuildFailedTrades(parseBool(tmp));
@@ -1514,6 +1569,14 @@ void OREAppInputParameters::loadParameters() {
         if (tmp == "Y")
             setStoreSurvivalProbabilities(true);
 
+        tmp = params_->get("simulation", "cubeQuantisationBits", false);
+        if (!tmp.empty())
+            setCubeQuantisationBits(parseInteger(tmp));
+
+        tmp = params_->get("simulation", "cubeQuantisationTolerance", false);
+        if (!tmp.empty())
+            setCubeQuantisationTolerance(parseReal(tmp));
+
         tmp = params_->get("simulation", "nettingSetId", false);
         if (tmp != "")
             setNettingSetId(tmp);
@@ -1522,10 +1585,31 @@ void OREAppInputParameters::loadParameters() {
         if (tmp != "")
             setWriteCube(true);
 
+        tmp = params_->get("simulation", "shardCount", false);
+        if (tmp != "") {
+            Size shardCount = parseInteger(tmp);
+            Size shardIndex = parseInteger(params_->get("simulation", "shardIndex"));
+            LOG("Simulation is restricted to shard " << shardIndex << " of " << shardCount);
+            setSimulationShard(shardIndex, shardCount);
+        }
+
         tmp = params_->get("simulation", "scenariodump", false);
         if (tmp != "")
             setWriteScenarios(true);
 
+        tmp = params_->get("simulation", "previousCubeFile", false);
+        if (tmp != "" && analytics().find("EXPOSURE") != analytics().end()) {
+            string cubeFile = (resultsPath() / tmp).generic_string();
+            LOG("Load previous cube for incremental run from file " << cubeFile);
+            setPreviousCubeFromFile(cubeFile);
+            tmp = params_->get("simulation", "previousScenarioFile", false);
+            if (tmp != "") {
+                string scenarioFile = (resultsPath() / tmp).generic_string();
+                LOG("Load previous agg scen data from file " << scenarioFile);
+                setPreviousMarketCubeFromFile(scenarioFile);
+            }
+        }
+
         tmp = params_->get("simulation", "xvaCgBumpSensis", false);
 	if (!tmp.empty())
 	    setXvaCgBumpSensis(parseBool(tmp));
@@ -1564,9 +1648,12 @@ void OREAppInputParameters::loadParameters() {
         setLoadCube(true);
         tmp = params_->get("xva", "cubeFile", false);
         if (tmp != "") {
-            string cubeFile = (resultsPath() / tmp).generic_string();
-            LOG("Load cube from file " << cubeFile);
-            setCubeFromFile(cubeFile);
+            // a list of cube files from sharded simulation runs is merged
+            vector<string> cubeFiles;
+            for (auto const& f : parseListOfValues(tmp))
+                cubeFiles.push_back((resultsPath() / f).generic_string());
+            LOG("Load cube from file(s) " << boost::algorithm::join(cubeFiles, ", "));
+            setCubeFromFiles(cubeFiles);
             LOG("Cube loading done: ids=" << cube()->numIds() << " dates=" << cube()->numDates()
                                           << " samples=" << cube()->samples() << " depth=" << cube()->depth());
         } else {
@@ -1592,6 +1679,9 @@ void OREAppInputParameters::loadParameters() {
 
     tmp = params_->get("xva", "nettingSetCubeFile", false);
     if (loadCube() && tmp != "") {
+        QL_REQUIRE(parseListOfValues(params_->get("xva", "cubeFile", false)).size() <= 1,
+                   "nettingSetCubeFile can not be combined with several cube files, netting set cubes of sharded "
+                   "simulations are not merged");
         string cubeFile = (resultsPath() / tmp).generic_string();
         LOG("Load nettingset cube from file " << cubeFile);
         setNettingSetCubeFromFile(cubeFile);
@@ -1602,18 +1692,22 @@ void OREAppInputParameters::loadParameters() {
 
     tmp = params_->get("xva", "cptyCubeFile", false);
     if (loadCube() && tmp != "") {
-        string cubeFile = resultsPath().string() + "/" + tmp;
-        LOG("Load cpty cube from file " << cubeFile);
-        setCptyCubeFromFile(cubeFile);
+        vector<string> cubeFiles;
+        for (auto const& f : parseListOfValues(tmp))
+            cubeFiles.push_back(resultsPath().string() + "/" + f);
+        LOG("Load cpty cube from file(s) " << boost::algorithm::join(cubeFiles, ", "));
+        setCptyCubeFromFiles(cubeFiles);
         DLOG("CptyCube loading done: ids=" << cptyCube()->numIds() << " dates=" << cptyCube()->numDates()
                                            << " samples=" << cptyCube()->samples() << " depth=" << cptyCube()->depth());
     }
 
     tmp = params_->get("xva", "scenarioFile", false);
     if (loadCube() && tmp != "") {
-        string cubeFile = resultsPath().string() + "/" + tmp;
-        LOG("Load agg scen data from file " << cubeFile);
-        setMarketCubeFromFile(cubeFile);
+        vector<string> cubeFiles;
+        for (auto const& f : parseListOfValues(tmp))
+            cubeFiles.push_back(resultsPath().string() + "/" + f);
+        LOG("Load agg scen data from file(s) " << boost::algorithm::join(cubeFiles, ", "));
+        setMarketCubeFromFiles(cubeFiles);
         LOG("MktCube loading done");
     }
 
@@ -1910,6 +2004,10 @@ void OREAppInputParameters::loadParameters() {
         } else {
             WLOG("Xva sensitivity scenario data not loaded");
         }
+
+        tmp = params_->get("xvaSensitivity", "reuseSimulation", false);
+        if (!tmp.empty())
+            setXvaSensiReuseSimulation(parseBool(tmp));
     }
 
     /*************
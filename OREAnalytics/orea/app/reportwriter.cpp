@@ -678,11 +678,11 @@ void ReportWriter::writeCashflowNpv(ore::data::Report& report, const ore::data::
     map<string, Real> npvMap;
     Date asof = Settings::instance().evaluationDate();
     for (Size i = 0; i < cashflowReport.rows(); ++i) {
-        string tradeId = QuantLib::ext::get<string>(cashflowReport.data(tradeIdColumn).at(i));
-        string tradeType = QuantLib::ext::get<string>(cashflowReport.data(tradeTypeColumn).at(i));
-        Date payDate = QuantLib::ext::get<Date>(cashflowReport.data(payDateColumn).at(i));
-        string ccy = QuantLib::ext::get<string>(cashflowReport.data(ccyColumn).at(i));
-        Real pv = QuantLib::ext::get<Real>(cashflowReport.data(pvColumn).at(i));
+        string tradeId = cashflowReport.dataAsString(tradeIdColumn, i);
+        string tradeType = cashflowReport.dataAsString(tradeTypeColumn, i);
+        Date payDate = cashflowReport.dataAsDate(payDateColumn).at(i);
+        string ccy = cashflowReport.dataAsString(ccyColumn, i);
+        Real pv = cashflowReport.dataAsReal(pvColumn).at(i);
         Real fx = 1.0;
 	// There shouldn't be entries in the cf report without ccy. We assume ccy = baseCcy in this case and log an error.
         if (ccy.empty()) {
@@ -1491,6 +1491,38 @@ void ReportWriter::writePricingStats(ore::data::Report& report, const QuantLib::
     LOG("Pricing stats report written");
 }
 
+void ReportWriter::writeProfile(ore::data::Report& report,
+                                const std::map<ore::data::ProfileKey, ore::data::ProfileStats>& stats) {
+
+    LOG("Writing profile report");
+
+    report.addColumn("Analytic", string())
+        .addColumn("Phase", string())
+        .addColumn("TradeType", string())
+        .addColumn("Engine", string())
+        .addColumn("Count", Size())
+        .addColumn("TotalTime", double(), 6)
+        .addColumn("AverageTime", double(), 6)
+        .addColumn("MinTime", double(), 6)
+        .addColumn("MaxTime", double(), 6);
+
+    for (auto const& [key, s] : stats) {
+        report.next()
+            .add(key.analytic)
+            .add(key.phase)
+            .add(key.tradeType)
+            .add(key.engine)
+            .add(s.count)
+            .add(s.totalTime)
+            .add(s.count > 0 ? s.totalTime / static_cast<double>(s.count) : 0.0)
+            .add(s.minTime)
+            .add(s.maxTime);
+    }
+
+    report.end();
+    LOG("Profile report written");
+}
+
 void ReportWriter::writeCube(ore::data::Report& report, const QuantLib::ext::shared_ptr<NPVCube>& cube,
                              const std::map<std::string, std::string>& nettingSetMap) {
     LOG("Writing cube report");
@@ -2412,14 +2444,14 @@ Real aggregateTradeFlow(const std::string& tradeId, const Date& d0, const Date&
 
     Real flow = 0.0;
     for (Size i = 0; i < cashFlowReport->rows(); ++i) {
-        string id = boost::get<string>(cashFlowReport->data(tradeIdColumn).at(i));
+        string id = cashFlowReport->dataAsString(tradeIdColumn, i);
 	if (id != tradeId)
 	    continue;
-	Date date = boost::get<Date>(cashFlowReport->data(dateColumn).at(i));
+	Date date = cashFlowReport->dataAsDate(dateColumn).at(i);
 	if (date <= d0 || date > d1)
 	    continue;
-	string ccy = boost::get<string>(cashFlowReport->data(ccyColumn).at(i));
-	Real amount = boost::get<Real>(cashFlowReport->data(amountColumn).at(i));
+	string ccy = cashFlowReport->dataAsString(ccyColumn, i);
+	Real amount = cashFlowReport->dataAsReal(amountColumn).at(i);
 	Real fx = 1.0;
 	if (ccy != baseCurrency)
 	    fx = market->fxRate(ccy + baseCurrency)->value();
@@ -2501,20 +2533,20 @@ void ReportWriter::writePnlReport(ore::data::Report& report,
 
     for (Size i = 0; i < t0NpvReport->rows(); ++i) {
         try {
-	    string tradeId = boost::get<string>(t0NpvReport->data(tradeIdColumn).at(i));
-	    string tradeId2 = boost::get<string>(t0NpvLaggedReport->data(tradeIdColumn).at(i));
-	    string tradeId3 = boost::get<string>(t1NpvLaggedReport->data(tradeIdColumn).at(i));
-	    string tradeId4 = boost::get<string>(t1NpvReport->data(tradeIdColumn).at(i));
+	    string tradeId = t0NpvReport->dataAsString(tradeIdColumn, i);
+	    string tradeId2 = t0NpvLaggedReport->dataAsString(tradeIdColumn, i);
+	    string tradeId3 = t1NpvLaggedReport->dataAsString(tradeIdColumn, i);
+	    string tradeId4 = t1NpvReport->dataAsString(tradeIdColumn, i);
 	    QL_REQUIRE(tradeId == tradeId2 && tradeId == tradeId3 && tradeId == tradeId4, "inconsistent ordering of NPV reports");
-	    string tradeType = boost::get<string>(t0NpvReport->data(tradeTypeColumn).at(i));
-	    Date maturityDate = boost::get<Date>(t0NpvReport->data(maturityDateColumn).at(i));
-            Real maturityTime = boost::get<Real>(t0NpvReport->data(maturityTimeColumn).at(i));
-	    string ccy = boost::get<string>(t0NpvReport->data(baseCcyColumn).at(i));
+	    string tradeType = t0NpvReport->dataAsString(tradeTypeColumn, i);
+	    Date maturityDate = t0NpvReport->dataAsDate(maturityDateColumn).at(i);
+            Real maturityTime = t0NpvReport->dataAsReal(maturityTimeColumn).at(i);
+	    string ccy = t0NpvReport->dataAsString(baseCcyColumn, i);
 	    QL_REQUIRE(ccy == baseCurrency, "inconsistent NPV and base currencies");
-            Real t0Npv = boost::get<Real>(t0NpvReport->data(npvBaseColumn).at(i));
-            Real t0NpvLagged = boost::get<Real>(t0NpvLaggedReport->data(npvBaseColumn).at(i));
-	    Real t1NpvLagged = boost::get<Real>(t1NpvLaggedReport->data(npvBaseColumn).at(i));
-	    Real t1Npv = boost::get<Real>(t1NpvReport->data(npvBaseColumn).at(i));
+            Real t0Npv = t0NpvReport->dataAsReal(npvBaseColumn).at(i);
+            Real t0NpvLagged = t0NpvLaggedReport->dataAsReal(npvBaseColumn).at(i);
+	    Real t1NpvLagged = t1NpvLaggedReport->dataAsReal(npvBaseColumn).at(i);
+	    Real t1Npv = t1NpvReport->dataAsReal(npvBaseColumn).at(i);
             
 	    Real hypotheticalCleanPnl = t0NpvLagged - t0Npv;
 	    Real periodFlow = aggregateTradeFlow(tradeId, startDate, endDate, t0CashFlowReport, market, baseCurrency);
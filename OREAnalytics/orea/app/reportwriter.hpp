@@ -43,6 +43,7 @@
 #include <ored/report/report.hpp>
 #include <ored/report/inmemoryreport.hpp>
 #include <ored/utilities/dategrid.hpp>
+#include <ored/utilities/profiler.hpp>
 #include <ored/utilities/xmlutils.hpp>
 #include <string>
 
@@ -126,6 +127,9 @@ public:
 
     virtual void writePricingStats(ore::data::Report& report, const QuantLib::ext::shared_ptr<Portfolio>& portfolio);
 
+    virtual void writeProfile(ore::data::Report& report,
+                              const std::map<ore::data::ProfileKey, ore::data::ProfileStats>& stats);
+
     virtual void writeCube(ore::data::Report& report, const QuantLib::ext::shared_ptr<NPVCube>& cube,
                            const std::map<std::string, std::string>& nettingSetMap = std::map<std::string, std::string>());
 
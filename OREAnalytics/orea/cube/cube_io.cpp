@@ -58,6 +58,20 @@ std::string getMetaData(const std::string& line, const std::string& tag, const b
     return line.substr(0, 1) == "#" && line.substr(2, tag.size()) == tag ? line.substr(15) : std::string();
 }
 
+QuantLib::ext::shared_ptr<NPVCube> createCube(const QuantLib::Date& asof, const std::set<std::string>& ids,
+                                              const std::vector<QuantLib::Date>& dates, const Size samples,
+                                              const Size depth, const bool doublePrecision) {
+    if (doublePrecision && depth <= 1) {
+        return QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(asof, ids, dates, samples, 0.0);
+    } else if (doublePrecision && depth > 1) {
+        return QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(asof, ids, dates, samples, depth, 0.0);
+    } else if (!doublePrecision && depth <= 1) {
+        return QuantLib::ext::make_shared<SinglePrecisionInMemoryCube>(asof, ids, dates, samples, 0.0f);
+    } else {
+        return QuantLib::ext::make_shared<SinglePrecisionInMemoryCubeN>(asof, ids, dates, samples, depth, 0.0f);
+    }
+}
+
 } // namespace
 
 NPVCubeWithMetaData loadCube(const std::string& filename, const bool doublePrecision) {
@@ -126,16 +140,20 @@ NPVCubeWithMetaData loadCube(const std::string& filename, const bool doublePreci
         DLOG("overwrite storeCreditStateNPVs with meta data from cube: " << md);
     }
 
-    QuantLib::ext::shared_ptr<NPVCube> cube;
-    if (doublePrecision && depth <= 1) {
-        cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(asof, ids, dates, samples, 0.0);
-    } else if (doublePrecision && depth > 1) {
-        cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(asof, ids, dates, samples, depth, 0.0);
-    } else if (!doublePrecision && depth <= 1) {
-        cube = QuantLib::ext::make_shared<SinglePrecisionInMemoryCube>(asof, ids, dates, samples, 0.0f);
-    } else if (!doublePrecision && depth > 1) {
-        cube = QuantLib::ext::make_shared<SinglePrecisionInMemoryCubeN>(asof, ids, dates, samples, depth, 0.0f);
+    if (std::string md = getMetaData(line, "tradeHash", false); !md.empty()) {
+        Size n = ore::data::parseInteger(md);
+        for (Size i = 0; i < n; ++i) {
+            // format is "# <hash> <id>", the hash does not contain blanks
+            std::getline(in, line);
+            Size sep = line.find(' ', 2);
+            QL_REQUIRE(sep != std::string::npos, "loadCube(): invalid trade hash line '" << line << "'");
+            result.tradeHashes[line.substr(sep + 1)] = line.substr(2, sep - 2);
+        }
+        std::getline(in, line);
+        DLOG("read " << n << " trade hashes from cube meta data");
     }
+
+    QuantLib::ext::shared_ptr<NPVCube> cube = createCube(asof, ids, dates, samples, depth, doublePrecision);
     result.cube = cube;
 
     vector<string> tokens;
@@ -208,6 +226,11 @@ void saveCube(const std::string& filename, const NPVCubeWithMetaData& cube, cons
     if (cube.storeCreditStateNPVs) {
         out << "# storeCrSt  : " << *cube.storeCreditStateNPVs << "\n";
     }
+    if (!cube.tradeHashes.empty()) {
+        out << "# tradeHash  : " << cube.tradeHashes.size() << "\n";
+        for (auto const& [id, hash] : cube.tradeHashes)
+            out << "# " << hash << " " << id << "\n";
+    }
 
     // set precision
 
@@ -340,5 +363,117 @@ void saveAggregationScenarioData(const std::string& filename, const AggregationS
     }
 }
 
+std::set<std::string> shardIds(const std::set<std::string>& ids, const Size shardIndex, const Size shardCount) {
+    QL_REQUIRE(shardCount > 0, "shardIds(): shardCount must be positive");
+    QL_REQUIRE(shardIndex < shardCount,
+               "shardIds(): shardIndex (" << shardIndex << ") must be less than shardCount (" << shardCount << ")");
+    std::set<std::string> result;
+    Size i = 0;
+    for (auto const& id : ids) {
+        if (i++ % shardCount == shardIndex)
+            result.insert(result.end(), id);
+    }
+    return result;
+}
+
+NPVCubeWithMetaData mergeCubes(const std::vector<NPVCubeWithMetaData>& cubes, const bool doublePrecision,
+                               const bool allowDuplicateIds) {
+
+    QL_REQUIRE(!cubes.empty(), "mergeCubes(): no cubes given");
+    QL_REQUIRE(cubes.front().cube, "mergeCubes(): cube #0 is null");
+    if (cubes.size() == 1)
+        return cubes.front();
+
+    // check the cubes are consistent and collect the ids
+
+    auto const& first = cubes.front().cube;
+    std::set<std::string> ids;
+    for (Size c = 0; c < cubes.size(); ++c) {
+        auto const& cube = cubes[c].cube;
+        QL_REQUIRE(cube, "mergeCubes(): cube #" << c << " is null");
+        QL_REQUIRE(cube->asof() == first->asof(), "mergeCubes(): cube #" << c << " has asof " << cube->asof()
+                                                                          << ", expected " << first->asof());
+        QL_REQUIRE(cube->dates() == first->dates(), "mergeCubes(): cube #" << c << " has different dates");
+        QL_REQUIRE(cube->samples() == first->samples(), "mergeCubes(): cube #" << c << " has " << cube->samples()
+                                                                               << " samples, expected "
+                                                                               << first->samples());
+        QL_REQUIRE(cube->depth() == first->depth(),
+                   "mergeCubes(): cube #" << c << " has depth " << cube->depth() << ", expected " << first->depth());
+        for (auto const& [id, _] : cube->idsAndIndexes()) {
+            QL_REQUIRE(ids.insert(id).second || allowDuplicateIds,
+                       "mergeCubes(): id '" << id << "' in cube #" << c << " occurs in a previous cube");
+        }
+    }
+
+    NPVCubeWithMetaData result;
+    result.scenarioGeneratorData = cubes.front().scenarioGeneratorData;
+    result.storeFlows = cubes.front().storeFlows;
+    result.storeCreditStateNPVs = cubes.front().storeCreditStateNPVs;
+    result.cube =
+        createCube(first->asof(), ids, first->dates(), first->samples(), first->depth(), doublePrecision);
+
+    // copy the values, values of duplicate ids must agree
+
+    std::vector<bool> written(ids.size(), false);
+    for (Size c = 0; c < cubes.size(); ++c) {
+        auto const& cube = cubes[c].cube;
+        for (auto const& [id, idx] : cube->idsAndIndexes()) {
+            Size r = result.cube->idsAndIndexes().at(id);
+            bool duplicate = written[r];
+            written[r] = true;
+            auto check = [&id, c](Real v1, Real v2) {
+                QL_REQUIRE(v1 == v2, "mergeCubes(): id '" << id << "' in cube #" << c
+                                                          << " has different values than in a previous cube (" << v1
+                                                          << ", " << v2 << ")");
+            };
+            for (Size d = 0; d < cube->depth(); ++d) {
+                if (duplicate)
+                    check(result.cube->getT0(r, d), cube->getT0(idx, d));
+                else
+                    result.cube->setT0(cube->getT0(idx, d), r, d);
+                for (Size j = 0; j < cube->numDates(); ++j) {
+                    for (Size k = 0; k < cube->samples(); ++k) {
+                        if (duplicate)
+                            check(result.cube->get(r, j, k, d), cube->get(idx, j, k, d));
+                        else
+                            result.cube->set(cube->get(idx, j, k, d), r, j, k, d);
+                    }
+                }
+            }
+        }
+        result.tradeHashes.insert(cubes[c].tradeHashes.begin(), cubes[c].tradeHashes.end());
+    }
+
+    LOG("merged " << cubes.size() << " cubes: asof = " << first->asof() << ", dim = " << ids.size() << " x "
+                  << first->numDates() << " x " << first->samples() << " x " << first->depth());
+
+    return result;
+}
+
+QuantLib::ext::shared_ptr<AggregationScenarioData>
+mergeAggregationScenarioData(const std::vector<QuantLib::ext::shared_ptr<AggregationScenarioData>>& data) {
+    QL_REQUIRE(!data.empty(), "mergeAggregationScenarioData(): no data given");
+    auto const& first = data.front();
+    QL_REQUIRE(first, "mergeAggregationScenarioData(): data #0 is null");
+    auto keys = first->keys();
+    for (Size c = 1; c < data.size(); ++c) {
+        QL_REQUIRE(data[c], "mergeAggregationScenarioData(): data #" << c << " is null");
+        QL_REQUIRE(data[c]->dimDates() == first->dimDates() && data[c]->dimSamples() == first->dimSamples() &&
+                       data[c]->keys() == keys,
+                   "mergeAggregationScenarioData(): data #" << c << " has different dimensions or keys");
+        for (Size i = 0; i < first->dimDates(); ++i) {
+            for (Size j = 0; j < first->dimSamples(); ++j) {
+                for (auto const& k : keys) {
+                    QL_REQUIRE(data[c]->get(i, j, k.first, k.second) == first->get(i, j, k.first, k.second),
+                               "mergeAggregationScenarioData(): data #"
+                                   << c << " differs from data #0 for key " << k.second << " at date index " << i
+                                   << ", sample " << j << ", were the shards run with the same scenario generator?");
+                }
+            }
+        }
+    }
+    return first;
+}
+
 } // namespace analytics
 } // namespace ore
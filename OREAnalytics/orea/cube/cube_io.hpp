@@ -41,6 +41,8 @@ struct NPVCubeWithMetaData {
     QuantLib::ext::shared_ptr<ScenarioGeneratorData> scenarioGeneratorData;
     boost::optional<bool> storeFlows;
     boost::optional<Size> storeCreditStateNPVs;
+    // trade hashes by trade id (see incrementalcube.hpp), empty if not given
+    std::map<std::string, std::string> tradeHashes;
 };
 
 NPVCubeWithMetaData loadCube(const std::string& filename, const bool doublePrecision = false);
@@ -49,5 +51,22 @@ void saveCube(const std::string& filename, const NPVCubeWithMetaData& cube, cons
 QuantLib::ext::shared_ptr<AggregationScenarioData> loadAggregationScenarioData(const std::string& filename);
 void saveAggregationScenarioData(const std::string& filename, const AggregationScenarioData& cube);
 
+/*! Select the ids belonging to shard shardIndex = 0, ..., shardCount - 1. The ids are assigned round robin in their
+    lexicographic order, so that each id belongs to exactly one shard. */
+std::set<std::string> shardIds(const std::set<std::string>& ids, const Size shardIndex, const Size shardCount);
+
+/*! Merge cubes generated for disjoint sets of ids, e.g. by sharded simulation runs. The cubes must agree in asof,
+    dates, samples and depth. The meta data is taken from the first cube, the trade hashes are joined. If
+    allowDuplicateIds is true, an id may occur in several cubes provided that all values agree, this is used for
+    counterparty cubes. The values are copied unchanged, so that the result is identical to a cube generated in a
+    single run. */
+NPVCubeWithMetaData mergeCubes(const std::vector<NPVCubeWithMetaData>& cubes, const bool doublePrecision = false,
+                               const bool allowDuplicateIds = false);
+
+/*! Merge aggregation scenario data from sharded simulation runs. All shards simulate the same scenarios, so the data
+    must be identical, this is checked and the first input is returned. */
+QuantLib::ext::shared_ptr<AggregationScenarioData>
+mergeAggregationScenarioData(const std::vector<QuantLib::ext::shared_ptr<AggregationScenarioData>>& data);
+
 } // namespace analytics
 } // namespace ore
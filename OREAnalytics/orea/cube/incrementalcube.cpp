@@ -0,0 +1,111 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <orea/cube/incrementalcube.hpp>
+#include <orea/cube/inmemorycube.hpp>
+
+#include <ored/utilities/log.hpp>
+
+#include <ql/errors.hpp>
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+
+namespace ore {
+namespace analytics {
+
+std::string tradeHash(const ore::data::Trade& trade) {
+    // 64 bit FNV-1a, this is stable across platforms and runs as opposed to std::hash
+    std::uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : trade.toXMLString()) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    std::ostringstream os;
+    os << std::hex << std::setw(16) << std::setfill('0') << h;
+    return os.str();
+}
+
+std::map<std::string, std::string> tradeHashes(const ore::data::Portfolio& portfolio) {
+    std::map<std::string, std::string> result;
+    for (auto const& [id, trade] : portfolio.trades())
+        result[id] = tradeHash(*trade);
+    return result;
+}
+
+std::set<std::string> changedTrades(const std::map<std::string, std::string>& previous,
+                                    const std::map<std::string, std::string>& current) {
+    std::set<std::string> result;
+    for (auto const& [id, hash] : current) {
+        auto p = previous.find(id);
+        if (p == previous.end() || p->second != hash)
+            result.insert(id);
+    }
+    return result;
+}
+
+QuantLib::ext::shared_ptr<NPVCube> spliceCube(const QuantLib::ext::shared_ptr<NPVCube>& previous,
+                                              const QuantLib::ext::shared_ptr<NPVCube>& update,
+                                              const std::set<std::string>& ids, const NPVCubeFactory& cubeFactory) {
+
+    QL_REQUIRE(previous, "spliceCube(): previous cube is null");
+    if (update) {
+        QL_REQUIRE(update->asof() == previous->asof(), "spliceCube(): asof does not match");
+        QL_REQUIRE(update->dates() == previous->dates(), "spliceCube(): dates do not match");
+        QL_REQUIRE(update->samples() == previous->samples(), "spliceCube(): samples do not match ("
+                                                                 << update->samples() << " vs. " << previous->samples()
+                                                                 << ")");
+        QL_REQUIRE(update->depth() == previous->depth(), "spliceCube(): depth does not match ("
+                                                             << update->depth() << " vs. " << previous->depth() << ")");
+    }
+
+    QuantLib::ext::shared_ptr<NPVCube> cube;
+    if (cubeFactory)
+        cube = cubeFactory(previous->asof(), ids, previous->dates(), previous->samples(), previous->depth());
+    else if (previous->depth() <= 1)
+        cube = QuantLib::ext::make_shared<SinglePrecisionInMemoryCube>(previous->asof(), ids, previous->dates(),
+                                                                       previous->samples(), 0.0f);
+    else
+        cube = QuantLib::ext::make_shared<SinglePrecisionInMemoryCubeN>(
+            previous->asof(), ids, previous->dates(), previous->samples(), previous->depth(), 0.0f);
+
+    Size fromUpdate = 0;
+    for (auto const& [id, pos] : cube->idsAndIndexes()) {
+        NPVCube* source = previous.get();
+        if (update && update->idsAndIndexes().count(id) > 0) {
+            source = update.get();
+            ++fromUpdate;
+        }
+        Size i = source->getTradeIndex(id);
+        for (Size d = 0; d < cube->depth(); ++d) {
+            cube->setT0(source->getT0(i, d), pos, d);
+            for (Size j = 0; j < cube->numDates(); ++j) {
+                for (Size k = 0; k < cube->samples(); ++k)
+                    cube->set(source->get(i, j, k, d), pos, j, k, d);
+            }
+        }
+    }
+
+    DLOG("spliceCube(): " << fromUpdate << " ids taken from update cube, " << cube->numIds() - fromUpdate
+                          << " from previous cube");
+    return cube;
+}
+
+} // namespace analytics
+} // namespace ore
@@ -0,0 +1,63 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/cube/incrementalcube.hpp
+    \brief utilities to reuse the npv cube of a previous run for unchanged trades
+    \ingroup cube
+*/
+
+#pragma once
+
+#include <orea/cube/npvcube.hpp>
+
+#include <ored/portfolio/portfolio.hpp>
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ore {
+namespace analytics {
+
+//! Hash of the trade's XML representation, used to detect new or amended trades between two runs
+std::string tradeHash(const ore::data::Trade& trade);
+
+//! Trade hashes by trade id
+std::map<std::string, std::string> tradeHashes(const ore::data::Portfolio& portfolio);
+
+//! Ids of the trades in \p current which are not in \p previous or whose hash differs
+std::set<std::string> changedTrades(const std::map<std::string, std::string>& previous,
+                                    const std::map<std::string, std::string>& current);
+
+//! Creates an empty cube for the given asof date, ids, dates, samples and depth
+using NPVCubeFactory = std::function<QuantLib::ext::shared_ptr<NPVCube>(
+    const QuantLib::Date&, const std::set<std::string>&, const std::vector<QuantLib::Date>&, QuantLib::Size,
+    QuantLib::Size)>;
+
+/*! Build an in-memory cube with the given ids. The entries for ids contained in \p update are copied from this cube,
+    all other entries are copied from \p previous. The update cube may be null. The spliced cube is created by
+    \p cubeFactory if given, otherwise it is a single precision in-memory cube. */
+QuantLib::ext::shared_ptr<NPVCube> spliceCube(const QuantLib::ext::shared_ptr<NPVCube>& previous,
+                                              const QuantLib::ext::shared_ptr<NPVCube>& update,
+                                              const std::set<std::string>& ids,
+                                              const NPVCubeFactory& cubeFactory = NPVCubeFactory());
+
+} // namespace analytics
+} // namespace ore
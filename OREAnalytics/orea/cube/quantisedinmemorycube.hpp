@@ -0,0 +1,244 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/cube/quantisedinmemorycube.hpp
+    \brief An in memory cube storing quantised values with a scale per (id, date, depth) block
+    \ingroup cube
+*/
+
+#pragma once
+
+#include <orea/cube/npvcube.hpp>
+
+#include <ored/utilities/log.hpp>
+
+#include <ql/errors.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <type_traits>
+#include <vector>
+
+namespace ore {
+namespace analytics {
+using QuantLib::Date;
+using QuantLib::Real;
+using QuantLib::Size;
+using std::vector;
+
+//! In memory cube storing quantised values
+/*! The T0 values are stored in double precision. All other values are stored as the difference to the T0 value of
+    the same id and depth, quantised to the signed integer type T. The scale is a power of two shared by all samples
+    of an (id, date, depth) block and is chosen as small as possible such that the largest absolute difference in the
+    block is still representable. If a larger difference is set later, the scale of the block is increased and the
+    values already stored are rescaled.
+
+    The absolute error of a value retrieved via get() is bounded by one quantisation step of its block, which is
+    returned by errorBound(). Relative to the largest absolute difference to T0 in the block this is at most
+    relativeErrorBound(), i.e. \f$2^{-14}\f$ for 16 bit and \f$2^{-6}\f$ for 8 bit storage. There is no bound
+    relative to the individual values. If an absolute error tolerance is given, a warning is logged for each block
+    whose error bound exceeds it.
+
+    Values that are not finite, or whose difference to T0 is not finite, are marked by a reserved integer and kept
+    as they are in a separate map per id. They do not affect the scale of their block.
+
+    Values are decoded with a single multiplication, so reading the cube in e.g. the exposure calculator does not
+    require a separate decompression step. Different ids are stored in separate containers, so different ids can be
+    written to concurrently.
+
+    \ingroup cube
+*/
+template <typename T> class QuantisedInMemoryCube : public NPVCube {
+    static_assert(std::is_integral<T>::value && std::is_signed<T>::value,
+                  "QuantisedInMemoryCube requires a signed integral storage type");
+
+public:
+    QuantisedInMemoryCube(const Date& asof, const std::set<std::string>& ids, const vector<Date>& dates, Size samples,
+                          Size depth = 1, Real errorTolerance = 0.0)
+        : asof_(asof), dates_(dates), samples_(samples), depth_(depth), errorTolerance_(errorTolerance),
+          t0Data_(ids.size() * depth, 0.0), exponents_(ids.size() * dates.size() * depth, emptyBlock),
+          data_(ids.size(), vector<T>(dates.size() * depth * samples, 0)), nonFiniteValues_(ids.size()) {
+        QL_REQUIRE(ids.size() > 0, "QuantisedInMemoryCube: no ids specified");
+        QL_REQUIRE(dates.size() > 0, "QuantisedInMemoryCube: no dates specified");
+        QL_REQUIRE(samples > 0, "QuantisedInMemoryCube: samples must be > 0");
+        QL_REQUIRE(depth > 0, "QuantisedInMemoryCube: depth must be > 0");
+        QL_REQUIRE(errorTolerance >= 0.0, "QuantisedInMemoryCube: error tolerance must be >= 0");
+        Size pos = 0;
+        for (const auto& id : ids)
+            idIdx_[id] = pos++;
+    }
+
+    Size numIds() const override { return idIdx_.size(); }
+    Size numDates() const override { return dates_.size(); }
+    Size samples() const override { return samples_; }
+    Size depth() const override { return depth_; }
+
+    const std::map<std::string, Size>& idsAndIndexes() const override { return idIdx_; }
+    const std::vector<QuantLib::Date>& dates() const override { return dates_; }
+    QuantLib::Date asof() const override { return asof_; }
+
+    Real getT0(Size i, Size d) const override {
+        check(i, 0, 0, d);
+        return t0Data_[i * depth_ + d];
+    }
+
+    //! Set a T0 value, values already set for the id and depth are re-encoded relative to the new T0 value
+    void setT0(Real value, Size i, Size d) override {
+        check(i, 0, 0, d);
+        vector<Real> values;
+        for (Size j = 0; j < dates_.size(); ++j) {
+            if (exponents_[block(i, j, d)] == emptyBlock)
+                continue;
+            values.resize(samples_);
+            for (Size k = 0; k < samples_; ++k)
+                values[k] = get(i, j, k, d);
+            exponents_[block(i, j, d)] = emptyBlock;
+            std::fill_n(data_[i].begin() + offset(j, d), samples_, T(0));
+            for (Size k = 0; k < samples_; ++k)
+                nonFiniteValues_[i].erase(offset(j, d) + k);
+            Real oldT0 = t0Data_[i * depth_ + d];
+            t0Data_[i * depth_ + d] = value;
+            for (Size k = 0; k < samples_; ++k)
+                set(values[k], i, j, k, d);
+            t0Data_[i * depth_ + d] = oldT0;
+        }
+        t0Data_[i * depth_ + d] = value;
+    }
+
+    Real get(Size i, Size j, Size k, Size d) const override {
+        check(i, j, k, d);
+        Real t0 = t0Data_[i * depth_ + d];
+        int e = exponents_[block(i, j, d)];
+        if (e == emptyBlock)
+            return t0;
+        T q = data_[i][offset(j, d) + k];
+        if (q == nonFinite)
+            return nonFiniteValues_[i].at(offset(j, d) + k);
+        return t0 + std::ldexp(static_cast<Real>(q), e);
+    }
+
+    void set(Real value, Size i, Size j, Size k, Size d) override {
+        check(i, j, k, d);
+        Real x = value - t0Data_[i * depth_ + d];
+        std::int16_t& e = exponents_[block(i, j, d)];
+        if (x == 0.0 && e == emptyBlock)
+            return;
+        T* q = &data_[i][offset(j, d)];
+        if (q[k] == nonFinite)
+            nonFiniteValues_[i].erase(offset(j, d) + k);
+        if (!std::isfinite(x)) {
+            nonFiniteValues_[i][offset(j, d) + k] = value;
+            q[k] = nonFinite;
+            // the block is no longer empty, the smallest scale lets the first finite value choose the scale
+            if (e == emptyBlock)
+                e = minExponent;
+            return;
+        }
+        if (e == emptyBlock || std::fabs(x) > std::ldexp(static_cast<Real>(maxQuantum), e)) {
+            // |x| < 2^exponent, choose the scale such that |x| / scale < 2^digits
+            int exponent;
+            std::frexp(x, &exponent);
+            int newE = exponent - std::numeric_limits<T>::digits;
+            if (e != emptyBlock) {
+                for (Size s = 0; s < samples_; ++s) {
+                    if (q[s] != nonFinite)
+                        q[s] = quantise(std::ldexp(static_cast<Real>(q[s]), e - newE));
+                }
+            }
+            if (errorTolerance_ > 0.0 && std::ldexp(1.0, newE) > errorTolerance_ &&
+                (e == emptyBlock || std::ldexp(1.0, e) <= errorTolerance_)) {
+                WLOG("QuantisedInMemoryCube: error bound " << std::ldexp(1.0, newE) << " for id " << i << ", date "
+                                                           << j << ", depth " << d << " exceeds the tolerance "
+                                                           << errorTolerance_);
+            }
+            e = static_cast<std::int16_t>(newE);
+        }
+        q[k] = quantise(std::ldexp(x, -e));
+    }
+
+    using NPVCube::remove;
+
+    //! Reset all values and the T0 values for the given id
+    void remove(Size i) override {
+        check(i, 0, 0, 0);
+        std::fill(data_[i].begin(), data_[i].end(), T(0));
+        std::fill_n(exponents_.begin() + block(i, 0, 0), dates_.size() * depth_, emptyBlock);
+        std::fill_n(t0Data_.begin() + i * depth_, depth_, 0.0);
+        nonFiniteValues_[i].clear();
+    }
+
+    //! Bound for the absolute error of the finite values retrieved for the given id, date and depth
+    Real errorBound(Size i, Size j, Size d) const {
+        check(i, j, 0, d);
+        int e = exponents_[block(i, j, d)];
+        return e == emptyBlock ? 0.0 : std::ldexp(1.0, e);
+    }
+
+    //! Absolute error tolerance above which a warning is logged, zero if there is no check
+    Real errorTolerance() const { return errorTolerance_; }
+
+    //! Bound for the absolute error relative to the largest absolute difference to T0 in a block
+    static Real relativeErrorBound() { return std::ldexp(1.0, 1 - std::numeric_limits<T>::digits); }
+
+private:
+    static constexpr std::int16_t emptyBlock = std::numeric_limits<std::int16_t>::min();
+    static constexpr std::int16_t minExponent = emptyBlock + 1;
+    static constexpr T maxQuantum = std::numeric_limits<T>::max();
+    // quantise() never returns the minimum of T, it marks values that are not finite
+    static constexpr T nonFinite = std::numeric_limits<T>::min();
+
+    void check(Size i, Size j, Size k, Size d) const {
+        QL_REQUIRE(i < numIds(), "Out of bounds on ids (i=" << i << ", numIds=" << numIds() << ")");
+        QL_REQUIRE(j < numDates(), "Out of bounds on dates (j=" << j << ", numDates=" << numDates() << ")");
+        QL_REQUIRE(k < samples(), "Out of bounds on samples (k=" << k << ", samples=" << samples() << ")");
+        QL_REQUIRE(d < depth(), "Out of bounds on depth (d=" << d << ", depth=" << depth() << ")");
+    }
+
+    Size block(Size i, Size j, Size d) const { return (i * dates_.size() + j) * depth_ + d; }
+    Size offset(Size j, Size d) const { return (j * depth_ + d) * samples_; }
+
+    static T quantise(Real x) {
+        return static_cast<T>(std::max<long>(-maxQuantum, std::min<long>(maxQuantum, std::lround(x))));
+    }
+
+    QuantLib::Date asof_;
+    vector<QuantLib::Date> dates_;
+    Size samples_, depth_;
+    Real errorTolerance_;
+    std::map<std::string, Size> idIdx_;
+    vector<Real> t0Data_;
+    // scale exponent per (id, date, depth) block, emptyBlock if all values in the block equal T0
+    vector<std::int16_t> exponents_;
+    // per id, the quantised values ordered by date, depth and sample
+    vector<vector<T>> data_;
+    // per id, the values that are not finite by their position in data_
+    vector<std::map<Size, Real>> nonFiniteValues_;
+};
+
+//! QuantisedInMemoryCube with 16 bit storage
+using QuantisedInMemoryCube16 = QuantisedInMemoryCube<std::int16_t>;
+
+//! QuantisedInMemoryCube with 8 bit storage
+using QuantisedInMemoryCube8 = QuantisedInMemoryCube<std::int8_t>;
+
+} // namespace analytics
+} // namespace ore
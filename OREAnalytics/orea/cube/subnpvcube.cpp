@@ -0,0 +1,39 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <orea/cube/subnpvcube.hpp>
+
+#include <ql/errors.hpp>
+
+namespace ore {
+namespace analytics {
+
+SubNPVCube::SubNPVCube(const QuantLib::ext::shared_ptr<NPVCube>& cube, const std::set<std::string>& ids)
+    : NPVCube(), cube_(cube) {
+    QL_REQUIRE(cube_ != nullptr, "SubNPVCube: no underlying cube given");
+    Size pos = 0;
+    for (auto const& id : ids) {
+        auto it = cube_->idsAndIndexes().find(id);
+        QL_REQUIRE(it != cube_->idsAndIndexes().end(), "SubNPVCube: id '" << id << "' not found in underlying cube");
+        idIdx_[id] = pos++;
+        cubeIds_.push_back(it->second);
+    }
+}
+
+} // namespace analytics
+} // namespace ore
@@ -0,0 +1,86 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/cube/subnpvcube.hpp
+    \brief view on a subset of the ids of a cube
+    \ingroup cube
+*/
+
+#pragma once
+
+#include <orea/cube/npvcube.hpp>
+
+namespace ore {
+namespace analytics {
+
+using QuantLib::Real;
+using QuantLib::Size;
+
+//! View on a subset of the ids of an NPV cube
+/*! All reads and writes are forwarded to the underlying cube, mapping the local id index to the index of the id
+    in the underlying cube. Several views on disjoint id subsets can be written to concurrently, provided the
+    underlying cube supports concurrent writes to distinct ids, as do the InMemoryCube types, which allocate their
+    storage upfront.
+
+    \ingroup cube
+ */
+class SubNPVCube : public NPVCube {
+public:
+    /*! The ids must be a subset of the ids of the underlying cube */
+    SubNPVCube(const QuantLib::ext::shared_ptr<NPVCube>& cube, const std::set<std::string>& ids);
+
+    //! Return the length of each dimension
+    Size numIds() const override { return idIdx_.size(); }
+    Size numDates() const override { return cube_->numDates(); }
+    Size samples() const override { return cube_->samples(); }
+    Size depth() const override { return cube_->depth(); }
+
+    const std::map<std::string, Size>& idsAndIndexes() const override { return idIdx_; }
+    const std::vector<QuantLib::Date>& dates() const override { return cube_->dates(); }
+    QuantLib::Date asof() const override { return cube_->asof(); }
+
+    Real getT0(Size id, Size depth = 0) const override { return cube_->getT0(cubeId(id), depth); }
+    void setT0(Real value, Size id, Size depth = 0) override { cube_->setT0(value, cubeId(id), depth); }
+
+    Real get(Size id, Size date, Size sample, Size depth = 0) const override {
+        return cube_->get(cubeId(id), date, sample, depth);
+    }
+    void set(Real value, Size id, Size date, Size sample, Size depth = 0) override {
+        cube_->set(value, cubeId(id), date, sample, depth);
+    }
+
+    void remove(Size id) override { cube_->remove(cubeId(id)); }
+    void remove(Size id, Size sample) override { cube_->remove(cubeId(id), sample); }
+
+    //! The underlying cube
+    const QuantLib::ext::shared_ptr<NPVCube>& cube() const { return cube_; }
+
+private:
+    Size cubeId(Size id) const {
+        QL_REQUIRE(id < cubeIds_.size(),
+                   "SubNPVCube: id (" << id << ") out of range, have " << cubeIds_.size() << " ids");
+        return cubeIds_[id];
+    }
+
+    const QuantLib::ext::shared_ptr<NPVCube> cube_;
+    std::map<std::string, Size> idIdx_;
+    std::vector<Size> cubeIds_;
+};
+
+} // namespace analytics
+} // namespace ore
@@ -734,11 +734,11 @@ void AMCValuationEngine::buildCube(const QuantLib::ext::shared_ptr<ore::data::Po
             portfolioIndex = 0;
     }
 
-    // output the portfolios into strings so that the worker threads can load them from there
+    // take binary snapshots of the portfolios so that the worker threads can load them from there without parsing xml
 
-    std::vector<std::string> portfoliosAsString;
+    std::vector<ore::data::XMLSnapshot> portfolioSnapshots;
     for (auto const& p : portfolios) {
-        portfoliosAsString.emplace_back(p->toXMLString());
+        portfolioSnapshots.push_back(p->toXMLSnapshot());
     }
 
     // log info on the portfolio split
@@ -793,7 +793,7 @@ void AMCValuationEngine::buildCube(const QuantLib::ext::shared_ptr<ore::data::Po
 
     for (Size i = 0; i < eff_nThreads; ++i) {
 
-        auto job = [this, obsMode, &portfoliosAsString, &loaders, &simDates, &progressIndicator](int id) -> resultType {
+        auto job = [this, obsMode, &portfolioSnapshots, &loaders, &simDates, &progressIndicator](int id) -> resultType {
             // set thread local singletons
 
             QuantLib::Settings::instance().evaluationDate() = today_;
@@ -835,7 +835,7 @@ void AMCValuationEngine::buildCube(const QuantLib::ext::shared_ptr<ore::data::Po
                 // build portfolio against init market
 
                 auto portfolio = QuantLib::ext::make_shared<ore::data::Portfolio>();
-                portfolio->fromXMLString(portfoliosAsString[id]);
+                portfolio->fromXMLSnapshot(portfolioSnapshots[id]);
 
                 QuantLib::ext::shared_ptr<EngineData> edCopy = QuantLib::ext::make_shared<EngineData>(*engineData_);
                 edCopy->globalParameters()["GenerateAdditionalResults"] = "false";
@@ -25,20 +25,20 @@ BufferedSensitivityStream::BufferedSensitivityStream(const QuantLib::ext::shared
     : stream_(stream) {}
 
 SensitivityRecord BufferedSensitivityStream::next() {
-    if (index_ == QuantLib::Null<Size>()) {
-        buffer_.push_back(stream_->next());
-        return buffer_.back();
-    }
-    if (index_ < buffer_.size()) {
-        return buffer_[index_++];
-    }
-    return {};
+    if (buffered_)
+        return buffer_.next();
+    nextCalled_ = true;
+    SensitivityRecord sr = stream_->next();
+    if (sr)
+        buffer_.add(sr);
+    return sr;
 }
 
 void BufferedSensitivityStream::reset() {
     // if next() was never called, we do not switch to the buffered mode
-    if (!buffer_.empty())
-        index_ = 0;
+    if (nextCalled_)
+        buffered_ = true;
+    buffer_.reset();
 }
 
 } // namespace analytics
@@ -22,7 +22,7 @@
 
 #pragma once
 
-#include <orea/engine/sensitivitystream.hpp>
+#include <orea/engine/columnarsensitivitystream.hpp>
 
 namespace ore {
 namespace analytics {
@@ -35,8 +35,9 @@ public:
 
 private:
     QuantLib::ext::shared_ptr<SensitivityStream> stream_;
-    std::vector<SensitivityRecord> buffer_;
-    QuantLib::Size index_ = QuantLib::Null<QuantLib::Size>();
+    ColumnarSensitivityStream buffer_;
+    bool buffered_ = false;
+    bool nextCalled_ = false;
 };
 
 } // namespace analytics
@@ -0,0 +1,125 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <orea/engine/columnarsensitivitystream.hpp>
+
+#include <ql/errors.hpp>
+
+#include <limits>
+
+namespace ore {
+namespace analytics {
+
+ColumnarSensitivityStream::ColumnarSensitivityStream() { clear(); }
+
+SensitivityRecord ColumnarSensitivityStream::next() {
+    // If there are no more records, return the empty record
+    if (current_ >= size())
+        return SensitivityRecord();
+    return record(current_++);
+}
+
+void ColumnarSensitivityStream::reset() { current_ = 0; }
+
+void ColumnarSensitivityStream::add(const SensitivityRecord& sr) {
+    QL_REQUIRE(size() < std::numeric_limits<std::uint32_t>::max(),
+               "ColumnarSensitivityStream::add(): maximum number of records exceeded");
+    tradeIndex_.push_back(static_cast<std::uint32_t>(tradeIdx(sr.tradeId)));
+    factorIndex1_.push_back(static_cast<std::uint32_t>(factorIdx(sr.key_1, sr.desc_1, sr.shift_1)));
+    factorIndex2_.push_back(static_cast<std::uint32_t>(factorIdx(sr.key_2, sr.desc_2, sr.shift_2)));
+    currencyIndex_.push_back(static_cast<std::uint32_t>(currencyIdx(sr.currency)));
+    isPar_.push_back(sr.isPar ? 1 : 0);
+    baseNpv_.push_back(sr.baseNpv);
+    delta_.push_back(sr.delta);
+    gamma_.push_back(sr.gamma);
+    reset();
+}
+
+void ColumnarSensitivityStream::reserve(QuantLib::Size n) {
+    tradeIndex_.reserve(n);
+    factorIndex1_.reserve(n);
+    factorIndex2_.reserve(n);
+    currencyIndex_.reserve(n);
+    isPar_.reserve(n);
+    baseNpv_.reserve(n);
+    delta_.reserve(n);
+    gamma_.reserve(n);
+}
+
+void ColumnarSensitivityStream::clear() {
+    tradeIds_.clear();
+    tradeLookup_.clear();
+    factors_.clear();
+    factorLookup_.clear();
+    currencies_.clear();
+    tradeIndex_.clear();
+    factorIndex1_.clear();
+    factorIndex2_.clear();
+    currencyIndex_.clear();
+    isPar_.clear();
+    baseNpv_.clear();
+    delta_.clear();
+    gamma_.clear();
+    current_ = 0;
+    // factor 0 is the empty risk factor, so that a zero second index identifies a non cross gamma record
+    factors_.push_back({RiskFactorKey(), std::string(), 0.0});
+}
+
+SensitivityRecord ColumnarSensitivityStream::record(QuantLib::Size i) const {
+    const Factor& f1 = factors_[factorIndex1_[i]];
+    const Factor& f2 = factors_[factorIndex2_[i]];
+    return SensitivityRecord(tradeIds_[tradeIndex_[i]], isPar_[i] != 0, f1.key, f1.description, f1.shift, f2.key,
+                             f2.description, f2.shift, currencies_[currencyIndex_[i]], baseNpv_[i], delta_[i],
+                             gamma_[i]);
+}
+
+QuantLib::Size ColumnarSensitivityStream::tradeIdx(const std::string& tradeId) {
+    auto r = tradeLookup_.emplace(tradeId, static_cast<std::uint32_t>(tradeIds_.size()));
+    if (r.second)
+        tradeIds_.push_back(tradeId);
+    return r.first->second;
+}
+
+QuantLib::Size ColumnarSensitivityStream::factorIdx(const RiskFactorKey& key, const std::string& description,
+                                                    QuantLib::Real shift) {
+    if (key == RiskFactorKey())
+        return 0;
+    // the description and shift size are in general a function of the key, so there is usually one candidate
+    auto& candidates = factorLookup_[key];
+    for (auto c : candidates) {
+        const Factor& f = factors_[c];
+        if (f.shift == shift && f.description == description)
+            return c;
+    }
+    candidates.push_back(static_cast<std::uint32_t>(factors_.size()));
+    factors_.push_back({key, description, shift});
+    return candidates.back();
+}
+
+QuantLib::Size ColumnarSensitivityStream::currencyIdx(const std::string& currency) {
+    // there are only a handful of currencies, a linear search is faster than a hash lookup
+    for (QuantLib::Size i = 0; i < currencies_.size(); ++i) {
+        if (currencies_[i] == currency)
+            return i;
+    }
+    currencies_.push_back(currency);
+    return currencies_.size() - 1;
+}
+
+} // namespace analytics
+} // namespace ore
@@ -0,0 +1,135 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/engine/columnarsensitivitystream.hpp
+    \brief Compact in-memory sensitivity store with interned trade ids and risk factors
+ */
+
+#pragma once
+
+#include <orea/engine/sensitivitystream.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ore {
+namespace analytics {
+
+/*! Class for storing and streaming SensitivityRecords in a columnar layout.
+
+    Trade ids, risk factors (key, description and shift size) and currencies are interned into dictionaries
+    and each record is stored as a row of integer indices into these dictionaries plus the base npv, delta
+    and gamma values. The full SensitivityRecord is only materialised on next() or record(), consumers that
+    are aware of the columnar layout can work on the integer indices directly.
+
+    Factor index 0 is reserved for the empty risk factor, i.e. factorIndex2(i) == 0 iff record i is not a
+    cross gamma. The description and shift attached to an empty risk factor key are not retained.
+*/
+class ColumnarSensitivityStream : public SensitivityStream {
+public:
+    //! A risk factor together with its description and shift size as it appears in a SensitivityRecord
+    struct Factor {
+        RiskFactorKey key;
+        std::string description;
+        QuantLib::Real shift;
+    };
+
+    //! Default constructor
+    ColumnarSensitivityStream();
+    //! Constructor from a range of sensitivity records
+    template <class Iter> ColumnarSensitivityStream(Iter begin, Iter end);
+
+    //! \name SensitivityStream interface
+    //@{
+    SensitivityRecord next() override;
+    void reset() override;
+    //@}
+
+    /*! Add a record to the store.
+
+        \warning this causes reset() to be called, i.e. after a call to add, a call to next() will start at
+                 the beginning again.
+    */
+    void add(const SensitivityRecord& sr);
+    //! Reserve space for \p n records
+    void reserve(QuantLib::Size n);
+    //! Remove all records and clear the dictionaries
+    void clear();
+
+    //! \name Index based access
+    //@{
+    QuantLib::Size size() const { return tradeIndex_.size(); }
+    bool empty() const { return tradeIndex_.empty(); }
+
+    QuantLib::Size tradeIndex(QuantLib::Size i) const { return tradeIndex_[i]; }
+    QuantLib::Size factorIndex1(QuantLib::Size i) const { return factorIndex1_[i]; }
+    QuantLib::Size factorIndex2(QuantLib::Size i) const { return factorIndex2_[i]; }
+    QuantLib::Size currencyIndex(QuantLib::Size i) const { return currencyIndex_[i]; }
+    bool isPar(QuantLib::Size i) const { return isPar_[i] != 0; }
+    bool isCrossGamma(QuantLib::Size i) const { return factorIndex2_[i] != 0; }
+    QuantLib::Real baseNpv(QuantLib::Size i) const { return baseNpv_[i]; }
+    QuantLib::Real delta(QuantLib::Size i) const { return delta_[i]; }
+    QuantLib::Real gamma(QuantLib::Size i) const { return gamma_[i]; }
+
+    //! Materialise record \p i as a SensitivityRecord
+    SensitivityRecord record(QuantLib::Size i) const;
+    //@}
+
+    //! \name Dictionaries
+    //@{
+    const std::vector<std::string>& tradeIds() const { return tradeIds_; }
+    const std::vector<Factor>& factors() const { return factors_; }
+    const std::vector<std::string>& currencies() const { return currencies_; }
+    //@}
+
+private:
+    QuantLib::Size tradeIdx(const std::string& tradeId);
+    QuantLib::Size factorIdx(const RiskFactorKey& key, const std::string& description, QuantLib::Real shift);
+    QuantLib::Size currencyIdx(const std::string& currency);
+
+    // dictionaries
+    std::vector<std::string> tradeIds_;
+    std::unordered_map<std::string, std::uint32_t> tradeLookup_;
+    std::vector<Factor> factors_;
+    std::unordered_map<RiskFactorKey, std::vector<std::uint32_t>> factorLookup_;
+    std::vector<std::string> currencies_;
+
+    // columns
+    std::vector<std::uint32_t> tradeIndex_;
+    std::vector<std::uint32_t> factorIndex1_;
+    std::vector<std::uint32_t> factorIndex2_;
+    std::vector<std::uint32_t> currencyIndex_;
+    std::vector<char> isPar_;
+    std::vector<QuantLib::Real> baseNpv_;
+    std::vector<QuantLib::Real> delta_;
+    std::vector<QuantLib::Real> gamma_;
+
+    //! Position of the next record to be streamed
+    QuantLib::Size current_ = 0;
+};
+
+template <class Iter>
+ColumnarSensitivityStream::ColumnarSensitivityStream(Iter begin, Iter end) : ColumnarSensitivityStream() {
+    for (; begin != end; ++begin)
+        add(*begin);
+}
+
+} // namespace analytics
+} // namespace ore
@@ -19,18 +19,26 @@
 #include <orea/engine/historicalpnlgenerator.hpp>
 
 #include <orea/engine/multithreadedvaluationengine.hpp>
+#include <orea/engine/observationmode.hpp>
 #include <orea/engine/valuationcalculator.hpp>
 
-#include <orea/cube/jointnpvcube.hpp>
 #include <orea/cube/inmemorycube.hpp>
 
+#include <ored/marketdata/clonedloader.hpp>
+#include <ored/marketdata/todaysmarket.hpp>
+#include <ored/portfolio/structuredtradeerror.hpp>
+#include <ored/utilities/to_string.hpp>
+
 #include <boost/range/adaptor/indexed.hpp>
 
+#include <future>
+
 using ore::data::EngineBuilder;
 using ore::data::EngineData;
 using ore::data::EngineFactory;
 using ore::data::MarketContext;
 using ore::data::Portfolio;
+using ore::data::StructuredTradeErrorMessage;
 using ore::data::TimePeriod;
 using QuantLib::Real;
 using QuantLib::io::iso_date;
@@ -47,8 +55,8 @@ HistoricalPnlGenerator::HistoricalPnlGenerator(
     const QuantLib::ext::shared_ptr<ScenarioSimMarket>& simMarket,
     const QuantLib::ext::shared_ptr<HistoricalScenarioGenerator>& hisScenGen, const QuantLib::ext::shared_ptr<NPVCube>& cube,
     const set<std::pair<string, QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>>>& modelBuilders, bool dryRun)
-    : useSingleThreadedEngine_(true), portfolio_(portfolio), simMarket_(simMarket), hisScenGen_(hisScenGen),
-      cube_(cube), dryRun_(dryRun),
+    : useSingleThreadedEngine_(true), baseCurrency_(baseCurrency), portfolio_(portfolio), simMarket_(simMarket),
+      hisScenGen_(hisScenGen), cube_(cube), modelBuilders_(modelBuilders), dryRun_(dryRun),
       npvCalculator_([&baseCurrency]() -> std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>> {
           return {QuantLib::ext::make_shared<NPVCalculator>(baseCurrency)};
       }) {
@@ -85,8 +93,8 @@ HistoricalPnlGenerator::HistoricalPnlGenerator(
     const QuantLib::ext::shared_ptr<ore::analytics::ScenarioSimMarketParameters>& simMarketData,
     const QuantLib::ext::shared_ptr<ReferenceDataManager>& referenceData, const IborFallbackConfig& iborFallbackConfig,
     bool dryRun, const std::string& context)
-    : useSingleThreadedEngine_(false), portfolio_(portfolio), hisScenGen_(hisScenGen), engineData_(engineData),
-      nThreads_(nThreads), today_(today), loader_(loader), curveConfigs_(curveConfigs),
+    : useSingleThreadedEngine_(false), baseCurrency_(baseCurrency), portfolio_(portfolio), hisScenGen_(hisScenGen),
+      engineData_(engineData), nThreads_(nThreads), today_(today), loader_(loader), curveConfigs_(curveConfigs),
       todaysMarketParams_(todaysMarketParams), configuration_(configuration), simMarketData_(simMarketData),
       referenceData_(referenceData), iborFallbackConfig_(iborFallbackConfig), dryRun_(dryRun), context_(context),
       npvCalculator_([&baseCurrency]() -> std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>> {
@@ -114,21 +122,278 @@ void HistoricalPnlGenerator::generateCube(const QuantLib::ext::shared_ptr<Scenar
         valuationEngine_->buildCube(portfolio_, cube_, npvCalculator_(), true, nullptr, nullptr, {}, dryRun_);
 
     } else {
-        MultiThreadedValuationEngine engine(
-            nThreads_, today_, QuantLib::ext::make_shared<ore::analytics::DateGrid>(), hisScenGen_->numScenarios(), loader_,
-            hisScenGen_, engineData_, curveConfigs_, todaysMarketParams_, configuration_, simMarketData_, false, false,
-            filter, referenceData_, iborFallbackConfig_, true, true, true, {}, {}, {}, context_);
+        auto dateGrid = QuantLib::ext::make_shared<ore::analytics::DateGrid>();
+        MultiThreadedValuationEngine engine(nThreads_, today_, dateGrid, hisScenGen_->numScenarios(), loader_,
+                                            hisScenGen_, engineData_, curveConfigs_, todaysMarketParams_,
+                                            configuration_, simMarketData_, false, false, filter, referenceData_,
+                                            iborFallbackConfig_, true, true, true, {}, {}, {}, context_);
         for (auto const& i : this->progressIndicators()) {
             i->reset();
             engine.registerProgressIndicator(i);
         }
+        // the threads write into disjoint id ranges of this cube
+        cube_ = QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(
+            today_, portfolio_->ids(), dateGrid->valuationDates(), hisScenGen_->numScenarios());
+        engine.setOutputCube(cube_);
         engine.buildCube(portfolio_, npvCalculator_, {}, true, dryRun_);
-        cube_ = QuantLib::ext::make_shared<JointNPVCube>(engine.outputCubes(), portfolio_->ids(), true);
     }
 
     DLOG("Historical P&L cube generated");
 }
 
+void HistoricalPnlGenerator::generateCube(const vector<QuantLib::ext::shared_ptr<ScenarioFilter>>& filters) {
+
+    QL_REQUIRE(!filters.empty(), "HistoricalPnlGenerator::generateCube(): no scenario filters given");
+
+    Size nSamples = hisScenGen_->numScenarios();
+    DLOG("Filling historical P&L cube for " << portfolio_->size() << " trades, " << nSamples << " scenarios and "
+                                            << filters.size() << " scenario filters.");
+
+    // draw the historical scenarios once, they are shared by all filters and threads
+
+    Date asof = useSingleThreadedEngine_ ? simMarket_->asofDate() : today_;
+    hisScenGen_->reset();
+    vector<QuantLib::ext::shared_ptr<Scenario>> scenarios;
+    for (Size s = 0; s < (dryRun_ ? std::min<Size>(1, nSamples) : nSamples); ++s)
+        scenarios.push_back(hisScenGen_->next(asof));
+
+    // evaluate the filters on the scenario keys once
+
+    QL_REQUIRE(hisScenGen_->baseScenario(), "HistoricalPnlGenerator::generateCube(): no base scenario set");
+    const auto& keys = hisScenGen_->baseScenario()->keys();
+    vector<vector<bool>> allowed(filters.size(), vector<bool>(keys.size()));
+    for (Size k = 0; k < filters.size(); ++k)
+        for (Size i = 0; i < keys.size(); ++i)
+            allowed[k][i] = filters[k]->allow(keys[i]);
+
+    filterCube_ = QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(asof, portfolio_->ids(),
+                                                                           vector<Date>(1, asof), nSamples,
+                                                                           filters.size());
+
+    std::atomic<Size> nextSample(0), samplesDone(0);
+    set<Size> failedTrades;
+
+    if (useSingleThreadedEngine_) {
+
+        failedTrades = populateFilterCube(portfolio_, simMarket_, modelBuilders_, scenarios, allowed, nextSample,
+                                          samplesDone, true, true);
+
+    } else {
+
+        // check whether sessions are enabled, if not exit with an error
+
+#ifndef QL_ENABLE_SESSIONS
+        QL_FAIL("HistoricalPnlGenerator::generateCube(): multi-threaded mode requires a build with "
+                "QL_ENABLE_SESSIONS = ON.");
+#endif
+
+        Size nThreads = std::max<Size>(1, std::min(nThreads_, scenarios.size()));
+        LOG("Generate historical P&L cube using " << nThreads << " threads");
+
+        // each thread builds the whole portfolio against its own market built from cloned market data
+
+        auto portfolioSnapshot = portfolio_->toXMLSnapshot();
+        vector<QuantLib::ext::shared_ptr<ore::data::ClonedLoader>> loaders;
+        for (Size t = 0; t < nThreads; ++t)
+            loaders.push_back(QuantLib::ext::make_shared<ore::data::ClonedLoader>(today_, loader_));
+
+        ObservationMode::Mode obsMode = ObservationMode::instance().mode();
+        vector<std::future<set<Size>>> results;
+        for (Size t = 0; t < nThreads; ++t) {
+            results.push_back(std::async(std::launch::async, [this, t, obsMode, &portfolioSnapshot, &loaders,
+                                                              &scenarios, &allowed, &nextSample, &samplesDone]() {
+                // set thread local singletons
+                QuantLib::Settings::instance().evaluationDate() = today_;
+                ObservationMode::instance().setMode(obsMode);
+                auto initMarket = QuantLib::ext::make_shared<ore::data::TodaysMarket>(
+                    today_, todaysMarketParams_, loaders[t], curveConfigs_, true, true, true, referenceData_, false,
+                    iborFallbackConfig_);
+                auto simMarket = QuantLib::ext::make_shared<ScenarioSimMarket>(
+                    initMarket, simMarketData_, configuration_, *curveConfigs_, *todaysMarketParams_, true, false,
+                    false, false, iborFallbackConfig_);
+                auto portfolio = QuantLib::ext::make_shared<Portfolio>();
+                portfolio->fromXMLSnapshot(portfolioSnapshot);
+                auto engineFactory = QuantLib::ext::make_shared<EngineFactory>(
+                    engineData_, simMarket, map<MarketContext, string>(), referenceData_, iborFallbackConfig_);
+                portfolio->build(engineFactory, context_, true);
+                return populateFilterCube(portfolio, simMarket, engineFactory->modelBuilders(), scenarios, allowed,
+                                          nextSample, samplesDone, t == 0, t == 0);
+            }));
+        }
+        for (auto& r : results) {
+            auto f = r.get();
+            failedTrades.insert(f.begin(), f.end());
+        }
+    }
+
+    if (dryRun_) {
+        LOG("Doing a dry run - fill remaining cube with random values.");
+        for (Size s = 1; s < nSamples; ++s) {
+            for (Size j = 0; j < filterCube_->numIds(); ++j) {
+                for (Size d = 0; d < filterCube_->depth(); ++d) {
+                    Real noise = s < 10 ? static_cast<Real>(j + d + s) : 0.0;
+                    filterCube_->set(filterCube_->getT0(j, d) + noise, j, 0, s, d);
+                }
+            }
+        }
+    }
+
+    // for trades with errors set all results to zero
+    for (auto i : failedTrades)
+        filterCube_->remove(i);
+
+    selectFilter(0);
+
+    DLOG("Historical P&L cube generated");
+}
+
+set<Size> HistoricalPnlGenerator::populateFilterCube(
+    const QuantLib::ext::shared_ptr<Portfolio>& portfolio,
+    const QuantLib::ext::shared_ptr<ScenarioSimMarket>& simMarket,
+    const set<pair<string, QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>>>& modelBuilders,
+    const vector<QuantLib::ext::shared_ptr<Scenario>>& scenarios, const vector<vector<bool>>& allowed,
+    std::atomic<Size>& nextSample, std::atomic<Size>& samplesDone, bool reportProgress, bool setT0) {
+
+    ObservationMode::Mode om = ObservationMode::instance().mode();
+    auto recalibrateModels = [&modelBuilders, om]() {
+        for (auto const& b : modelBuilders) {
+            if (om == ObservationMode::Mode::Disable)
+                b.second->forceRecalculate();
+            b.second->recalibrate();
+        }
+    };
+
+    Date asof = simMarket->asofDate();
+    Size dateIdx = 0;
+    const auto& base = hisScenGen_->baseScenario();
+    const auto& keys = base->keys();
+    const auto& trades = portfolio->trades();
+    QuantLib::ext::shared_ptr<NPVCube> cube = filterCube_, nettingSetCube;
+
+    // the filtered variants are applied unfiltered to a sim market in its base state, the sim market's own filter
+    // is restored on exit
+
+    struct RestoreFilter {
+        ~RestoreFilter() { simMarket->filter() = filter; }
+        QuantLib::ext::shared_ptr<ScenarioSimMarket> simMarket;
+        QuantLib::ext::shared_ptr<ScenarioFilter> filter;
+    } restoreFilter{simMarket, simMarket->filter()};
+
+    simMarket->filter() = QuantLib::ext::make_shared<ScenarioFilter>();
+    simMarket->reset();
+
+    vector<QuantLib::ext::shared_ptr<ValuationCalculator>> calculators;
+    for (Size k = 0; k < allowed.size(); ++k) {
+        calculators.push_back(QuantLib::ext::make_shared<NPVCalculator>(baseCurrency_, k));
+        calculators.back()->init(portfolio, simMarket);
+        calculators.back()->initScenario();
+    }
+
+    vector<Size> cubeIdx;
+    set<Size> failedTrades;
+    for (const auto& [tradeId, trade] : trades) {
+        cubeIdx.push_back(cube->getTradeIndex(tradeId));
+        trade->instrument()->initialise(vector<Date>(1, asof));
+        recalibrateModels();
+        if (!setT0)
+            continue;
+        try {
+            for (auto& c : calculators)
+                c->calculateT0(trade, cubeIdx.back(), simMarket, cube, nettingSetCube);
+        } catch (const std::exception& e) {
+            string expMsg = string("T0 valuation error: ") + e.what();
+            StructuredTradeErrorMessage(tradeId, trade->tradeType(), "ScenarioValuation", expMsg.c_str()).log();
+            failedTrades.insert(cubeIdx.back());
+        }
+    }
+
+    vector<Real> applied(keys.size()), values(keys.size());
+    for (Size s = nextSample++; s < scenarios.size(); s = nextSample++) {
+
+        for (auto& [tradeId, trade] : trades)
+            trade->instrument()->reset();
+
+        for (Size k = 0; k < allowed.size(); ++k) {
+
+            // build the variant of the scenario under the k-th filter, i.e. reset the disallowed keys to base
+
+            auto variant = scenarios[s]->clone();
+            for (Size i = 0; i < keys.size(); ++i) {
+                values[i] = allowed[k][i] ? scenarios[s]->get(keys[i]) : base->get(keys[i]);
+                if (!allowed[k][i])
+                    variant->add(keys[i], values[i]);
+            }
+
+            // if the variant coincides with the previous one, there is nothing to reprice
+
+            if (k > 0 && values == applied) {
+                for (Size j = 0; j < cubeIdx.size(); ++j)
+                    cube->set(cube->get(cubeIdx[j], dateIdx, s, k - 1), cubeIdx[j], dateIdx, s, k);
+                continue;
+            }
+
+            // only the sim data that differs from the previous variant notifies its observers, trades not
+            // depending on it are not recalculated
+
+            simMarket->preUpdate();
+            simMarket->updateDate(asof);
+            simMarket->applyScenario(variant);
+            simMarket->postUpdate(asof, true);
+            recalibrateModels();
+            applied.swap(values);
+
+            calculators[k]->initScenario();
+            Size j = 0;
+            for (auto it = trades.begin(); it != trades.end(); ++it, ++j) {
+                if (failedTrades.count(cubeIdx[j]))
+                    continue;
+                if (om == ObservationMode::Mode::Disable || om == ObservationMode::Mode::Unregister)
+                    it->second->instrument()->updateQlInstruments();
+                try {
+                    calculators[k]->calculate(it->second, cubeIdx[j], simMarket, cube, nettingSetCube, asof, dateIdx,
+                                              s);
+                } catch (const std::exception& e) {
+                    string expMsg = "sample = " + ore::data::to_string(s) + ", filter = " + ore::data::to_string(k) +
+                                    ": " + e.what();
+                    StructuredTradeErrorMessage(it->second->id(), it->second->tradeType(), "ScenarioValuation",
+                                                expMsg.c_str())
+                        .log();
+                    failedTrades.insert(cubeIdx[j]);
+                }
+            }
+        }
+
+        simMarket->fixingManager()->reset();
+
+        Size done = ++samplesDone;
+        if (reportProgress) {
+            std::ostringstream detail;
+            detail << trades.size() << " trade" << (trades.size() == 1 ? "" : "s") << ", " << scenarios.size()
+                   << " sample" << (scenarios.size() == 1 ? "" : "s") << ", " << allowed.size() << " filter"
+                   << (allowed.size() == 1 ? "" : "s");
+            updateProgress(done, scenarios.size(), detail.str());
+        }
+    }
+
+    simMarket->reset();
+
+    return failedTrades;
+}
+
+void HistoricalPnlGenerator::selectFilter(Size index) {
+    QL_REQUIRE(filterCube_, "HistoricalPnlGenerator::selectFilter(): no multi-filter cube generated");
+    QL_REQUIRE(index < filterCube_->depth(), "HistoricalPnlGenerator::selectFilter(): index "
+                                                 << index << " out of range, cube has depth " << filterCube_->depth());
+    auto cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(
+        filterCube_->asof(), portfolio_->ids(), filterCube_->dates(), filterCube_->samples());
+    for (const auto& [id, idx] : filterCube_->idsAndIndexes()) {
+        cube->setT0(filterCube_->getT0(idx, index), cube->getTradeIndex(id));
+        for (Size s = 0; s < filterCube_->samples(); ++s)
+            cube->set(filterCube_->get(idx, 0, s, index), cube->getTradeIndex(id), 0, s);
+    }
+    cube_ = cube;
+}
+
 vector<Real> HistoricalPnlGenerator::pnl(const TimePeriod& period, const set<pair<string, Size>>& tradeIds) const {
 
     // Create result with enough space
@@ -30,6 +30,8 @@
 #include <ored/utilities/timeperiod.hpp>
 #include <orea/scenario/historicalscenariogenerator.hpp>
 #include <ql/types.hpp>
+
+#include <atomic>
 #include <vector>
 
 namespace ore {
@@ -86,6 +88,20 @@ public:
     */
     void generateCube(const QuantLib::ext::shared_ptr<ScenarioFilter>& filter);
 
+    /*! Generate a cube of P&L values for each of the given scenario \p filters in a single pass over the
+        historical scenarios. The filtered variants of a scenario are applied back to back, so that only the
+        market data points differing from the previously applied variant are updated and only the trades
+        depending on them are repriced. If the multi-threaded constructor was used, the scenarios are shared
+        out between the threads, each of which prices the whole portfolio into the common cube. The cube
+        has one depth per filter, selectFilter() picks the one used by cube(), pnl() and tradeLevelPnl().
+    */
+    void generateCube(const std::vector<QuantLib::ext::shared_ptr<ScenarioFilter>>& filters);
+
+    /*! Make the results for the filter with the given \p index in the last call to the multi-filter
+        generateCube the current cube.
+    */
+    void selectFilter(QuantLib::Size index);
+
     /*! Return a vector of historical portfolio P&L values restricted to scenarios
         falling in \p period and restricted to the given \p tradeIds. The P&L values
         are calculated from the last cube generated by generateCube.
@@ -148,12 +164,16 @@ public:
 
 private:
     bool useSingleThreadedEngine_;
+    std::string baseCurrency_;
 
     QuantLib::ext::shared_ptr<ore::data::Portfolio> portfolio_;
     QuantLib::ext::shared_ptr<ScenarioSimMarket> simMarket_;
     QuantLib::ext::shared_ptr<HistoricalScenarioGenerator> hisScenGen_;
     QuantLib::ext::shared_ptr<NPVCube> cube_;
     QuantLib::ext::shared_ptr<ValuationEngine> valuationEngine_;
+    std::set<std::pair<std::string, QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>>> modelBuilders_;
+    // cube holding one depth per filter, populated by the multi-filter generateCube
+    QuantLib::ext::shared_ptr<NPVCube> filterCube_;
 
     // additional parameters needed for multi-threaded ctor
     QuantLib::ext::shared_ptr<ore::data::EngineData> engineData_;
@@ -174,6 +194,17 @@ private:
 
     //! Get the index of the as of date in the cube.
     QuantLib::Size indexAsof() const;
+
+    /*! Price the filtered variants of the scenarios taken from \p nextSample into filterCube_, using the given
+        portfolio built against \p simMarket. Returns the indices of the trades that failed to price.
+    */
+    std::set<QuantLib::Size> populateFilterCube(
+        const QuantLib::ext::shared_ptr<ore::data::Portfolio>& portfolio,
+        const QuantLib::ext::shared_ptr<ScenarioSimMarket>& simMarket,
+        const std::set<std::pair<std::string, QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>>>& modelBuilders,
+        const std::vector<QuantLib::ext::shared_ptr<Scenario>>& scenarios,
+        const std::vector<std::vector<bool>>& allowed, std::atomic<QuantLib::Size>& nextSample,
+        std::atomic<QuantLib::Size>& samplesDone, bool reportProgress, bool setT0);
 };
 
 } // namespace analytics
@@ -22,6 +22,7 @@
 #include <orea/cube/cubewriter.hpp>
 #include <orea/cube/inmemorycube.hpp>
 #include <orea/cube/npvcube.hpp>
+#include <orea/engine/columnarsensitivitystream.hpp>
 #include <orea/engine/marketriskreport.hpp>
 #include <orea/engine/sensitivityaggregator.hpp>
 #include <ql/math/matrixutilities/pseudosqrt.hpp>
@@ -124,7 +125,6 @@ void MarketRiskReport::initialise() {
         fullRevalArgs_->engineData_->globalParameters()["RunType"] = std::string("HistoricalPnL");
     }
 
-    // save a sensi pnl calculator
     if (hisScenGen_) {
         // Build the filtered historical scenario generator
         hisScenGen_ = QuantLib::ext::make_shared<HistoricalScenarioGeneratorWithFilteredDates>(
@@ -134,10 +134,6 @@ void MarketRiskReport::initialise() {
             hisScenGen_->baseScenario() = fullRevalArgs_->simMarket_->baseScenario();
     }
 
-    if (sensiArgs_ && hisScenGen_)
-        sensiPnlCalculator_ =
-            ext::make_shared<HistoricalSensiPnlCalculator>(hisScenGen_, sensiArgs_->sensitivityStream_);
-
     if (fullRevalArgs_) {
         LOG("Build the portfolio for full reval bt.");
 
@@ -169,7 +165,24 @@ void MarketRiskReport::initialise() {
         }
     }
 
+    // risk groups are set up after the portfolio build, which may remove trades
     initialiseRiskGroups();
+
+    // The sensitivities are streamed again for each risk group. Only if there is more than one, it pays to load
+    // them into a columnar store once, otherwise the copy just duplicates the stream in memory.
+    if (sensiArgs_ && sensiArgs_->sensitivityStream_ && riskGroups_->size() > 1 &&
+        !ext::dynamic_pointer_cast<ColumnarSensitivityStream>(sensiArgs_->sensitivityStream_)) {
+        auto cs = ext::make_shared<ColumnarSensitivityStream>();
+        sensiArgs_->sensitivityStream_->reset();
+        while (SensitivityRecord sr = sensiArgs_->sensitivityStream_->next())
+            cs->add(sr);
+        sensiArgs_->sensitivityStream_ = cs;
+    }
+
+    // save a sensi pnl calculator
+    if (sensiArgs_ && hisScenGen_)
+        sensiPnlCalculator_ =
+            ext::make_shared<HistoricalSensiPnlCalculator>(hisScenGen_, sensiArgs_->sensitivityStream_);
 }
 
 void MarketRiskReport::initialiseRiskGroups() {
@@ -264,28 +277,46 @@ void MarketRiskReport::calculate(const ext::shared_ptr<MarketRiskReport::Reports
     bool runDetailTrd = runTradeDetail(reports);
     addPnlCalculators(reports);
 
-    // Loop over all the risk groups
+    // Build the scenario filters for all risk groups, skipping those that disable all risk factors
+    vector<pair<ext::shared_ptr<MarketRiskGroupBase>, ext::shared_ptr<ScenarioFilter>>> riskGroupFilters;
     riskGroups_->reset();
-    Size currentRiskGroup = 0;
     while (ext::shared_ptr<MarketRiskGroupBase> riskGroup = riskGroups_->next()) {
-        LOG("[progress] Processing RiskGroup " << ++currentRiskGroup << " out of " << riskGroups_->size()
-                                                  << ") = " << riskGroup);
-
         ext::shared_ptr<ScenarioFilter> filter = createScenarioFilter(riskGroup);
-
-        // If this filter disables all risk factors, move to next risk group
         if (disablesAll(filter))
             continue;
-
         updateFilter(riskGroup, filter);
+        riskGroupFilters.push_back(std::make_pair(riskGroup, filter));
+    }
+
+    // If doing a full revaluation backtest, generate the cubes under all filters in one pass over the scenarios
+    map<ext::shared_ptr<MarketRiskGroupBase>, Size> cubeDepth;
+    if (fullReval_) {
+        vector<ext::shared_ptr<ScenarioFilter>> cubeFilters;
+        for (const auto& [riskGroup, filter] : riskGroupFilters) {
+            if (generateCube(riskGroup)) {
+                cubeDepth[riskGroup] = cubeFilters.size();
+                cubeFilters.push_back(filter);
+            }
+        }
+        if (!cubeFilters.empty()) {
+            LOG("Generating historical P&L cube for " << cubeFilters.size() << " risk groups");
+            histPnlGen_->generateCube(cubeFilters);
+        }
+    }
+
+    // Loop over all the risk groups
+    Size currentRiskGroup = 0;
+    for (const auto& [riskGroup, filter] : riskGroupFilters) {
+        LOG("[progress] Processing RiskGroup " << ++currentRiskGroup << " out of " << riskGroupFilters.size()
+                                                  << ") = " << riskGroup);
 
         if (sensiBased_)
             sensiAgg->aggregate(*sensiArgs_->sensitivityStream_, filter);
 
-        // If doing a full revaluation backtest, generate the cube under this filter
+        // If doing a full revaluation backtest, select the cube generated under this filter
         if (fullReval_) {
-            if (generateCube(riskGroup)) {
-                histPnlGen_->generateCube(filter);
+            if (auto d = cubeDepth.find(riskGroup); d != cubeDepth.end()) {
+                histPnlGen_->selectFilter(d->second);
                 if (fullRevalArgs_->writeCube_) {
                     CubeWriter writer(cubeFilePath(riskGroup));
                     writer.write(histPnlGen_->cube(), {});
@@ -18,6 +18,7 @@
 
 #include <orea/app/structuredanalyticserror.hpp>
 #include <orea/cube/inmemorycube.hpp>
+#include <orea/cube/subnpvcube.hpp>
 #include <orea/engine/multithreadedvaluationengine.hpp>
 #include <orea/engine/observationmode.hpp>
 #include <orea/scenario/clonedscenariogenerator.hpp>
@@ -101,6 +102,10 @@ void MultiThreadedValuationEngine::setAggregationScenarioData(
     aggregationScenarioData_ = aggregationScenarioData;
 }
 
+void MultiThreadedValuationEngine::setOutputCube(const QuantLib::ext::shared_ptr<ore::analytics::NPVCube>& outputCube) {
+    outputCube_ = outputCube;
+}
+
 void MultiThreadedValuationEngine::buildCube(
     const QuantLib::ext::shared_ptr<ore::data::Portfolio>& portfolio,
     const std::function<std::vector<QuantLib::ext::shared_ptr<ore::analytics::ValuationCalculator>>()>& calculators,
@@ -111,6 +116,19 @@ void MultiThreadedValuationEngine::buildCube(
 
     LOG("MultiThreadedValuationEngine::buildCube() was called");
 
+    if (outputCube_) {
+        QL_REQUIRE(outputCube_->ids() == portfolio->ids(),
+                   "MultiThreadedValuationEngine::buildCube(): output cube ids ("
+                       << outputCube_->numIds() << ") do not match portfolio ids (" << portfolio->size() << ")");
+        QL_REQUIRE(outputCube_->numDates() == dateGrid_->valuationDates().size(),
+                   "MultiThreadedValuationEngine::buildCube(): output cube dates ("
+                       << outputCube_->numDates() << ") do not match valuation dates ("
+                       << dateGrid_->valuationDates().size() << ")");
+        QL_REQUIRE(outputCube_->samples() == nSamples_,
+                   "MultiThreadedValuationEngine::buildCube(): output cube samples ("
+                       << outputCube_->samples() << ") do not match samples (" << nSamples_ << ")");
+    }
+
     // extract pricing stats accumulated so far and clear them
 
     LOG("Extract pricing stats and clear them in the current portfolio");
@@ -187,11 +205,11 @@ void MultiThreadedValuationEngine::buildCube(
             portfolioIndex = 0;
     }
 
-    // output the portfolios into strings so that the worker threads can load them from there
+    // take binary snapshots of the portfolios so that the worker threads can load them from there without parsing xml
 
-    std::vector<std::string> portfoliosAsString;
+    std::vector<ore::data::XMLSnapshot> portfolioSnapshots;
     for (auto const& p : portfolios) {
-        portfoliosAsString.emplace_back(p->toXMLString());
+        portfolioSnapshots.push_back(p->toXMLSnapshot());
     }
 
     // log info on the portfolio split
@@ -222,14 +240,18 @@ void MultiThreadedValuationEngine::buildCube(
     for (Size i = 0; i < eff_nThreads; ++i)
         loaders.push_back(QuantLib::ext::make_shared<ore::data::ClonedLoader>(today_, loader_));
 
-    // build nThreads mini-cubes to which each thread writes its results
+    // build nThreads mini-cubes to which each thread writes its results, if an output cube is given these are views
+    // on disjoint id ranges of this cube
 
     LOG("Build " << eff_nThreads << " mini result cubes...");
     miniCubes_.clear();
     miniNettingSetCubes_.clear();
     miniCptyCubes_.clear();
     for (Size i = 0; i < eff_nThreads; ++i) {
-        miniCubes_.push_back(cubeFactory_(today_, portfolios[i]->ids(), dateGrid_->valuationDates(), nSamples_));
+        if (outputCube_)
+            miniCubes_.push_back(QuantLib::ext::make_shared<SubNPVCube>(outputCube_, portfolios[i]->ids()));
+        else
+            miniCubes_.push_back(cubeFactory_(today_, portfolios[i]->ids(), dateGrid_->valuationDates(), nSamples_));
         miniNettingSetCubes_.push_back(nettingSetCubeFactory_(today_, dateGrid_->valuationDates(), nSamples_));
         miniCptyCubes_.push_back(
             cptyCubeFactory_(today_, portfolios[i]->counterparties(), dateGrid_->valuationDates(), nSamples_));
@@ -261,7 +283,7 @@ void MultiThreadedValuationEngine::buildCube(
 
     for (Size i = 0; i < eff_nThreads; ++i) {
 
-        auto job = [this, obsMode, dryRun, &calculators, &cptyCalculators, mporStickyDate, &portfoliosAsString,
+        auto job = [this, obsMode, dryRun, &calculators, &cptyCalculators, mporStickyDate, &portfolioSnapshots,
                     &scenarioGenerators, &loaders, &workerPricingStats, &progressIndicator](int id) -> resultType {
             // set thread local singletons
 
@@ -305,7 +327,7 @@ void MultiThreadedValuationEngine::buildCube(
                 // build portfolio against sim market
 
                 auto portfolio = QuantLib::ext::make_shared<ore::data::Portfolio>();
-                portfolio->fromXMLString(portfoliosAsString[id]);
+                portfolio->fromXMLSnapshot(portfolioSnapshots[id]);
                 auto engineFactory = QuantLib::ext::make_shared<ore::data::EngineFactory>(
                     engineData_, simMarket, std::map<ore::data::MarketContext, string>(), referenceData_,
                     iborFallbackConfig_);
@@ -402,6 +424,11 @@ void MultiThreadedValuationEngine::buildCube(
         t->resetPricingStats(n, d);
     }
 
+    // the threads have written into the output cube directly, so there is nothing to join
+
+    if (outputCube_)
+        miniCubes_ = {outputCube_};
+
     // log timings and return the result mini-cubes
 
     LOG("MultiThreadedValuationEngine::buildCube() successfully finished, timings: "
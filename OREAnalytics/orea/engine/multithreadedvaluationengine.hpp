@@ -72,6 +72,12 @@ public:
     // can be optionally called to set the agg scen data (which is done in the ssm for single-threaded runs)
     void setAggregationScenarioData(const QuantLib::ext::shared_ptr<AggregationScenarioData>& aggregationScenarioData);
 
+    /* can be optionally called to set a preallocated output cube covering all trades of the portfolio passed to
+       buildCube(), the cube factory is then not used for the trade cube. The threads write their results directly
+       into disjoint id ranges of this cube, which therefore must support concurrent writes to distinct ids (as the
+       in memory cubes do), and outputCubes() returns this single cube, so that no joint cube is needed. */
+    void setOutputCube(const QuantLib::ext::shared_ptr<ore::analytics::NPVCube>& outputCube);
+
     /* analoguous to buildCube() in the single-threaded engine, results are retrieved using below constructors
        if no cptyCalculators is given a function returning an empty vector of calculators will be returned */
     void
@@ -81,7 +87,7 @@ public:
                   cptyCalculators = {},
               bool mporStickyDate = true, bool dryRun = false);
 
-    // result output cubes (mini-cubes, one per thread)
+    // result output cubes (mini-cubes, one per thread, or the output cube if set)
     std::vector<QuantLib::ext::shared_ptr<ore::analytics::NPVCube>> outputCubes() const { return miniCubes_; }
 
     // result netting cubes (might be null, if nettingSetCubeFactory is returning null)
@@ -125,6 +131,7 @@ private:
     QuantLib::ext::shared_ptr<ore::analytics::Scenario> offsetScenario_;
     QuantLib::ext::shared_ptr<AggregationScenarioData>
             aggregationScenarioData_;
+    QuantLib::ext::shared_ptr<ore::analytics::NPVCube> outputCube_;
     std::vector<QuantLib::ext::shared_ptr<ore::analytics::NPVCube>> miniCubes_;
     std::vector<QuantLib::ext::shared_ptr<ore::analytics::NPVCube>> miniNettingSetCubes_;
     std::vector<QuantLib::ext::shared_ptr<ore::analytics::NPVCube>> miniCptyCubes_;
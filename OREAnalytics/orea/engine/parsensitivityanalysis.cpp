@@ -300,29 +300,69 @@ void ParSensitivityAnalysis::computeParInstrumentSensitivities(const QuantLib::e
         parKeysCheck.insert(p.first);
     }
 
-    for (Size i = 1; i < scenarioGenerator->samples(); ++i) {
+    // In observation mode Disable the par instruments are not notified by the sim market, so we need to deep update
+    // them manually. To avoid repricing all par instruments for each shift, we deep update only those that depend on
+    // the curve (key type and name) of the shifted risk factor. The dependent instruments of a curve are read off the
+    // observer graph once: the first up shift on a curve is applied to the base scenario with notifications enabled
+    // and the par instruments that are invalidated by this are recorded. If selectiveDeepUpdate() is false, all par
+    // instruments are deep updated for each shift.
+
+    bool disableMode = ObservationMode::instance().mode() == ObservationMode::Mode::Disable;
+    bool selective = disableMode && selectiveDeepUpdate_;
+    std::map<std::pair<RiskFactorKey::KeyType, std::string>, std::set<RiskFactorKey>> curveDependents;
+
+    struct ObservationModeRestorer {
+        explicit ObservationModeRestorer(const ObservationMode::Mode mode) : mode_(mode) {}
+        ~ObservationModeRestorer() { ObservationMode::instance().setMode(mode_); }
+        ObservationMode::Mode mode_;
+    };
 
-        simMarket->update(asof_);
+    auto deepUpdate = [this](const RiskFactorKey& key) {
+        if (auto it = instruments_.parHelpers_.find(key); it != instruments_.parHelpers_.end())
+            it->second->deepUpdate();
+        if (auto it = instruments_.parCaps_.find(key); it != instruments_.parCaps_.end())
+            it->second->deepUpdate();
+        if (auto it = instruments_.parYoYCaps_.find(key); it != instruments_.parYoYCaps_.end())
+            it->second->deepUpdate();
+    };
+
+    auto deepUpdateAll = [this]() {
+        for (auto const& p : instruments_.parHelpers_)
+            p.second->deepUpdate();
+        for (auto const& p : instruments_.parCaps_)
+            p.second->deepUpdate();
+        for (auto const& p : instruments_.parYoYCaps_)
+            p.second->deepUpdate();
+    };
+
+    for (Size i = 1; i < scenarioGenerator->samples(); ++i) {
 
         // use single "UP" shift scenarios only, use only scenarios relevant for par instruments,
         // use relevant scenarios only, if specified
         // ignore risk factor types that have been disabled
-        if (desc[i].type() != ShiftScenarioGenerator::ScenarioDescription::Type::Up ||
-            !isParType(desc[i].key1().keytype) || typesDisabled_.count(desc[i].key1().keytype) == 1 ||
-            !(relevantRiskFactors_.empty() || relevantRiskFactors_.find(desc[i].key1()) != relevantRiskFactors_.end()))
-            continue;
-
-        // Since we are not using ValuationEngine we need to manually perform the trade updates here
-        // TODO - explore means of utilising valuation engine
-        if (ObservationMode::instance().mode() == ObservationMode::Mode::Disable) {
-            for (auto it : instruments_.parHelpers_)
-                it.second->deepUpdate();
-            for (auto it : instruments_.parCaps_)
-                it.second->deepUpdate();
-            for (auto it : instruments_.parYoYCaps_)
-                it.second->deepUpdate();
+        bool relevant =
+            desc[i].type() == ShiftScenarioGenerator::ScenarioDescription::Type::Up &&
+            isParType(desc[i].key1().keytype) && typesDisabled_.count(desc[i].key1().keytype) == 0 &&
+            (relevantRiskFactors_.empty() || relevantRiskFactors_.find(desc[i].key1()) != relevantRiskFactors_.end());
+
+        auto curve = std::make_pair(desc[i].key1().keytype, desc[i].key1().name);
+        bool probe = selective && relevant && curveDependents.find(curve) == curveDependents.end();
+
+        if (probe) {
+            // go back to the base scenario without notifications, then apply the shift with notifications enabled
+            simMarket->preUpdate();
+            simMarket->applyScenario(simMarket->baseScenario());
+            simMarket->postUpdate(asof_, false);
+            ObservationModeRestorer modeRestorer(ObservationMode::Mode::Disable);
+            ObservationMode::instance().setMode(ObservationMode::Mode::None);
+            simMarket->update(asof_);
+        } else {
+            simMarket->update(asof_);
         }
 
+        if (!relevant)
+            continue;
+
         rawKeysCheck.insert(desc[i].key1());
 
         // Get the absolute shift size and skip if close to zero
@@ -334,6 +374,36 @@ void ParSensitivityAnalysis::computeParInstrumentSensitivities(const QuantLib::e
             continue;
         }
 
+        // Since we are not using ValuationEngine we need to manually perform the trade updates here
+        // TODO - explore means of utilising valuation engine
+        if (probe) {
+            auto& dependents = curveDependents[curve];
+            for (auto const& p : instruments_.parHelpers_)
+                if (!p.second->isCalculated())
+                    dependents.insert(p.first);
+            for (auto const& p : instruments_.parCaps_)
+                if (!p.second->isCalculated())
+                    dependents.insert(p.first);
+            for (auto const& p : instruments_.parYoYCaps_)
+                if (!p.second->isCalculated())
+                    dependents.insert(p.first);
+            DLOG("Par instruments depending on " << curve.first << "/" << curve.second << ": " << dependents.size());
+            if (dependents.empty()) {
+                // the shift did not change the sim market (e.g. a zero shift in the scenario), so the observer graph
+                // did not tell us anything, update all instruments and probe again on the next shift on the curve
+                curveDependents.erase(curve);
+                deepUpdateAll();
+            } else {
+                deepUpdate(desc[i].key1());
+            }
+        } else if (selective) {
+            for (auto const& k : curveDependents.at(curve))
+                deepUpdate(k);
+            deepUpdate(desc[i].key1());
+        } else if (disableMode) {
+            deepUpdateAll();
+        }
+
         // process par helpers
 
         std::set<RiskFactorKey::KeyType> survivalAndRateCurveTypes = {
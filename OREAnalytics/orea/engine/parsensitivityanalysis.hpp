@@ -84,6 +84,11 @@ public:
     const std::set<ore::analytics::RiskFactorKey>& relevantRiskFactors() const { return relevantRiskFactors_; }
     std::set<ore::analytics::RiskFactorKey>& relevantRiskFactors() { return relevantRiskFactors_; }
 
+    /*! get / set whether in observation mode Disable only the par instruments depending on the curve of a shift are
+        updated (default), otherwise all par instruments are updated for each shift */
+    bool selectiveDeepUpdate() const { return selectiveDeepUpdate_; }
+    bool& selectiveDeepUpdate() { return selectiveDeepUpdate_; }
+
     //! Return the zero rate and par rate absolute shift size for each risk factor key
     std::map<ore::analytics::RiskFactorKey, std::pair<QuantLib::Real, QuantLib::Real>> shiftSizes() const {
         return shiftSizes_;
@@ -120,6 +125,7 @@ private:
     std::string marketConfiguration_;
     bool continueOnError_;
     std::set<ore::analytics::RiskFactorKey> relevantRiskFactors_;
+    bool selectiveDeepUpdate_ = true;
 
     static std::set<ore::analytics::RiskFactorKey::KeyType> parTypes_;
 
@@ -0,0 +1,133 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <orea/engine/scenarioresultstore.hpp>
+
+#include <boost/functional/hash.hpp>
+
+#include <cstdint>
+
+namespace ore {
+namespace analytics {
+
+void scenarioResultHashCombine(ScenarioResultHash& seed, const std::string& s) {
+    boost::hash_combine(seed.first, s);
+    // FNV-1a, continued from the previous value of the second component
+    std::uint64_t h = seed.second == 0 ? 14695981039346656037ULL : static_cast<std::uint64_t>(seed.second);
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    // separates consecutive strings, i.e. ("ab", "c") and ("a", "bc") give different hashes
+    h ^= s.size();
+    h *= 1099511628211ULL;
+    seed.second = static_cast<std::size_t>(h);
+}
+
+bool operator==(const ScenarioResultKey& lhs, const ScenarioResultKey& rhs) {
+    return lhs.tradeHash == rhs.tradeHash && lhs.scenarioHash == rhs.scenarioHash && lhs.asof == rhs.asof;
+}
+
+std::size_t ScenarioResultStore::KeyHash::operator()(const ScenarioResultKey& key) const {
+    std::size_t seed = 0;
+    boost::hash_combine(seed, key.tradeHash.first);
+    boost::hash_combine(seed, key.tradeHash.second);
+    boost::hash_combine(seed, key.scenarioHash.first);
+    boost::hash_combine(seed, key.scenarioHash.second);
+    boost::hash_combine(seed, key.asof.serialNumber());
+    return seed;
+}
+
+ScenarioResultStore::ScenarioResultStore(const QuantLib::Size maxSize) : maxSize_(maxSize) {
+    QL_REQUIRE(maxSize_ > 0, "ScenarioResultStore: maxSize must be positive");
+}
+
+bool ScenarioResultStore::get(const ScenarioResultKey& key, QuantLib::Real& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        ++misses_;
+        return false;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    value = it->second->second;
+    ++hits_;
+    return true;
+}
+
+void ScenarioResultStore::put(const ScenarioResultKey& key, const QuantLib::Real value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = index_.find(key); it != index_.end()) {
+        it->second->second = value;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    if (entries_.size() == maxSize_) {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+        ++evictions_;
+    }
+    entries_.emplace_front(key, value);
+    index_[key] = entries_.begin();
+}
+
+void ScenarioResultStore::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    hits_ = misses_ = evictions_ = 0;
+}
+
+QuantLib::Size ScenarioResultStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+QuantLib::Size ScenarioResultStore::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+QuantLib::Size ScenarioResultStore::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+QuantLib::Size ScenarioResultStore::evictions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return evictions_;
+}
+
+QuantLib::Real ScenarioResultStore::hitRate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    QuantLib::Size n = hits_ + misses_;
+    return n == 0 ? 0.0 : static_cast<QuantLib::Real>(hits_) / static_cast<QuantLib::Real>(n);
+}
+
+ScenarioResultHash scenarioResultContextHash(const ore::data::EngineData& engineData,
+                                             const ScenarioSimMarketParameters& simMarketParams,
+                                             const std::string& marketConfiguration) {
+    ScenarioResultHash seed(0, 0);
+    scenarioResultHashCombine(seed, engineData.toXMLString());
+    scenarioResultHashCombine(seed, simMarketParams.toXMLString());
+    scenarioResultHashCombine(seed, marketConfiguration);
+    return seed;
+}
+
+} // namespace analytics
+} // namespace ore
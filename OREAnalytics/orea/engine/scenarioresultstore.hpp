@@ -0,0 +1,111 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file orea/engine/scenarioresultstore.hpp
+    \brief memo store for trade npvs under given scenarios, shared across analytics
+    \ingroup engine
+*/
+
+#pragma once
+
+#include <ored/portfolio/enginedata.hpp>
+#include <orea/scenario/scenariosimmarketparameters.hpp>
+
+#include <ql/time/date.hpp>
+#include <ql/types.hpp>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace ore {
+namespace analytics {
+
+/*! Pair of two independent hashes identifying a trade or a scenario in a ScenarioResultStore, a stored npv is only
+    returned if both components match, so that a collision of a single 64 bit hash does not return a wrong npv */
+using ScenarioResultHash = std::pair<std::size_t, std::size_t>;
+
+//! Combines a string into both components of a ScenarioResultHash
+void scenarioResultHashCombine(ScenarioResultHash& seed, const std::string& s);
+
+//! Key of a ScenarioResultStore entry
+struct ScenarioResultKey {
+    //! hash of the trade and the pricing context it was built in
+    ScenarioResultHash tradeHash;
+    //! hash of the sim market state, see ScenarioSimMarket::stateHash()
+    ScenarioResultHash scenarioHash;
+    //! valuation date
+    QuantLib::Date asof;
+};
+
+bool operator==(const ScenarioResultKey& lhs, const ScenarioResultKey& rhs);
+
+//! Memo store for trade npvs under given scenarios
+/*! The store is shared by the valuation calculators of the analytics in one run. A calculator looks up the npv of a
+    trade under the current scenario before pricing it and adds the npv after pricing, so that a trade priced under
+    the same scenario by another analytic (e.g. under the base scenario or under an identical single factor shift)
+    is priced only once.
+
+    The store holds at most maxSize entries and evicts the least recently used entry when full. It is thread safe.
+*/
+class ScenarioResultStore {
+public:
+    explicit ScenarioResultStore(const QuantLib::Size maxSize);
+
+    //! Returns true and sets the value, if the key is in the store
+    bool get(const ScenarioResultKey& key, QuantLib::Real& value);
+    //! Adds or updates an entry
+    void put(const ScenarioResultKey& key, const QuantLib::Real value);
+    //! Removes all entries and resets the statistics
+    void clear();
+
+    //! \name Inspectors
+    //@{
+    QuantLib::Size maxSize() const { return maxSize_; }
+    QuantLib::Size size() const;
+    QuantLib::Size hits() const;
+    QuantLib::Size misses() const;
+    QuantLib::Size evictions() const;
+    //! hits / (hits + misses), zero if there were no lookups
+    QuantLib::Real hitRate() const;
+    //@}
+
+private:
+    struct KeyHash {
+        std::size_t operator()(const ScenarioResultKey& key) const;
+    };
+    using Entry = std::pair<ScenarioResultKey, QuantLib::Real>;
+
+    QuantLib::Size maxSize_;
+    mutable std::mutex mutex_;
+    // most recently used entry first
+    std::list<Entry> entries_;
+    std::unordered_map<ScenarioResultKey, std::list<Entry>::iterator, KeyHash> index_;
+    QuantLib::Size hits_ = 0, misses_ = 0, evictions_ = 0;
+};
+
+/*! Hash of the pricing context that trade npvs stored in a ScenarioResultStore depend on beyond the trade and the
+    scenario: the engine data (including the run type), the sim market parameters and the market configuration. */
+ScenarioResultHash scenarioResultContextHash(const ore::data::EngineData& engineData,
+                                             const ScenarioSimMarketParameters& simMarketParams,
+                                             const std::string& marketConfiguration);
+
+} // namespace analytics
+} // namespace ore
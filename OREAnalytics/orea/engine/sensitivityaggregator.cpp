@@ -24,8 +24,10 @@
 using ore::analytics::ScenarioFilter;
 using std::function;
 using std::map;
+using std::pair;
 using std::set;
 using std::string;
+using std::vector;
 
 namespace ore {
 namespace analytics {
@@ -50,6 +52,12 @@ SensitivityAggregator::SensitivityAggregator(const map<string, function<bool(str
 }
 
 void SensitivityAggregator::aggregate(SensitivityStream& ss, const QuantLib::ext::shared_ptr<ScenarioFilter>& filter) {
+    // Use the index based aggregation if possible
+    if (auto cs = dynamic_cast<ColumnarSensitivityStream*>(&ss)) {
+        aggregate(*cs, filter);
+        return;
+    }
+
     // Ensure at start of stream
     ss.reset();
 
@@ -76,6 +84,46 @@ void SensitivityAggregator::aggregate(SensitivityStream& ss, const QuantLib::ext
     }
 }
 
+void SensitivityAggregator::aggregate(const ColumnarSensitivityStream& ss,
+                                      const QuantLib::ext::shared_ptr<ScenarioFilter>& filter) {
+    // Evaluate the filter once per risk factor, factor 0 is the empty key of non cross gamma records
+    const auto& factors = ss.factors();
+    vector<char> allowed(factors.size(), 1);
+    for (Size f = 1; f < factors.size(); ++f)
+        allowed[f] = filter->allow(factors[f].key) ? 1 : 0;
+
+    const auto& tradeIds = ss.tradeIds();
+    vector<char> inCat(tradeIds.size());
+    for (const auto& kv : categories_) {
+        // Evaluate the category once per trade ID
+        for (Size t = 0; t < tradeIds.size(); ++t)
+            inCat[t] = kv.second(tradeIds[t]) ? 1 : 0;
+
+        // Aggregate by (factor 1, factor 2) index, the first record of each pair provides the static data
+        map<pair<Size, Size>, SensitivityRecord> agg;
+        for (Size i = 0; i < ss.size(); ++i) {
+            Size f1 = ss.factorIndex1(i), f2 = ss.factorIndex2(i);
+            if (!inCat[ss.tradeIndex(i)] || !allowed[f1] || !allowed[f2])
+                continue;
+            auto r = agg.emplace(std::make_pair(f1, f2), SensitivityRecord());
+            if (r.second) {
+                r.first->second = ss.record(i);
+                r.first->second.tradeId = "";
+            } else {
+                r.first->second.baseNpv += ss.baseNpv(i);
+                r.first->second.delta += ss.delta(i);
+                r.first->second.gamma += ss.gamma(i);
+            }
+        }
+
+        auto& records = aggRecords_[kv.first];
+        for (auto& a : agg) {
+            DLOG("Updating aggregated sensitivities for category " << kv.first << " with record: " << a.second);
+            add(a.second, records);
+        }
+    }
+}
+
 void SensitivityAggregator::reset() {
     // Clear the aggregated sensitivities
     aggRecords_.clear();
@@ -22,7 +22,7 @@
 
 #pragma once
 
-#include <orea/engine/sensitivitystream.hpp>
+#include <orea/engine/columnarsensitivitystream.hpp>
 #include <orea/scenario/scenariosimmarket.hpp>
 
 #include <functional>
@@ -63,6 +63,14 @@ public:
     void aggregate(SensitivityStream& ss, const QuantLib::ext::shared_ptr<ScenarioFilter>& filter =
                                               QuantLib::ext::make_shared<ScenarioFilter>());
 
+    /*! Update the aggregator with the records from the columnar store \p ss. The filter is evaluated once per
+        risk factor and the categories once per trade id, the aggregation itself works on the integer indices
+        of the store. This overload is used by the general aggregate() if the stream is a
+        ColumnarSensitivityStream.
+    */
+    void aggregate(const ColumnarSensitivityStream& ss, const QuantLib::ext::shared_ptr<ScenarioFilter>& filter =
+                                                            QuantLib::ext::make_shared<ScenarioFilter>());
+
     //! Reset the aggregator to it's initial state by clearing all aggregations
     void reset();
 
@@ -167,9 +167,14 @@ void SensitivityAnalysis::generateSensitivities() {
         if (nonShiftedBaseCurrencyConversion_)
             // use "original" FX rates to convert sensi to base currency
             calculators.push_back(QuantLib::ext::make_shared<NPVCalculatorFXT0>(simMarketData_->baseCcy(), market_));
-        else
+        else {
             // use the scenario FX rate when converting sensi to base currency
-            calculators.push_back(QuantLib::ext::make_shared<NPVCalculator>(simMarketData_->baseCcy()));
+            auto npvCalculator = QuantLib::ext::make_shared<NPVCalculator>(simMarketData_->baseCcy());
+            if (resultStore_)
+                npvCalculator->setResultStore(resultStore_,
+                                              scenarioResultContextHash(*ed, *simMarketData_, marketConfiguration_));
+            calculators.push_back(npvCalculator);
+        }
 
         sensiCubes_.clear();
         for (auto const& [pf, scenGen] :
@@ -249,10 +254,17 @@ void SensitivityAnalysis::generateSensitivities() {
                 engine.registerProgressIndicator(i);
 
             auto baseCcy = simMarketData_->baseCcy();
+            auto resultStore = resultStore_;
+            ScenarioResultHash contextHash = resultStore
+                                                 ? scenarioResultContextHash(*ed, *simMarketData_, marketConfiguration_)
+                                                 : ScenarioResultHash(0, 0);
             engine.buildCube(
                 pf,
-                [&baseCcy]() -> std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>> {
-                    return {QuantLib::ext::make_shared<NPVCalculator>(baseCcy)};
+                [&baseCcy, resultStore, contextHash]() -> std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>> {
+                    auto npvCalculator = QuantLib::ext::make_shared<NPVCalculator>(baseCcy);
+                    if (resultStore)
+                        npvCalculator->setResultStore(resultStore, contextHash);
+                    return {npvCalculator};
                 },
                 {}, true, dryRun_);
             std::vector<QuantLib::ext::shared_ptr<NPVSensiCube>> miniCubes;
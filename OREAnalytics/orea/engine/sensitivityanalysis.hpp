@@ -25,6 +25,7 @@
 
 #include <orea/cube/npvsensicube.hpp>
 #include <orea/cube/sensitivitycube.hpp>
+#include <orea/engine/scenarioresultstore.hpp>
 #include <orea/scenario/scenariosimmarket.hpp>
 #include <orea/scenario/scenariosimmarketparameters.hpp>
 #include <orea/scenario/sensitivityscenariodata.hpp>
@@ -117,6 +118,9 @@ public:
     //! override shift tenors with sim market tenors
     void overrideTenors(const bool b) { overrideTenors_ = b; }
 
+    //! memoise the trade npvs in the given store, which may be shared with other analytics
+    void setScenarioResultStore(const QuantLib::ext::shared_ptr<ScenarioResultStore>& store) { resultStore_ = store; }
+
     //! the portfolio of trades
     QuantLib::ext::shared_ptr<Portfolio> portfolio() const { return portfolio_; }
 
@@ -168,6 +172,8 @@ private:
     Size nThreads_;
     QuantLib::ext::shared_ptr<ore::data::Loader> loader_;
     std::string context_;
+    //! optional memo store for trade npvs
+    QuantLib::ext::shared_ptr<ScenarioResultStore> resultStore_;
 };
 
 /*! Returns the absolute shift size corresponding to a particular risk factor \p key
@@ -44,7 +44,8 @@ StressTest::StressTest(const QuantLib::ext::shared_ptr<ore::data::Portfolio>& po
                        const CurveConfigurations& curveConfigs, const TodaysMarketParameters& todaysMarketParams,
                        QuantLib::ext::shared_ptr<ScenarioFactory> scenarioFactory,
                        const QuantLib::ext::shared_ptr<ReferenceDataManager>& referenceData,
-                       const IborFallbackConfig& iborFallbackConfig, bool continueOnError) {
+                       const IborFallbackConfig& iborFallbackConfig, bool continueOnError,
+                       const QuantLib::ext::shared_ptr<ScenarioResultStore>& resultStore) {
 
     LOG("Run Stress Test");
     DLOG("Build Simulation Market");
@@ -79,7 +80,10 @@ StressTest::StressTest(const QuantLib::ext::shared_ptr<ore::data::Portfolio>& po
     DLOG("Run Stress Scenarios");
     QuantLib::ext::shared_ptr<DateGrid> dg = QuantLib::ext::make_shared<DateGrid>("1,0W", NullCalendar());
     vector<QuantLib::ext::shared_ptr<ValuationCalculator>> calculators;
-    calculators.push_back(QuantLib::ext::make_shared<NPVCalculator>(simMarketData->baseCcy()));
+    auto npvCalculator = QuantLib::ext::make_shared<NPVCalculator>(simMarketData->baseCcy());
+    if (resultStore)
+        npvCalculator->setResultStore(resultStore, scenarioResultContextHash(*ed, *simMarketData, marketConfiguration));
+    calculators.push_back(npvCalculator);
     ValuationEngine engine(asof, dg, simMarket, factory->modelBuilders());
 
     engine.registerProgressIndicator(QuantLib::ext::make_shared<ProgressLog>("stress scenarios", 100, oreSeverity::notice));
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <orea/cube/npvcube.hpp>
+#include <orea/engine/scenarioresultstore.hpp>
 #include <orea/scenario/scenariosimmarket.hpp>
 #include <orea/scenario/scenariosimmarketparameters.hpp>
 #include <orea/scenario/stressscenariodata.hpp>
@@ -65,7 +66,8 @@ public:
                QuantLib::ext::shared_ptr<ScenarioFactory> scenarioFactory = {},
                const QuantLib::ext::shared_ptr<ReferenceDataManager>& referenceData = nullptr,
                const IborFallbackConfig& iborFallbackConfig = IborFallbackConfig::defaultConfig(),
-               bool continueOnError = false);
+               bool continueOnError = false,
+               const QuantLib::ext::shared_ptr<ScenarioResultStore>& resultStore = nullptr);
 
     //! Return set of trades analysed
     const std::set<std::string>& trades() { return trades_; }
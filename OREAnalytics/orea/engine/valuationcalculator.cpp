@@ -22,6 +22,7 @@
 */
 
 #include <orea/engine/valuationcalculator.hpp>
+#include <orea/scenario/scenariosimmarket.hpp>
 #include <ored/portfolio/optionwrapper.hpp>
 #include <ored/utilities/log.hpp>
 
@@ -45,11 +46,33 @@ void NPVCalculator::init(const QuantLib::ext::shared_ptr<Portfolio>& portfolio,
     for (Size i = 0; i < ccys.size(); ++i)
         ccyQuotes_[i] = (simMarket->fxRate(*std::next(ccys.begin(), i) + baseCcyCode_));
     fxRates_.resize(ccys.size());
+
+    resultStoreSimMarket_ = nullptr;
+    tradeHashes_.clear();
+    if (resultStore_) {
+        resultStoreSimMarket_ = QuantLib::ext::dynamic_pointer_cast<ScenarioSimMarket>(simMarket);
+        if (resultStoreSimMarket_ == nullptr) {
+            WLOG("NPVCalculator: result store is ignored, since the sim market is not a ScenarioSimMarket");
+        } else {
+            for (auto const& [tradeId, trade] : portfolio->trades()) {
+                boost::optional<ScenarioResultHash> seed = resultContextHash_;
+                try {
+                    scenarioResultHashCombine(*seed, trade->toXMLString());
+                } catch (const std::exception& e) {
+                    WLOG("NPVCalculator: trade " << tradeId << " is not memoised in the result store: " << e.what());
+                    seed = boost::none;
+                }
+                tradeHashes_.push_back(seed);
+            }
+        }
+    }
 }
 
 void NPVCalculator::initScenario() {
     for (Size i = 0; i < ccyQuotes_.size(); ++i)
         fxRates_[i] = ccyQuotes_[i]->value();
+    if (resultStoreSimMarket_)
+        scenarioHash_ = resultStoreSimMarket_->stateHash();
 }
 
 void NPVCalculator::calculate(const QuantLib::ext::shared_ptr<Trade>& trade, Size tradeIndex,
@@ -68,7 +91,16 @@ void NPVCalculator::calculateT0(const QuantLib::ext::shared_ptr<Trade>& trade, S
 
 Real NPVCalculator::npv(Size tradeIndex, const QuantLib::ext::shared_ptr<Trade>& trade,
                         const QuantLib::ext::shared_ptr<SimMarket>& simMarket) {
-    Real npv = trade->instrument()->NPV();
+    Real npv;
+    if (resultStoreSimMarket_ && tradeHashes_[tradeIndex]) {
+        ScenarioResultKey key{*tradeHashes_[tradeIndex], scenarioHash_, simMarket->asofDate()};
+        if (!resultStore_->get(key, npv)) {
+            npv = trade->instrument()->NPV();
+            resultStore_->put(key, npv);
+        }
+    } else {
+        npv = trade->instrument()->NPV();
+    }
     if (close_enough(npv, 0.0))
         return npv;
     Real fx = fxRates_[tradeCcyIndex_[tradeIndex]];
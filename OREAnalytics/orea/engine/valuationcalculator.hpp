@@ -24,10 +24,13 @@
 #pragma once
 
 #include <orea/cube/npvcube.hpp>
+#include <orea/engine/scenarioresultstore.hpp>
 #include <orea/simulation/simmarket.hpp>
 #include <ored/portfolio/trade.hpp>
 #include <ored/utilities/dategrid.hpp>
 
+#include <boost/optional.hpp>
+
 namespace ore {
 namespace analytics {
 using ore::data::Trade;
@@ -35,6 +38,8 @@ using QuantLib::Date;
 using QuantLib::Real;
 using QuantLib::Size;
 
+class ScenarioSimMarket;
+
 //! ValuationCalculator interface
 class ValuationCalculator {
 public:
@@ -104,6 +109,15 @@ public:
     void init(const QuantLib::ext::shared_ptr<Portfolio>& portfolio, const QuantLib::ext::shared_ptr<SimMarket>& simMarket) override;
     void initScenario() override;
 
+    /*! Look up the trade npvs in the given store before pricing and add them after pricing. The context hash
+        identifies the pricing setup, see scenarioResultContextHash(). The store is only used with a
+        ScenarioSimMarket. */
+    void setResultStore(const QuantLib::ext::shared_ptr<ScenarioResultStore>& store,
+                        const ScenarioResultHash& contextHash) {
+        resultStore_ = store;
+        resultContextHash_ = contextHash;
+    }
+
 protected:
     std::string baseCcyCode_;
     Size index_;
@@ -111,6 +125,13 @@ protected:
     std::vector<Handle<Quote>> ccyQuotes_;
     std::vector<double> fxRates_;
     std::vector<Size> tradeCcyIndex_;
+
+    QuantLib::ext::shared_ptr<ScenarioResultStore> resultStore_;
+    ScenarioResultHash resultContextHash_;
+    QuantLib::ext::shared_ptr<ScenarioSimMarket> resultStoreSimMarket_;
+    // none for trades that are not memoised
+    std::vector<boost::optional<ScenarioResultHash>> tradeHashes_;
+    ScenarioResultHash scenarioHash_;
 };
 
 //! CashflowCalculator
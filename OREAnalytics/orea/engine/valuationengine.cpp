@@ -21,6 +21,7 @@
 #include <orea/engine/observationmode.hpp>
 #include <orea/engine/valuationcalculator.hpp>
 #include <orea/engine/valuationengine.hpp>
+#include <orea/scenario/scenariosimmarket.hpp>
 #include <orea/simulation/simmarket.hpp>
 
 #include <ored/portfolio/optionwrapper.hpp>
@@ -29,6 +30,7 @@
 #include <ored/utilities/dategrid.hpp>
 #include <ored/utilities/log.hpp>
 #include <ored/utilities/parsers.hpp>
+#include <ored/utilities/profiler.hpp>
 #include <ored/utilities/progressbar.hpp>
 #include <ored/utilities/to_string.hpp>
 
@@ -61,6 +63,7 @@ ValuationEngine::ValuationEngine(const Date& today, const QuantLib::ext::shared_
 void ValuationEngine::recalibrateModels() {
     ObservationMode::Mode om = ObservationMode::instance().mode();
     for (auto const& b : modelBuilders_) {
+        ScopedProfileTimer profileTimer("model calibration", std::string(), b.first);
         if (om == ObservationMode::Mode::Disable)
             b.second->forceRecalculate();
         b.second->recalibrate();
@@ -164,6 +167,21 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
     }
     LOG("Total number of trades = " << portfolio->size());
 
+    // in observation mode Disable a scenario sim market can tell which trades depend on the risk factors changed by
+    // a scenario, so that we only need to refresh those
+    auto scenarioSimMarket = QuantLib::ext::dynamic_pointer_cast<ScenarioSimMarket>(simMarket_);
+    refreshDependents_.clear();
+    if (scenarioSimMarket) {
+        scenarioSimMarket->clearRefreshDependents();
+        if (om == ObservationMode::Mode::Disable) {
+            for (auto const& [tradeId, trade] : trades) {
+                auto wrapper = trade->instrument();
+                auto isInvalidated = [wrapper]() { return !wrapper->qlInstrumentsCalculated(); };
+                refreshDependents_.push_back(scenarioSimMarket->addRefreshDependent(isInvalidated));
+            }
+        }
+    }
+
     if (!dates.empty() && dates.front() > simMarket_->asofDate()) {
         // the fixing manager is only required if sim dates contain future dates
         simMarket_->fixingManager()->initialise(portfolio, simMarket_);
@@ -278,6 +296,11 @@ void ValuationEngine::buildCube(const QuantLib::ext::shared_ptr<data::Portfolio>
            << (outputCube->samples() == 1 ? "" : "s");
     updateProgress(outputCube->samples() * nTrades, outputCube->samples() * nTrades, detail.str());
     loopTimer.stop();
+    if (scenarioSimMarket) {
+        scenarioSimMarket->clearRefreshDependents();
+        refreshDependents_.clear();
+    }
+
     LOG("ValuationEngine completed: loop " << setprecision(2) << loopTimer.format(2, "%w") << " sec, "
                                            << "pricing " << pricingTime << " sec, "
                                            << "update " << updateTime << " sec "
@@ -302,6 +325,9 @@ void ValuationEngine::runCalculators(bool isCloseOutDate, const std::map<std::st
                                      QuantLib::ext::shared_ptr<analytics::NPVCube>& outputCubeNettingSet, const Date& d,
                                      const Size cubeDateIndex, const Size sample, const string& label) {
     ObservationMode::Mode om = ObservationMode::instance().mode();
+    auto scenarioSimMarket = refreshDependents_.empty()
+                                 ? QuantLib::ext::shared_ptr<ScenarioSimMarket>()
+                                 : QuantLib::ext::dynamic_pointer_cast<ScenarioSimMarket>(simMarket_);
     for (auto& calc : calculators)
         calc->initScenario();
     // loop over trades
@@ -313,9 +339,13 @@ void ValuationEngine::runCalculators(bool isCloseOutDate, const std::map<std::st
         }
 
         // We can avoid checking mode here and always call updateQlInstruments()
-        if (om == ObservationMode::Mode::Disable || om == ObservationMode::Mode::Unregister)
+        if ((om == ObservationMode::Mode::Disable || om == ObservationMode::Mode::Unregister) &&
+            (scenarioSimMarket == nullptr || scenarioSimMarket->refreshRequired(refreshDependents_[j]))) {
+            ScopedProfileTimer profileTimer("notifications", trade->tradeType());
             trade->instrument()->updateQlInstruments();
+        }
         try {
+            ScopedProfileTimer profileTimer("pricing", trade->tradeType());
             for (auto& calc : calculators)
                 calc->calculate(trade, j, simMarket_, outputCube, outputCubeNettingSet, d, cubeDateIndex, sample,
                                 isCloseOutDate);
@@ -365,19 +395,22 @@ std::pair<double, double> ValuationEngine::populateCube(
     QL_REQUIRE(cubeDateIndex >= 0, "first date should be a valuation date");
     cpu_timer timer;
     timer.start();
-    simMarket_->preUpdate();
-    if (isValueDate || !isStickyDate) {
-        simMarket_->updateDate(d);
-    }
-    // We can skip this step, if we have done that above in the close-out date section
-    if (!scenarioUpdated) {
-        simMarket_->updateScenario(d);
-    }
-    // Always with fixing update here, in contrast to the close-out date section
-    simMarket_->postUpdate(d, !isStickyDate || isValueDate);
-    // Aggregation scenario data update on valuation dates only
-    if (isValueDate) {
-        simMarket_->updateAsd(d);
+    {
+        ScopedProfileTimer profileTimer("scenario apply");
+        simMarket_->preUpdate();
+        if (isValueDate || !isStickyDate) {
+            simMarket_->updateDate(d);
+        }
+        // We can skip this step, if we have done that above in the close-out date section
+        if (!scenarioUpdated) {
+            simMarket_->updateScenario(d);
+        }
+        // Always with fixing update here, in contrast to the close-out date section
+        simMarket_->postUpdate(d, !isStickyDate || isValueDate);
+        // Aggregation scenario data update on valuation dates only
+        if (isValueDate) {
+            simMarket_->updateAsd(d);
+        }
     }
     recalibrateModels();
 
@@ -126,6 +126,8 @@ private:
     QuantLib::ext::shared_ptr<ore::data::DateGrid> dg_;
     QuantLib::ext::shared_ptr<ore::analytics::SimMarket> simMarket_;
     set<std::pair<std::string, QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>>> modelBuilders_;
+    // ids of the trades registered with a scenario sim market for selective refresh in observation mode Disable
+    std::vector<QuantLib::Size> refreshDependents_;
 };
 } // namespace analytics
 } // namespace ore
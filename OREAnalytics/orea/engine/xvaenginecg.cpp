@@ -64,7 +64,8 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
                          const string& marketConfiguration, const string& marketConfigurationInCcy,
                          const QuantLib::ext::shared_ptr<ore::analytics::SensitivityScenarioData>& sensitivityData,
                          const QuantLib::ext::shared_ptr<ReferenceDataManager>& referenceData,
-                         const IborFallbackConfig& iborFallbackConfig, const bool bumpCvaSensis,
+                         const IborFallbackConfig& iborFallbackConfig, const std::string& dvaName,
+                         const bool bumpCvaSensis,
                          const bool useExternalComputeDevice, const bool externalDeviceCompatibilityMode,
                          const bool useDoublePrecisionForExternalCalculation, const std::string& externalComputeDevice,
                          const bool continueOnCalibrationError, const bool continueOnError, const std::string& context)
@@ -72,7 +73,8 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
       simMarketData_(simMarketData), engineData_(engineData), crossAssetModelData_(crossAssetModelData),
       scenarioGeneratorData_(scenarioGeneratorData), portfolio_(portfolio), marketConfiguration_(marketConfiguration),
       marketConfigurationInCcy_(marketConfigurationInCcy), sensitivityData_(sensitivityData),
-      referenceData_(referenceData), iborFallbackConfig_(iborFallbackConfig), bumpCvaSensis_(bumpCvaSensis),
+      referenceData_(referenceData), iborFallbackConfig_(iborFallbackConfig), dvaName_(dvaName),
+      bumpCvaSensis_(bumpCvaSensis),
       useExternalComputeDevice_(useExternalComputeDevice),
       externalDeviceCompatibilityMode_(externalDeviceCompatibilityMode),
       useDoublePrecisionForExternalCalculation_(useDoublePrecisionForExternalCalculation),
@@ -83,10 +85,10 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
 
     if (auto param_N = getenv("XVA_ENGINE_CG_N")) {
         portfolio_ = QuantLib::ext::make_shared<Portfolio>();
-        std::string pfxml = portfolio->toXMLString();
+        ore::data::XMLSnapshot pfSnapshot = portfolio->toXMLSnapshot();
         for (Size i = 0; i < atoi(param_N); ++i) {
             auto p = QuantLib::ext::make_shared<Portfolio>();
-            p->fromXMLString(pfxml);
+            p->fromXMLSnapshot(pfSnapshot);
             for (auto const& [id, t] : p->trades()) {
                 t->id() += "_" + std::to_string(i + 1);
                 portfolio_->add(t);
@@ -236,24 +238,101 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
 
     // Add post processor
     // This constitues part D of the computation graph from lastExposureNode ... g->size()
-    // The cvaNode is the ultimate result w.r.t. which we want to compute sensitivities
-
-    // note: very simplified calculation, for testing, just multiply the EPE on each date by fixed default prob
-    auto defaultCurve = simMarket_->defaultCurve("BANK")->curve();
-    model_->registerWith(defaultCurve);
-    Size cvaNode = cg_const(*g, 0.0);
-    for (Size i = 0; i < simulationDates.size(); ++i) {
-        Date d = i == 0 ? model_->referenceDate() : *std::next(simulationDates.begin(), i - 1);
-        Date e = *std::next(simulationDates.begin(), i);
-        std::size_t defaultProb =
-            addModelParameter(*g, model_->modelParameterFunctors(), "__defaultprob_" + std::to_string(i),
-                              [defaultCurve, d, e]() { return defaultCurve->defaultProbability(d, e); });
-        cvaNode = cg_add(*g, cvaNode, cg_mult(*g, defaultProb, cg_max(*g, pfExposureNodes[i], cg_const(*g, 0.0))));
+    // The cva and dva nodes are the ultimate results w.r.t. which we want to compute sensitivities:
+    //   CVA = LGD_cpty * sum_i PD_cpty(t_{i-1}, t_i) * EPE_ns(t_i), per netting set ns with counterparty cpty
+    //   DVA = LGD_own  * sum_i PD_own(t_{i-1}, t_i)  * ENE_ns(t_i), if a dva name is given
+    // The default probabilities and LGDs are model parameters, so that we get the credit sensitivities as well.
+
+    std::map<std::string, std::string> nettingSetCounterparty;
+    std::map<std::string, std::vector<std::size_t>> nettingSetTrades;
+    {
+        Size j = 0;
+        for (auto const& [id, trade] : portfolio_->trades()) {
+            const auto& nettingSetId = trade->envelope().nettingSetId();
+            const auto& counterparty = trade->envelope().counterparty();
+            auto c = nettingSetCounterparty.insert(std::make_pair(nettingSetId, counterparty)).first;
+            QL_REQUIRE(c->second == counterparty, "XvaEngineCG: netting set '"
+                                                      << nettingSetId << "' has trades with different counterparties ('"
+                                                      << c->second << "', '" << counterparty << "')");
+            nettingSetTrades[nettingSetId].push_back(j++);
+        }
+    }
+
+    std::map<std::string, std::pair<std::size_t, std::vector<std::size_t>>> creditNodes; // name => (lgd, pds)
+    auto credit = [this, &g, &simulationDates,
+                   &creditNodes](const std::string& name) -> const std::pair<std::size_t, std::vector<std::size_t>>& {
+        if (auto c = creditNodes.find(name); c != creditNodes.end())
+            return c->second;
+        auto defaultCurve = simMarket_->defaultCurve(name)->curve();
+        auto recoveryRate = simMarket_->recoveryRate(name);
+        model_->registerWith(defaultCurve);
+        model_->registerWith(recoveryRate);
+        std::size_t lgd = addModelParameter(*g, model_->modelParameterFunctors(), "__lgd_" + name,
+                                            [recoveryRate]() { return 1.0 - recoveryRate->value(); });
+        std::vector<std::size_t> defaultProbs;
+        for (Size i = 0; i < simulationDates.size(); ++i) {
+            Date d = i == 0 ? model_->referenceDate() : *std::next(simulationDates.begin(), i - 1);
+            Date e = *std::next(simulationDates.begin(), i);
+            defaultProbs.push_back(
+                addModelParameter(*g, model_->modelParameterFunctors(),
+                                  "__defaultprob_" + name + "_" + std::to_string(i),
+                                  [defaultCurve, d, e]() { return defaultCurve->defaultProbability(d, e); }));
+        }
+        return creditNodes[name] = std::make_pair(lgd, defaultProbs);
+    };
+
+    std::vector<std::size_t> nettingSetCvaNodes, nettingSetDvaNodes;
+    for (auto const& [nettingSetId, tradeIndices] : nettingSetTrades) {
+        std::vector<std::size_t> nettingSetExposureNodes;
+        for (Size i = 0; i < simulationDates.size(); ++i) {
+            std::vector<std::size_t> tradeNodes;
+            for (auto j : tradeIndices)
+                tradeNodes.push_back(amcNpvNodes[j][i + 1]);
+            nettingSetExposureNodes.push_back(model_->npv(cg_add(*g, tradeNodes),
+                                                          *std::next(simulationDates.begin(), i), cg_const(*g, 1.0),
+                                                          boost::none, ComputationGraph::nan, ComputationGraph::nan));
+        }
+        auto weightedExposure = [&g, &nettingSetExposureNodes](
+                                    const std::pair<std::size_t, std::vector<std::size_t>>& c, const bool positive) {
+            std::vector<std::size_t> terms;
+            for (Size i = 0; i < nettingSetExposureNodes.size(); ++i) {
+                std::size_t e = positive ? nettingSetExposureNodes[i] : cg_negative(*g, nettingSetExposureNodes[i]);
+                terms.push_back(cg_mult(*g, c.second[i], cg_max(*g, e, cg_const(*g, 0.0))));
+            }
+            return cg_mult(*g, c.first, terms.empty() ? cg_const(*g, 0.0) : cg_add(*g, terms));
+        };
+        nettingSetCvaNodes.push_back(weightedExposure(credit(nettingSetCounterparty[nettingSetId]), true));
+        if (!dvaName_.empty())
+            nettingSetDvaNodes.push_back(weightedExposure(credit(dvaName_), false));
+    }
+
+    // the total cva and dva, the dva node is nan if no dva name is given
+
+    std::size_t cvaNode = nettingSetCvaNodes.empty() ? cg_const(*g, 0.0) : cg_add(*g, nettingSetCvaNodes);
+    std::size_t dvaNode = ComputationGraph::nan;
+    if (!dvaName_.empty())
+        dvaNode = nettingSetDvaNodes.empty() ? cg_const(*g, 0.0) : cg_add(*g, nettingSetDvaNodes);
+
+    std::vector<std::size_t> xvaNodes{cvaNode};
+    std::vector<std::string> xvaNames{"CVA"};
+    if (dvaNode != ComputationGraph::nan) {
+        xvaNodes.push_back(dvaNode);
+        xvaNames.push_back("DVA");
     }
 
     boost::timer::nanosecond_type timing7 = timer.elapsed().wall;
 
+    // Eliminate the nodes which do not contribute to the exposures or the xvas
+
+    std::vector<std::size_t> outputNodes(pfExposureNodes);
+    outputNodes.insert(outputNodes.end(), nettingSetCvaNodes.begin(), nettingSetCvaNodes.end());
+    outputNodes.insert(outputNodes.end(), nettingSetDvaNodes.begin(), nettingSetDvaNodes.end());
+    outputNodes.insert(outputNodes.end(), xvaNodes.begin(), xvaNodes.end());
+    std::size_t deadNodes = g->eliminateDeadNodes(outputNodes);
+
     LOG("XvaEngineCG: graph building complete, size is " << g->size());
+    LOG("XvaEngineCG: shared " << g->commonSubexpressions() << " common subexpressions, eliminated " << deadNodes
+                               << " dead nodes, " << g->size() - deadNodes << " nodes remaining.");
     LOG("XvaEngineCG: got " << g->redBlockDependencies().size() << " red block dependencies.");
     std::size_t sumRedNodes = 0;
     for (auto const& r : g->redBlockRanges()) {
@@ -358,12 +437,10 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
         }
     }
 
-    for (auto const& n : pfExposureNodes) {
+    for (auto const& n : outputNodes) {
         keepNodes[n] = true;
     }
 
-    keepNodes[cvaNode] = true;
-
     std::vector<bool> rvOpAllowsPredeletion = QuantExt::getRandomVariableOpAllowsPredeletion();
 
     std::vector<std::vector<double>> externalOutput;
@@ -372,20 +449,18 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
         forwardEvaluation(*g, valuesExternal, opsExternal_, ExternalRandomVariable::deleter, !bumpCvaSensis_,
                           opNodeRequirements_, keepNodes, 0, ComputationGraph::nan, false,
                           ExternalRandomVariable::preDeleter, rvOpAllowsPredeletion);
-        for (Size i = 0; i < pfExposureNodes.size(); ++i) {
-            valuesExternal[pfExposureNodes[i]].declareAsOutput();
+        for (auto const n : outputNodes) {
+            valuesExternal[n].declareAsOutput();
         }
-        valuesExternal[cvaNode].declareAsOutput();
-        externalOutput.resize(pfExposureNodes.size() + 1, std::vector<double>(model_->size()));
+        externalOutput.resize(outputNodes.size(), std::vector<double>(model_->size()));
         externalOutputPtr.resize(externalOutput.size());
         std::transform(externalOutput.begin(), externalOutput.end(), externalOutputPtr.begin(),
                        [](std::vector<double>& v) { return &v[0]; });
         ComputeEnvironment::instance().context().finalizeCalculation(externalOutputPtr);
         // could skip this and use externalOutput directly below, but it's more convenient to copy the results to values
-        for (Size i = 0; i < pfExposureNodes.size(); ++i) {
-            values[pfExposureNodes[i]] = RandomVariable(model_->size(), externalOutputPtr[i]);
+        for (Size i = 0; i < outputNodes.size(); ++i) {
+            values[outputNodes[i]] = RandomVariable(model_->size(), externalOutputPtr[i]);
         }
-        values[cvaNode] = RandomVariable(model_->size(), externalOutputPtr.back());
     } else {
         forwardEvaluation(*g, values, ops_, RandomVariable::deleter, !bumpCvaSensis_, opNodeRequirements_, keepNodes);
     }
@@ -409,8 +484,31 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
         epeReport_->end();
     }
 
-    Real cva = expectation(values[cvaNode]).at(0);
-    LOG("XvaEngineCG: Calcuated CVA (node " << cvaNode << ") = " << cva);
+    std::vector<Real> xvas;
+    for (Size k = 0; k < xvaNodes.size(); ++k) {
+        xvas.push_back(expectation(values[xvaNodes[k]]).at(0));
+        LOG("XvaEngineCG: Calcuated " << xvaNames[k] << " (node " << xvaNodes[k] << ") = " << xvas.back());
+    }
+
+    // Write xva report by netting set
+
+    {
+        xvaReport_ = QuantLib::ext::make_shared<InMemoryReport>();
+        xvaReport_->addColumn("NettingSetId", string())
+            .addColumn("Counterparty", string())
+            .addColumn("CVA", double(), 2)
+            .addColumn("DVA", double(), 2);
+        Size k = 0;
+        for (auto const& [nettingSetId, counterparty] : nettingSetCounterparty) {
+            xvaReport_->next()
+                .add(nettingSetId)
+                .add(counterparty)
+                .add(expectation(values[nettingSetCvaNodes[k]]).at(0))
+                .add(nettingSetDvaNodes.empty() ? 0.0 : expectation(values[nettingSetDvaNodes[k]]).at(0));
+            ++k;
+        }
+        xvaReport_->end();
+    }
 
     rvMemMax = std::max(rvMemMax, numberOfStochasticRvs(values) + numberOfStochasticRvs(derivatives));
 
@@ -424,38 +522,46 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
 
         timing11 = timer.elapsed().wall;
 
-        std::vector<double> modelParamDerivatives(baseModelParams_.size());
-
-        if (!bumpCvaSensis_) {
+        // one backward derivatives run per xva, the values from the forward evaluation are reused
 
-            LOG("XvaEngineCG: run backward derivatives");
+        std::vector<std::vector<double>> modelParamDerivatives(xvaNodes.size(),
+                                                               std::vector<double>(baseModelParams_.size()));
 
-            derivatives[cvaNode] = RandomVariable(model_->size(), 1.0);
+        if (!bumpCvaSensis_) {
 
             std::vector<bool> keepNodesDerivatives(g->size(), false);
 
             for (auto const& [n, _] : baseModelParams_)
                 keepNodesDerivatives[n] = true;
 
-            // backward derivatives run
+            for (Size k = 0; k < xvaNodes.size(); ++k) {
+
+                LOG("XvaEngineCG: run backward derivatives for " << xvaNames[k]);
+
+                if (k > 0)
+                    derivatives.assign(g->size(), RandomVariable(model_->size(), 0.0));
+                derivatives[xvaNodes[k]] = RandomVariable(model_->size(), 1.0);
 
-            backwardDerivatives(*g, values, derivatives, grads_, RandomVariable::deleter, keepNodesDerivatives, ops_,
-                                opNodeRequirements_, keepNodes, RandomVariableOpCode::ConditionalExpectation,
-                                ops_[RandomVariableOpCode::ConditionalExpectation]);
+                // backward derivatives run
 
-            // read model param derivatives
+                backwardDerivatives(*g, values, derivatives, grads_, RandomVariable::deleter, keepNodesDerivatives,
+                                    ops_, opNodeRequirements_, keepNodes, RandomVariableOpCode::ConditionalExpectation,
+                                    ops_[RandomVariableOpCode::ConditionalExpectation]);
 
-            Size i = 0;
-            for (auto const& [n, v] : baseModelParams_) {
-                modelParamDerivatives[i++] = expectation(derivatives[n]).at(0);
+                // read model param derivatives
+
+                Size i = 0;
+                for (auto const& [n, v] : baseModelParams_) {
+                    modelParamDerivatives[k][i++] = expectation(derivatives[n]).at(0);
+                }
             }
 
             // get mem consumption
 
             rvMemMax = std::max(rvMemMax, numberOfStochasticRvs(values) + numberOfStochasticRvs(derivatives));
 
-            LOG("XvaEngineCG: got " << modelParamDerivatives.size()
-                                    << " model parameter derivatives from run backward derivatives");
+            LOG("XvaEngineCG: got " << baseModelParams_.size() << " model parameter derivatives for "
+                                    << xvaNodes.size() << " xvas from run backward derivatives");
 
             timing11 = timer.elapsed().wall;
 
@@ -477,9 +583,10 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
 
         simMarket_->scenarioGenerator() = sensiScenarioGenerator_;
 
-        auto resultCube = QuantLib::ext::make_shared<DoublePrecisionSensiCube>(std::set<std::string>{"CVA"}, asof_,
-                                                                               sensiScenarioGenerator_->samples());
-        resultCube->setT0(cva, 0, 0);
+        auto resultCube = QuantLib::ext::make_shared<DoublePrecisionSensiCube>(
+            std::set<std::string>(xvaNames.begin(), xvaNames.end()), asof_, sensiScenarioGenerator_->samples());
+        for (Size k = 0; k < xvaNodes.size(); ++k)
+            resultCube->setT0(xvas[k], resultCube->getTradeIndex(xvaNames[k]), 0);
 
         model_->alwaysForwardNotifications();
 
@@ -496,9 +603,9 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
 
             camBuilder_->recalibrate();
 
-            Real sensi = 0.0;
+            std::vector<Real> sensis(xvaNodes.size(), 0.0);
 
-            // calculate sensi if model was notified of a change
+            // calculate sensis if model was notified of a change
 
             if (!model_->isCalculated()) {
 
@@ -507,23 +614,25 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
 
                 if (!bumpCvaSensis_) {
 
-                    // calcuate CVA sensi using ad derivatives
+                    // calcuate xva sensis using ad derivatives
 
                     auto modelParameters = model_->modelParameters();
-                    Size i = 0;
-                    boost::accumulators::accumulator_set<
-                        double, boost::accumulators::stats<boost::accumulators::tag::weighted_sum>, double>
-                        acc;
-                    for (auto const& [n, v0] : baseModelParams_) {
-                        Real v1 = modelParameters[i].second;
-                        acc(modelParamDerivatives[i], boost::accumulators::weight = (v1 - v0));
-                        ++i;
+                    for (Size k = 0; k < xvaNodes.size(); ++k) {
+                        Size i = 0;
+                        boost::accumulators::accumulator_set<
+                            double, boost::accumulators::stats<boost::accumulators::tag::weighted_sum>, double>
+                            acc;
+                        for (auto const& [n, v0] : baseModelParams_) {
+                            Real v1 = modelParameters[i].second;
+                            acc(modelParamDerivatives[k][i], boost::accumulators::weight = (v1 - v0));
+                            ++i;
+                        }
+                        sensis[k] = boost::accumulators::weighted_sum(acc);
                     }
-                    sensi = boost::accumulators::weighted_sum(acc);
 
                 } else {
 
-                    // calcuate CVA sensi doing full recalc of CVA
+                    // calcuate xva sensis doing full recalc of the xvas
 
                     if (useExternalComputeDevice_) {
                         ComputeEnvironment::instance().context().initiateCalculation(
@@ -531,19 +640,22 @@ XvaEngineCG::XvaEngineCG(const Size nThreads, const Date& asof,
                         populateConstants(values, valuesExternal);
                         populateModelParameters(model_->modelParameters(), values, valuesExternal);
                         ComputeEnvironment::instance().context().finalizeCalculation(externalOutputPtr);
-                        values[cvaNode] = RandomVariable(model_->size(), externalOutputPtr.back());
+                        for (Size i = 0; i < outputNodes.size(); ++i)
+                            values[outputNodes[i]] = RandomVariable(model_->size(), externalOutputPtr[i]);
                     } else {
                         populateModelParameters(model_->modelParameters(), values, valuesExternal);
                         forwardEvaluation(*g, values, ops_, RandomVariable::deleter, true, opNodeRequirements_,
                                           keepNodes);
                     }
-                    sensi = expectation(values[cvaNode]).at(0) - cva;
+                    for (Size k = 0; k < xvaNodes.size(); ++k)
+                        sensis[k] = expectation(values[xvaNodes[k]]).at(0) - xvas[k];
                 }
             }
 
             // set result in cube
 
-            resultCube->set(cva + sensi, 0, 0, sample, 0);
+            for (Size k = 0; k < xvaNodes.size(); ++k)
+                resultCube->set(xvas[k] + sensis[k], resultCube->getTradeIndex(xvaNames[k]), 0, sample, 0);
         }
 
         timing12 = timer.elapsed().wall;
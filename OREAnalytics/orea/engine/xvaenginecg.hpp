@@ -62,7 +62,7 @@ public:
                 const QuantLib::ext::shared_ptr<ore::analytics::SensitivityScenarioData>& sensitivityData = nullptr,
                 const QuantLib::ext::shared_ptr<ReferenceDataManager>& referenceData = nullptr,
                 const IborFallbackConfig& iborFallbackConfig = IborFallbackConfig::defaultConfig(),
-                const bool bumpCvaSensis = false, const bool useExternalComputeDevice = false,
+                const std::string& dvaName = std::string(), const bool bumpCvaSensis = false, const bool useExternalComputeDevice = false,
                 const bool externalDeviceCompatibilityMode = false,
                 const bool useDoublePrecisionForExternalCalculation = false,
                 const std::string& externalComputeDevice = std::string(), const bool continueOnCalibrationError = true,
@@ -70,6 +70,7 @@ public:
 
     QuantLib::ext::shared_ptr<InMemoryReport> exposureReport() { return epeReport_; }
     QuantLib::ext::shared_ptr<InMemoryReport> sensiReport() { return sensiReport_; }
+    QuantLib::ext::shared_ptr<InMemoryReport> xvaReport() { return xvaReport_; }
 
 private:
     void populateRandomVariates(std::vector<RandomVariable>& values,
@@ -95,6 +96,7 @@ private:
     QuantLib::ext::shared_ptr<ore::analytics::SensitivityScenarioData> sensitivityData_;
     QuantLib::ext::shared_ptr<ReferenceDataManager> referenceData_;
     IborFallbackConfig iborFallbackConfig_;
+    std::string dvaName_;
     bool bumpCvaSensis_;
     bool useExternalComputeDevice_;
     bool externalDeviceCompatibilityMode_;
@@ -119,7 +121,7 @@ private:
     std::size_t externalCalculationId_;
 
     // output reports
-    QuantLib::ext::shared_ptr<InMemoryReport> epeReport_, sensiReport_;
+    QuantLib::ext::shared_ptr<InMemoryReport> epeReport_, sensiReport_, xvaReport_;
 };
 
 } // namespace analytics
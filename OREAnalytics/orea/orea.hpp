@@ -58,17 +58,21 @@
 #include <orea/cube/cubecsvreader.hpp>
 #include <orea/cube/cubeinterpretation.hpp>
 #include <orea/cube/cubewriter.hpp>
+#include <orea/cube/incrementalcube.hpp>
 #include <orea/cube/inmemorycube.hpp>
 #include <orea/cube/jaggedcube.hpp>
 #include <orea/cube/jointnpvcube.hpp>
 #include <orea/cube/jointnpvsensicube.hpp>
 #include <orea/cube/npvcube.hpp>
 #include <orea/cube/npvsensicube.hpp>
+#include <orea/cube/quantisedinmemorycube.hpp>
 #include <orea/cube/sensicube.hpp>
 #include <orea/cube/sensitivitycube.hpp>
 #include <orea/cube/sparsenpvcube.hpp>
+#include <orea/cube/subnpvcube.hpp>
 #include <orea/engine/amcvaluationengine.hpp>
 #include <orea/engine/bufferedsensitivitystream.hpp>
+#include <orea/engine/columnarsensitivitystream.hpp>
 #include <orea/engine/cptycalculator.hpp>
 #include <orea/engine/decomposedsensitivitystream.hpp>
 #include <orea/engine/filteredsensitivitystream.hpp>
@@ -91,6 +95,7 @@
 #include <orea/engine/parstressscenarioconverter.hpp>
 #include <orea/engine/pnlexplainreport.hpp>
 #include <orea/engine/riskfilter.hpp>
+#include <orea/engine/scenarioresultstore.hpp>
 #include <orea/engine/sensitivityaggregator.hpp>
 #include <orea/engine/sensitivityanalysis.hpp>
 #include <orea/engine/sensitivitycubestream.hpp>
@@ -2929,6 +2929,8 @@ ScenarioSimMarket::ScenarioSimMarket(
         baseScenario_ = tmp;
         baseScenarioAbsolute_ = tmpAbs;
     }
+    baseSimDataHash_ = simDataHash();
+    simDataIsBasePlusDelta_ = true;
     LOG("building base scenario done");
 }
 
@@ -2964,6 +2966,8 @@ void ScenarioSimMarket::reset() {
     applyScenario(baseScenario_);
     // clear delta scenario keys
     diffToBaseKeys_.clear();
+    // the sim data is the base scenario again
+    simDataIsBasePlusDelta_ = true;
     // see the comment in update() for why this is necessary...
     if (ObservationMode::instance().mode() == ObservationMode::Mode::Unregister) {
         QuantLib::ext::shared_ptr<QuantLib::Observable> obs = QuantLib::Settings::instance().evaluationDate();
@@ -2991,6 +2995,7 @@ void ScenarioSimMarket::applyScenario(const QuantLib::ext::shared_ptr<Scenario>&
             auto it = simData_.find(key);
             if (it != simData_.end()) {
                 it->second->setValue(baseScenario_->get(key));
+                changedRiskFactors_.emplace(key.keytype, key.name);
             }
         }
         diffToBaseKeys_.clear();
@@ -3005,6 +3010,7 @@ void ScenarioSimMarket::applyScenario(const QuantLib::ext::shared_ptr<Scenario>&
                 if (filter_->allow(key)) {
                     it->second->setValue(delta->get(key));
                     diffToBaseKeys_.insert(key);
+                    changedRiskFactors_.emplace(key.keytype, key.name);
                 }
             }
         }
@@ -3013,6 +3019,10 @@ void ScenarioSimMarket::applyScenario(const QuantLib::ext::shared_ptr<Scenario>&
         return;
     }
 
+    // we do not track the changed keys for other scenario types
+    fullRefresh_ = true;
+    simDataIsBasePlusDelta_ = false;
+
     // 2 apply scenario based on cached indices for simData_ for a SimpleScenario
     //   the scenario's keysHash() is used to make sure consistent keys are used
     //   if keysHash() is zero, this check is not effective (for backwards compatibility)
@@ -3131,17 +3141,109 @@ void ScenarioSimMarket::postUpdate(const Date& d, bool withFixings) {
 
     // Observation Mode - key to update these before fixings are set
     if (om == ObservationMode::Mode::Disable) {
-        refresh();
+        refreshChanged();
         ObservableSettings::instance().enableUpdates();
     } else if (om == ObservationMode::Mode::Defer) {
         ObservableSettings::instance().enableUpdates();
     }
+    changedRiskFactors_.clear();
 
     // Apply fixings as historical fixings. Must do this before we populate ASD
     if (withFixings)
         fixingManager_->update(d);
 }
 
+void ScenarioSimMarket::initRefreshTermStructures() {
+    if (refreshTsInitialised_)
+        return;
+    // only lazy term structures can tell whether a notification reached them, the others are always refreshed
+    for (auto const& ts : refreshTermStructures(Market::defaultConfiguration)) {
+        if (auto lazy = QuantLib::ext::dynamic_pointer_cast<LazyObject>(ts))
+            refreshLazyTs_.push_back(std::make_pair(ts, lazy));
+        else
+            refreshAlwaysTs_.push_back(ts);
+    }
+    refreshTsInitialised_ = true;
+}
+
+void ScenarioSimMarket::learnRefreshDependencies(const RefreshRiskFactor& riskFactor) {
+    initRefreshTermStructures();
+    // the quotes already carry the new values, notify them once with updates enabled
+    ObservableSettings::instance().enableUpdates();
+    for (auto it = simData_.lower_bound(RiskFactorKey(riskFactor.first, riskFactor.second, 0));
+         it != simData_.end() && it->first.keytype == riskFactor.first && it->first.name == riskFactor.second; ++it)
+        it->second->notifyObservers();
+    ObservableSettings::instance().disableUpdates(false);
+    // objects that were not calculated before are included as well, which is conservative
+    RefreshDependencies& deps = refreshDependencies_[riskFactor];
+    for (Size i = 0; i < refreshLazyTs_.size(); ++i) {
+        if (!refreshLazyTs_[i].second->isCalculated())
+            deps.termStructures.push_back(i);
+    }
+    for (Size i = 0; i < refreshDependents_.size(); ++i) {
+        if (refreshDependents_[i]())
+            deps.dependents.push_back(i);
+    }
+    DLOG("ScenarioSimMarket: risk factor " << riskFactor.first << "/" << riskFactor.second << " affects "
+                                           << deps.termStructures.size() << " of " << refreshLazyTs_.size()
+                                           << " term structures and " << deps.dependents.size() << " of "
+                                           << refreshDependents_.size() << " dependents");
+}
+
+void ScenarioSimMarket::refreshChanged() {
+    Date today = Settings::instance().evaluationDate();
+    bool full = fullRefresh_ || today != lastRefreshDate_;
+    if (!full) {
+        std::vector<RefreshRiskFactor> unknown;
+        for (auto const& r : changedRiskFactors_) {
+            if (refreshDependencies_.find(r) == refreshDependencies_.end())
+                unknown.push_back(r);
+        }
+        // invalidated objects can only be attributed to a risk factor if it is the only unknown one
+        if (unknown.size() == 1)
+            learnRefreshDependencies(unknown.front());
+        else if (unknown.size() > 1)
+            full = true;
+    }
+    if (full) {
+        refresh();
+        refreshRequired_.assign(refreshDependents_.size(), true);
+    } else {
+        refreshRequired_.assign(refreshDependents_.size(), false);
+        if (!changedRiskFactors_.empty()) {
+            for (auto const& ts : refreshAlwaysTs_)
+                ts->deepUpdate();
+        }
+        for (auto const& r : changedRiskFactors_) {
+            const RefreshDependencies& deps = refreshDependencies_.at(r);
+            for (auto i : deps.termStructures)
+                refreshLazyTs_[i].first->deepUpdate();
+            for (auto i : deps.dependents)
+                refreshRequired_[i] = true;
+        }
+    }
+    fullRefresh_ = false;
+    lastRefreshDate_ = today;
+}
+
+Size ScenarioSimMarket::addRefreshDependent(const std::function<bool()>& isInvalidated) {
+    refreshDependents_.push_back(isInvalidated);
+    refreshRequired_.push_back(true);
+    // the learned dependencies do not cover the new object
+    refreshDependencies_.clear();
+    return refreshDependents_.size() - 1;
+}
+
+bool ScenarioSimMarket::refreshRequired(const Size id) const {
+    return id >= refreshRequired_.size() || refreshRequired_[id];
+}
+
+void ScenarioSimMarket::clearRefreshDependents() {
+    refreshDependents_.clear();
+    refreshRequired_.clear();
+    refreshDependencies_.clear();
+}
+
 void ScenarioSimMarket::updateAsd(const Date& d) {
     if (asd_) {
         // add additional scenario data to the given container, if required
@@ -3193,6 +3295,57 @@ bool ScenarioSimMarket::isSimulated(const RiskFactorKey::KeyType& factor) const
     return std::find(nonSimulatedFactors_.begin(), nonSimulatedFactors_.end(), factor) == nonSimulatedFactors_.end();
 }
 
+namespace {
+// Contribution of one sim data point to the state hash. The points are combined order independently (xor resp. sum),
+// so that the contribution of a point can be replaced without rehashing the other points.
+std::pair<std::size_t, std::size_t> simDataPointHash(const RiskFactorKey& key, const Real value) {
+    std::pair<std::size_t, std::size_t> h(0, 0x9e3779b97f4a7c15ULL);
+    boost::hash_combine(h.first, key);
+    boost::hash_combine(h.first, value);
+    boost::hash_combine(h.second, value);
+    boost::hash_combine(h.second, key.name);
+    boost::hash_combine(h.second, key.index);
+    boost::hash_combine(h.second, static_cast<int>(key.keytype));
+    return h;
+}
+
+void addSimDataPointHash(std::pair<std::size_t, std::size_t>& h, const std::pair<std::size_t, std::size_t>& p) {
+    h.first ^= p.first;
+    h.second += p.second;
+}
+
+void removeSimDataPointHash(std::pair<std::size_t, std::size_t>& h, const std::pair<std::size_t, std::size_t>& p) {
+    h.first ^= p.first;
+    h.second -= p.second;
+}
+} // namespace
+
+std::pair<std::size_t, std::size_t> ScenarioSimMarket::simDataHash() const {
+    std::pair<std::size_t, std::size_t> h(0, 0);
+    for (auto const& [key, quote] : simData_)
+        addSimDataPointHash(h, simDataPointHash(key, quote->value()));
+    return h;
+}
+
+std::pair<std::size_t, std::size_t> ScenarioSimMarket::stateHash() const {
+    std::pair<std::size_t, std::size_t> seed;
+    if (simDataIsBasePlusDelta_) {
+        seed = baseSimDataHash_;
+        for (auto const& key : diffToBaseKeys_) {
+            removeSimDataPointHash(seed, simDataPointHash(key, baseScenario_->get(key)));
+            addSimDataPointHash(seed, simDataPointHash(key, simData_.at(key)->value()));
+        }
+    } else {
+        seed = simDataHash();
+    }
+    for (std::size_t* s : {&seed.first, &seed.second}) {
+        boost::hash_combine(*s, Settings::instance().evaluationDate().value().serialNumber());
+        boost::hash_combine(*s, numeraire_);
+        boost::hash_combine(*s, useSpreadedTermStructures_);
+    }
+    return seed;
+}
+
 Handle<YieldTermStructure> ScenarioSimMarket::getYieldCurve(const string& yieldSpecId,
                                                             const TodaysMarketParameters& todaysMarketParams,
                                                             const string& configuration,
@@ -31,7 +31,11 @@
 #include <ored/configuration/curveconfigurations.hpp>
 #include <ored/configuration/iborfallbackconfig.hpp>
 
+#include <ql/patterns/lazyobject.hpp>
+
+#include <functional>
 #include <map>
+#include <utility>
 
 namespace ore {
 namespace analytics {
@@ -139,8 +143,26 @@ public:
     //! is risk factor key simulated by this sim market instance?
     virtual bool isSimulated(const RiskFactorKey::KeyType& factor) const;
 
+    /*! Hash of the current state of the market: the evaluation date, the numeraire and the keys and values of the
+        simulation data. The two components are independent hashes, two states with the same hashes are treated as
+        identical, e.g. by the ScenarioResultStore. After reset() and while delta scenarios are applied, the hash is
+        updated from the keys differing from the base scenario only, otherwise all simulation data is hashed. */
+    std::pair<std::size_t, std::size_t> stateHash() const;
+
     void applyScenario(const QuantLib::ext::shared_ptr<Scenario>& scenario);
 
+    /*! Register an object depending on the sim market, e.g. a trade's instrument, which the caller refreshes itself
+        in observation mode Disable. The function must return true if the object was invalidated by a notification.
+        The returned id can be passed to refreshRequired() after each update. */
+    Size addRefreshDependent(const std::function<bool()>& isInvalidated);
+
+    /*! True if the registered object depends on a risk factor changed by the last update in observation mode
+        Disable, or if the last update refreshed the whole market */
+    bool refreshRequired(const Size id) const;
+
+    //! Remove all objects registered with addRefreshDependent()
+    void clearRefreshDependents();
+
 protected:
     
 
@@ -194,6 +216,38 @@ protected:
     // for delta scenario application
     std::set<ore::analytics::RiskFactorKey> diffToBaseKeys_;
 
+    // for stateHash(), the hash of the simulation data under the base scenario and whether the simulation data is
+    // the base scenario except for diffToBaseKeys_
+    std::pair<std::size_t, std::size_t> baseSimDataHash_;
+    bool simDataIsBasePlusDelta_ = false;
+    std::pair<std::size_t, std::size_t> simDataHash() const;
+
+    /* Selective refresh in observation mode Disable: instead of refreshing all term structures after each update
+       we keep a flattened list of the term structures and registered objects depending on each risk factor (key
+       type and name). The list for a risk factor is learned the first time it is the only unknown risk factor
+       changed by a delta scenario, by notifying its quotes once and collecting the objects that were invalidated.
+       Only lazy term structures can be learned this way. The non-lazy ones in refreshAlwaysTs_ do not record that
+       they were invalidated, so they are still deep updated after every scenario that changes a risk factor. */
+    typedef std::pair<RiskFactorKey::KeyType, std::string> RefreshRiskFactor;
+    struct RefreshDependencies {
+        std::vector<Size> termStructures;
+        std::vector<Size> dependents;
+    };
+    void refreshChanged();
+    void initRefreshTermStructures();
+    void learnRefreshDependencies(const RefreshRiskFactor& riskFactor);
+
+    std::vector<std::pair<QuantLib::ext::shared_ptr<TermStructure>, QuantLib::ext::shared_ptr<LazyObject>>>
+        refreshLazyTs_;
+    std::vector<QuantLib::ext::shared_ptr<TermStructure>> refreshAlwaysTs_;
+    bool refreshTsInitialised_ = false;
+    std::map<RefreshRiskFactor, RefreshDependencies> refreshDependencies_;
+    std::set<RefreshRiskFactor> changedRiskFactors_;
+    bool fullRefresh_ = true;
+    Date lastRefreshDate_;
+    std::vector<std::function<bool()>> refreshDependents_;
+    std::vector<bool> refreshRequired_;
+
     mutable QuantLib::ext::shared_ptr<Scenario> currentScenario_;
     QuantLib::ext::shared_ptr<Scenario> offsetScenario_;
 };
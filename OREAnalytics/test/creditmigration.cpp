@@ -0,0 +1,348 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <oret/toplevelfixture.hpp>
+#include <orea/aggregation/creditmigrationhelper.hpp>
+#include <orea/cube/inmemorycube.hpp>
+#include <orea/scenario/aggregationscenariodata.hpp>
+#include <qle/math/matrixfunctions.hpp>
+#include <qle/models/hullwhitebucketing.hpp>
+#include <qle/models/transitionmatrix.hpp>
+#include <ql/math/comparison.hpp>
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+#include <ql/time/daycounters/actualactual.hpp>
+
+#include <numeric>
+
+using namespace QuantLib;
+using namespace QuantExt;
+using namespace ore::data;
+using namespace ore::analytics;
+
+namespace {
+
+// a trade that only carries the issuer and envelope data used by the credit migration helper
+class TestTrade : public Trade {
+public:
+    TestTrade(const std::string& id, const std::string& issuer, const Envelope& env = Envelope())
+        : Trade("TestTrade", env) {
+        this->id() = id;
+        issuer_ = issuer;
+    }
+    void build(const QuantLib::ext::shared_ptr<EngineFactory>&) override {}
+};
+
+/* The inputs of a small credit migration run: three entities, two of them issuers of a trade each, the third is the
+   counterparty of a netting set, and a fourth trade with market risk only. */
+struct TestData {
+    TestData(const std::string& evaluation, const Size threads) {
+        asof = Date(5, Feb, 2016);
+        dates = {asof + 1 * Years, asof + 2 * Years, asof + 3 * Years};
+
+        parameters = QuantLib::ext::make_shared<CreditSimulationParameters>();
+        std::vector<Real> data = {
+            0.8588, 0.0976, 0.0048, 0.0000, 0.0003, 0.0000, 0.0000, 0.0000, //
+            0.0092, 0.8487, 0.0964, 0.0036, 0.0015, 0.0002, 0.0000, 0.0004, //
+            0.0008, 0.0224, 0.8624, 0.0609, 0.0077, 0.0021, 0.0000, 0.0002, //
+            0.0008, 0.0037, 0.0602, 0.7916, 0.0648, 0.0130, 0.0011, 0.0019, //
+            0.0003, 0.0008, 0.0046, 0.0402, 0.7676, 0.0788, 0.0047, 0.0140, //
+            0.0001, 0.0004, 0.0016, 0.0053, 0.0586, 0.7607, 0.0274, 0.0660, //
+            0.0000, 0.0000, 0.0000, 0.0100, 0.0279, 0.0538, 0.5674, 0.2535, //
+            0.0000, 0.0000, 0.0000, 0.0000, 0.0000, 0.0000, 0.0000, 1.0000};
+        Matrix m(n, n);
+        std::copy(data.begin(), data.end(), m.begin());
+        parameters->transitionMatrix()["TM"] = m;
+        parameters->entities() = {"CPTY_A", "CPTY_B", "CPTY_C"};
+        parameters->factorLoadings() = std::vector<Array>(3, Array(1, 0.4898979485566356));
+        parameters->transitionMatrices() = std::vector<std::string>(3, "TM");
+        parameters->initialStates() = {5, 4, 3};
+        parameters->marketRisk() = true;
+        parameters->creditRisk() = true;
+        parameters->zeroMarketPnl() = false;
+        parameters->evaluation() = evaluation;
+        parameters->doubleDefault() = false;
+        parameters->seed() = 42;
+        parameters->paths() = 200;
+        parameters->threads() = threads;
+        parameters->creditMode() = "Migration";
+        parameters->loanExposureMode() = "Value";
+        parameters->nettingSetIds() = {"NS_C"};
+
+        trades["BOND_A"] = QuantLib::ext::make_shared<TestTrade>("BOND_A", "CPTY_A");
+        trades["BOND_B"] = QuantLib::ext::make_shared<TestTrade>("BOND_B", "CPTY_B");
+        trades["SWAP_C"] = QuantLib::ext::make_shared<TestTrade>("SWAP_C", "", Envelope("CPTY_C", "NS_C"));
+        trades["SWAP_D"] = QuantLib::ext::make_shared<TestTrade>("SWAP_D", "");
+        std::set<std::string> ids;
+        for (auto const& [id, _] : trades)
+            ids.insert(id);
+
+        // depth: npv, cashflows, npvs by credit state
+        cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(asof, ids, dates, samples, 2 + n);
+        nettedCube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(asof, std::set<std::string>{"NS_C"},
+                                                                              dates, samples, 1);
+        aggData = QuantLib::ext::make_shared<InMemoryAggregationScenarioData>(dates.size(), samples);
+
+        MersenneTwisterUniformRng rng(17);
+        InverseCumulativeNormal icn;
+        for (Size id = 0; id < ids.size(); ++id) {
+            Real notional = 1.0E6 * (1.0 + rng.next().value);
+            cube->setT0(notional * (rng.next().value - 0.5), id, 0);
+            cube->setT0(0.0, id, 1);
+            for (Size d = 0; d < dates.size(); ++d) {
+                for (Size s = 0; s < samples; ++s) {
+                    Real npv = notional * (rng.next().value - 0.5);
+                    cube->set(npv, id, d, s, 0);
+                    cube->set(1.0E4 * rng.next().value, id, d, s, 1);
+                    for (Size k = 0; k < n; ++k)
+                        cube->set(k == n - 1 ? 0.4 * npv : npv * (1.0 - 0.01 * k), id, d, s, 2 + k);
+                }
+            }
+        }
+        for (Size d = 0; d < dates.size(); ++d) {
+            Real dt = ActualActual(ActualActual::ISDA).yearFraction(d == 0 ? asof : dates[d - 1], dates[d]);
+            for (Size s = 0; s < samples; ++s) {
+                nettedCube->set(1.0E6 * (rng.next().value - 0.3), "NS_C", dates[d], s);
+                // the global factor is a brownian motion sampled at the cube dates
+                Real w = d == 0 ? 0.0 : aggData->get(d - 1, s, AggregationScenarioDataType::CreditState, "0");
+                aggData->set(d, s, w + std::sqrt(dt) * icn(rng.next().value), AggregationScenarioDataType::CreditState,
+                             "0");
+            }
+        }
+    }
+
+    static constexpr Size n = 8, samples = 50;
+    static constexpr Real lowerBound = -3.0E6, upperBound = 3.0E6;
+    static constexpr Size buckets = 200;
+    Date asof;
+    std::vector<Date> dates;
+    QuantLib::ext::shared_ptr<CreditSimulationParameters> parameters;
+    std::map<std::string, QuantLib::ext::shared_ptr<Trade>> trades;
+    QuantLib::ext::shared_ptr<NPVCube> cube, nettedCube;
+    QuantLib::ext::shared_ptr<InMemoryAggregationScenarioData> aggData;
+};
+
+Array pnlDistribution(const TestData& td, const Size date) {
+    CreditMigrationHelper helper(td.parameters, td.cube, td.nettedCube, td.aggData, 1, 2, TestData::lowerBound,
+                                 TestData::upperBound, TestData::buckets, Matrix(1, 1, 1.0), "EUR");
+    helper.build(td.trades);
+    return helper.pnlDistribution(date);
+}
+
+/* The previous implementation of CreditMigrationHelper::pnlDistribution(), restricted to the features used by the
+   test data (no bonds or CDS, value exposure mode, migration mode, no double default), with the same order of
+   floating point operations. The inverse normal is evaluated per path and state, the inner simulation is done path
+   by path. */
+Array previousPnlDistribution(const TestData& td, const Size date) {
+    const CreditSimulationParameters& p = *td.parameters;
+    const NPVCube& cube = *td.cube;
+    const NPVCube& nettedCube = *td.nettedCube;
+    const Size n = TestData::n;
+    const Size nEntities = p.entities().size();
+    const std::vector<std::set<std::string>> issuerTradeIds = {{"BOND_A"}, {"BOND_B"}, {}};
+    const std::vector<std::set<std::string>> cptyNettingSetIds = {{}, {}, {"NS_C"}};
+
+    auto conditionalProb = [](const Real p, const Real m, const Real v) {
+        CumulativeNormalDistribution nd;
+        InverseCumulativeNormal icn;
+        if (close_enough(p, 0.0))
+            return 0.0;
+        if (close_enough(p, 1.0))
+            return 1.0;
+        Real icnP = icn(p);
+        if (close_enough(v, 1.0))
+            return icnP >= m ? 1.0 : 0.0;
+        return nd((icnP - m) / std::sqrt(1.0 - v));
+    };
+
+    Time t = ActualActual(ActualActual::ISDA).yearFraction(cube.asof(), cube.dates()[date]);
+    Matrix m = p.transitionMatrix().at("TM");
+    sanitiseTransitionMatrix(m);
+    Matrix transMat = Expm(t * generator(m));
+
+    std::vector<Real> globalVar(nEntities), globalState(nEntities);
+    for (Size i = 0; i < nEntities; ++i) {
+        globalVar[i] += p.factorLoadings()[i][0] * p.factorLoadings()[i][0] * 1.0;
+    }
+
+    Array res(TestData::buckets, 0.0);
+    Bucketing bucketing(TestData::lowerBound, TestData::upperBound, TestData::buckets);
+    HullWhiteBucketing hwBucketing(bucketing.upperBucketBound().begin(), bucketing.upperBucketBound().end());
+    MersenneTwisterUniformRng mt(p.seed());
+    std::vector<Size> states(nEntities);
+
+    for (Size path = 0; path < cube.samples(); ++path) {
+
+        for (Size i = 0; i < nEntities; ++i) {
+            Array globalFactors(1, td.aggData->get(date, path, AggregationScenarioDataType::CreditState, "0"));
+            globalState[i] = DotProduct(p.factorLoadings()[i], globalFactors / std::sqrt(t));
+        }
+
+        Real cash = 0.0;
+        for (Size j = 0; j <= date + 1; ++j) {
+            for (auto const& tradeId : cube.ids()) {
+                Size i = cube.idsAndIndexes().at(tradeId);
+                Real sp = 1.0;
+                if (j == 0) {
+                    cash -= cube.getT0(i, 0);
+                    cash += cube.getT0(i, 1);
+                } else if (j <= date) {
+                    cash += sp * cube.get(i, j - 1, path, 1);
+                } else {
+                    cash += sp * cube.get(i, j - 1, path, 0);
+                }
+            }
+        }
+
+        std::vector<Array> condProbs, pnl;
+
+        if (p.evaluation() != "Analytic") {
+            condProbs.resize(1, Array(p.paths(), 1.0 / static_cast<Real>(p.paths())));
+            pnl.resize(1, Array(p.paths(), 0.0));
+            std::vector<Matrix> cond(nEntities, Matrix(n, n, 0.0));
+            for (Size i = 0; i < nEntities; ++i) {
+                for (Size ii = 0; ii < n; ++ii) {
+                    Real pc = 0.0, condProb0 = 0.0;
+                    for (Size jj = 0; jj < n; ++jj) {
+                        pc += transMat[ii][jj];
+                        Real condProb = conditionalProb(pc, globalState[i], globalVar[i]);
+                        cond[i][ii][jj] = condProb - condProb0;
+                        condProb0 = condProb;
+                    }
+                }
+                try {
+                    checkTransitionMatrix(cond[i]);
+                } catch (const std::exception&) {
+                    sanitiseTransitionMatrix(cond[i]);
+                }
+                for (Size ii = 0; ii < n; ++ii)
+                    for (Size jj = 1; jj < n; ++jj)
+                        cond[i][ii][jj] += cond[i][ii][jj - 1];
+            }
+            for (Size path2 = 0; path2 < p.paths(); ++path2) {
+                for (Size i = 0; i < nEntities; ++i) {
+                    Size initialState = p.initialStates()[i];
+                    Real tmp = mt.next().value;
+                    Size entityState =
+                        std::lower_bound(cond[i].row_begin(initialState), cond[i].row_end(initialState), tmp) -
+                        cond[i].row_begin(initialState);
+                    states[i] = std::min(entityState, n - 1);
+                }
+                Real migrationPnl = 0.0;
+                for (Size i = 0; i < nEntities; ++i) {
+                    for (auto const& tradeId : issuerTradeIds[i]) {
+                        Size tid = cube.idsAndIndexes().at(tradeId);
+                        Real baseValue = cube.get(tid, date, path, 0);
+                        Real stateValue = cube.get(tid, date, path, 2 + states[i]);
+                        migrationPnl += stateValue - baseValue;
+                    }
+                    for (auto const& nettingSetId : cptyNettingSetIds[i]) {
+                        Size nid = nettedCube.idsAndIndexes().at(nettingSetId);
+                        if (states[i] == n - 1)
+                            migrationPnl -= std::max(nettedCube.get(nid, date, path), 0.0);
+                    }
+                }
+                pnl[0][path2] = migrationPnl;
+            }
+        } else {
+            condProbs.resize(nEntities, Array(n + 1, 0.0));
+            pnl.resize(nEntities, Array(n + 1, 0.0));
+            for (Size i = 0; i < nEntities; ++i) {
+                Size initialState = p.initialStates()[i];
+                Real pc = 0.0, condProb0 = 0.0;
+                for (Size j = 0; j < n; ++j) {
+                    pc += transMat[initialState][j];
+                    Real condProb = conditionalProb(pc, globalState[i], globalVar[i]);
+                    condProbs[i][j] = condProb - condProb0;
+                    condProb0 = condProb;
+                }
+                for (auto const& tradeId : issuerTradeIds[i]) {
+                    for (Size j = 0; j < n; ++j) {
+                        Size tid = cube.idsAndIndexes().at(tradeId);
+                        Real baseValue = cube.get(tid, date, path, 0);
+                        Real stateValue = cube.get(tid, date, path, 2 + j);
+                        pnl[i][j] += stateValue - baseValue;
+                        if (j == n - 1)
+                            pnl[i][n] += stateValue - baseValue;
+                    }
+                }
+                for (auto const& nettingSetId : cptyNettingSetIds[i]) {
+                    Size nid = nettedCube.idsAndIndexes().at(nettingSetId);
+                    pnl[i][n - 1] -= std::max(nettedCube.get(nid, date, path), 0.0);
+                }
+            }
+        }
+
+        condProbs.push_back(Array(1, 1.0));
+        pnl.push_back(Array(1, cash));
+
+        hwBucketing.computeMultiState(condProbs.begin(), condProbs.end(), pnl.begin());
+        res += hwBucketing.probability() / static_cast<Real>(cube.samples());
+    }
+
+    return res;
+}
+
+void checkIdentical(const Array& a, const Array& b, const std::string& label) {
+    BOOST_REQUIRE_EQUAL(a.size(), b.size());
+    Size mismatches = 0;
+    for (Size k = 0; k < a.size(); ++k) {
+        if (a[k] != b[k] && ++mismatches <= 5)
+            BOOST_ERROR(label << ": bucket " << k << " differs, " << a[k] << " vs " << b[k]);
+    }
+    BOOST_CHECK_MESSAGE(mismatches == 0, label << ": " << mismatches << " buckets differ");
+}
+
+void testPnlDistribution(const std::string& evaluation) {
+    if (!QuantExt::supports_Expm()) {
+        BOOST_TEST_MESSAGE("skipping this test because Expm is not supported");
+        return;
+    }
+    TestData serial(evaluation, 1), parallel(evaluation, 4);
+    for (Size date : {0, 2}) {
+        Array expected = previousPnlDistribution(serial, date);
+        Array resultSerial = pnlDistribution(serial, date);
+        Array resultParallel = pnlDistribution(parallel, date);
+        // the distribution is not trivial
+        BOOST_CHECK_CLOSE(std::accumulate(expected.begin(), expected.end(), 0.0), 1.0, 1E-8);
+        BOOST_CHECK(std::count_if(expected.begin(), expected.end(), [](Real x) { return x > 0.0; }) > 10);
+        checkIdentical(resultSerial, expected, evaluation + ", Threads=1 vs previous implementation");
+        checkIdentical(resultParallel, resultSerial, evaluation + ", Threads=4 vs Threads=1");
+    }
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(CreditMigrationTest)
+
+BOOST_AUTO_TEST_CASE(testAnalyticPnlDistribution) {
+    BOOST_TEST_MESSAGE("Testing credit migration pnl distribution (Analytic)...");
+    testPnlDistribution("Analytic");
+}
+
+BOOST_AUTO_TEST_CASE(testTerminalSimulationPnlDistribution) {
+    BOOST_TEST_MESSAGE("Testing credit migration pnl distribution (TerminalSimulation)...");
+    testPnlDistribution("TerminalSimulation");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,8 +20,11 @@
 #include <boost/test/unit_test.hpp>
 #include <orea/cube/inmemorycube.hpp>
 #include <orea/cube/cube_io.hpp>
+#include <orea/cube/incrementalcube.hpp>
 #include <orea/cube/npvcube.hpp>
+#include <orea/cube/quantisedinmemorycube.hpp>
 #include <orea/cube/jaggedcube.hpp>
+#include <orea/cube/subnpvcube.hpp>
 #include <orea/engine/filteredsensitivitystream.hpp>
 #include <orea/engine/observationmode.hpp>
 #include <orea/engine/parametricvar.hpp>
@@ -58,6 +61,8 @@
 
 #include "testmarket.hpp"
 
+#include <thread>
+
 using namespace ore::analytics;
 using namespace boost::unit_test_framework;
 using std::string;
@@ -251,6 +256,107 @@ void testCubeFileIO(QuantLib::ext::shared_ptr<NPVCube> cube, const std::string&
     checkCube(*cube2, tolerance, portfolio, d);
 }
 
+template <class T> void testQuantisedCube(const std::string& cubeName) {
+    BOOST_TEST_MESSAGE("Testing cube " << cubeName);
+
+    Date d(1, QuantLib::Jan, 2016);
+    vector<Date> dates = {Date(1, QuantLib::Feb, 2016), Date(1, QuantLib::Mar, 2016)};
+    Size samples = 50, depth = 2;
+    std::set<string> ids = {"a", "b", "c"};
+    T cube(d, ids, dates, samples, depth);
+
+    // the deviations from T0 grow with the sample index, so blocks are rescaled while they are filled
+    auto t0 = [](Size i, Size l) { return 1000.0 * (i + 1) - 10.0 * l; };
+    auto value = [&t0](Size i, Size j, Size k, Size l) {
+        return t0(i, l) + (k % 2 == 0 ? 1.0 : -1.0) * std::pow(1.2, k) * (j + 1) / (i + 1);
+    };
+    for (Size i = 0; i < ids.size(); ++i) {
+        for (Size l = 0; l < depth; ++l) {
+            cube.setT0(t0(i, l), i, l);
+            for (Size j = 0; j < dates.size(); ++j)
+                for (Size k = 0; k < samples; ++k)
+                    cube.set(value(i, j, k, l), i, j, k, l);
+        }
+    }
+
+    for (Size i = 0; i < ids.size(); ++i) {
+        for (Size l = 0; l < depth; ++l) {
+            BOOST_CHECK_EQUAL(cube.getT0(i, l), t0(i, l));
+            for (Size j = 0; j < dates.size(); ++j) {
+                Real maxDeviation = 0.0;
+                for (Size k = 0; k < samples; ++k) {
+                    BOOST_CHECK_SMALL(cube.get(i, j, k, l) - value(i, j, k, l), cube.errorBound(i, j, l));
+                    maxDeviation = std::max(maxDeviation, std::fabs(value(i, j, k, l) - t0(i, l)));
+                }
+                BOOST_CHECK_GT(cube.errorBound(i, j, l), 0.0);
+                BOOST_CHECK_LE(cube.errorBound(i, j, l), T::relativeErrorBound() * maxDeviation);
+            }
+        }
+    }
+
+    // changing T0 re-encodes the values, adding at most one quantisation step of the new encoding
+    Real oldBound = cube.errorBound(1, 1, 0);
+    cube.setT0(t0(1, 0) + 5.0, 1, 0);
+    BOOST_CHECK_EQUAL(cube.getT0(1, 0), t0(1, 0) + 5.0);
+    for (Size k = 0; k < samples; ++k)
+        BOOST_CHECK_SMALL(cube.get(1, 1, k, 0) - value(1, 1, k, 0), oldBound + cube.errorBound(1, 1, 0));
+
+    // values that are not finite are kept as they are and do not affect the scale of their block
+    Real nan = std::numeric_limits<Real>::quiet_NaN(), inf = std::numeric_limits<Real>::infinity();
+    Real bound = cube.errorBound(0, 0, 0);
+    cube.set(nan, 0, 0, 3, 0);
+    cube.set(inf, 0, 0, 4, 0);
+    cube.set(-inf, 0, 0, 5, 0);
+    BOOST_CHECK(std::isnan(cube.get(0, 0, 3, 0)));
+    BOOST_CHECK_EQUAL(cube.get(0, 0, 4, 0), inf);
+    BOOST_CHECK_EQUAL(cube.get(0, 0, 5, 0), -inf);
+    BOOST_CHECK_EQUAL(cube.errorBound(0, 0, 0), bound);
+    BOOST_CHECK_SMALL(cube.get(0, 0, 6, 0) - value(0, 0, 6, 0), bound);
+    // a block is rescaled around them, a finite value replaces them
+    cube.set(t0(0, 0) + 1.0E6, 0, 0, 6, 0);
+    BOOST_CHECK(std::isnan(cube.get(0, 0, 3, 0)));
+    BOOST_CHECK_EQUAL(cube.get(0, 0, 4, 0), inf);
+    BOOST_CHECK_SMALL(cube.get(0, 0, 6, 0) - (t0(0, 0) + 1.0E6), cube.errorBound(0, 0, 0));
+    cube.set(value(0, 0, 4, 0), 0, 0, 4, 0);
+    BOOST_CHECK_SMALL(cube.get(0, 0, 4, 0) - value(0, 0, 4, 0), cube.errorBound(0, 0, 0));
+    // and they survive a change of T0
+    cube.setT0(t0(0, 0) + 1.0, 0, 0);
+    BOOST_CHECK(std::isnan(cube.get(0, 0, 3, 0)));
+    BOOST_CHECK_EQUAL(cube.get(0, 0, 5, 0), -inf);
+    // a block holding only values that are not finite, the first finite value sets the scale
+    T fresh(d, ids, dates, samples, depth);
+    fresh.set(inf, 0, 0, 0, 0);
+    BOOST_CHECK_EQUAL(fresh.get(0, 0, 0, 0), inf);
+    BOOST_CHECK_EQUAL(fresh.get(0, 0, 1, 0), 0.0);
+    fresh.set(2.0, 0, 0, 1, 0);
+    BOOST_CHECK_EQUAL(fresh.get(0, 0, 0, 0), inf);
+    BOOST_CHECK_SMALL(fresh.get(0, 0, 1, 0) - 2.0, fresh.errorBound(0, 0, 0));
+    BOOST_CHECK_LE(fresh.errorBound(0, 0, 0), T::relativeErrorBound() * 2.0);
+    BOOST_CHECK_EQUAL(fresh.get(0, 0, 2, 0), 0.0);
+    // a T0 value that is not finite, values that are not set equal T0
+    fresh.setT0(nan, 1, 0);
+    fresh.set(1.0, 1, 0, 0, 0);
+    BOOST_CHECK(std::isnan(fresh.getT0(1, 0)));
+    BOOST_CHECK_EQUAL(fresh.get(1, 0, 0, 0), 1.0);
+    BOOST_CHECK(std::isnan(fresh.get(1, 0, 1, 0)));
+    BOOST_CHECK_THROW(cube.set(1.0, 0, dates.size(), 0, 0), std::exception);
+
+    // removing an id resets its T0 and other values, other ids are unaffected
+    cube.remove(cube.getTradeIndex("b"));
+    BOOST_CHECK_EQUAL(cube.getT0(1, 1), 0.0);
+    BOOST_CHECK_EQUAL(cube.get(1, 1, 7, 1), 0.0);
+    BOOST_CHECK_EQUAL(cube.errorBound(1, 1, 1), 0.0);
+    BOOST_CHECK_SMALL(cube.get(2, 1, 7, 1) - value(2, 1, 7, 1), cube.errorBound(2, 1, 1));
+
+    // the error tolerance is only checked, it does not change the encoding
+    T checked(d, ids, dates, samples, depth, 1E-3);
+    BOOST_CHECK_EQUAL(checked.errorTolerance(), 1E-3);
+    checked.set(1.0E6, 0, 0, 0, 0);
+    BOOST_CHECK_GT(checked.errorBound(0, 0, 0), 1E-3);
+    BOOST_CHECK_SMALL(checked.get(0, 0, 0, 0) - 1.0E6, checked.errorBound(0, 0, 0));
+    BOOST_CHECK_THROW(T(d, ids, dates, samples, depth, -1.0), std::exception);
+}
+
 } // namespace
 
 // Returns an int in the interval [min, max]. Inclusive.
@@ -582,6 +688,216 @@ BOOST_AUTO_TEST_CASE(testInMemoryReportBuffer) {
     diffFiles(filename_0, filename_100000);
 }
 
+BOOST_AUTO_TEST_CASE(testSpliceCube) {
+    BOOST_TEST_MESSAGE("Testing splicing of a previous and an update cube...");
+
+    Date d(1, QuantLib::Jan, 2016);
+    vector<Date> dates = {Date(1, QuantLib::Feb, 2016), Date(1, QuantLib::Mar, 2016)};
+    Size samples = 10, depth = 2;
+    auto previous = QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(
+        d, std::set<string>{"a", "b", "c"}, dates, samples, depth);
+    auto update =
+        QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(d, std::set<string>{"b", "d"}, dates, samples, depth);
+    auto value = [](Real offset, Size j, Size k, Size l) { return offset + 100.0 * j + k + 0.25 * l; };
+    for (auto const& [cube, offset] : {std::make_pair(previous, 1000.0), std::make_pair(update, 2000.0)}) {
+        for (Size i = 0; i < cube->numIds(); ++i) {
+            for (Size l = 0; l < depth; ++l) {
+                cube->setT0(offset + 10000.0 * i + l, i, l);
+                for (Size j = 0; j < dates.size(); ++j)
+                    for (Size k = 0; k < samples; ++k)
+                        cube->set(value(offset + 10000.0 * i, j, k, l), i, j, k, l);
+            }
+        }
+    }
+
+    auto spliced = spliceCube(previous, update, {"a", "b", "d"});
+    BOOST_REQUIRE_EQUAL(spliced->numIds(), 3);
+    BOOST_CHECK_EQUAL(spliced->depth(), depth);
+    BOOST_CHECK_EQUAL(spliced->samples(), samples);
+    // a is taken from the previous cube, b and d from the update cube
+    std::vector<std::pair<NPVCube*, string>> sources = {
+        {previous.get(), "a"}, {update.get(), "b"}, {update.get(), "d"}};
+    for (auto const& [source, id] : sources) {
+        for (Size l = 0; l < depth; ++l) {
+            BOOST_CHECK_CLOSE(spliced->getT0(spliced->getTradeIndex(id), l),
+                              source->getT0(source->getTradeIndex(id), l), 1e-6);
+            for (Size j = 0; j < dates.size(); ++j)
+                for (Size k = 0; k < samples; ++k)
+                    BOOST_CHECK_CLOSE(spliced->get(spliced->getTradeIndex(id), j, k, l),
+                                      source->get(source->getTradeIndex(id), j, k, l), 1e-6);
+        }
+    }
+
+    // without an update cube all entries are taken from the previous cube
+    spliced = spliceCube(previous, nullptr, {"c"});
+    BOOST_CHECK_CLOSE(spliced->get(0, 1, 3, 1), previous->get(2, 1, 3, 1), 1e-6);
+    // ids must be present in one of the cubes
+    BOOST_CHECK_THROW(spliceCube(previous, update, {"e"}), std::exception);
+
+    // the spliced cube is created by the given factory, e.g. a quantised cube
+    spliced = spliceCube(previous, update, {"a", "b", "d"},
+                         [](const Date& asof, const std::set<string>& ids, const vector<Date>& dates, Size samples,
+                            Size depth) {
+                             return QuantLib::ext::make_shared<QuantisedInMemoryCube16>(asof, ids, dates, samples,
+                                                                                        depth);
+                         });
+    auto quantised = QuantLib::ext::dynamic_pointer_cast<QuantisedInMemoryCube16>(spliced);
+    BOOST_REQUIRE(quantised);
+    for (auto const& [source, id] : sources) {
+        Size i = spliced->getTradeIndex(id);
+        for (Size l = 0; l < depth; ++l) {
+            BOOST_CHECK_EQUAL(spliced->getT0(i, l), source->getT0(source->getTradeIndex(id), l));
+            for (Size j = 0; j < dates.size(); ++j)
+                for (Size k = 0; k < samples; ++k)
+                    BOOST_CHECK_SMALL(spliced->get(i, j, k, l) - source->get(source->getTradeIndex(id), j, k, l),
+                                      quantised->errorBound(i, j, l));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testCubeTradeHashesIO) {
+    BOOST_TEST_MESSAGE("Testing trade hashes in cube meta data...");
+
+    Date d(1, QuantLib::Jan, 2016);
+    NPVCubeWithMetaData r;
+    r.cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(d, std::set<string>{"trade 1", "trade2"},
+                                                                     vector<Date>(2, d), 3);
+    r.tradeHashes = {{"trade 1", "0123456789abcdef"}, {"trade2", "fedcba9876543210"}};
+    string filename = (boost::filesystem::temp_directory_path() / "cube_tradehashes.csv").string();
+    saveCube(filename, r, true);
+    auto loaded = loadCube(filename, true);
+    BOOST_CHECK(loaded.tradeHashes == r.tradeHashes);
+    BOOST_CHECK_EQUAL(loaded.cube->numIds(), 2);
+
+    std::map<string, string> current = {{"trade 1", "0123456789abcdef"}, {"trade2", "0"}, {"trade3", "1"}};
+    BOOST_CHECK(changedTrades(r.tradeHashes, current) == std::set<string>({"trade2", "trade3"}));
+}
+
+BOOST_AUTO_TEST_CASE(testMergeShardedCubes) {
+    BOOST_TEST_MESSAGE("Testing merge of cubes from sharded simulation runs...");
+
+    Date d(1, QuantLib::Jan, 2016);
+    vector<Date> dates = {Date(1, QuantLib::Feb, 2016), Date(1, QuantLib::Mar, 2016)};
+    Size samples = 5, depth = 2;
+    std::set<string> ids = {"a", "b", "c", "d", "e"};
+    auto value = [](const string& id, Size j, Size k, Size l) { return 1000.0 * id[0] + 100.0 * j + k + 0.25 * l; };
+    auto fill = [&value, &dates, samples, depth](const QuantLib::ext::shared_ptr<NPVCube>& cube) {
+        for (auto const& [id, i] : cube->idsAndIndexes()) {
+            for (Size l = 0; l < depth; ++l) {
+                cube->setT0(value(id, 0, 0, l) - 1.0, i, l);
+                for (Size j = 0; j < dates.size(); ++j)
+                    for (Size k = 0; k < samples; ++k)
+                        cube->set(value(id, j, k, l), i, j, k, l);
+            }
+        }
+    };
+
+    // the shards partition the ids
+    Size shardCount = 3;
+    std::set<string> allShardIds;
+    vector<NPVCubeWithMetaData> shards;
+    for (Size s = 0; s < shardCount; ++s) {
+        auto sids = shardIds(ids, s, shardCount);
+        for (auto const& id : sids)
+            BOOST_CHECK(allShardIds.insert(id).second);
+        NPVCubeWithMetaData shard;
+        shard.cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(d, sids, dates, samples, depth);
+        fill(shard.cube);
+        for (auto const& id : sids)
+            shard.tradeHashes[id] = "hash_" + id;
+        shards.push_back(shard);
+    }
+    BOOST_CHECK(allShardIds == ids);
+    BOOST_CHECK_THROW(shardIds(ids, 3, 3), std::exception);
+
+    // the merged cube does not depend on the order of the shards
+    auto merged = mergeCubes(shards, true);
+    std::reverse(shards.begin(), shards.end());
+    auto mergedReverse = mergeCubes(shards, true);
+    BOOST_REQUIRE_EQUAL(merged.cube->numIds(), ids.size());
+    BOOST_CHECK(merged.cube->ids() == mergedReverse.cube->ids());
+    BOOST_CHECK_EQUAL(merged.tradeHashes.size(), ids.size());
+    for (auto const& [id, i] : merged.cube->idsAndIndexes()) {
+        BOOST_CHECK_EQUAL(mergedReverse.cube->getTradeIndex(id), i);
+        for (Size l = 0; l < depth; ++l) {
+            BOOST_CHECK_EQUAL(merged.cube->getT0(i, l), value(id, 0, 0, l) - 1.0);
+            for (Size j = 0; j < dates.size(); ++j)
+                for (Size k = 0; k < samples; ++k) {
+                    BOOST_CHECK_EQUAL(merged.cube->get(i, j, k, l), value(id, j, k, l));
+                    BOOST_CHECK_EQUAL(mergedReverse.cube->get(i, j, k, l), value(id, j, k, l));
+                }
+        }
+    }
+
+    // overlapping shards and inconsistent layouts are rejected
+    BOOST_CHECK_THROW(mergeCubes({merged, shards.front()}, true), std::exception);
+    NPVCubeWithMetaData other;
+    other.cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(d, std::set<string>{"f"}, dates,
+                                                                         samples + 1, depth);
+    BOOST_CHECK_THROW(mergeCubes({merged, other}, true), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(testSubNPVCubeConcurrentWrites) {
+    BOOST_TEST_MESSAGE("Testing concurrent writes through views on disjoint ids of a cube...");
+
+    Date d(1, QuantLib::Jan, 2016);
+    vector<Date> dates = {Date(1, QuantLib::Feb, 2016), Date(1, QuantLib::Mar, 2016)};
+    Size samples = 50, depth = 2;
+    std::set<string> ids = {"a", "b", "c", "d", "e", "f", "g"};
+    auto cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCubeN>(d, ids, dates, samples, depth);
+    auto value = [](const string& id, Size j, Size k, Size l) { return 1000.0 * id[0] + 100.0 * j + k + 0.25 * l; };
+
+    // split the ids round robin into views, as the multi-threaded valuation engine does
+    Size nViews = 3;
+    vector<std::set<string>> viewIds(nViews);
+    Size n = 0;
+    for (auto const& id : ids)
+        viewIds[n++ % nViews].insert(id);
+    vector<QuantLib::ext::shared_ptr<NPVCube>> views;
+    for (auto const& v : viewIds)
+        views.push_back(QuantLib::ext::make_shared<SubNPVCube>(cube, v));
+
+    vector<std::thread> threads;
+    for (auto const& view : views) {
+        threads.emplace_back([view, &value, &dates, samples, depth]() {
+            for (auto const& [id, i] : view->idsAndIndexes()) {
+                for (Size l = 0; l < depth; ++l) {
+                    view->setT0(value(id, 0, 0, l) - 1.0, i, l);
+                    for (Size j = 0; j < dates.size(); ++j)
+                        for (Size k = 0; k < samples; ++k)
+                            view->set(value(id, j, k, l), i, j, k, l);
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    for (auto const& [id, i] : cube->idsAndIndexes()) {
+        for (Size l = 0; l < depth; ++l) {
+            BOOST_CHECK_EQUAL(cube->getT0(i, l), value(id, 0, 0, l) - 1.0);
+            for (Size j = 0; j < dates.size(); ++j)
+                for (Size k = 0; k < samples; ++k)
+                    BOOST_CHECK_EQUAL(cube->get(i, j, k, l), value(id, j, k, l));
+        }
+    }
+
+    // views read through to the underlying cube and remove only their own ids
+    BOOST_CHECK_EQUAL(views[1]->numIds(), viewIds[1].size());
+    BOOST_CHECK_EQUAL(views[1]->get(views[1]->getTradeIndex("e"), 1, 7, 1), value("e", 1, 7, 1));
+    views[1]->remove(views[1]->getTradeIndex("e"));
+    BOOST_CHECK_EQUAL(cube->get(cube->getTradeIndex("e"), 1, 7, 1), 0.0);
+    BOOST_CHECK_EQUAL(cube->get(cube->getTradeIndex("d"), 1, 7, 1), value("d", 1, 7, 1));
+
+    // ids must be present in the underlying cube
+    BOOST_CHECK_THROW(QuantLib::ext::make_shared<SubNPVCube>(cube, std::set<string>{"h"}), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(testQuantisedInMemoryCube) {
+    testQuantisedCube<QuantisedInMemoryCube16>("QuantisedInMemoryCube16");
+    testQuantisedCube<QuantisedInMemoryCube8>("QuantisedInMemoryCube8");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,224 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <oret/toplevelfixture.hpp>
+
+#include <orea/aggregation/dimregressioncalculator.hpp>
+#include <orea/app/inputparameters.hpp>
+#include <orea/cube/cubeinterpretation.hpp>
+#include <orea/cube/inmemorycube.hpp>
+#include <orea/scenario/aggregationscenariodata.hpp>
+#include <ored/portfolio/portfolio.hpp>
+#include <ored/portfolio/trade.hpp>
+
+#include <qle/math/nadarayawatson.hpp>
+#include <qle/math/stabilisedglls.hpp>
+
+#include <ql/math/distributions/normaldistribution.hpp>
+#include <ql/math/kernelfunctions.hpp>
+#include <ql/math/randomnumbers/mt19937uniformrng.hpp>
+#include <ql/methods/montecarlo/lsmbasissystem.hpp>
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics/mean.hpp>
+#include <boost/accumulators/statistics/stats.hpp>
+#include <boost/accumulators/statistics/variance.hpp>
+
+using namespace boost::unit_test_framework;
+using namespace boost::accumulators;
+using namespace QuantLib;
+using namespace ore::data;
+using namespace ore::analytics;
+using std::string;
+using std::vector;
+
+namespace {
+
+class TestTrade : public Trade {
+public:
+    TestTrade(const string& id, const string& nettingSetId) : Trade("TestTrade", Envelope("CP", nettingSetId)) {
+        this->id() = id;
+    }
+    void build(const QuantLib::ext::shared_ptr<EngineFactory>&) override {}
+};
+
+// Simulated trade NPVs, numeraires and one index fixing, the NPVs depend quadratically on the fixing
+struct DimTestData {
+    DimTestData(Size nettingSets, Size tradesPerNettingSet, Size nDates, Size samples) {
+        Date asof(15, January, 2024);
+        vector<Date> dates;
+        for (Size j = 0; j < nDates; ++j)
+            dates.push_back(asof + 14 * (j + 1));
+
+        portfolio = QuantLib::ext::make_shared<Portfolio>();
+        for (Size n = 0; n < nettingSets; ++n)
+            for (Size t = 0; t < tradesPerNettingSet; ++t)
+                portfolio->add(QuantLib::ext::make_shared<TestTrade>("Trade_" + std::to_string(n) + "_" +
+                                                                         std::to_string(t),
+                                                                     "NettingSet_" + std::to_string(n)));
+
+        cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(asof, portfolio->ids(), dates, samples);
+        scenarioData = QuantLib::ext::make_shared<InMemoryAggregationScenarioData>(nDates, samples);
+
+        MersenneTwisterUniformRng rng(42);
+        for (Size j = 0; j < nDates; ++j) {
+            for (Size k = 0; k < samples; ++k) {
+                Real fixing = 0.02 + 0.01 * std::sqrt(j + 1.0) * (rng.nextReal() - 0.5);
+                scenarioData->set(j, k, fixing, AggregationScenarioDataType::IndexFixing, "EUR-EURIBOR-6M");
+                scenarioData->set(j, k, 1.0 + 0.01 * j + 0.001 * rng.nextReal(),
+                                  AggregationScenarioDataType::Numeraire);
+                Size i = 0;
+                for (auto const& [id, trade] : portfolio->trades()) {
+                    Real a = 1.0E6 * (1.0 + i), b = 2.0E7 * (i % 3 == 0 ? 1.0 : -1.0);
+                    cube->set(a * fixing + b * fixing * fixing + 1.0E4 * (rng.nextReal() - 0.5), i, j, k);
+                    ++i;
+                }
+            }
+        }
+        cubeInterpretation = QuantLib::ext::make_shared<CubeInterpretation>(
+            false, false, Handle<AggregationScenarioData>(scenarioData));
+    }
+
+    QuantLib::ext::shared_ptr<Portfolio> portfolio;
+    QuantLib::ext::shared_ptr<NPVCube> cube;
+    QuantLib::ext::shared_ptr<InMemoryAggregationScenarioData> scenarioData;
+    QuantLib::ext::shared_ptr<CubeInterpretation> cubeInterpretation;
+};
+
+// The regression DIM as computed before the regression was moved to RandomVariable, i.e. with one Array of
+// regressors per sample, StabilisedGLLS and a NadarayaWatson local regression over all samples
+void referenceDim(const DimTestData& data, const string& nettingSet, const vector<string>& regressors, Real quantile,
+                  Size horizonCalendarDays, Size regressionOrder, Size localRegressionEvaluations,
+                  Real localRegressionBandWidth, vector<vector<Real>>& dim, vector<vector<Real>>& localDim) {
+    const auto& cube = data.cube;
+    const auto& cubeInterpretation = data.cubeInterpretation;
+    Size nDates = cube->dates().size() - 1;
+    Size samples = cube->samples();
+
+    vector<Size> tradeIndices;
+    Size i = 0;
+    for (auto const& [id, trade] : data.portfolio->trades()) {
+        if (trade->envelope().nettingSetId() == nettingSet)
+            tradeIndices.push_back(i);
+        ++i;
+    }
+
+    Size regressionDimension = regressors.empty() ? 1 : regressors.size();
+    std::vector<ext::function<Real(Array)>> v(
+        LsmBasisSystem::multiPathBasisSystem(regressionDimension, regressionOrder, LsmBasisSystem::Monomial));
+    Real confidenceLevel = InverseCumulativeNormal()(quantile);
+
+    dim = vector<vector<Real>>(nDates, vector<Real>(samples, 0.0));
+    localDim = vector<vector<Real>>(nDates, vector<Real>(samples, 0.0));
+    for (Size j = 0; j < nDates; ++j) {
+        accumulator_set<double, stats<boost::accumulators::tag::mean, boost::accumulators::tag::variance>> accDiff;
+        vector<Real> rx0(samples), ry1(samples), ry2(samples), numDefault(samples);
+        vector<Array> rx(samples);
+        for (Size k = 0; k < samples; ++k) {
+            Real npv = 0.0, closeOutNpv = 0.0;
+            for (auto t : tradeIndices) {
+                npv += cubeInterpretation->getDefaultNpv(cube, t, j, k);
+                closeOutNpv += cubeInterpretation->getCloseOutNpv(cube, t, j, k);
+            }
+            numDefault[k] =
+                cubeInterpretation->getDefaultAggregationScenarioData(AggregationScenarioDataType::Numeraire, j, k);
+            Real numCloseOut =
+                cubeInterpretation->getCloseOutAggregationScenarioData(AggregationScenarioDataType::Numeraire, j, k);
+            Real z = closeOutNpv * numCloseOut - npv * numDefault[k];
+            accDiff(z);
+            rx[k] = Array(regressionDimension);
+            for (Size r = 0; r < regressionDimension; ++r) {
+                rx[k][r] = regressors.empty() || regressors[r] == "NPV"
+                               ? npv
+                               : cubeInterpretation->getDefaultAggregationScenarioData(
+                                     AggregationScenarioDataType::IndexFixing, j, k, regressors[r]);
+            }
+            rx0[k] = rx[k][0];
+            ry1[k] = z;
+            ry2[k] = z * z;
+        }
+        Real horizonScaling = std::sqrt(1.0 * horizonCalendarDays / cubeInterpretation->getMporCalendarDays(cube, j));
+        QuantExt::StabilisedGLLS ls(rx, ry2, v, QuantExt::StabilisedGLLS::MeanStdDev);
+        QuantExt::NadarayaWatson lr(rx0.begin(), rx0.end(), ry1.begin(), GaussianKernel(0.0, localRegressionBandWidth));
+        Size localRegressionSamples = Size(std::floor(1.0 * samples / localRegressionEvaluations + .5));
+        Real scalingFactor = horizonScaling * confidenceLevel;
+        for (Size k = 0; k < samples; ++k) {
+            Real e = ls.eval(rx[k], v);
+            dim[j][k] = std::sqrt(std::max(e, 0.0)) * scalingFactor / numDefault[k];
+            if (k % localRegressionSamples == 0)
+                localDim[j][k] = lr.standardDeviation(rx0[k]) * scalingFactor / numDefault[k];
+        }
+    }
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(DimRegressionTest)
+
+BOOST_AUTO_TEST_CASE(testRegressionAgainstReference) {
+    BOOST_TEST_MESSAGE("Testing regression DIM against the reference implementation and across thread counts...");
+
+    Size nettingSets = 5, samples = 500;
+    DimTestData data(nettingSets, 3, 6, samples);
+    Real quantile = 0.99;
+    Size horizon = 14, order = 2, localEvaluations = 50;
+
+    // regressors and the local regression band width in units of the first regressor
+    vector<std::pair<vector<string>, Real>> testCases = {
+        {{}, 2000.0}, {{"EUR-EURIBOR-6M"}, 0.002}, {{"EUR-EURIBOR-6M", "NPV"}, 0.002}};
+    for (auto const& [regressors, bandWidth] : testCases) {
+        BOOST_TEST_MESSAGE("Regressors: " << regressors.size());
+        auto inputs = QuantLib::ext::make_shared<InputParameters>();
+        vector<QuantLib::ext::shared_ptr<RegressionDynamicInitialMarginCalculator>> calculators;
+        for (Size nThreads : {1, 3}) {
+            calculators.push_back(QuantLib::ext::make_shared<RegressionDynamicInitialMarginCalculator>(
+                inputs, data.portfolio, data.cube, data.cubeInterpretation, data.scenarioData, quantile, horizon,
+                order, regressors, localEvaluations, bandWidth, std::map<string, Real>(), nThreads));
+            calculators.back()->build();
+        }
+
+        for (Size n = 0; n < nettingSets; ++n) {
+            string nettingSet = "NettingSet_" + std::to_string(n);
+            vector<vector<Real>> dim, localDim;
+            referenceDim(data, nettingSet, regressors, quantile, horizon, order, localEvaluations, bandWidth, dim,
+                         localDim);
+            for (Size j = 0; j < dim.size(); ++j) {
+                for (Size k = 0; k < samples; ++k) {
+                    // the single and multi-threaded runs are identical
+                    BOOST_CHECK_EQUAL(calculators[0]->dynamicIM(nettingSet)[j][k],
+                                      calculators[1]->dynamicIM(nettingSet)[j][k]);
+                    BOOST_CHECK_EQUAL(calculators[0]->dimCube()->get(n, j, k),
+                                      calculators[1]->dimCube()->get(n, j, k));
+                    BOOST_CHECK_EQUAL(calculators[0]->localRegressionResults(nettingSet)[j][k],
+                                      calculators[1]->localRegressionResults(nettingSet)[j][k]);
+                    // and agree with the reference implementation up to rounding
+                    BOOST_CHECK_CLOSE(calculators[0]->dynamicIM(nettingSet)[j][k], dim[j][k], 1E-4);
+                    BOOST_CHECK_CLOSE(calculators[0]->localRegressionResults(nettingSet)[j][k], localDim[j][k],
+                                      1E-4);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
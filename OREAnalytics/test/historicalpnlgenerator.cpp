@@ -0,0 +1,167 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <orea/cube/inmemorycube.hpp>
+#include <orea/engine/historicalpnlgenerator.hpp>
+#include <orea/scenario/historicalscenariogenerator.hpp>
+#include <orea/scenario/scenariofilter.hpp>
+#include <orea/scenario/scenariosimmarket.hpp>
+#include <orea/scenario/scenariosimmarketparameters.hpp>
+#include <orea/scenario/simplescenario.hpp>
+#include <orea/scenario/simplescenariofactory.hpp>
+#include <ored/portfolio/builders/fxoption.hpp>
+#include <ored/portfolio/builders/swap.hpp>
+#include <ored/portfolio/portfolio.hpp>
+#include <oret/toplevelfixture.hpp>
+#include <ql/time/calendars/target.hpp>
+#include "testmarket.hpp"
+#include "testportfolio.hpp"
+
+using namespace std;
+using namespace QuantLib;
+using namespace QuantExt;
+using namespace ore;
+using namespace ore::data;
+using namespace ore::analytics;
+
+using testsuite::buildFxOption;
+using testsuite::buildSwap;
+
+namespace {
+
+QuantLib::ext::shared_ptr<ScenarioSimMarketParameters> pnlSimMarketData() {
+    auto simMarketData = QuantLib::ext::make_shared<ScenarioSimMarketParameters>();
+    simMarketData->baseCcy() = "EUR";
+    simMarketData->setDiscountCurveNames({"EUR", "USD"});
+    simMarketData->setYieldCurveTenors("", {6 * Months, 1 * Years, 2 * Years, 3 * Years, 5 * Years, 7 * Years,
+                                            10 * Years, 15 * Years, 20 * Years});
+    simMarketData->setIndices({"EUR-EURIBOR-6M", "USD-LIBOR-3M"});
+    simMarketData->interpolation() = "LogLinear";
+    simMarketData->extrapolation() = "FlatFwd";
+
+    simMarketData->setFxVolExpiries("", vector<Period>{1 * Months, 3 * Months, 6 * Months, 2 * Years, 5 * Years});
+    simMarketData->setFxVolDecayMode(string("ConstantVariance"));
+    simMarketData->setSimulateFXVols(true);
+    simMarketData->setFxVolIsSurface(false);
+    simMarketData->setFxVolMoneyness(vector<Real>{0.0});
+    simMarketData->setFxVolCcyPairs({"EURUSD"});
+    simMarketData->setFxCcyPairs({"EURUSD"});
+    return simMarketData;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(HistoricalPnlGeneratorTest)
+
+BOOST_AUTO_TEST_CASE(testMultiFilterCubeMatchesSingleFilterCubes) {
+
+    BOOST_TEST_MESSAGE("Checking that a multi-filter historical P&L cube matches one cube per filter...");
+
+    SavedSettings backup;
+    Date asof(14, April, 2016);
+    Settings::instance().evaluationDate() = asof;
+
+    testsuite::TestConfigurationObjects::setConventions();
+    auto initMarket = QuantLib::ext::make_shared<testsuite::TestMarket>(asof);
+    auto simMarketData = pnlSimMarketData();
+    auto simMarket = QuantLib::ext::make_shared<ScenarioSimMarket>(initMarket, simMarketData);
+
+    auto engineData = QuantLib::ext::make_shared<EngineData>();
+    engineData->model("Swap") = "DiscountedCashflows";
+    engineData->engine("Swap") = "DiscountingSwapEngine";
+    engineData->model("FxOption") = "GarmanKohlhagen";
+    engineData->engine("FxOption") = "AnalyticEuropeanEngine";
+    auto factory = QuantLib::ext::make_shared<EngineFactory>(engineData, simMarket);
+
+    auto portfolio = QuantLib::ext::make_shared<Portfolio>();
+    portfolio->add(buildSwap("1_Swap_EUR", "EUR", true, 10000000.0, 0, 10, 0.03, 0.00, "1Y", "30/360", "6M", "A360",
+                             "EUR-EURIBOR-6M"));
+    portfolio->add(buildSwap("2_Swap_USD", "USD", true, 10000000.0, 0, 15, 0.02, 0.00, "6M", "30/360", "3M", "A360",
+                             "USD-LIBOR-3M"));
+    portfolio->add(buildFxOption("3_FxOption_EUR_USD", "Long", "Call", 3, "EUR", 10000000.0, "USD", 11000000.0));
+    portfolio->build(factory);
+    BOOST_REQUIRE_EQUAL(portfolio->size(), 3);
+
+    // made up history of the sim market's risk factors on consecutive business days, each key moves by a
+    // small amount depending on the date and the key's position
+
+    auto base = simMarket->baseScenarioAbsolute();
+    Calendar cal = TARGET();
+    auto loader = QuantLib::ext::make_shared<HistoricalScenarioLoader>();
+    Date d = cal.advance(asof, -6 * Days);
+    for (Size i = 0; i < 6; ++i, d = cal.advance(d, 1 * Days)) {
+        auto s = QuantLib::ext::make_shared<SimpleScenario>(d);
+        for (Size k = 0; k < base->keys().size(); ++k) {
+            const auto& key = base->keys()[k];
+            s->add(key, base->get(key) * (1.0 + 0.001 * (i + 1) * ((static_cast<int>((i + k) % 3)) - 1)));
+        }
+        loader->historicalScenarios().push_back(s);
+        loader->dates().push_back(d);
+    }
+    auto hisScenGen = QuantLib::ext::make_shared<HistoricalScenarioGenerator>(
+        loader, QuantLib::ext::make_shared<SimpleScenarioFactory>(true), cal, nullptr, 1);
+    hisScenGen->baseScenario() = simMarket->baseScenario();
+    Size samples = hisScenGen->numScenarios();
+    BOOST_REQUIRE_EQUAL(samples, 5);
+
+    auto cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(asof, portfolio->ids(), vector<Date>{asof},
+                                                                        samples);
+    HistoricalPnlGenerator generator("EUR", portfolio, simMarket, hisScenGen, cube);
+
+    vector<QuantLib::ext::shared_ptr<ScenarioFilter>> filters = {
+        QuantLib::ext::make_shared<RiskFactorTypeScenarioFilter>(
+            vector<RiskFactorKey::KeyType>{RiskFactorKey::KeyType::DiscountCurve, RiskFactorKey::KeyType::IndexCurve}),
+        QuantLib::ext::make_shared<RiskFactorTypeScenarioFilter>(
+            vector<RiskFactorKey::KeyType>{RiskFactorKey::KeyType::FXSpot, RiskFactorKey::KeyType::FXVolatility}),
+        QuantLib::ext::make_shared<ScenarioFilter>()};
+
+    auto simMarketFilter = simMarket->filter();
+    generator.generateCube(filters);
+    BOOST_CHECK(simMarket->filter() == simMarketFilter);
+
+    vector<HistoricalPnlGenerator::TradePnlStore> multiPnl;
+    for (Size k = 0; k < filters.size(); ++k) {
+        generator.selectFilter(k);
+        multiPnl.push_back(generator.tradeLevelPnl());
+    }
+
+    for (Size k = 0; k < filters.size(); ++k) {
+        generator.generateCube(filters[k]);
+        auto singlePnl = generator.tradeLevelPnl();
+        BOOST_REQUIRE_EQUAL(singlePnl.size(), multiPnl[k].size());
+        Real maxAbsPnl = 0.0;
+        for (Size s = 0; s < singlePnl.size(); ++s) {
+            BOOST_REQUIRE_EQUAL(singlePnl[s].size(), multiPnl[k][s].size());
+            for (Size t = 0; t < singlePnl[s].size(); ++t) {
+                maxAbsPnl = std::max(maxAbsPnl, std::abs(singlePnl[s][t]));
+                BOOST_CHECK_MESSAGE(std::abs(singlePnl[s][t] - multiPnl[k][s][t]) < 1E-6,
+                                    "filter " << k << ", scenario " << s << ", trade " << t << ": single filter pnl "
+                                              << singlePnl[s][t] << ", multi filter pnl " << multiPnl[k][s][t]);
+            }
+        }
+        // the made up history must actually move the trades for the comparison to mean something
+        BOOST_CHECK_GT(maxAbsPnl, 1.0);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
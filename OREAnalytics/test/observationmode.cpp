@@ -17,6 +17,7 @@
 */
 
 #include "testmarket.hpp"
+#include "testportfolio.hpp"
 #include <boost/test/unit_test.hpp>
 #include <boost/timer/timer.hpp>
 #include <orea/cube/inmemorycube.hpp>
@@ -36,8 +37,10 @@
 #include <orea/engine/valuationcalculator.hpp>
 #include <orea/engine/valuationengine.hpp>
 #include <orea/scenario/crossassetmodelscenariogenerator.hpp>
+#include <orea/scenario/deltascenario.hpp>
 #include <orea/scenario/scenariosimmarket.hpp>
 #include <orea/scenario/scenariosimmarketparameters.hpp>
+#include <orea/scenario/simplescenario.hpp>
 #include <orea/scenario/simplescenariofactory.hpp>
 #include <ored/model/crossassetmodelbuilder.hpp>
 #include <ored/model/lgmdata.hpp>
@@ -355,6 +358,112 @@ void simulation(string dateGridString, bool checkFixings) {
     }
 }
 
+namespace {
+
+// returns the given scenarios in order
+class ScenarioListGenerator : public ScenarioGenerator {
+public:
+    explicit ScenarioListGenerator(const vector<QuantLib::ext::shared_ptr<Scenario>>& scenarios)
+        : scenarios_(scenarios) {}
+    QuantLib::ext::shared_ptr<Scenario> next(const Date& d) override {
+        QL_REQUIRE(counter_ < scenarios_.size(), "ScenarioListGenerator: no more scenarios");
+        return scenarios_[counter_++];
+    }
+    void reset() override { counter_ = 0; }
+
+private:
+    vector<QuantLib::ext::shared_ptr<Scenario>> scenarios_;
+    Size counter_ = 0;
+};
+
+// first key of the given type (and name, if not empty) in the scenario
+RiskFactorKey findKey(const QuantLib::ext::shared_ptr<Scenario>& scenario, const RiskFactorKey::KeyType type,
+                      const string& name = string(), const Size index = 0) {
+    for (auto const& k : scenario->keys()) {
+        if (k.keytype == type && (name.empty() || k.name == name) && k.index == index)
+            return k;
+    }
+    QL_FAIL("no key of type " << type << " and name '" << name << "' in scenario");
+}
+
+/* Builds a cube in observation mode Disable under scenarios shifting the given keys by the given relative amounts,
+   on each date of the grid. With deltaScenarios the scenarios are delta scenarios, i.e. the sim market refreshes
+   the term structures and trades depending on the changed risk factors only. Otherwise the same market data is
+   applied as absolute scenarios, which trigger a full refresh. */
+QuantLib::ext::shared_ptr<NPVCube> selectiveRefreshCube(const string& dateGrid, const bool simulateVols,
+                                                        const bool deltaScenarios,
+                                                        const vector<vector<pair<RiskFactorKey, Real>>>& shifts) {
+    Date today = Settings::instance().evaluationDate();
+    auto initMarket = QuantLib::ext::make_shared<TestMarket>(today);
+
+    // without simulation the swaption and equity vols are non-lazy term structures, which are always refreshed,
+    // while the yield curves, fx vols and equity curves remain lazy
+    auto simMarketData = testsuite::TestConfigurationObjects::setupSimMarketData5();
+    simMarketData->setSimulateSwapVols(simulateVols);
+    simMarketData->setSimulateEquityVols(simulateVols);
+    auto simMarket = QuantLib::ext::make_shared<ScenarioSimMarket>(initMarket, simMarketData);
+    auto base = simMarket->baseScenario();
+
+    auto dg = QuantLib::ext::make_shared<DateGrid>(dateGrid);
+    vector<QuantLib::ext::shared_ptr<Scenario>> scenarios;
+    for (auto const& shift : shifts) {
+        for (auto const& d : dg->dates()) {
+            auto delta = QuantLib::ext::make_shared<SimpleScenario>(d);
+            for (auto const& [key, relShift] : shift)
+                delta->add(key, base->get(key) * (1.0 + relShift));
+            auto deltaScenario = QuantLib::ext::make_shared<DeltaScenario>(base, delta);
+            if (deltaScenarios) {
+                scenarios.push_back(deltaScenario);
+            } else {
+                auto full = QuantLib::ext::make_shared<SimpleScenario>(d, "", base->getNumeraire());
+                for (auto const& k : base->keys())
+                    full->add(k, deltaScenario->get(k));
+                scenarios.push_back(full);
+            }
+        }
+    }
+    simMarket->scenarioGenerator() = QuantLib::ext::make_shared<ScenarioListGenerator>(scenarios);
+
+    auto data = QuantLib::ext::make_shared<EngineData>();
+    data->model("Swap") = "DiscountedCashflows";
+    data->engine("Swap") = "DiscountingSwapEngine";
+    data->model("EuropeanSwaption") = "BlackBachelier";
+    data->engine("EuropeanSwaption") = "BlackBachelierSwaptionEngine";
+    data->model("FxOption") = "GarmanKohlhagen";
+    data->engine("FxOption") = "AnalyticEuropeanEngine";
+    data->model("EquityOption") = "BlackScholesMerton";
+    data->engine("EquityOption") = "AnalyticEuropeanEngine";
+    data->model("CapFloor") = "IborCapModel";
+    data->engine("CapFloor") = "IborCapEngine";
+    auto factory = QuantLib::ext::make_shared<EngineFactory>(data, simMarket);
+
+    auto portfolio = QuantLib::ext::make_shared<Portfolio>();
+    portfolio->add(testsuite::buildSwap("1_Swap_EUR", "EUR", true, 10000000.0, 0, 10, 0.03, 0.00, "1Y", "30/360", "6M",
+                                        "A360", "EUR-EURIBOR-6M"));
+    portfolio->add(testsuite::buildSwap("2_Swap_USD", "USD", true, 10000000.0, 0, 15, 0.02, 0.00, "6M", "30/360",
+                                        "3M", "A360", "USD-LIBOR-3M"));
+    portfolio->add(testsuite::buildEuropeanSwaption("3_Swaption_EUR", "Long", "EUR", true, 1000000.0, 2, 5, 0.02,
+                                                    0.00, "1Y", "30/360", "6M", "A360", "EUR-EURIBOR-6M", "Physical"));
+    portfolio->add(
+        testsuite::buildFxOption("4_FxOption_EUR_USD", "Long", "Call", 3, "EUR", 10000000.0, "USD", 11000000.0));
+    portfolio->add(
+        testsuite::buildEquityOption("5_EquityOption_SP5", "Long", "Call", 2, "SP5", "USD", 2147.56, 775));
+    portfolio->add(
+        testsuite::buildCap("6_Cap_EUR", "EUR", "Long", 0.05, 1000000.0, 0, 10, "6M", "A360", "EUR-EURIBOR-6M"));
+    portfolio->build(factory);
+    BOOST_REQUIRE_EQUAL(portfolio->size(), 6);
+
+    auto cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(today, portfolio->ids(),
+                                                                        dg->valuationDates(), shifts.size());
+    vector<QuantLib::ext::shared_ptr<ValuationCalculator>> calculators = {
+        QuantLib::ext::make_shared<NPVCalculator>(simMarketData->baseCcy())};
+    ValuationEngine engine(today, dg, simMarket, factory->modelBuilders());
+    engine.buildCube(portfolio, cube, calculators);
+    return cube;
+}
+
+} // namespace
+
 BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::OreaTopLevelFixture)
 
 BOOST_AUTO_TEST_SUITE(ObservationModeTest)
@@ -432,6 +541,71 @@ BOOST_AUTO_TEST_CASE(testDefer) {
     simulation("10,1Y", true);
 }
 
+BOOST_AUTO_TEST_CASE(testDisableSelectiveRefresh) {
+    BOOST_TEST_MESSAGE("Testing the selective refresh under delta scenarios in observation mode Disable...");
+
+    SavedSettings backup;
+    ObservationMode::instance().setMode(ObservationMode::Mode::Disable);
+    Date today(14, April, 2016);
+    Settings::instance().evaluationDate() = today;
+    testsuite::TestConfigurationObjects::setConventions();
+
+    // the keys only serve to define the shifts, they are the same in all sim markets below
+    auto base = ScenarioSimMarket(QuantLib::ext::make_shared<TestMarket>(today),
+                                  testsuite::TestConfigurationObjects::setupSimMarketData5())
+                    .baseScenario();
+    RiskFactorKey eurDsc0 = findKey(base, RiskFactorKey::KeyType::DiscountCurve, "EUR", 0);
+    RiskFactorKey eurDsc3 = findKey(base, RiskFactorKey::KeyType::DiscountCurve, "EUR", 3);
+    RiskFactorKey eurFwd2 = findKey(base, RiskFactorKey::KeyType::IndexCurve, "EUR-EURIBOR-6M", 2);
+    RiskFactorKey usdDsc2 = findKey(base, RiskFactorKey::KeyType::DiscountCurve, "USD", 2);
+    RiskFactorKey fxSpot = findKey(base, RiskFactorKey::KeyType::FXSpot);
+    RiskFactorKey eqSpot = findKey(base, RiskFactorKey::KeyType::EquitySpot, "SP5");
+    RiskFactorKey fxVol = findKey(base, RiskFactorKey::KeyType::FXVolatility, "EURUSD", 3);
+
+    // the risk factors' dependencies are learned when a single unknown risk factor changes, known risk factors are
+    // refreshed selectively and several unknown ones fall back to a full refresh
+    vector<vector<pair<RiskFactorKey, Real>>> shifts = {
+        {},                                       // base
+        {{eurDsc0, -0.001}},                      // single factor, learned
+        {{eurDsc3, -0.002}},                      // single factor, known
+        {},                                       // base, i.e. the previous delta is reverted
+        {{eurFwd2, -0.002}},                      // single factor, learned
+        {{eurDsc3, -0.002}, {eurFwd2, 0.002}},    // cross gamma, both known
+        {{fxSpot, 0.01}, {eqSpot, 0.02}},         // cross gamma, both unknown, full refresh
+        {{fxSpot, -0.01}},                        // single factor, learned
+        {{fxVol, 0.05}},                          // single factor, learned
+        {{eqSpot, -0.02}, {eurDsc0, 0.001}},      // cross gamma, one unknown, learned
+        {{usdDsc2, -0.002}, {fxSpot, 0.01}},      // cross gamma, one unknown, learned
+        {{eurDsc0, 0.001}},                       // single factor, known, reverts the cross gamma delta
+        {}                                        // base
+    };
+
+    // with a single valuation date the scenarios do not change the date, otherwise every scenario does
+    for (auto const& dateGrid : {"1,0W", "3,1M"}) {
+        for (bool simulateVols : {true, false}) {
+            BOOST_TEST_MESSAGE("date grid " << dateGrid << ", simulate vols " << std::boolalpha << simulateVols);
+            auto selective = selectiveRefreshCube(dateGrid, simulateVols, true, shifts);
+            auto full = selectiveRefreshCube(dateGrid, simulateVols, false, shifts);
+            Real maxAbsChange = 0.0;
+            for (Size i = 0; i < full->numIds(); ++i) {
+                for (Size j = 0; j < full->numDates(); ++j) {
+                    for (Size k = 0; k < full->samples(); ++k) {
+                        Real expected = full->get(i, j, k);
+                        maxAbsChange = std::max(maxAbsChange, std::abs(expected - full->get(i, j, 0)));
+                        BOOST_CHECK_MESSAGE(std::abs(selective->get(i, j, k) - expected) <
+                                                1E-10 * std::max(1.0, std::abs(expected)),
+                                            "trade " << i << ", date " << j << ", scenario " << k
+                                                     << ": selective refresh " << selective->get(i, j, k)
+                                                     << ", full refresh " << expected);
+                    }
+                }
+            }
+            // the shifts must actually move the trades for the comparison to mean something
+            BOOST_CHECK_GT(maxAbsChange, 1.0);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
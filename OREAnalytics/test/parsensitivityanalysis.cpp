@@ -1362,6 +1362,63 @@ void ParSensitivityAnalysisTest::testParConversionUnregisterObs() {
     testParConversion(ObservationMode::Mode::Unregister);
 }
 
+void ParSensitivityAnalysisTest::testSelectiveDeepUpdate() {
+
+    SavedSettings backup;
+
+    ObservationMode::Mode backupMode = ObservationMode::instance().mode();
+    ObservationMode::instance().setMode(ObservationMode::Mode::Disable);
+
+    Date today = Date(14, April, 2016);
+    Settings::instance().evaluationDate() = today;
+
+    QuantLib::ext::shared_ptr<Market> initMarket = QuantLib::ext::make_shared<TestMarket>(today);
+    QuantLib::ext::shared_ptr<analytics::ScenarioSimMarketParameters> simMarketData = setupSimMarketData5();
+    QuantLib::ext::shared_ptr<SensitivityScenarioData> sensiData = setupSensitivityScenarioData5(true);
+
+    QuantLib::ext::shared_ptr<EngineData> engineData = QuantLib::ext::make_shared<EngineData>();
+    engineData->model("Swap") = "DiscountedCashflows";
+    engineData->engine("Swap") = "DiscountingSwapEngine";
+    QuantLib::ext::shared_ptr<Portfolio> portfolio(new Portfolio());
+    portfolio->add(buildSwap("1_Swap_EUR", "EUR", true, 10000000.0, 0, 10, 0.03, 0.00, "1Y", "30/360", "6M", "A360",
+                             "EUR-EURIBOR-6M"));
+
+    // the par analysis under test updates only the par instruments depending on the shifted curve, the reference
+    // updates all of them for each shift, both run on the same sim market
+    ParSensitivityAnalysis parAnalysis(today, simMarketData, *sensiData, Market::defaultConfiguration);
+    parAnalysis.alignPillars();
+    QuantLib::ext::shared_ptr<SensitivityAnalysis> zeroAnalysis = QuantLib::ext::make_shared<SensitivityAnalysis>(
+        portfolio, initMarket, Market::defaultConfiguration, engineData, simMarketData, sensiData, false);
+    zeroAnalysis->overrideTenors(true);
+    zeroAnalysis->generateSensitivities();
+
+    BOOST_REQUIRE(parAnalysis.selectiveDeepUpdate());
+    parAnalysis.computeParInstrumentSensitivities(zeroAnalysis->simMarket());
+
+    ParSensitivityAnalysis fullAnalysis(today, simMarketData, *sensiData, Market::defaultConfiguration);
+    fullAnalysis.selectiveDeepUpdate() = false;
+    fullAnalysis.computeParInstrumentSensitivities(zeroAnalysis->simMarket());
+
+    const auto& selective = parAnalysis.parSensitivities();
+    const auto& full = fullAnalysis.parSensitivities();
+    BOOST_CHECK_EQUAL(selective.size(), full.size());
+    BOOST_CHECK_GT(full.size(), 0);
+    for (auto const& [keys, sensi] : full) {
+        auto s = selective.find(keys);
+        BOOST_CHECK_MESSAGE(s != selective.end(),
+                            "par sensitivity of " << keys.first << " w.r.t. " << keys.second << " missing");
+        if (s != selective.end()) {
+            BOOST_CHECK_MESSAGE(std::abs(s->second - sensi) < 1E-10, "par sensitivity of "
+                                                                         << keys.first << " w.r.t. " << keys.second
+                                                                         << " is " << s->second << ", expected "
+                                                                         << sensi);
+        }
+    }
+
+    ObservationMode::instance().setMode(backupMode);
+    IndexManager::instance().clearHistories();
+}
+
 void ParSensitivityAnalysisTest::test1dZeroShifts() {
     BOOST_TEST_MESSAGE("Testing 1d shifts");
 
@@ -1606,6 +1663,11 @@ BOOST_AUTO_TEST_CASE(ParConversionUnregisterObs) {
     ParSensitivityAnalysisTest::testParConversionUnregisterObs();
 }
 
+BOOST_AUTO_TEST_CASE(SelectiveDeepUpdate) {
+    BOOST_TEST_MESSAGE("Testing selective deep update of par instruments in DisableObs");
+    ParSensitivityAnalysisTest::testSelectiveDeepUpdate();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -49,6 +49,8 @@ public:
     static void testParConversionDeferObs();
     //! Test par conversion of sensitivities ("Unregister" observation mode)
     static void testParConversionUnregisterObs();
+    //! Test that the selective update of par instruments ("Disable" observation mode) matches a full update
+    static void testSelectiveDeepUpdate();
     static boost::unit_test_framework::test_suite* suite();
 };
 } // namespace testsuite
@@ -0,0 +1,341 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <oret/datapaths.hpp>
+#include <oret/toplevelfixture.hpp>
+
+#include <orea/cube/inmemorycube.hpp>
+#include <orea/engine/scenarioresultstore.hpp>
+#include <orea/engine/sensitivityanalysis.hpp>
+#include <orea/engine/valuationcalculator.hpp>
+#include <orea/engine/valuationengine.hpp>
+#include <orea/scenario/deltascenario.hpp>
+#include <orea/scenario/deltascenariofactory.hpp>
+#include <orea/scenario/scenariosimmarket.hpp>
+#include <orea/scenario/sensitivityscenariogenerator.hpp>
+#include <orea/scenario/simplescenario.hpp>
+#include <ored/configuration/conventions.hpp>
+#include <ored/configuration/curveconfigurations.hpp>
+#include <ored/marketdata/csvloader.hpp>
+#include <ored/marketdata/todaysmarketparameters.hpp>
+#include <ored/portfolio/builders/capfloor.hpp>
+#include <ored/portfolio/builders/fxoption.hpp>
+#include <ored/portfolio/builders/swap.hpp>
+#include <ored/portfolio/portfolio.hpp>
+#include "testmarket.hpp"
+#include "testportfolio.hpp"
+
+using namespace boost::unit_test_framework;
+using namespace QuantLib;
+using namespace ore::data;
+using namespace ore::analytics;
+
+using testsuite::buildCap;
+using testsuite::buildFxOption;
+using testsuite::buildSwap;
+using testsuite::TestConfigurationObjects;
+
+namespace {
+
+// a key whose trade and scenario hashes have equal components
+ScenarioResultKey key(std::size_t trade, std::size_t scenario, const Date& asof) {
+    return {{trade, trade}, {scenario, scenario}, asof};
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(ScenarioResultStoreTest)
+
+BOOST_AUTO_TEST_CASE(testLookupAndStatistics) {
+    BOOST_TEST_MESSAGE("Testing scenario result store lookups and hit rate...");
+
+    Date asof(10, Jan, 2024);
+    ScenarioResultStore store(10);
+    Real value = 0.0;
+
+    BOOST_CHECK(!store.get(key(1, 2, asof), value));
+    store.put(key(1, 2, asof), 100.0);
+    BOOST_CHECK(store.get(key(1, 2, asof), value));
+    BOOST_CHECK_EQUAL(value, 100.0);
+
+    // keys differing in trade, scenario or date are different entries
+    BOOST_CHECK(!store.get(key(3, 2, asof), value));
+    BOOST_CHECK(!store.get(key(1, 3, asof), value));
+    BOOST_CHECK(!store.get(key(1, 2, asof + 1), value));
+
+    store.put(key(1, 2, asof), 200.0);
+    BOOST_CHECK(store.get(key(1, 2, asof), value));
+    BOOST_CHECK_EQUAL(value, 200.0);
+
+    BOOST_CHECK_EQUAL(store.size(), 1);
+    BOOST_CHECK_EQUAL(store.hits(), 2);
+    BOOST_CHECK_EQUAL(store.misses(), 4);
+    BOOST_CHECK_CLOSE(store.hitRate(), 2.0 / 6.0, 1E-10);
+
+    store.clear();
+    BOOST_CHECK_EQUAL(store.size(), 0);
+    BOOST_CHECK_EQUAL(store.hitRate(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(testBothHashesAreCompared) {
+    BOOST_TEST_MESSAGE("Testing that scenario result store keys differing in one hash component only are different...");
+
+    Date asof(10, Jan, 2024);
+    ScenarioResultStore store(10);
+    Real value = 0.0;
+
+    store.put({{1, 1}, {2, 2}, asof}, 100.0);
+    BOOST_CHECK(!store.get({{1, 7}, {2, 2}, asof}, value));
+    BOOST_CHECK(!store.get({{1, 1}, {2, 7}, asof}, value));
+    BOOST_CHECK(store.get({{1, 1}, {2, 2}, asof}, value));
+    BOOST_CHECK_EQUAL(value, 100.0);
+
+    // both components depend on the strings combined and on how they are split
+    ScenarioResultHash h1(0, 0), h2(0, 0), h3(0, 0);
+    scenarioResultHashCombine(h1, "ab");
+    scenarioResultHashCombine(h1, "c");
+    scenarioResultHashCombine(h2, "a");
+    scenarioResultHashCombine(h2, "bc");
+    scenarioResultHashCombine(h3, "ab");
+    scenarioResultHashCombine(h3, "c");
+    BOOST_CHECK(h1 == h3);
+    BOOST_CHECK(h1.first != h2.first);
+    BOOST_CHECK(h1.second != h2.second);
+}
+
+BOOST_AUTO_TEST_CASE(testLruEviction) {
+    BOOST_TEST_MESSAGE("Testing scenario result store LRU eviction...");
+
+    Date asof(10, Jan, 2024);
+    ScenarioResultStore store(2);
+    Real value = 0.0;
+
+    store.put(key(1, 0, asof), 1.0);
+    store.put(key(2, 0, asof), 2.0);
+
+    // touch entry 1, so that entry 2 is the least recently used one
+    BOOST_CHECK(store.get(key(1, 0, asof), value));
+    store.put(key(3, 0, asof), 3.0);
+
+    BOOST_CHECK_EQUAL(store.size(), 2);
+    BOOST_CHECK_EQUAL(store.evictions(), 1);
+    BOOST_CHECK(store.get(key(1, 0, asof), value));
+    BOOST_CHECK_EQUAL(value, 1.0);
+    BOOST_CHECK(!store.get(key(2, 0, asof), value));
+    BOOST_CHECK(store.get(key(3, 0, asof), value));
+    BOOST_CHECK_EQUAL(value, 3.0);
+}
+
+BOOST_AUTO_TEST_CASE(testIncrementalStateHash) {
+    BOOST_TEST_MESSAGE("Testing that the sim market state hash under delta scenarios equals the full state hash...");
+
+    SavedSettings backup;
+    Date today(14, April, 2016);
+    Settings::instance().evaluationDate() = today;
+
+    auto initMarket = QuantLib::ext::make_shared<testsuite::TestMarket>(today);
+    auto simMarketData = TestConfigurationObjects::setupSimMarketData5();
+    auto simMarket = QuantLib::ext::make_shared<ScenarioSimMarket>(initMarket, simMarketData);
+    simMarket->reset();
+    auto base = simMarket->baseScenario();
+    auto baseHash = simMarket->stateHash();
+
+    // the first delta moves two keys, the second one a different key, i.e. the first two are reverted
+    const std::vector<RiskFactorKey>& keys = base->keys();
+    BOOST_REQUIRE_GT(keys.size(), 10);
+    std::vector<std::vector<Size>> shifted = {{0, 5}, {10}};
+    for (auto const& indices : shifted) {
+        auto delta = QuantLib::ext::make_shared<SimpleScenario>(today, "", 0.0);
+        for (auto i : indices)
+            delta->add(keys[i], base->get(keys[i]) + 0.0001);
+        auto deltaScenario = QuantLib::ext::make_shared<DeltaScenario>(base, delta);
+        simMarket->applyScenario(deltaScenario);
+        auto incremental = simMarket->stateHash();
+        BOOST_CHECK(incremental != baseHash);
+
+        // the same values applied as a full scenario
+        auto full = QuantLib::ext::make_shared<SimpleScenario>(today);
+        for (auto const& k : keys)
+            full->add(k, deltaScenario->get(k));
+        simMarket->applyScenario(full);
+        BOOST_CHECK(simMarket->stateHash() == incremental);
+
+        // back to the base plus delta state
+        simMarket->reset();
+        BOOST_CHECK(simMarket->stateHash() == baseHash);
+        simMarket->applyScenario(deltaScenario);
+        BOOST_CHECK(simMarket->stateHash() == incremental);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testNpvCalculatorWithStore) {
+    BOOST_TEST_MESSAGE("Testing that an NPV calculator with a scenario result store gives the same cube as without...");
+
+    SavedSettings backup;
+    Date today(14, April, 2016);
+    Settings::instance().evaluationDate() = today;
+
+    auto initMarket = QuantLib::ext::make_shared<testsuite::TestMarket>(today);
+    auto simMarketData = TestConfigurationObjects::setupSimMarketData5();
+    auto sensiData = TestConfigurationObjects::setupSensitivityScenarioData5();
+    auto simMarket = QuantLib::ext::make_shared<ScenarioSimMarket>(initMarket, simMarketData);
+    auto scenarioGenerator = QuantLib::ext::make_shared<SensitivityScenarioGenerator>(
+        sensiData, simMarket->baseScenario(), simMarketData, simMarket,
+        QuantLib::ext::make_shared<DeltaScenarioFactory>(simMarket->baseScenario()), false);
+    simMarket->scenarioGenerator() = scenarioGenerator;
+
+    auto engineData = QuantLib::ext::make_shared<EngineData>();
+    engineData->model("Swap") = "DiscountedCashflows";
+    engineData->engine("Swap") = "DiscountingSwapEngine";
+    engineData->model("FxOption") = "GarmanKohlhagen";
+    engineData->engine("FxOption") = "AnalyticEuropeanEngine";
+    engineData->model("CapFloor") = "IborCapModel";
+    engineData->engine("CapFloor") = "IborCapEngine";
+    auto factory = QuantLib::ext::make_shared<EngineFactory>(engineData, simMarket);
+
+    auto portfolio = QuantLib::ext::make_shared<Portfolio>();
+    portfolio->add(buildSwap("1_Swap_EUR", "EUR", true, 10000000.0, 0, 10, 0.03, 0.00, "1Y", "30/360", "6M", "A360",
+                             "EUR-EURIBOR-6M"));
+    portfolio->add(buildSwap("2_Swap_USD", "USD", true, 10000000.0, 0, 15, 0.02, 0.00, "6M", "30/360", "3M", "A360",
+                             "USD-LIBOR-3M"));
+    portfolio->add(buildFxOption("3_FxOption_EUR_USD", "Long", "Call", 3, "EUR", 10000000.0, "USD", 11000000.0));
+    portfolio->add(buildCap("4_Cap_EUR", "EUR", "Long", 0.05, 1000000.0, 0, 10, "6M", "A360", "EUR-EURIBOR-6M"));
+    portfolio->build(factory);
+    BOOST_REQUIRE_EQUAL(portfolio->size(), 4);
+
+    auto dg = QuantLib::ext::make_shared<DateGrid>("1,0W");
+    Size samples = scenarioGenerator->samples();
+    auto buildCube = [&](const QuantLib::ext::shared_ptr<ScenarioResultStore>& store) {
+        auto calculator = QuantLib::ext::make_shared<NPVCalculator>(simMarketData->baseCcy());
+        if (store)
+            calculator->setResultStore(store, scenarioResultContextHash(*engineData, *simMarketData, ""));
+        QuantLib::ext::shared_ptr<NPVCube> cube = QuantLib::ext::make_shared<DoublePrecisionInMemoryCube>(
+            today, portfolio->ids(), std::vector<Date>(1, today), samples);
+        std::vector<QuantLib::ext::shared_ptr<ValuationCalculator>> calculators = {calculator};
+        scenarioGenerator->reset();
+        ValuationEngine engine(today, dg, simMarket, factory->modelBuilders());
+        engine.buildCube(portfolio, cube, calculators);
+        return cube;
+    };
+
+    auto expected = buildCube(nullptr);
+
+    // the first run stores the npvs, the second one finds them in the store
+    auto store = QuantLib::ext::make_shared<ScenarioResultStore>(100000);
+    std::vector<QuantLib::ext::shared_ptr<NPVCube>> cubes;
+    cubes.push_back(buildCube(store));
+    Size hitsFirstRun = store->hits();
+    cubes.push_back(buildCube(store));
+    BOOST_CHECK_GT(store->hits(), hitsFirstRun);
+    BOOST_CHECK_EQUAL(store->hits() - hitsFirstRun, portfolio->size() * (samples + 1));
+    BOOST_TEST_MESSAGE("hits " << store->hits() << ", misses " << store->misses() << ", hit rate "
+                               << store->hitRate());
+
+    Real maxAbsSensi = 0.0;
+    for (auto const& cube : cubes) {
+        for (Size i = 0; i < portfolio->size(); ++i) {
+            BOOST_CHECK_EQUAL(cube->getT0(i), expected->getT0(i));
+            for (Size j = 0; j < samples; ++j) {
+                maxAbsSensi = std::max(maxAbsSensi, std::abs(expected->get(i, 0, j) - expected->getT0(i)));
+                BOOST_CHECK_MESSAGE(cube->get(i, 0, j) == expected->get(i, 0, j),
+                                    "trade " << i << ", sample " << j << ": npv with store " << cube->get(i, 0, j)
+                                             << ", without store " << expected->get(i, 0, j));
+            }
+        }
+    }
+    // the scenarios must actually move the trades for the comparison to mean something
+    BOOST_CHECK_GT(maxAbsSensi, 1.0);
+}
+
+BOOST_AUTO_TEST_CASE(testMultiThreadedSensitivityAnalysisWithStore) {
+    BOOST_TEST_MESSAGE("Testing the multi-threaded sensitivity analysis with a scenario result store...");
+
+#ifndef QL_ENABLE_SESSIONS
+    BOOST_TEST_MESSAGE("skipping this test, the multi-threaded valuation engine requires QL_ENABLE_SESSIONS = ON");
+#else
+    SavedSettings backup;
+    Date asof(5, Feb, 2016);
+    Settings::instance().evaluationDate() = asof;
+
+    auto conventions = QuantLib::ext::make_shared<Conventions>();
+    conventions->fromFile(TEST_INPUT_FILE("conventions.xml"));
+    InstrumentConventions::instance().setConventions(conventions);
+    auto curveConfigs = QuantLib::ext::make_shared<CurveConfigurations>();
+    curveConfigs->fromFile(TEST_INPUT_FILE("curveconfig.xml"));
+    auto todaysMarketParams = QuantLib::ext::make_shared<TodaysMarketParameters>();
+    todaysMarketParams->fromFile(TEST_INPUT_FILE("todaysmarket.xml"));
+    auto engineData = QuantLib::ext::make_shared<EngineData>();
+    engineData->fromFile(TEST_INPUT_FILE("pricingengine.xml"));
+    auto simMarketData = QuantLib::ext::make_shared<ScenarioSimMarketParameters>();
+    simMarketData->fromFile(TEST_INPUT_FILE("simulation.xml"));
+    auto sensiData = QuantLib::ext::make_shared<SensitivityScenarioData>();
+    sensiData->fromFile(TEST_INPUT_FILE("sensitivity.xml"));
+    auto loader =
+        QuantLib::ext::make_shared<CSVLoader>(TEST_INPUT_FILE("market.txt"), TEST_INPUT_FILE("fixings.txt"), false);
+
+    auto runSensitivityAnalysis = [&](const QuantLib::ext::shared_ptr<ScenarioResultStore>& store) {
+        auto portfolio = QuantLib::ext::make_shared<Portfolio>();
+        portfolio->fromFile(TEST_INPUT_FILE("portfolio.xml"));
+        auto sa = QuantLib::ext::make_shared<SensitivityAnalysis>(
+            2, asof, loader, portfolio, Market::defaultConfiguration, engineData, simMarketData, sensiData, false,
+            curveConfigs, todaysMarketParams);
+        sa->setScenarioResultStore(store);
+        sa->generateSensitivities();
+        return sa->sensiCube()->npvCube();
+    };
+
+    auto expected = runSensitivityAnalysis(nullptr);
+    Size numTrades = expected->numIds(), samples = expected->samples();
+    BOOST_REQUIRE_EQUAL(numTrades, 4);
+    BOOST_REQUIRE_GT(samples, 0);
+
+    // the first run stores the npvs, the second one finds them in the store
+    auto store = QuantLib::ext::make_shared<ScenarioResultStore>(100000);
+    std::vector<QuantLib::ext::shared_ptr<NPVSensiCube>> cubes;
+    cubes.push_back(runSensitivityAnalysis(store));
+    Size hitsFirstRun = store->hits();
+    cubes.push_back(runSensitivityAnalysis(store));
+    BOOST_CHECK_EQUAL(store->hits() - hitsFirstRun, numTrades * (samples + 1));
+    BOOST_TEST_MESSAGE("hits " << store->hits() << ", misses " << store->misses() << ", hit rate "
+                               << store->hitRate());
+
+    Real maxAbsSensi = 0.0;
+    for (auto const& cube : cubes) {
+        BOOST_REQUIRE(cube->ids() == expected->ids());
+        BOOST_REQUIRE_EQUAL(cube->samples(), samples);
+        for (Size i = 0; i < numTrades; ++i) {
+            BOOST_CHECK_EQUAL(cube->getT0(i), expected->getT0(i));
+            for (Size j = 0; j < samples; ++j) {
+                maxAbsSensi = std::max(maxAbsSensi, std::abs(expected->get(i, 0, j) - expected->getT0(i)));
+                BOOST_CHECK_MESSAGE(cube->get(i, 0, j) == expected->get(i, 0, j),
+                                    "trade " << i << ", sample " << j << ": npv with store " << cube->get(i, 0, j)
+                                             << ", without store " << expected->get(i, 0, j));
+            }
+        }
+    }
+    // the scenarios must actually move the trades for the comparison to mean something
+    BOOST_CHECK_GT(maxAbsSensi, 1.0);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -17,6 +17,7 @@
 */
 
 #include <boost/test/unit_test.hpp>
+#include <orea/engine/columnarsensitivitystream.hpp>
 #include <orea/engine/sensitivityaggregator.hpp>
 #include <orea/engine/sensitivityinmemorystream.hpp>
 #include <oret/toplevelfixture.hpp>
@@ -26,6 +27,7 @@
 using namespace boost::unit_test_framework;
 using namespace std;
 
+using ore::analytics::ColumnarSensitivityStream;
 using ore::analytics::RiskFactorKey;
 using ore::analytics::SensitivityAggregator;
 using ore::analytics::SensitivityInMemoryStream;
@@ -240,6 +242,59 @@ BOOST_AUTO_TEST_CASE(testGeneralAggregationFunctionCategories) {
     check(expAggregationAll, res, "all_except_002");
 }
 
+BOOST_AUTO_TEST_CASE(testColumnarStreamRoundTrip) {
+
+    BOOST_TEST_MESSAGE("Testing that the columnar sensitivity stream reproduces its records");
+
+    ColumnarSensitivityStream ss(records.begin(), records.end());
+    BOOST_CHECK_EQUAL(ss.size(), records.size());
+    BOOST_CHECK_EQUAL(ss.currencies().size(), QuantLib::Size(1));
+
+    // Stream twice to check that reset() works
+    for (QuantLib::Size pass = 0; pass < 2; ++pass) {
+        ss.reset();
+        auto it = records.begin();
+        while (SensitivityRecord sr = ss.next()) {
+            BOOST_REQUIRE(it != records.end());
+            BOOST_CHECK_EQUAL(sr, *it);
+            BOOST_CHECK_EQUAL(sr.desc_1, it->desc_1);
+            BOOST_CHECK_EQUAL(sr.desc_2, it->desc_2);
+            BOOST_CHECK_EQUAL(sr.isCrossGamma(), it->isCrossGamma());
+            BOOST_CHECK_CLOSE(sr.delta, it->delta, 1e-12);
+            BOOST_CHECK_CLOSE(sr.gamma, it->gamma, 1e-12);
+            ++it;
+        }
+        BOOST_CHECK(it == records.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testColumnarAggregation) {
+
+    BOOST_TEST_MESSAGE("Testing index based aggregation on a columnar sensitivity stream");
+
+    ColumnarSensitivityStream ss(records.begin(), records.end());
+
+    map<string, set<std::pair<std::string, QuantLib::Size>>> categories;
+    set<pair<string, QuantLib::Size>> trades = {make_pair("trade_001", 0), make_pair("trade_003", 1),
+                                                make_pair("trade_004", 2), make_pair("trade_005", 3),
+                                                make_pair("trade_006", 4)};
+    for (const auto& trade : trades) {
+        categories[trade.first] = {trade};
+    }
+    categories["all_except_002"] = trades;
+
+    SensitivityAggregator sAgg(categories);
+    sAgg.aggregate(ss);
+
+    for (const auto& trade : trades) {
+        BOOST_TEST_MESSAGE("Testing for category with single trade " << trade.first);
+        check(filter(records, trade.first), sAgg.sensitivities(trade.first), trade.first);
+    }
+
+    BOOST_TEST_MESSAGE("Testing for category 'all_except_002'");
+    check(expAggregationAll, sAgg.sensitivities("all_except_002"), "all_except_002");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,274 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <oret/datapaths.hpp>
+#include <oret/toplevelfixture.hpp>
+
+#include <orea/app/inputparameters.hpp>
+#include <orea/app/oreapp.hpp>
+#include <orea/cube/cube_io.hpp>
+#include <orea/cube/incrementalcube.hpp>
+#include <orea/cube/npvcube.hpp>
+#include <ored/report/inmemoryreport.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+using namespace boost::unit_test_framework;
+using namespace QuantLib;
+using namespace ore::data;
+using namespace ore::analytics;
+
+namespace {
+
+std::vector<std::string> readLines(const std::string& fileName) {
+    std::ifstream in(fileName);
+    QL_REQUIRE(in.is_open(), "could not open " << fileName);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty())
+            lines.push_back(line);
+    }
+    return lines;
+}
+
+// inputs for a classic single-threaded exposure simulation of the given portfolio, the analytics are set by the caller
+QuantLib::ext::shared_ptr<InputParameters> exposureInputs(const std::string& portfolioFile) {
+    auto inputs = QuantLib::ext::make_shared<InputParameters>();
+    inputs->setAsOfDate("2016-02-05");
+    inputs->setResultsPath(TEST_OUTPUT);
+    inputs->setBaseCurrency("EUR");
+    inputs->setEntireMarket(true);
+    inputs->setAllFixings(true);
+    inputs->setBuildFailedTrades(false);
+    inputs->setConventionsFromFile(TEST_INPUT_FILE("conventions.xml"));
+    inputs->setCurveConfigsFromFile(TEST_INPUT_FILE("curveconfig.xml"));
+    inputs->setTodaysMarketParamsFromFile(TEST_INPUT_FILE("todaysmarket.xml"));
+    inputs->setPricingEngineFromFile(TEST_INPUT_FILE("pricingengine.xml"));
+    inputs->setPortfolioFromFile(portfolioFile, TEST_INPUT);
+    inputs->setExposureSimMarketParamsFromFile(TEST_INPUT_FILE("simulation.xml"));
+    inputs->setCrossAssetModelDataFromFile(TEST_INPUT_FILE("simulation.xml"));
+    inputs->setScenarioGeneratorDataFromFile(TEST_INPUT_FILE("simulation.xml"));
+    inputs->setSimulationPricingEngineFromFile(TEST_INPUT_FILE("pricingengine.xml"));
+    inputs->setExposureBaseCurrency("EUR");
+    inputs->setXvaBaseCurrency("EUR");
+    inputs->setNettingSetManagerFromFile(TEST_INPUT_FILE("netting.xml"));
+    inputs->setWriteCube(true);
+    return inputs;
+}
+
+QuantLib::ext::shared_ptr<OREApp> runApp(const QuantLib::ext::shared_ptr<InputParameters>& inputs) {
+    auto app = QuantLib::ext::make_shared<OREApp>(inputs, TEST_OUTPUT_FILE("log.txt"));
+    app->run(readLines(TEST_INPUT_FILE("market.txt")), readLines(TEST_INPUT_FILE("fixings.txt")));
+    return app;
+}
+
+// write the cube with the meta data that OREApp::run() stores along with it
+void writeCube(const std::string& fileName, const QuantLib::ext::shared_ptr<InputParameters>& inputs,
+               const QuantLib::ext::shared_ptr<NPVCube>& cube) {
+    NPVCubeWithMetaData r;
+    r.cube = cube;
+    r.scenarioGeneratorData = inputs->scenarioGeneratorData();
+    r.storeFlows = inputs->storeFlows();
+    r.storeCreditStateNPVs = inputs->storeCreditStateNPVs();
+    r.tradeHashes = tradeHashes(*inputs->portfolio());
+    saveCube(fileName, r);
+}
+
+// the cubes are generated from identical scenarios, so we expect identical values
+void checkCubesEqual(const NPVCube& expected, const NPVCube& actual) {
+    std::set<std::string> expectedIds, actualIds;
+    for (auto const& [id, pos] : expected.idsAndIndexes())
+        expectedIds.insert(id);
+    for (auto const& [id, pos] : actual.idsAndIndexes())
+        actualIds.insert(id);
+    BOOST_REQUIRE(expectedIds == actualIds);
+    BOOST_REQUIRE(expected.dates() == actual.dates());
+    BOOST_REQUIRE_EQUAL(expected.samples(), actual.samples());
+    BOOST_REQUIRE_EQUAL(expected.depth(), actual.depth());
+
+    Size mismatches = 0;
+    for (auto const& id : expectedIds) {
+        Size i = expected.index(id), j = actual.index(id);
+        for (Size d = 0; d < expected.depth(); ++d) {
+            if (expected.getT0(i, d) != actual.getT0(j, d))
+                ++mismatches;
+            for (Size k = 0; k < expected.numDates(); ++k) {
+                for (Size s = 0; s < expected.samples(); ++s) {
+                    if (expected.get(i, k, s, d) != actual.get(j, k, s, d)) {
+                        if (mismatches++ < 10)
+                            BOOST_ERROR("cube entry differs for " << id << ", date " << k << ", sample " << s
+                                                                  << ", depth " << d << ": expected "
+                                                                  << expected.get(i, k, s, d) << ", actual "
+                                                                  << actual.get(j, k, s, d));
+                    }
+                }
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(mismatches, 0);
+}
+
+void checkReportsEqual(const PlainInMemoryReport& expected, const PlainInMemoryReport& actual,
+                       const std::string& name) {
+    BOOST_TEST_MESSAGE("Checking report " << name);
+    BOOST_REQUIRE_EQUAL(expected.columns(), actual.columns());
+    BOOST_REQUIRE_EQUAL(expected.rows(), actual.rows());
+    for (Size i = 0; i < expected.columns(); ++i) {
+        BOOST_CHECK_EQUAL(expected.header(i), actual.header(i));
+        BOOST_REQUIRE_EQUAL(expected.columnType(i), actual.columnType(i));
+        switch (expected.columnType(i)) {
+        case 0:
+            BOOST_CHECK(expected.dataAsSize(i) == actual.dataAsSize(i));
+            break;
+        case 1: {
+            std::vector<Real> e = expected.dataAsReal(i), a = actual.dataAsReal(i);
+            for (Size j = 0; j < e.size(); ++j) {
+                BOOST_CHECK_MESSAGE(std::abs(e[j] - a[j]) <= 1E-10 * std::max(1.0, std::abs(e[j])),
+                                    name << ": column " << expected.header(i) << ", row " << j << " differs, expected "
+                                         << e[j] << ", actual " << a[j]);
+            }
+            break;
+        }
+        case 2:
+            BOOST_CHECK(expected.dataAsString(i) == actual.dataAsString(i));
+            break;
+        case 3:
+            BOOST_CHECK(expected.dataAsDate(i) == actual.dataAsDate(i));
+            break;
+        default:
+            BOOST_CHECK(expected.dataAsPeriod(i) == actual.dataAsPeriod(i));
+        }
+    }
+}
+
+// compare the exposure profiles and the xva report of two runs
+void checkXvaReportsEqual(OREApp& expected, OREApp& actual) {
+    std::set<std::string> names = expected.getReportNames();
+    BOOST_CHECK(names.count("xva") == 1);
+    for (auto const& name : names) {
+        if (name == "xva" || name.find("exposure_") == 0)
+            checkReportsEqual(*expected.getReport(name), *actual.getReport(name), name);
+    }
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREAnalyticsTestSuite, ore::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(XvaAnalyticTest)
+
+BOOST_AUTO_TEST_CASE(testIncrementalExposureRun) {
+    BOOST_TEST_MESSAGE("Testing that an incremental exposure run reproduces a full run...");
+
+    // previous run on the original portfolio
+
+    auto previousInputs = exposureInputs("portfolio.xml");
+    previousInputs->insertAnalytic("EXPOSURE");
+    auto previous = runApp(previousInputs);
+    std::string previousCubeFile = TEST_OUTPUT_FILE("previous_cube.csv");
+    writeCube(previousCubeFile, previousInputs, previous->getCube("cube"));
+
+    // the amended portfolio changes Swap_2, removes Swap_3 and adds Swap_6
+
+    auto fullInputs = exposureInputs("portfolio_amended.xml");
+    fullInputs->insertAnalytic("EXPOSURE");
+    fullInputs->insertAnalytic("XVA");
+    auto full = runApp(fullInputs);
+
+    auto incrementalInputs = exposureInputs("portfolio_amended.xml");
+    incrementalInputs->insertAnalytic("EXPOSURE");
+    incrementalInputs->insertAnalytic("XVA");
+    incrementalInputs->setPreviousCubeFromFile(previousCubeFile);
+    auto incremental = runApp(incrementalInputs);
+
+    auto fullCube = full->getCube("cube");
+    BOOST_CHECK_EQUAL(fullCube->numIds(), 5);
+    BOOST_CHECK_EQUAL(fullCube->idsAndIndexes().count("Swap_3"), 0);
+    BOOST_CHECK_EQUAL(fullCube->idsAndIndexes().count("Swap_6"), 1);
+    checkCubesEqual(*fullCube, *incremental->getCube("cube"));
+    checkXvaReportsEqual(*full, *incremental);
+
+    // make sure that the unchanged trades are really taken from the previous cube by marking one of them
+
+    NPVCubeWithMetaData marked = loadCube(previousCubeFile);
+    marked.cube->setT0(1234.0, "Swap_1");
+    marked.cube->setT0(1234.0, "Swap_2");
+    std::string markedCubeFile = TEST_OUTPUT_FILE("previous_cube_marked.csv");
+    saveCube(markedCubeFile, marked);
+
+    auto markedInputs = exposureInputs("portfolio_amended.xml");
+    markedInputs->insertAnalytic("EXPOSURE");
+    markedInputs->setPreviousCubeFromFile(markedCubeFile);
+    auto markedCube = runApp(markedInputs)->getCube("cube");
+    BOOST_CHECK_EQUAL(markedCube->getT0("Swap_1"), 1234.0);
+    BOOST_CHECK_EQUAL(markedCube->getT0("Swap_2"), fullCube->getT0("Swap_2"));
+}
+
+BOOST_AUTO_TEST_CASE(testShardedExposureRun) {
+    BOOST_TEST_MESSAGE("Testing that merged shards reproduce an unsharded exposure and xva run...");
+
+    auto fullInputs = exposureInputs("portfolio.xml");
+    fullInputs->insertAnalytic("EXPOSURE");
+    fullInputs->insertAnalytic("XVA");
+    auto full = runApp(fullInputs);
+
+    // simulate two shards and write their partial cubes and scenario data
+
+    Size shardCount = 2;
+    std::vector<std::string> cubeFiles, scenarioFiles;
+    for (Size i = 0; i < shardCount; ++i) {
+        auto shardInputs = exposureInputs("portfolio.xml");
+        shardInputs->insertAnalytic("EXPOSURE");
+        shardInputs->setSimulationShard(i, shardCount);
+        auto shard = runApp(shardInputs);
+        auto shardCube = shard->getCube("cube");
+        BOOST_CHECK(shardCube->numIds() > 0 && shardCube->numIds() < shardInputs->portfolio()->size());
+        cubeFiles.push_back(TEST_OUTPUT_FILE("shard_cube_" + std::to_string(i) + ".csv"));
+        scenarioFiles.push_back(TEST_OUTPUT_FILE("shard_scenariodata_" + std::to_string(i) + ".csv"));
+        writeCube(cubeFiles.back(), shardInputs, shardCube);
+        saveAggregationScenarioData(scenarioFiles.back(), *shard->getMarketCube("scenariodata"));
+    }
+
+    // merge the shards in an xva run
+
+    auto mergedInputs = exposureInputs("portfolio.xml");
+    mergedInputs->insertAnalytic("XVA");
+    mergedInputs->setLoadCube(true);
+    mergedInputs->setCubeFromFiles(cubeFiles);
+    mergedInputs->setMarketCubeFromFiles(scenarioFiles);
+    auto merged = runApp(mergedInputs);
+
+    checkCubesEqual(*full->getCube("cube"), *mergedInputs->cube());
+    checkXvaReportsEqual(*full, *merged);
+
+    // a sharded run can not produce the xva, which needs the full cube
+
+    auto invalidInputs = exposureInputs("portfolio.xml");
+    invalidInputs->insertAnalytic("EXPOSURE");
+    invalidInputs->insertAnalytic("XVA");
+    invalidInputs->setSimulationShard(0, shardCount);
+    BOOST_CHECK_THROW(runApp(invalidInputs), QuantLib::Error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
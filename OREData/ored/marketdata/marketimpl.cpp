@@ -510,7 +510,8 @@ void MarketImpl::addSwapIndex(const string& swapIndex, const string& discountInd
     }
 }
 
-void MarketImpl::refresh(const string& configuration) {
+const std::set<QuantLib::ext::shared_ptr<TermStructure>>&
+MarketImpl::refreshTermStructures(const string& configuration) {
 
     auto it = refreshTs_.find(configuration);
     if (it == refreshTs_.end()) {
@@ -617,9 +618,13 @@ void MarketImpl::refresh(const string& configuration) {
         }
     }
 
+    return it->second;
+}
+
+void MarketImpl::refresh(const string& configuration) {
     // term structures might be wrappers around nested termstructures that need to be updated as well,
     // therefore we need to call deepUpdate() (=update() if no such nesting is present)
-    for (auto& x : it->second)
+    for (auto& x : refreshTermStructures(configuration))
         x->deepUpdate();
 
 } // refresh
@@ -236,6 +236,9 @@ protected:
     void addSwapIndex(const string& swapindex, const string& discountIndex,
                       const string& configuration = Market::defaultConfiguration) const;
 
+    //! the term structures updated by refresh(), built on first use
+    const std::set<QuantLib::ext::shared_ptr<TermStructure>>& refreshTermStructures(const string& configuration);
+
     // set of term structure pointers for refresh (per configuration)
     map<string, std::set<QuantLib::ext::shared_ptr<TermStructure>>> refreshTs_;
 
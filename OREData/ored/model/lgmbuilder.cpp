@@ -21,6 +21,8 @@
 #include <ql/pricingengines/swaption/blackswaptionengine.hpp>
 #include <ql/quotes/simplequote.hpp>
 
+#include <boost/timer/timer.hpp>
+
 #include <qle/models/irlgm1fconstantparametrization.hpp>
 #include <qle/models/irlgm1fpiecewiseconstanthullwhiteadaptor.hpp>
 #include <qle/models/irlgm1fpiecewiseconstantparametrization.hpp>
@@ -354,13 +356,16 @@ void LgmBuilder::performCalculations() const {
         swaptionBasket_[j]->update();
     }
 
-    // reset model parameters to ensure identical results on identical market data input
-    model_->setParams(params_);
+    // reset model parameters to ensure identical results on identical market data input, unless we warm start from
+    // the last successful calibration
+    bool warmStarted = warmStart_ && !calibratedParams_.empty();
+    model_->setParams(warmStarted ? calibratedParams_ : params_);
     parametrization_->shift() = 0.0;
     parametrization_->scaling() = 1.0;
 
     LgmCalibrationInfo calibrationInfo;
     error_ = QL_MAX_REAL;
+    boost::timer::cpu_timer timer;
     std::string errorTemplate =
         std::string("Failed to calibrate LGM Model. ") +
         (continueOnError_ ? std::string("Calculation will proceed anyway - using the calibration as is!")
@@ -390,6 +395,8 @@ void LgmBuilder::performCalculations() const {
         }
         TLOG("LGM " << data_->qualifier() << " calibration errors:");
         error_ = getCalibrationError(swaptionBasket_);
+        DLOG("LGM " << data_->qualifier() << " calibrated (" << (warmStarted ? "warm" : "cold")
+                    << " start), rmse = " << error_ << ", time = " << timer.elapsed().wall / 1E6 << " ms");
     } catch (const std::exception& e) {
         // just log a warning, we check below if we meet the bootstrap tolerance and handle the result there
         StructuredModelErrorMessage(errorTemplate, e.what(), id_).log();
@@ -397,6 +404,7 @@ void LgmBuilder::performCalculations() const {
     calibrationInfo.rmse = error_;
     if (fabs(error_) < bootstrapTolerance_ ||
         (data_->calibrationType() == CalibrationType::BestFit && error_ != QL_MAX_REAL)) {
+        calibratedParams_ = model_->params();
         // we check the log level here to avoid unnecessary computations
         if (Log::instance().filter(ORE_DATA) || setCalibrationInfo_) {
             TLOGGERSTREAM("Basket details:");
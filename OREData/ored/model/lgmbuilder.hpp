@@ -104,6 +104,8 @@ private:
     mutable Real error_;
     mutable QuantLib::ext::shared_ptr<QuantExt::LGM> model_;
     mutable Array params_;
+    // parameters of the last successful calibration, used as a starting point if warm start is enabled
+    mutable Array calibratedParams_;
     mutable QuantLib::ext::shared_ptr<QuantExt::IrLgm1fParametrization> parametrization_;
 
     // which swaptions in data->optionExpries() are actually in the basket?
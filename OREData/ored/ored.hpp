@@ -340,6 +340,7 @@
 #include <ored/report/report.hpp>
 #include <ored/report/utilities.hpp>
 #include <ored/scripting/ast.hpp>
+#include <ored/scripting/astcompiler.hpp>
 #include <ored/scripting/astprinter.hpp>
 #include <ored/scripting/astresetter.hpp>
 #include <ored/scripting/asttoscriptconverter.hpp>
@@ -401,6 +402,7 @@
 #include <ored/utilities/marketdata.hpp>
 #include <ored/utilities/osutils.hpp>
 #include <ored/utilities/parsers.hpp>
+#include <ored/utilities/profiler.hpp>
 #include <ored/utilities/progressbar.hpp>
 #include <ored/utilities/serializationdate.hpp>
 #include <ored/utilities/serializationdaycounter.hpp>
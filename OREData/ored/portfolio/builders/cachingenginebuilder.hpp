@@ -46,6 +46,9 @@ namespace data {
  *  The remaining variable arguments are to be passed to engine() and
  *  engineImpl(), these are the specific parameters required to build
  *  an engine or coupon pricer for this trade type.
+ *
+ *  The cache lookup and engine creation are guarded by the builder's mutex, so that
+ *  trades can be built in parallel against the same builder.
     \ingroup builders
  */
 template <class T, class U, typename... Args> class CachingEngineBuilder : public EngineBuilder {
@@ -60,6 +63,7 @@ public:
 
     //! Return a PricingEngine or a FloatingRateCouponPricer
     QuantLib::ext::shared_ptr<U> engine(Args... params) {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         T key = keyImpl(params...);
         if (engines_.find(key) == engines_.end()) {
             // build first (in case it throws)
@@ -70,7 +74,10 @@ public:
         return engines_[key];
     }
 
-    void reset() override { engines_.clear(); }
+    void reset() override {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        engines_.clear();
+    }
 
 protected:
     virtual T keyImpl(Args...) = 0;
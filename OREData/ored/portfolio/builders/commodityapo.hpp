@@ -89,7 +89,7 @@ protected:
         }
 
         auto modelBuilder = QuantLib::ext::make_shared<CommodityApoModelBuilder>(yts, vol, apo, dontCalibrate);
-        modelBuilders_.insert(std::make_pair(id, modelBuilder));
+        addModelBuilder(id, modelBuilder);
 
         return QuantLib::ext::make_shared<QuantExt::CommodityAveragePriceOptionAnalyticalEngine>(yts, modelBuilder->model(),
                                                                                          beta);
@@ -140,7 +140,7 @@ protected:
         }
 
         auto modelBuilder = QuantLib::ext::make_shared<CommodityApoModelBuilder>(yts, vol, apo, dontCalibrate);
-        modelBuilders_.insert(std::make_pair(id, modelBuilder));
+        addModelBuilder(id, modelBuilder);
 
         return QuantLib::ext::make_shared<QuantExt::CommodityAveragePriceOptionMonteCarloEngine>(yts, modelBuilder->model(),
                                                                                          samples, beta);
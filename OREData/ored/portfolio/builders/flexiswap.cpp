@@ -148,7 +148,7 @@ QuantLib::ext::shared_ptr<QuantExt::LGM> FlexiSwapBGSLGMGridEngineBuilderBase::m
         model = calib->model();
         calib->unfreeze();
     }
-    modelBuilders_.insert(std::make_pair(id, calib));
+    addModelBuilder(id, calib);
 
     return model;
 }
@@ -246,7 +246,7 @@ QuantLib::ext::shared_ptr<PricingEngine> CamMcMultiLegOptionEngineBuilder::engin
         configurationXois, configurationXois, configurationInCcy, configurationInCcy, configurationXois, !calibrate,
         continueOnCalibrationError, "", SalvagingAlgorithm::Spectral, id);
 
-    modelBuilders_.insert(std::make_pair(id, builder));
+    addModelBuilder(id, builder);
 
     // build the pricing engine
 
@@ -232,7 +232,7 @@ RiskParticipationAgreementLGMGridEngineBuilder::model(const string& id, const st
         model = calib->model();
         calib->unfreeze();
     }
-    modelBuilders_.insert(std::make_pair(id, calib));
+    addModelBuilder(id, calib);
 
     return model;
 }
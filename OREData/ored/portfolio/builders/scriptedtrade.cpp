@@ -79,6 +79,9 @@ ScriptedTradeEngineBuilder::engine(const std::string& id, const ScriptedTrade& s
                                    const QuantLib::ext::shared_ptr<ReferenceDataManager>& referenceData,
                                    const IborFallbackConfig& iborFallbackConfig) {
 
+    // the builder keeps the state of the current engine build in its members
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+
     const std::vector<ScriptedTradeEventData>& events = scriptedTrade.events();
     const std::vector<ScriptedTradeValueTypeData>& numbers = scriptedTrade.numbers();
     const std::vector<ScriptedTradeValueTypeData>& indices = scriptedTrade.indices();
@@ -1221,7 +1224,7 @@ void ScriptedTradeEngineBuilder::buildBlackScholes(const std::string& id,
                                                   builder->model(), correlations_, mcParams_, simulationDates_,
                                                   iborFallbackConfig, calibration_, filteredStrikes);
     }
-    modelBuilders_.insert(std::make_pair(id, builder));
+    addModelBuilder(id, builder);
 }
 
 void ScriptedTradeEngineBuilder::buildFdBlackScholes(const std::string& id,
@@ -1236,7 +1239,7 @@ void ScriptedTradeEngineBuilder::buildFdBlackScholes(const std::string& id,
         modelIndicesCurrencies_, payCcys_, builder->model(), correlations_, simulationDates_, iborFallbackConfig,
         calibration_, filteredStrikes, mesherEpsilon_, mesherScaling_, mesherConcentration_,
         mesherMaxConcentratingPoints_, mesherIsStatic_);
-    modelBuilders_.insert(std::make_pair(id, builder));
+    addModelBuilder(id, builder);
 }
 
 void ScriptedTradeEngineBuilder::buildLocalVol(const std::string& id, const IborFallbackConfig& iborFallbackConfig) {
@@ -1254,7 +1257,7 @@ void ScriptedTradeEngineBuilder::buildLocalVol(const std::string& id, const Ibor
     model_ = QuantLib::ext::make_shared<LocalVol>(modelSize_, modelCcys_, modelCurves_, modelFxSpots_, modelIrIndices_,
                                           modelInfIndices_, modelIndices_, modelIndicesCurrencies_, builder->model(),
                                           correlations_, mcParams_, simulationDates_, iborFallbackConfig);
-    modelBuilders_.insert(std::make_pair(id, builder));
+    addModelBuilder(id, builder);
 }
 
 namespace {
@@ -1651,7 +1654,7 @@ void ScriptedTradeEngineBuilder::buildGaussianCam(const std::string& id, const I
             iborFallbackConfig, std::vector<Size>(), conditionalExpectationModelStates);
     }
 
-    modelBuilders_.insert(std::make_pair(id, camBuilder));
+    addModelBuilder(id, camBuilder);
 }
 
 void ScriptedTradeEngineBuilder::buildFdGaussianCam(const std::string& id,
@@ -1749,7 +1752,7 @@ void ScriptedTradeEngineBuilder::buildFdGaussianCam(const std::string& id,
                                                modelIrIndices_, simulationDates_, modelSize_, timeStepsPerYear_,
                                                mesherEpsilon_, iborFallbackConfig);
 
-    modelBuilders_.insert(std::make_pair(id, camBuilder));
+    addModelBuilder(id, camBuilder);
 }
 
 void ScriptedTradeEngineBuilder::buildAMCCGModel(const std::string& id, const IborFallbackConfig& iborFallbackConfig,
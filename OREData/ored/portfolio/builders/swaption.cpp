@@ -230,7 +230,7 @@ QuantLib::ext::shared_ptr<QuantExt::LGM> LGMSwaptionEngineBuilder::model(const s
         model = calib->model();
         calib->unfreeze();
     }
-    modelBuilders_.insert(std::make_pair(id, calib));
+    addModelBuilder(id, calib);
 
     return model;
 }
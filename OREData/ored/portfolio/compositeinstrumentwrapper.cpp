@@ -79,6 +79,14 @@ void CompositeInstrumentWrapper::updateQlInstruments() {
     }
 }
 
+bool CompositeInstrumentWrapper::qlInstrumentsCalculated() const {
+    for (auto const& w : wrappers_) {
+        if (!w->qlInstrumentsCalculated())
+            return false;
+    }
+    return true;
+}
+
 bool CompositeInstrumentWrapper::isOption() {
     for (const auto& w : wrappers_) {
         if (w->isOption()) {
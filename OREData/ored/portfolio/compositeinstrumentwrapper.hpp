@@ -59,6 +59,7 @@ public:
     QuantLib::Real NPV() const override;
     const std::map<std::string, boost::any>& additionalResults() const override;
     void updateQlInstruments() override;
+    bool qlInstrumentsCalculated() const override;
     bool isOption() override;
 
 protected:
@@ -19,12 +19,15 @@
 
 #include <ored/utilities/log.hpp>
 #include <ored/portfolio/enginefactory.hpp>
+#include <ored/utilities/parsers.hpp>
 
 #include <boost/make_shared.hpp>
 #include <boost/algorithm/string/join.hpp>
 
 #include <ql/errors.hpp>
 
+#include <typeinfo>
+
 namespace ore {
 namespace data {
 
@@ -57,6 +60,14 @@ std::string EngineBuilder::engineParameter(const std::string& p, const std::vect
     return getParameter(engineParameters_, p, qualifiers, mandatory, defaultValue);
 }
 
+void EngineBuilder::addModelBuilder(const string& id,
+                                    const QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>& modelBuilder) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    auto p = globalParameters_.find("WarmStartCalibration");
+    modelBuilder->setWarmStart(p != globalParameters_.end() && parseBool(p->second));
+    modelBuilders_.insert(std::make_pair(id, modelBuilder));
+}
+
 std::string EngineBuilder::modelParameter(const std::string& p, const std::vector<std::string>& qualifiers,
                                           const bool mandatory, const std::string& defaultValue) const {
     return getParameter(modelParameters_, p, qualifiers, mandatory, defaultValue);
@@ -191,8 +202,13 @@ void EngineFactory::registerBuilder(const QuantLib::ext::shared_ptr<EngineBuilde
     const string& modelName = builder->model();
     const string& engineName = builder->engine();
     auto key = make_tuple(modelName, engineName, builder->tradeTypes());
-    if (allowOverwrite)
+    if (allowOverwrite) {
         builders_.erase(key);
+        std::lock_guard<std::mutex> lock(mutex_);
+        builderParameters_.erase(key);
+        for (auto i = builderInstances_.begin(); i != builderInstances_.end();)
+            i = i->first.first == key ? builderInstances_.erase(i) : std::next(i);
+    }
     QL_REQUIRE(builders_.insert(make_pair(key, builder)).second,
                "EngineFactory: duplicate engine builder for (" << modelName << "/" << engineName << "/"
                                                                << boost::algorithm::join(builder->tradeTypes(), ",")
@@ -223,12 +239,46 @@ QuantLib::ext::shared_ptr<EngineBuilder> EngineFactory::builder(const string& tr
     if(auto db = QuantLib::ext::dynamic_pointer_cast<DelegatingEngineBuilder>(builder))
 	effectiveTradeType = db->effectiveTradeType();
 
-    builder->init(market_, configurations_, engineData_->modelParameters(effectiveTradeType),
-                  engineData_->engineParameters(effectiveTradeType), engineData_->globalParameters());
+    BuilderParameters parameters(engineData_->modelParameters(effectiveTradeType),
+                                 engineData_->engineParameters(effectiveTradeType));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto p = builderParameters_.insert(make_pair(it->first, parameters)).first;
+        if (p->second != parameters) {
+            auto i = builderInstances_.find(make_pair(it->first, parameters));
+            if (i == builderInstances_.end()) {
+                auto b = newBuilderInstance(it->first, *builder);
+                if (b == nullptr) {
+                    WLOG("EngineFactory: builder " << model << "/" << engine << " is used with different parameters "
+                                                   << "for trade type " << tradeType
+                                                   << ", but no separate instance can be created for these "
+                                                   << "parameters. The builder is re-initialised, so that trades "
+                                                   << "using it must not be built in parallel.");
+                } else {
+                    DLOG("EngineFactory: created a separate instance of builder " << model << "/" << engine
+                                                                                  << " for trade type " << tradeType);
+                }
+                i = builderInstances_.insert(make_pair(make_pair(it->first, parameters), b)).first;
+            }
+            if (i->second != nullptr)
+                builder = i->second;
+        }
+    }
+
+    builder->init(market_, configurations_, parameters.first, parameters.second, engineData_->globalParameters());
 
     return builder;
 }
 
+QuantLib::ext::shared_ptr<EngineBuilder> EngineFactory::newBuilderInstance(const BuilderKey& key,
+                                                                           const EngineBuilder& registered) const {
+    for (auto const& b : EngineBuilderFactory::instance().generateEngineBuilders()) {
+        if (make_tuple(b->model(), b->engine(), b->tradeTypes()) == key && typeid(*b) == typeid(registered))
+            return b;
+    }
+    return nullptr;
+}
+
 void EngineFactory::registerLegBuilder(const QuantLib::ext::shared_ptr<LegBuilder>& legBuilder, const bool allowOverwrite) {
     if (allowOverwrite)
         legBuilders_.erase(legBuilder->legType());
@@ -248,6 +298,11 @@ set<std::pair<string, QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>>> Engine
     for (auto const& b : builders_) {
         res.insert(b.second->modelBuilders().begin(), b.second->modelBuilders().end());
     }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto const& b : builderInstances_) {
+        if (b.second != nullptr)
+            res.insert(b.second->modelBuilders().begin(), b.second->modelBuilders().end());
+    }
     return res;
 }
 
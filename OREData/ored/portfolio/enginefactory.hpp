@@ -36,6 +36,7 @@
 #include <ql/shared_ptr.hpp>
 
 #include <map>
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -128,14 +129,23 @@ public:
     /*! This method should not be called directly, it is called by the EngineFactory
      *  before it is returned.
      */
+    /*! Members are only assigned if they change, so that concurrent readers are not disturbed when a builder
+     *  is repeatedly initialised with the same data during a parallel portfolio build.
+     */
     void init(const QuantLib::ext::shared_ptr<Market> market, const map<MarketContext, string>& configurations,
               const map<string, string>& modelParameters, const map<string, string>& engineParameters,
               const std::map<std::string, std::string>& globalParameters = {}) {
-        market_ = market;
-        configurations_ = configurations;
-        modelParameters_ = modelParameters;
-        engineParameters_ = engineParameters;
-        globalParameters_ = globalParameters;
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (market_ != market)
+            market_ = market;
+        if (configurations_ != configurations)
+            configurations_ = configurations;
+        if (modelParameters_ != modelParameters)
+            modelParameters_ = modelParameters;
+        if (engineParameters_ != engineParameters)
+            engineParameters_ = engineParameters;
+        if (globalParameters_ != globalParameters)
+            globalParameters_ = globalParameters;
     }
 
     //! return model builders
@@ -148,7 +158,15 @@ public:
     std::string modelParameter(const std::string& p, const std::vector<std::string>& qualifiers = {},
                                const bool mandatory = true, const std::string& defaultValue = "") const;
 
+    /*! lock the builder state, needed by callers that query results of the last engine build from the builder
+        (e.g. ScriptedTradeEngineBuilder), while trades are built in parallel */
+    std::unique_lock<std::recursive_mutex> lock() const { return std::unique_lock<std::recursive_mutex>(mutex_); }
+
 protected:
+    /*! add a model builder created by this engine builder, its warm start flag is set from the global engine
+        parameter WarmStartCalibration (defaults to false) */
+    void addModelBuilder(const string& id, const QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>& modelBuilder);
+
     string model_;
     string engine_;
     set<string> tradeTypes_;
@@ -158,6 +176,8 @@ protected:
     map<string, string> engineParameters_;
     std::map<std::string, std::string> globalParameters_;
     set<std::pair<string, QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>>> modelBuilders_;
+    //! guards the builder state (init, engine caches) when trades are built in parallel
+    mutable std::recursive_mutex mutex_;
 };
 
 //! Delegating Engine Builder
@@ -265,6 +285,12 @@ public:
         the returned builder can be cast to the type required for the tradeType.
 
         The factory will call EngineBuilder::init() before returning it.
+
+        A registered builder is used for the model and engine parameters of the first trade type it is requested
+        for. If it is requested for another trade type with different parameters, a separate instance of the
+        builder is created from the EngineBuilderFactory and cached for these parameters, so that a builder is
+        never re-initialised with different parameters while another thread builds an engine from it. If no such
+        instance can be created (e.g. for extra engine builders) the shared builder is re-initialised as before.
      */
     QuantLib::ext::shared_ptr<EngineBuilder> builder(const string& tradeType);
 
@@ -285,16 +311,28 @@ public:
     void clear() {
         builders_.clear();
         legBuilders_.clear();
+        builderParameters_.clear();
+        builderInstances_.clear();
     }
 
     //! return model builders
     set<std::pair<string, QuantLib::ext::shared_ptr<QuantExt::ModelBuilder>>> modelBuilders() const;
 
 private:
+    using BuilderKey = tuple<string, string, set<string>>;
+    using BuilderParameters = std::pair<map<string, string>, map<string, string>>;
+    QuantLib::ext::shared_ptr<EngineBuilder> newBuilderInstance(const BuilderKey& key,
+                                                                const EngineBuilder& registered) const;
+
     QuantLib::ext::shared_ptr<Market> market_;
     QuantLib::ext::shared_ptr<EngineData> engineData_;
     map<MarketContext, string> configurations_;
-    map<tuple<string, string, set<string>>, QuantLib::ext::shared_ptr<EngineBuilder>> builders_;
+    map<BuilderKey, QuantLib::ext::shared_ptr<EngineBuilder>> builders_;
+    // model and engine parameters a registered builder is used with
+    map<BuilderKey, BuilderParameters> builderParameters_;
+    // further instances of registered builders for other parameters, null if no instance could be created
+    map<std::pair<BuilderKey, BuilderParameters>, QuantLib::ext::shared_ptr<EngineBuilder>> builderInstances_;
+    mutable std::mutex mutex_;
     map<string, QuantLib::ext::shared_ptr<LegBuilder>> legBuilders_;
     QuantLib::ext::shared_ptr<ReferenceDataManager> referenceData_;
     IborFallbackConfig iborFallbackConfig_;
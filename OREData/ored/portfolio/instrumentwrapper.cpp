@@ -47,6 +47,15 @@ void InstrumentWrapper::updateQlInstruments() {
         additionalInstruments_[i]->deepUpdate();
 }
 
+bool InstrumentWrapper::qlInstrumentsCalculated() const {
+    if (instrument_ == nullptr || !instrument_->isCalculated())
+        return false;
+    for (QuantLib::Size i = 0; i < additionalInstruments_.size(); ++i)
+        if (!additionalInstruments_[i]->isCalculated())
+            return false;
+    return true;
+}
+
 bool InstrumentWrapper::isOption() { return false; }
 
 QuantLib::ext::shared_ptr<QuantLib::Instrument> InstrumentWrapper::qlInstrument(const bool calculate) const {
@@ -73,6 +73,9 @@ public:
     //! call update on enclosed instrument(s)
     virtual void updateQlInstruments();
 
+    //! true if the enclosed instrument(s) hold calculated results, i.e. were not invalidated since the last pricing
+    virtual bool qlInstrumentsCalculated() const;
+
     //! is it an Option?
     virtual bool isOption();
 
@@ -61,6 +61,12 @@ public:
             underlyingInstruments_[i]->update();
         InstrumentWrapper::updateQlInstruments();
     }
+    bool qlInstrumentsCalculated() const override {
+        for (QuantLib::Size i = 0; i < underlyingInstruments_.size(); ++i)
+            if (!underlyingInstruments_[i]->isCalculated())
+                return false;
+        return InstrumentWrapper::qlInstrumentsCalculated();
+    }
     bool isOption() override { return true; }
     //@}
 
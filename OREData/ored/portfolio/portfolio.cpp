@@ -24,10 +24,14 @@
 #include <ored/portfolio/swap.hpp>
 #include <ored/portfolio/swaption.hpp>
 #include <ored/utilities/log.hpp>
+#include <ored/utilities/profiler.hpp>
 #include <ored/utilities/xmlutils.hpp>
 #include <ql/errors.hpp>
 #include <ql/time/date.hpp>
 
+#include <atomic>
+#include <future>
+
 using namespace QuantLib;
 using namespace std;
 
@@ -120,14 +124,70 @@ void Portfolio::removeMatured(const Date& asof) {
 }
 
 void Portfolio::build(const QuantLib::ext::shared_ptr<EngineFactory>& engineFactory, const std::string& context,
-                      const bool emitStructuredError) {
+                      const bool emitStructuredError, const Size nThreads) {
     LOG("Building Portfolio of size " << trades_.size() << " for context = '" << context << "'");
-    auto trade = trades_.begin();
     Size initialSize = trades_.size();
     Size failedTrades = 0;
+
+    bool parallel = nThreads > 1 && trades_.size() > 1;
+#if !defined(QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN) || defined(QL_ENABLE_SESSIONS)
+    if (parallel) {
+        WLOG("Parallel portfolio build requires QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN = ON and QL_ENABLE_SESSIONS = "
+             "OFF, will build the portfolio serially, context is " + context);
+        parallel = false;
+    }
+#endif
+
+    // in parallel mode build the trades on the worker threads first, keep the errors for the loop below
+
+    std::vector<char> built;
+    std::vector<std::string> errors;
+    if (parallel) {
+        std::vector<QuantLib::ext::shared_ptr<Trade>> trades;
+        for (auto const& t : trades_)
+            trades.push_back(t.second);
+        built.resize(trades.size(), 0);
+        errors.resize(trades.size());
+        Size eff_nThreads = std::min(nThreads, trades.size());
+        LOG("Build portfolio using " << eff_nThreads << " threads");
+        std::atomic<Size> next(0);
+        auto job = [&trades, &built, &errors, &next, &engineFactory]() {
+            for (Size i = next++; i < trades.size(); i = next++) {
+                try {
+                    ScopedProfileTimer profileTimer("portfolio build", trades[i]->tradeType());
+                    trades[i]->reset();
+                    trades[i]->build(engineFactory);
+                    built[i] = 1;
+                } catch (const std::exception& e) {
+                    errors[i] = e.what();
+                }
+            }
+        };
+        std::vector<std::future<void>> results;
+        for (Size i = 0; i < eff_nThreads; ++i)
+            results.push_back(std::async(std::launch::async, job));
+        for (auto& r : results)
+            r.get();
+    }
+
+    auto trade = trades_.begin();
+    Size index = 0;
     while (trade != trades_.end()) {
-        auto [ft, success] = buildTrade((*trade).second, engineFactory, context, ignoreTradeBuildFail(),
-                                        buildFailedTrades(), emitStructuredError);
+        std::pair<QuantLib::ext::shared_ptr<Trade>, bool> result;
+        if (!parallel) {
+            ScopedProfileTimer profileTimer("portfolio build", (*trade).second->tradeType());
+            result = buildTrade((*trade).second, engineFactory, context, ignoreTradeBuildFail(), buildFailedTrades(),
+                                emitStructuredError);
+        } else if (built[index]) {
+            TLOG("Required Fixings for trade " << (*trade).second->id() << ":");
+            TLOGGERSTREAM((*trade).second->requiredFixings());
+            result = std::make_pair(nullptr, true);
+        } else {
+            result = handleTradeBuildError((*trade).second, engineFactory, context, errors[index],
+                                           ignoreTradeBuildFail(), buildFailedTrades(), emitStructuredError);
+        }
+        ++index;
+        auto [ft, success] = result;
         if (success) {
             ++trade;
         } else if (ft) {
@@ -266,6 +326,32 @@ Portfolio::underlyingIndices(AssetClass assetClass,
     return std::set<std::string>();
 }
 
+std::pair<QuantLib::ext::shared_ptr<Trade>, bool>
+handleTradeBuildError(const QuantLib::ext::shared_ptr<Trade>& trade,
+                      const QuantLib::ext::shared_ptr<EngineFactory>& engineFactory, const std::string& context,
+                      const std::string& error, const bool ignoreTradeBuildFail, const bool buildFailedTrades,
+                      const bool emitStructuredError) {
+    if (emitStructuredError) {
+        StructuredTradeErrorMessage(trade, "Error building trade for context '" + context + "'", error).log();
+    } else {
+        ALOG("Error building trade '" << trade->id() << "' for context '" + context + "': " + error);
+    }
+    if (ignoreTradeBuildFail) {
+        return std::make_pair(trade, false);
+    } else if (buildFailedTrades) {
+        QuantLib::ext::shared_ptr<FailedTrade> failed = QuantLib::ext::make_shared<FailedTrade>();
+        failed->id() = trade->id();
+        failed->setUnderlyingTradeType(trade->tradeType());
+        failed->setEnvelope(trade->envelope());
+        failed->build(engineFactory);
+        failed->resetPricingStats(trade->getNumberOfPricings(), trade->getCumulativePricingTime());
+        LOG("Built failed trade with id " << failed->id());
+        return std::make_pair(failed, false);
+    } else {
+        return std::make_pair(nullptr, false);
+    }
+}
+
 std::pair<QuantLib::ext::shared_ptr<Trade>, bool> buildTrade(QuantLib::ext::shared_ptr<Trade>& trade,
                                                      const QuantLib::ext::shared_ptr<EngineFactory>& engineFactory,
                                                      const std::string& context, const bool ignoreTradeBuildFail,
@@ -277,25 +363,8 @@ std::pair<QuantLib::ext::shared_ptr<Trade>, bool> buildTrade(QuantLib::ext::shar
         TLOGGERSTREAM(trade->requiredFixings());
         return std::make_pair(nullptr, true);
     } catch (std::exception& e) {
-        if (emitStructuredError) {
-            StructuredTradeErrorMessage(trade, "Error building trade for context '" + context + "'", e.what()).log();
-        } else {
-            ALOG("Error building trade '" << trade->id() << "' for context '" + context + "': " + e.what());
-        }
-        if (ignoreTradeBuildFail) {
-            return std::make_pair(trade, false);
-        } else if (buildFailedTrades) {
-            QuantLib::ext::shared_ptr<FailedTrade> failed = QuantLib::ext::make_shared<FailedTrade>();
-            failed->id() = trade->id();
-            failed->setUnderlyingTradeType(trade->tradeType());
-            failed->setEnvelope(trade->envelope());
-            failed->build(engineFactory);
-            failed->resetPricingStats(trade->getNumberOfPricings(), trade->getCumulativePricingTime());
-            LOG("Built failed trade with id " << failed->id());
-            return std::make_pair(failed, false);
-        } else {
-            return std::make_pair(nullptr, false);
-        }
+        return handleTradeBuildError(trade, engineFactory, context, e.what(), ignoreTradeBuildFail,
+                                     buildFailedTrades, emitStructuredError);
     }
 }
 
@@ -80,8 +80,13 @@ public:
     void removeMatured(const QuantLib::Date& asof);
 
     //! Call build on all trades in the portfolio, the context is included in error messages
+    /*! If nThreads > 1 the trades are built on up to nThreads worker threads sharing the given engine factory.
+        Errors are collected and handled in trade order after all workers have finished, so that the resulting
+        portfolio (including failed trades) is the same as for a serial build. A parallel build requires a
+        QuantLib build with QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN = ON and QL_ENABLE_SESSIONS = OFF and a
+        market that is not built lazily, otherwise the trades are built serially. */
     void build(const QuantLib::ext::shared_ptr<EngineFactory>&, const std::string& context = "unspecified",
-               const bool emitStructuredError = true);
+               const bool emitStructuredError = true, const QuantLib::Size nThreads = 1);
 
     //! Calculates the maturity of the portfolio
     QuantLib::Date maturity() const;
@@ -134,6 +139,14 @@ private:
     std::map<AssetClass, std::set<std::string>> underlyingIndicesCache_;
 };
 
+/*! Log a trade build error and return the trade that replaces the original trade in the portfolio, along with
+    the success flag (always false). The replacing trade is null if the trade should be removed. */
+std::pair<QuantLib::ext::shared_ptr<Trade>, bool>
+handleTradeBuildError(const QuantLib::ext::shared_ptr<Trade>& trade,
+                      const QuantLib::ext::shared_ptr<EngineFactory>& engineFactory, const std::string& context,
+                      const std::string& error, const bool ignoreTradeBuildFail, const bool buildFailedTrades,
+                      const bool emitStructuredError);
+
 std::pair<QuantLib::ext::shared_ptr<Trade>, bool> buildTrade(
     QuantLib::ext::shared_ptr<Trade>& trade,
     const QuantLib::ext::shared_ptr<EngineFactory>& engineFactory,
@@ -44,6 +44,9 @@ void ScriptedTrade::build(const QuantLib::ext::shared_ptr<EngineFactory>& engine
     auto builder = QuantLib::ext::dynamic_pointer_cast<ScriptedTradeEngineBuilder>(engineFactory->builder("ScriptedTrade"));
 
     QL_REQUIRE(builder, "no builder found for ScriptedTrade");
+
+    // the results below are read from the builder's members, keep other threads from building an engine meanwhile
+    auto builderLock = builder->lock();
     auto engine = builder->engine(id(), *this, engineFactory->referenceData(), engineFactory->iborFallbackConfig());
 
     simmProductClass_ = builder->simmProductClass();
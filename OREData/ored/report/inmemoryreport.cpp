@@ -23,6 +23,7 @@
 #include <boost/algorithm/string/join.hpp>
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/serialization/variant.hpp>
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
@@ -32,11 +33,24 @@
 namespace ore {
 namespace data {
 
+// ReportType::which() of the column types
+namespace {
+enum ColumnType { SizeType = 0, RealType = 1, StringType = 2, DateType = 3, PeriodType = 4 };
+} // namespace
+
+template <class Archive> void InMemoryReport::Column::serialize(Archive& ar, const unsigned int version) {
+    ar& sizes;
+    ar& reals;
+    ar& strings;
+    ar& dates;
+    ar& periods;
+}
+
 Report& InMemoryReport::addColumn(const string& name, const ReportType& rt, Size precision) {
     headers_.push_back(name);
     columnTypes_.push_back(rt);
     columnPrecision_.push_back(precision);
-    data_.push_back(vector<ReportType>()); // Initialise vector for column
+    data_.push_back(Column()); // Initialise column
     i_++;
     return *this;
 }
@@ -45,16 +59,13 @@ Report& InMemoryReport::next() {
     QL_REQUIRE(i_ == headers_.size(), "Cannot go to next line, only " << i_ << " entries filled, report headers are: "
                                                                       << boost::join(headers_, ","));
     i_ = 0;
-    if (bufferSize_ && data_[0].size() == bufferSize_ && !headers_.empty()) {
+    if (bufferSize_ && !headers_.empty() && columnSize(0) == bufferSize_) {
         std::string s = std::tmpnam(nullptr);
         std::ofstream os(s.c_str(), std::ios::binary);
-        boost::archive::binary_oarchive oa(os, boost::archive::no_header);
-        for (Size i = 0; i < headers_.size(); i++) {
-            oa << data_[i];
-            data_[i].clear();
-        }
+        writeColumns(os, data_, strings_);
         os.close();
         files_.push_back(s);
+        clearColumns();
     }
     return *this;
 }
@@ -67,7 +78,26 @@ Report& InMemoryReport::add(const ReportType& rt) {
                                                            << headers_[i_] << " of type " << columnTypes_[i_].which()
                                                            << ", report headers are: " << boost::join(headers_, ","));
 
-    data_[i_].push_back(rt);
+    Column& c = data_[i_];
+    switch (rt.which()) {
+    case SizeType:
+        c.sizes.push_back(boost::get<Size>(rt));
+        break;
+    case RealType:
+        c.reals.push_back(boost::get<Real>(rt));
+        break;
+    case StringType:
+        c.strings.push_back(intern(boost::get<string>(rt)));
+        break;
+    case DateType:
+        c.dates.push_back(boost::get<Date>(rt));
+        break;
+    case PeriodType:
+        c.periods.push_back(boost::get<Period>(rt));
+        break;
+    default:
+        QL_FAIL("InMemoryReport::add(): unexpected report type " << rt.which());
+    }
     i_++;
     return *this;
 }
@@ -90,7 +120,7 @@ Report& InMemoryReport::add(const InMemoryReport& report) {
         
     for (Size rowIdx = 0; rowIdx < report.rows(); rowIdx++) {
         for (Size columnIdx = 0; columnIdx < report.columns(); columnIdx++) {
-            add(report.data(columnIdx)[rowIdx]);
+            add(report.value(columnIdx, rowIdx));
         }
         next();
     }
@@ -104,14 +134,110 @@ void InMemoryReport::end() {
                                                      << ", report headers are: " << boost::join(headers_, ","));
 }
 
-const vector<Report::ReportType>& InMemoryReport::data(Size i) const {
-    QL_REQUIRE(files_.empty(), "Member function InMemoryReport::data() is not supported "
-        "when buffering is active");
-    QL_REQUIRE(data_[i].size() == rows(), "internal error: report column "
-                                              << i << " (" << header(i) << ") contains " << data_[i].size()
+Size InMemoryReport::columnSize(Size i) const {
+    const Column& c = data_[i];
+    return c.sizes.size() + c.reals.size() + c.strings.size() + c.dates.size() + c.periods.size();
+}
+
+Size InMemoryReport::intern(const string& s) {
+    auto r = stringIndex_.emplace(s, strings_.size());
+    if (r.second)
+        strings_.push_back(r.first->first);
+    return r.first->second;
+}
+
+void InMemoryReport::clearColumns() {
+    for (auto& c : data_)
+        c = Column();
+    strings_.clear();
+    stringIndex_.clear();
+}
+
+void InMemoryReport::checkBuffering(const std::string& method) const {
+    QL_REQUIRE(files_.empty(), "Member function InMemoryReport::" << method
+                                                                  << "() is not supported when buffering is active");
+}
+
+vector<Report::ReportType> InMemoryReport::data(Size i) const {
+    checkBuffering("data");
+    QL_REQUIRE(columnSize(i) == rows(), "internal error: report column "
+                                              << i << " (" << header(i) << ") contains " << columnSize(i)
                                               << " rows, expected are " << rows()
                                               << " rows, report headers are: " << boost::join(headers_, ","));
-    return data_[i];
+    vector<ReportType> result;
+    result.reserve(rows());
+    for (Size j = 0; j < rows(); ++j)
+        result.push_back(value(data_[i], strings_, i, j));
+    return result;
+}
+
+Report::ReportType InMemoryReport::value(const Column& c, const vector<string>& strings, Size i, Size j) const {
+    switch (columnTypes_[i].which()) {
+    case SizeType:
+        return c.sizes.at(j);
+    case RealType:
+        return c.reals.at(j);
+    case StringType:
+        return strings.at(c.strings.at(j));
+    case DateType:
+        return c.dates.at(j);
+    case PeriodType:
+        return c.periods.at(j);
+    default:
+        QL_FAIL("InMemoryReport::value(): unexpected report type " << columnTypes_[i].which());
+    }
+}
+
+Report::ReportType InMemoryReport::value(Size i, Size j) const {
+    checkBuffering("value");
+    return value(data_.at(i), strings_, i, j);
+}
+
+const vector<Size>& InMemoryReport::dataAsSize(Size i) const {
+    checkBuffering("dataAsSize");
+    QL_REQUIRE(columnTypes_.at(i).which() == SizeType, "InMemoryReport: column " << header(i) << " is not of type Size");
+    return data_[i].sizes;
+}
+
+const vector<Real>& InMemoryReport::dataAsReal(Size i) const {
+    checkBuffering("dataAsReal");
+    QL_REQUIRE(columnTypes_.at(i).which() == RealType, "InMemoryReport: column " << header(i) << " is not of type Real");
+    return data_[i].reals;
+}
+
+const vector<Date>& InMemoryReport::dataAsDate(Size i) const {
+    checkBuffering("dataAsDate");
+    QL_REQUIRE(columnTypes_.at(i).which() == DateType, "InMemoryReport: column " << header(i) << " is not of type Date");
+    return data_[i].dates;
+}
+
+const vector<Period>& InMemoryReport::dataAsPeriod(Size i) const {
+    checkBuffering("dataAsPeriod");
+    QL_REQUIRE(columnTypes_.at(i).which() == PeriodType,
+               "InMemoryReport: column " << header(i) << " is not of type Period");
+    return data_[i].periods;
+}
+
+const string& InMemoryReport::dataAsString(Size i, Size j) const {
+    checkBuffering("dataAsString");
+    QL_REQUIRE(columnTypes_.at(i).which() == StringType,
+               "InMemoryReport: column " << header(i) << " is not of type string");
+    return strings_[data_[i].strings.at(j)];
+}
+
+void InMemoryReport::writeColumns(std::ostream& os, const vector<Column>& columns,
+                                  const vector<string>& strings) const {
+    boost::archive::binary_oarchive oa(os, boost::archive::no_header);
+    oa << strings;
+    for (auto const& c : columns)
+        oa << c;
+}
+
+void InMemoryReport::readColumns(std::istream& is, vector<Column>& columns, vector<string>& strings) const {
+    boost::archive::binary_iarchive ia(is, boost::archive::no_header);
+    ia >> strings;
+    for (auto& c : columns)
+        ia >> c;
 }
 
 void InMemoryReport::toFile(const string& filename, const char sep, const bool commentCharacter, char quoteChar,
@@ -126,35 +252,86 @@ void InMemoryReport::toFile(const string& filename, const char sep, const bool c
     auto numColumns = columns();
     if (numColumns > 0) {
 
-        for (auto &f : files_) {
-            vector<vector<ReportType>> data(numColumns);
-            std::ifstream is(f.c_str(), std::ios::binary);
-            boost::archive::binary_iarchive ia(is, boost::archive::no_header);
-            for (Size i = 0; i < numColumns; i++) {
-                ia >> data[i];
-            }
-            is.close();
-
-            for (Size i = 0; i < data[0].size(); i++) {
+        auto write = [this, &cReport, numColumns](const vector<Column>& data, const vector<string>& strings) {
+            Size numRows = data[0].sizes.size() + data[0].reals.size() + data[0].strings.size() +
+                           data[0].dates.size() + data[0].periods.size();
+            for (Size i = 0; i < numRows; i++) {
                 cReport.next();
                 for (Size j = 0; j < numColumns; j++) {
-                    cReport.add(data[j][i]);
+                    cReport.add(value(data[j], strings, j, i));
                 }
             }
-        }
-
-        auto numRows = data_[0].size();
+        };
 
-        for (Size i = 0; i < numRows; i++) {
-            cReport.next();
-            for (Size j = 0; j < numColumns; j++) {
-                cReport.add(data_[j][i]);
-            }
+        for (auto &f : files_) {
+            vector<Column> data(numColumns);
+            vector<string> strings;
+            std::ifstream is(f.c_str(), std::ios::binary);
+            readColumns(is, data, strings);
+            is.close();
+            write(data, strings);
         }
+
+        write(data_, strings_);
     }
 
     cReport.end();
 }
 
+void InMemoryReport::toBinaryFile(const string& filename) const {
+    std::ofstream os(filename.c_str(), std::ios::binary);
+    QL_REQUIRE(os.is_open(), "InMemoryReport::toBinaryFile(): could not open file '" << filename << "'");
+    boost::archive::binary_oarchive oa(os, boost::archive::no_header);
+    oa << headers_;
+    oa << columnTypes_;
+    oa << columnPrecision_;
+    // spilled chunks are copied as they are, followed by the data in memory, each chunk with its string table
+    Size chunks = files_.size() + 1;
+    oa << chunks;
+    for (auto const& f : files_) {
+        vector<Column> data(columns());
+        vector<string> strings;
+        std::ifstream is(f.c_str(), std::ios::binary);
+        readColumns(is, data, strings);
+        oa << strings;
+        for (auto const& c : data)
+            oa << c;
+    }
+    oa << strings_;
+    for (auto const& c : data_)
+        oa << c;
+}
+
+void InMemoryReport::fromBinaryFile(const string& filename) {
+    QL_REQUIRE(headers_.empty(), "InMemoryReport::fromBinaryFile(): report is not empty");
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    QL_REQUIRE(is.is_open(), "InMemoryReport::fromBinaryFile(): could not open file '" << filename << "'");
+    boost::archive::binary_iarchive ia(is, boost::archive::no_header);
+    ia >> headers_;
+    ia >> columnTypes_;
+    ia >> columnPrecision_;
+    data_.resize(headers_.size());
+    Size chunks;
+    ia >> chunks;
+    for (Size k = 0; k < chunks; ++k) {
+        vector<Column> data(columns());
+        vector<string> strings;
+        ia >> strings;
+        for (auto& c : data)
+            ia >> c;
+        for (Size i = 0; i < columns(); ++i) {
+            Column& c = data_[i];
+            c.sizes.insert(c.sizes.end(), data[i].sizes.begin(), data[i].sizes.end());
+            c.reals.insert(c.reals.end(), data[i].reals.begin(), data[i].reals.end());
+            // map the chunk's string indices to the report's string table
+            for (auto s : data[i].strings)
+                c.strings.push_back(intern(strings.at(s)));
+            c.dates.insert(c.dates.end(), data[i].dates.begin(), data[i].dates.end());
+            c.periods.insert(c.periods.end(), data[i].periods.begin(), data[i].periods.end());
+        }
+    }
+    i_ = columns();
+}
+
 } // namespace data
 } // namespace ore
@@ -27,6 +27,8 @@
 #include <ored/report/report.hpp>
 #include <ql/errors.hpp>
 #include <ql/tuple.hpp>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace ore {
@@ -36,6 +38,11 @@ using std::vector;
 
 /*! InMemoryReport just stores report information in local vectors and provides an interface to access
  *  the values. It could be used as a backend to a GUI
+
+    The data is stored column-wise in typed vectors, strings are interned in a table shared by all columns, so that
+    no boost::variant is stored per cell. The typed accessors give direct access to the column data, data() returns
+    a copy of a column as ReportType values. If more than bufferSize rows are added, the data is spilled to temporary
+    files in a binary columnar format, together with the strings it refers to, and the string table is cleared.
  \ingroup report
  */
 class InMemoryReport : public Report {
@@ -50,24 +57,57 @@ public:
 
     // InMemoryInterface
     Size columns() const { return headers_.size(); }
-    Size rows() const { return columns() == 0 ? 0 : files_.size() * bufferSize_ + data_[0].size(); }
+    Size rows() const { return columns() == 0 ? 0 : files_.size() * bufferSize_ + columnSize(0); }
     const string& header(Size i) const { return headers_[i]; }
     bool hasHeader(string h) const { return std::find(headers_.begin(), headers_.end(), h) != headers_.end(); }
     ReportType columnType(Size i) const { return columnTypes_[i]; }
     Size columnPrecision(Size i) const { return columnPrecision_[i]; }
-    //! Returns the data
-    const vector<ReportType>& data(Size i) const;
+    //! Returns a copy of column i, use value() or the typed accessors to avoid the copy
+    vector<ReportType> data(Size i) const;
+    //! Returns the value in column i and row j
+    ReportType value(Size i, Size j) const;
+    //! \name Typed column access, not supported when buffering is active
+    //@{
+    const vector<Size>& dataAsSize(Size i) const;
+    const vector<Real>& dataAsReal(Size i) const;
+    const vector<Date>& dataAsDate(Size i) const;
+    const vector<Period>& dataAsPeriod(Size i) const;
+    const string& dataAsString(Size i, Size j) const;
+    //@}
     void toFile(const string& filename, const char sep = ',', const bool commentCharacter = true, char quoteChar = '\0',
                 const string& nullString = "#N/A", bool lowerHeader = false);
+    //! Write the report to a file in binary columnar format
+    void toBinaryFile(const string& filename) const;
+    //! Read a report written by toBinaryFile(), the report must be empty
+    void fromBinaryFile(const string& filename);
     void jumpToColumn(Size i) { i_ = i; }
 
 private:
+    struct Column {
+        vector<Size> sizes;
+        vector<Real> reals;
+        vector<Size> strings;
+        vector<Date> dates;
+        vector<Period> periods;
+        template <class Archive> void serialize(Archive& ar, const unsigned int version);
+    };
+    Size columnSize(Size i) const;
+    Size intern(const string& s);
+    void clearColumns();
+    void checkBuffering(const std::string& method) const;
+    void writeColumns(std::ostream& os, const vector<Column>& columns, const vector<string>& strings) const;
+    void readColumns(std::istream& is, vector<Column>& columns, vector<string>& strings) const;
+    ReportType value(const Column& c, const vector<string>& strings, Size i, Size j) const;
+
     Size i_;
     Size bufferSize_;
     vector<string> headers_;
     vector<ReportType> columnTypes_;
     vector<Size> columnPrecision_;
-    vector<vector<ReportType>> data_;
+    vector<Column> data_;
+    // strings referenced by the columns in memory, each spilled file has its own table
+    vector<string> strings_;
+    std::unordered_map<string, Size> stringIndex_;
     vector<string> files_;
 };
 
@@ -87,22 +127,32 @@ public:
     vector<Date> dataAsDate(Size i) const { return data_T<Date>(i, 3); }
     vector<Period> dataAsPeriod(Size i) const { return data_T<Period>(i, 4); }
     // for convenience, access by row j and column i
-    Size rows() const { return columns() == 0 ? 0 : imReport_->data(0).size(); }
-    int dataAsSize(Size j, Size i) const { return int(boost::get<Size>(imReport_->data(i).at(j))); }
-    Real dataAsReal(Size j, Size i) const { return boost::get<Real>(imReport_->data(i).at(j)); }
-    string dataAsString(Size j, Size i) const { return boost::get<string>(imReport_->data(i).at(j)); }
-    Date dataAsDate(Size j, Size i) const { return boost::get<Date>(imReport_->data(i).at(j)); }
-    Period dataAsPeriod(Size j, Size i) const { return boost::get<Period>(imReport_->data(i).at(j)); }
+    Size rows() const { return imReport_->rows(); }
+    int dataAsSize(Size j, Size i) const { return int(imReport_->dataAsSize(i).at(j)); }
+    Real dataAsReal(Size j, Size i) const { return imReport_->dataAsReal(i).at(j); }
+    string dataAsString(Size j, Size i) const { return imReport_->dataAsString(i, j); }
+    Date dataAsDate(Size j, Size i) const { return imReport_->dataAsDate(i).at(j); }
+    Period dataAsPeriod(Size j, Size i) const { return imReport_->dataAsPeriod(i).at(j); }
 
 private:
     template <typename T> vector<T> data_T(Size i, Size w) const {
         QL_REQUIRE(columnType(i) == w,
                    "PlainTypeInMemoryReport::data_T(column=" << i << ",expectedType=" << w
                    << "): Type mismatch, have " << columnType(i));
-        vector<T> tmp;
-        for(auto const& d: imReport_->data(i))
-            tmp.push_back(boost::get<T>(d));
-        return tmp;
+        if constexpr (std::is_same_v<T, string>) {
+            vector<string> tmp;
+            for (Size j = 0; j < rows(); ++j)
+                tmp.push_back(imReport_->dataAsString(i, j));
+            return tmp;
+        } else if constexpr (std::is_same_v<T, Size>) {
+            return imReport_->dataAsSize(i);
+        } else if constexpr (std::is_same_v<T, Real>) {
+            return imReport_->dataAsReal(i);
+        } else if constexpr (std::is_same_v<T, Date>) {
+            return imReport_->dataAsDate(i);
+        } else {
+            return imReport_->dataAsPeriod(i);
+        }
     }
     vector<int> sizeToInt(const vector<Size>& v) const {
         std::vector<int> vi;
@@ -34,6 +34,7 @@
 #include <ql/shared_ptr.hpp>
 
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -45,6 +46,8 @@ using namespace QuantLib;
 struct ASTNode;
 using ASTNodePtr = QuantLib::ext::shared_ptr<ASTNode>;
 
+struct ExpressionProgram;
+
 struct LocationInfo {
     LocationInfo() : initialised(false) {}
     LocationInfo(const Size lineStart, const Size columnStart, const Size lineEnd, const Size columnEnd)
@@ -62,6 +65,10 @@ struct ASTNode {
     virtual void accept(AcyclicVisitor&);
     LocationInfo locationInfo;
     std::vector<ASTNodePtr> args;
+    // cache for the compiled form of expression nodes (see astcompiler.hpp), independent of the context; cached
+    // ASTs are shared between trades which may run concurrently, so the program is only set under programOnce
+    QuantLib::ext::shared_ptr<ExpressionProgram> program;
+    std::once_flag programOnce;
 };
 
 struct OperatorPlusNode : public ASTNode {
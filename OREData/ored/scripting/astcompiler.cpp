@@ -0,0 +1,165 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <ored/scripting/astcompiler.hpp>
+
+#include <ql/errors.hpp>
+
+namespace ore {
+namespace data {
+
+namespace {
+using OpCode = ExpressionProgram::OpCode;
+
+class ASTCompiler : public AcyclicVisitor,
+                    public Visitor<ASTNode>,
+                    public Visitor<OperatorPlusNode>,
+                    public Visitor<OperatorMinusNode>,
+                    public Visitor<OperatorMultiplyNode>,
+                    public Visitor<OperatorDivideNode>,
+                    public Visitor<NegateNode>,
+                    public Visitor<FunctionAbsNode>,
+                    public Visitor<FunctionExpNode>,
+                    public Visitor<FunctionLogNode>,
+                    public Visitor<FunctionSqrtNode>,
+                    public Visitor<FunctionNormalCdfNode>,
+                    public Visitor<FunctionNormalPdfNode>,
+                    public Visitor<FunctionMinNode>,
+                    public Visitor<FunctionMaxNode>,
+                    public Visitor<FunctionPowNode>,
+                    public Visitor<ConstantNumberNode>,
+                    public Visitor<VariableNode>,
+                    public Visitor<ConditionEqNode>,
+                    public Visitor<ConditionNeqNode>,
+                    public Visitor<ConditionLtNode>,
+                    public Visitor<ConditionLeqNode>,
+                    public Visitor<ConditionGtNode>,
+                    public Visitor<ConditionGeqNode>,
+                    public Visitor<ConditionNotNode>,
+                    public Visitor<ConditionAndNode>,
+                    public Visitor<ConditionOrNode> {
+public:
+    // if dryRun is true, we only determine whether the visited node is a compilable expression
+    ASTCompiler(ExpressionProgram& program, const bool dryRun = false) : program_(program), dryRun_(dryRun) {}
+
+    bool compilable = false;
+
+    Size compile(ASTNode& n) {
+        n.accept(*this);
+        return program_.code.size() - 1;
+    }
+
+    void visit(ASTNode& n) override { emit(OpCode::Evaluate, n); }
+
+    void visit(OperatorPlusNode& n) override { binary(OpCode::Plus, n); }
+    void visit(OperatorMinusNode& n) override { binary(OpCode::Minus, n); }
+    void visit(OperatorMultiplyNode& n) override { binary(OpCode::Multiply, n); }
+    void visit(OperatorDivideNode& n) override { binary(OpCode::Divide, n); }
+    void visit(NegateNode& n) override { unary(OpCode::Negate, n); }
+    void visit(FunctionAbsNode& n) override { unary(OpCode::Abs, n); }
+    void visit(FunctionExpNode& n) override { unary(OpCode::Exp, n); }
+    void visit(FunctionLogNode& n) override { unary(OpCode::Log, n); }
+    void visit(FunctionSqrtNode& n) override { unary(OpCode::Sqrt, n); }
+    void visit(FunctionNormalCdfNode& n) override { unary(OpCode::NormalCdf, n); }
+    void visit(FunctionNormalPdfNode& n) override { unary(OpCode::NormalPdf, n); }
+    void visit(FunctionMinNode& n) override { binary(OpCode::Min, n); }
+    void visit(FunctionMaxNode& n) override { binary(OpCode::Max, n); }
+    void visit(FunctionPowNode& n) override { binary(OpCode::Pow, n); }
+
+    void visit(ConditionEqNode& n) override { binary(OpCode::Eq, n); }
+    void visit(ConditionNeqNode& n) override { binary(OpCode::Neq, n); }
+    void visit(ConditionLtNode& n) override { binary(OpCode::Lt, n); }
+    void visit(ConditionLeqNode& n) override { binary(OpCode::Leq, n); }
+    void visit(ConditionGtNode& n) override { binary(OpCode::Gt, n); }
+    void visit(ConditionGeqNode& n) override { binary(OpCode::Geq, n); }
+    void visit(ConditionNotNode& n) override { unary(OpCode::Not, n); }
+    void visit(ConditionAndNode& n) override { shortCut(OpCode::SkipIfFalse, OpCode::And, n); }
+    void visit(ConditionOrNode& n) override { shortCut(OpCode::SkipIfTrue, OpCode::Or, n); }
+
+    void visit(ConstantNumberNode& n) override {
+        emit(OpCode::Constant, n);
+        program_.code.back().value = n.value;
+    }
+
+    // variables are resolved by the runner, which caches the context lookup in the node
+    void visit(VariableNode& n) override { emit(OpCode::Variable, n); }
+
+private:
+    void emit(const OpCode op, ASTNode& n, const Size left = 0, const Size right = 0) {
+        ExpressionProgram::Instruction i;
+        i.op = op;
+        i.node = &n;
+        i.left = left;
+        i.right = right;
+        program_.code.push_back(i);
+    }
+
+    void unary(const OpCode op, ASTNode& n) {
+        if (dryRun_) {
+            compilable = true;
+            return;
+        }
+        Size arg = compile(*n.args[0]);
+        emit(op, n, arg);
+    }
+
+    void binary(const OpCode op, ASTNode& n) {
+        if (dryRun_) {
+            compilable = true;
+            return;
+        }
+        Size left = compile(*n.args[0]);
+        Size right = compile(*n.args[1]);
+        emit(op, n, left, right);
+    }
+
+    void shortCut(const OpCode skip, const OpCode op, ASTNode& n) {
+        if (dryRun_) {
+            compilable = true;
+            return;
+        }
+        Size left = compile(*n.args[0]);
+        emit(skip, n, left);
+        Size skipPos = program_.code.size() - 1;
+        Size right = compile(*n.args[1]);
+        emit(op, n, left, right);
+        program_.code[skipPos].next = program_.code.size();
+    }
+
+    ExpressionProgram& program_;
+    const bool dryRun_;
+};
+} // namespace
+
+bool isCompilableExpression(ASTNode& n) {
+    ExpressionProgram p;
+    ASTCompiler c(p, true);
+    n.accept(c);
+    return c.compilable;
+}
+
+ExpressionProgram compileExpression(ASTNode& n) {
+    QL_REQUIRE(isCompilableExpression(n), "compileExpression(): node is not a compilable expression");
+    ExpressionProgram p;
+    ASTCompiler c(p);
+    c.compile(n);
+    return p;
+}
+
+} // namespace data
+} // namespace ore
@@ -0,0 +1,86 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file ored/scripting/astcompiler.hpp
+    \brief compiles expressions in an ast to a linear register program
+    \ingroup utilities
+*/
+
+#pragma once
+
+#include <ored/scripting/ast.hpp>
+
+#include <vector>
+
+namespace ore {
+namespace data {
+
+/*! Linear register program for an expression subtree of an AST. The result of instruction k is stored in register k,
+    the result of the whole expression in the last register. Arithmetic, condition and logical operators, constants
+    and variables are compiled, all other nodes (e.g. model functions like PAY or NPV) are kept as Evaluate
+    instructions which are delegated back to the AST runner. */
+struct ExpressionProgram {
+    enum class OpCode {
+        Constant,
+        Variable,
+        Evaluate,
+        Plus,
+        Minus,
+        Multiply,
+        Divide,
+        Negate,
+        Abs,
+        Exp,
+        Log,
+        Sqrt,
+        NormalCdf,
+        NormalPdf,
+        Min,
+        Max,
+        Pow,
+        Eq,
+        Neq,
+        Lt,
+        Leq,
+        Gt,
+        Geq,
+        Not,
+        And,
+        Or,
+        // if the condition in register left is deterministically false (true), set register next - 1 to false
+        // (true) and continue with instruction next, implementing the short cut of AND (OR)
+        SkipIfFalse,
+        SkipIfTrue
+    };
+    struct Instruction {
+        OpCode op;
+        ASTNode* node;
+        Size left = 0, right = 0, next = 0;
+        double value = 0.0;
+    };
+    std::vector<Instruction> code;
+};
+
+//! true if the node is an operator, function or condition node that can be compiled to an ExpressionProgram
+bool isCompilableExpression(ASTNode& n);
+
+//! compile the expression rooted at \p n, requires isCompilableExpression(n)
+ExpressionProgram compileExpression(ASTNode& n);
+
+} // namespace data
+} // namespace ore
@@ -16,6 +16,7 @@
  FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
 */
 
+#include <ored/scripting/astcompiler.hpp>
 #include <ored/scripting/astresetter.hpp>
 #include <ored/scripting/safestack.hpp>
 #include <ored/scripting/scriptengine.hpp>
@@ -117,6 +118,8 @@ public:
 
     template <typename R>
     void binaryOp(ASTNode& n, const std::string& name, const std::function<R(ValueType, ValueType)>& op) {
+        if (runCompiled(n))
+            return;
         n.args[0]->accept(*this);
         n.args[1]->accept(*this);
         checkpoint(n);
@@ -127,6 +130,8 @@ public:
     }
 
     template <typename R> void unaryOp(ASTNode& n, const std::string& name, const std::function<R(ValueType)>& op) {
+        if (runCompiled(n))
+            return;
         n.args[0]->accept(*this);
         checkpoint(n);
         auto arg = value.pop();
@@ -134,6 +139,171 @@ public:
         TRACE(name << "( " << arg << " )", n);
     }
 
+    // run the compiled program of an expression node, returns false if the tree walk should be used instead
+
+    template <typename RV, typename V>
+    static void numberOp(ValueType& target, ValueType& x, const ValueType& y, RV rvOp, V op) {
+        if (x.which() == ValueTypeWhich::Number && y.which() == ValueTypeWhich::Number)
+            target = rvOp(std::move(QuantLib::ext::get<RandomVariable>(x)), QuantLib::ext::get<RandomVariable>(y));
+        else
+            target = op(x, y);
+    }
+
+    template <typename RV, typename V> static void numberOp(ValueType& target, ValueType& x, RV rvOp, V op) {
+        if (x.which() == ValueTypeWhich::Number)
+            target = rvOp(std::move(QuantLib::ext::get<RandomVariable>(x)));
+        else
+            target = op(x);
+    }
+
+    bool runCompiled(ASTNode& n) {
+        // the tree walk is needed to trace single nodes in interactive mode
+        if (interactive_)
+            return false;
+        std::call_once(n.programOnce,
+                       [&n]() { n.program = QuantLib::ext::make_shared<ExpressionProgram>(compileExpression(n)); });
+        using OpCode = ExpressionProgram::OpCode;
+        const auto& code = n.program->code;
+        // registers are consumed exactly once, so operands can be moved from
+        std::vector<ValueType> reg(code.size());
+        for (Size pc = 0; pc < code.size(); ++pc) {
+            const auto& i = code[pc];
+            checkpoint(*i.node);
+            switch (i.op) {
+            case OpCode::Constant:
+                reg[pc] = RandomVariable(size_, i.value);
+                break;
+            case OpCode::Variable:
+                reg[pc] = getVariableRef(static_cast<VariableNode&>(*i.node)).first;
+                break;
+            case OpCode::Evaluate:
+                i.node->accept(*this);
+                reg[pc] = value.pop();
+                break;
+            case OpCode::Plus:
+                numberOp(
+                    reg[pc], reg[i.left], reg[i.right],
+                    [](RandomVariable x, const RandomVariable& y) { return std::move(x) + y; },
+                    [](const ValueType& x, const ValueType& y) { return x + y; });
+                break;
+            case OpCode::Minus:
+                numberOp(
+                    reg[pc], reg[i.left], reg[i.right],
+                    [](RandomVariable x, const RandomVariable& y) { return std::move(x) - y; },
+                    [](const ValueType& x, const ValueType& y) { return x - y; });
+                break;
+            case OpCode::Multiply:
+                numberOp(
+                    reg[pc], reg[i.left], reg[i.right],
+                    [](RandomVariable x, const RandomVariable& y) { return std::move(x) * y; },
+                    [](const ValueType& x, const ValueType& y) { return x * y; });
+                break;
+            case OpCode::Divide:
+                numberOp(
+                    reg[pc], reg[i.left], reg[i.right],
+                    [](RandomVariable x, const RandomVariable& y) { return std::move(x) / y; },
+                    [](const ValueType& x, const ValueType& y) { return x / y; });
+                break;
+            case OpCode::Min:
+                numberOp(
+                    reg[pc], reg[i.left], reg[i.right],
+                    [](RandomVariable x, const RandomVariable& y) { return QuantExt::min(std::move(x), y); },
+                    [](const ValueType& x, const ValueType& y) { return min(x, y); });
+                break;
+            case OpCode::Max:
+                numberOp(
+                    reg[pc], reg[i.left], reg[i.right],
+                    [](RandomVariable x, const RandomVariable& y) { return QuantExt::max(std::move(x), y); },
+                    [](const ValueType& x, const ValueType& y) { return max(x, y); });
+                break;
+            case OpCode::Pow:
+                numberOp(
+                    reg[pc], reg[i.left], reg[i.right],
+                    [](RandomVariable x, const RandomVariable& y) { return QuantExt::pow(std::move(x), y); },
+                    [](const ValueType& x, const ValueType& y) { return pow(x, y); });
+                break;
+            case OpCode::Negate:
+                numberOp(
+                    reg[pc], reg[i.left], [](RandomVariable x) { return -std::move(x); },
+                    [](const ValueType& x) { return -x; });
+                break;
+            case OpCode::Abs:
+                numberOp(
+                    reg[pc], reg[i.left], [](RandomVariable x) { return QuantExt::abs(std::move(x)); },
+                    [](const ValueType& x) { return abs(x); });
+                break;
+            case OpCode::Exp:
+                numberOp(
+                    reg[pc], reg[i.left], [](RandomVariable x) { return QuantExt::exp(std::move(x)); },
+                    [](const ValueType& x) { return exp(x); });
+                break;
+            case OpCode::Log:
+                numberOp(
+                    reg[pc], reg[i.left], [](RandomVariable x) { return QuantExt::log(std::move(x)); },
+                    [](const ValueType& x) { return log(x); });
+                break;
+            case OpCode::Sqrt:
+                numberOp(
+                    reg[pc], reg[i.left], [](RandomVariable x) { return QuantExt::sqrt(std::move(x)); },
+                    [](const ValueType& x) { return sqrt(x); });
+                break;
+            case OpCode::NormalCdf:
+                numberOp(
+                    reg[pc], reg[i.left], [](RandomVariable x) { return QuantExt::normalCdf(std::move(x)); },
+                    [](const ValueType& x) { return normalCdf(x); });
+                break;
+            case OpCode::NormalPdf:
+                numberOp(
+                    reg[pc], reg[i.left], [](RandomVariable x) { return QuantExt::normalPdf(std::move(x)); },
+                    [](const ValueType& x) { return normalPdf(x); });
+                break;
+            case OpCode::Eq:
+                reg[pc] = equal(reg[i.left], reg[i.right]);
+                break;
+            case OpCode::Neq:
+                reg[pc] = notequal(reg[i.left], reg[i.right]);
+                break;
+            case OpCode::Lt:
+                reg[pc] = lt(reg[i.left], reg[i.right]);
+                break;
+            case OpCode::Leq:
+                reg[pc] = leq(reg[i.left], reg[i.right]);
+                break;
+            case OpCode::Gt:
+                reg[pc] = gt(reg[i.left], reg[i.right]);
+                break;
+            case OpCode::Geq:
+                reg[pc] = geq(reg[i.left], reg[i.right]);
+                break;
+            case OpCode::Not:
+                reg[pc] = logicalNot(reg[i.left]);
+                break;
+            case OpCode::And:
+                reg[pc] = logicalAnd(reg[i.left], reg[i.right]);
+                break;
+            case OpCode::Or:
+                reg[pc] = logicalOr(reg[i.left], reg[i.right]);
+                break;
+            case OpCode::SkipIfFalse:
+            case OpCode::SkipIfTrue: {
+                QL_REQUIRE(reg[i.left].which() == ValueTypeWhich::Filter, "expected condition");
+                const Filter& l = QuantLib::ext::get<Filter>(reg[i.left]);
+                bool shortCutValue = i.op == OpCode::SkipIfTrue;
+                if (l.deterministic() && l[0] == shortCutValue) {
+                    reg[i.next - 1] = Filter(l.size(), shortCutValue);
+                    pc = i.next - 1;
+                }
+                break;
+            }
+            default:
+                QL_FAIL("internal error: unhandled op code " << static_cast<int>(i.op));
+            }
+        }
+        checkpoint(n);
+        value.push(std::move(reg.back()));
+        return true;
+    }
+
     // get ref to context variable + index (0 for scalars, 0,1,2,... for arrays)
 
     std::pair<ValueType&, long> getVariableRef(VariableNode& v) {
@@ -250,6 +420,8 @@ public:
     }
 
     void visit(ConditionAndNode& n) override {
+        if (runCompiled(n))
+            return;
         n.args[0]->accept(*this);
         auto left = value.pop();
         checkpoint(n);
@@ -270,6 +442,8 @@ public:
     }
 
     void visit(ConditionOrNode& n) override {
+        if (runCompiled(n))
+            return;
         n.args[0]->accept(*this);
         auto left = value.pop();
         checkpoint(n);
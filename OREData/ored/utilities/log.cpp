@@ -31,7 +31,9 @@
 #include <boost/log/support/date_time.hpp>
 #include <boost/log/sources/severity_feature.hpp>
 #include <boost/phoenix/bind/bind_function.hpp>
+#include <algorithm>
 #include <iomanip>
+#include <iterator>
 #include <ored/utilities/log.hpp>
 #include <ored/utilities/to_string.hpp>
 #include <ql/errors.hpp>
@@ -275,6 +277,8 @@ Log::Log() : loggers_(), enabled_(false), mask_(255), ls_() {
     ls_.setf(ios::showpoint);
 }
 
+Log::~Log() { stopWriter(); }
+
 void Log::registerLogger(const QuantLib::ext::shared_ptr<Logger>& logger) {
     boost::unique_lock<boost::shared_mutex> lock(mutex_);
     QL_REQUIRE(loggers_.find(logger->name()) == loggers_.end(),
@@ -318,6 +322,7 @@ QuantLib::ext::shared_ptr<IndependentLogger>& Log::independentLogger(const strin
 }
 
 void Log::removeLogger(const string& name) {
+    flush();
     boost::unique_lock<boost::shared_mutex> lock(mutex_);
     map<string, QuantLib::ext::shared_ptr<Logger>>::iterator it = loggers_.find(name);
     if (it != loggers_.end()) {
@@ -339,6 +344,7 @@ void Log::removeIndependentLogger(const string& name) {
 }
 
 void Log::removeAllLoggers() {
+    flush();
     boost::unique_lock<boost::shared_mutex> lock(mutex_);
     loggers_.clear();
     logging::core::get()->remove_all_sinks();
@@ -372,14 +378,19 @@ string Log::source(const char* filename, int lineNo) const {
 void Log::addExcludeFilter(const string& key, const std::function<bool(const std::string&)> func) {
     boost::unique_lock<boost::shared_mutex> lock(mutex_);
     excludeFilters_[key] = func;
+    hasExcludeFilters_ = true;
 }
 
 void Log::removeExcludeFilter(const string& key) {
     boost::unique_lock<boost::shared_mutex> lock(mutex_);
     excludeFilters_.erase(key);
+    hasExcludeFilters_ = !excludeFilters_.empty();
 }
 
 bool Log::checkExcludeFilters(const std::string& msg) {
+    // avoid the lock in the common case where no filters are set
+    if (!hasExcludeFilters_)
+        return false;
     boost::shared_lock<boost::shared_mutex> lock(mutex_);
     for (const auto& f : excludeFilters_) {
         if (f.second(msg))
@@ -389,6 +400,10 @@ bool Log::checkExcludeFilters(const std::string& msg) {
 }
 
 void Log::header(unsigned m, const char* filename, int lineNo) {
+    header(m, filename, lineNo, microsec_clock::local_time());
+}
+
+void Log::header(unsigned m, const char* filename, int lineNo, const ptime& time) {
     // 1. Reset stringstream
     ls_.str(string());
     ls_.clear();
@@ -425,7 +440,7 @@ void Log::header(unsigned m, const char* filename, int lineNo) {
     // Timestamp
     // Use boost::posix_time microsecond clock to get better precision (when available).
     // format is "2014-Apr-04 11:10:16.179347"
-    ls_ << '[' << to_simple_string(microsec_clock::local_time()) << ']';
+    ls_ << '[' << to_simple_string(time) << ']';
 
     // Filename & line no
     // format is " (file:line)"
@@ -466,6 +481,139 @@ void Log::log(unsigned m) {
     }
 }
 
+void Log::log(unsigned m, const char* filename, int lineNo, const std::string& text) {
+    if (async_) {
+        ptime time = microsec_clock::local_time();
+        Buffer& buffer = threadBuffer();
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        // async_ is checked again under the buffer lock, so no message is queued after the writer has collected the
+        // buffers on stop. The sequence number is drawn under the buffer lock as well, so that a message with a
+        // smaller sequence number than seq_ is always visible to the writer.
+        if (async_) {
+            buffer.records.push_back({seq_++, m, filename, lineNo, time, text});
+            return;
+        }
+    }
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
+    header(m, filename, lineNo);
+    ls_ << text;
+    log(m);
+}
+
+Log::Buffer& Log::threadBuffer() {
+    thread_local std::shared_ptr<Buffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<Buffer>();
+        std::lock_guard<std::mutex> lock(buffersMutex_);
+        buffers_.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void Log::collect(std::vector<Record>& records) {
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    for (auto b = buffers_.begin(); b != buffers_.end();) {
+        {
+            std::lock_guard<std::mutex> bufferLock((*b)->mutex);
+            std::move((*b)->records.begin(), (*b)->records.end(), std::back_inserter(records));
+            (*b)->records.clear();
+        }
+        // drop buffers of threads that have terminated
+        if (b->use_count() == 1)
+            b = buffers_.erase(b);
+        else
+            ++b;
+    }
+}
+
+void Log::dispatch(std::vector<Record>& records, bool all) {
+    // The buffers are not collected atomically, so a record with a smaller sequence number can arrive in a later
+    // collection. Records are therefore only dispatched up to the first missing sequence number, the others are kept
+    // until the gap is filled. When all is true no further records can arrive and everything is dispatched.
+    std::move(records.begin(), records.end(), std::back_inserter(pending_));
+    records.clear();
+    std::sort(pending_.begin(), pending_.end(), [](const Record& x, const Record& y) { return x.seq < y.seq; });
+    Size n = 0;
+    while (n < pending_.size() && (all || pending_[n].seq == nextSeq_))
+        nextSeq_ = pending_[n++].seq + 1;
+    if (n > 0) {
+        boost::unique_lock<boost::shared_mutex> lock(mutex_);
+        for (Size i = 0; i < n; ++i) {
+            const Record& r = pending_[i];
+            header(r.mask, r.filename, r.lineNo, r.time);
+            ls_ << r.text;
+            log(r.mask);
+        }
+    }
+    pending_.erase(pending_.begin(), pending_.begin() + n);
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        written_ = nextSeq_;
+    }
+    flushedCv_.notify_all();
+}
+
+void Log::writerLoop() {
+    std::vector<Record> records;
+    bool stop = false;
+    while (!stop) {
+        {
+            std::unique_lock<std::mutex> lock(writerMutex_);
+            writerCv_.wait_for(lock, std::chrono::milliseconds(50),
+                               [this] { return stopRequested_ || written_ < flushTarget_; });
+            stop = stopRequested_;
+        }
+        // async_ is false once stop is requested, so this collects the last queued messages in that case
+        collect(records);
+        dispatch(records, stop);
+    }
+}
+
+void Log::setAsync(bool async) {
+    if (async) {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        if (!writerRunning_) {
+            stopRequested_ = false;
+            writerRunning_ = true;
+            writer_ = std::thread(&Log::writerLoop, this);
+        }
+        async_ = true;
+    } else {
+        async_ = false;
+        stopWriter();
+    }
+}
+
+void Log::flush() {
+    std::unique_lock<std::mutex> lock(writerMutex_);
+    if (!writerRunning_)
+        return;
+    std::size_t target = seq_;
+    flushTarget_ = std::max(flushTarget_, target);
+    writerCv_.notify_one();
+    flushedCv_.wait(lock, [this, target] { return written_ >= target || !writerRunning_; });
+}
+
+void Log::stopWriter() {
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        if (!writerRunning_)
+            return;
+        stopRequested_ = true;
+    }
+    writerCv_.notify_one();
+    writer_.join();
+    // drain once more, the writer is stopped so this is the only thread dispatching records
+    std::vector<Record> records;
+    collect(records);
+    dispatch(records, true);
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        writerRunning_ = false;
+    }
+    flushedCv_.notify_all();
+}
+
 // --------
 
 LoggerStream::LoggerStream(unsigned mask, const char* filename, unsigned lineNo)
@@ -479,12 +627,8 @@ LoggerStream::~LoggerStream() {
     string text;
     while (getline(ss_, text)) {
         // we expand the MLOG macro here so we can overwrite __FILE__ and __LINE__
-        if (ore::data::Log::instance().enabled() && ore::data::Log::instance().filter(mask_)) {
-            boost::unique_lock<boost::shared_mutex> lock(ore::data::Log::instance().mutex());
-            ore::data::Log::instance().header(mask_, filename_, lineNo_);
-            ore::data::Log::instance().logStream() << text;
-            ore::data::Log::instance().log(mask_);
-        }
+        if (ore::data::Log::instance().enabled() && ore::data::Log::instance().filter(mask_))
+            ore::data::Log::instance().log(mask_, filename_, lineNo_, text);
     }
 }
 
@@ -33,10 +33,21 @@
 #define ORE_DATA 64    // 01000000  127
 #define ORE_MEMORY 128 // 10000000  255
 
+// compile time mask, log statements for levels not contained in this mask are removed by the compiler
+#ifndef ORE_LOG_COMPILE_MASK
+#define ORE_LOG_COMPILE_MASK 255
+#endif
+
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <time.h>
+#include <vector>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/log/attributes/mutable_constant.hpp>
@@ -64,6 +75,7 @@
 #include <sstream>
 
 #include <boost/any.hpp>
+#include <boost/date_time/posix_time/ptime.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/lock_types.hpp>
 
@@ -358,7 +370,13 @@ private:
   Once a message is received, it is immediately dispatched to each of the registered loggers, the order in which
   the loggers are called is not guaranteed.
 
-  Logging is done by the calling thread and the LOG call blocks until all the loggers have returned.
+  By default logging is done by the calling thread and the LOG call blocks until all the loggers have returned.
+
+  In asynchronous mode (see setAsync()) the calling thread only formats the message and appends it to a buffer
+  owned by this thread. A background writer thread collects the buffered messages, orders them by the sequence
+  in which they were logged and dispatches them to the loggers. Use flush() to wait until all messages logged so
+  far have reached the loggers, this is done implicitly when loggers are removed and when asynchronous mode is
+  switched off.
 
   At start up, the Log class has no loggers and so will ignore any LOG() messages until it is configured.
 
@@ -391,6 +409,8 @@ class Log : public QuantLib::Singleton<Log, std::integral_constant<bool, true>>
     friend class QuantLib::Singleton<Log, std::integral_constant<bool, true>>;
 
 public:
+    ~Log();
+
     //! Add a new Logger.
     /*!
       Adds a new logger to the Log class, the logger will be stored by it's Logger::name().
@@ -441,23 +461,22 @@ public:
     std::ostream& logStream() { return ls_; }
     //! macro utility function - do not use directly, not thread safe
     void log(unsigned m);
+    //! macro utility function - do not use directly, thread safe, dispatches or queues the given message
+    void log(unsigned m, const char* filename, int lineNo, const std::string& text);
 
     //! mutex to acquire locks
     boost::shared_mutex& mutex() { return mutex_; }
 
+    //! switch asynchronous logging on or off, switching it off flushes all pending messages
+    void setAsync(bool async);
+    bool async() const { return async_; }
+    //! block until all messages logged in asynchronous mode before the call are dispatched to the loggers
+    void flush();
+
     // Avoid a large number of warnings in VS by adding 0 !=
-    bool filter(unsigned mask) {
-        boost::shared_lock<boost::shared_mutex> lock(mutex());
-        return 0 != (mask & mask_);
-    }
-    unsigned mask() {
-        boost::shared_lock<boost::shared_mutex> lock(mutex());
-        return mask_;
-    }
-    void setMask(unsigned mask) {
-        boost::unique_lock<boost::shared_mutex> lock(mutex());
-        mask_ = mask;
-    }
+    bool filter(unsigned mask) const { return 0 != (mask & mask_); }
+    unsigned mask() const { return mask_; }
+    void setMask(unsigned mask) { mask_ = mask; }
     const boost::filesystem::path& rootPath() {
         boost::shared_lock<boost::shared_mutex> lock(mutex());
         return rootPath_;
@@ -475,18 +494,9 @@ public:
         maxLen_ = n;
     }
 
-    bool enabled() {
-        boost::shared_lock<boost::shared_mutex> lock(mutex());
-        return enabled_;
-    }
-    void switchOn() {
-        boost::unique_lock<boost::shared_mutex> lock(mutex());
-        enabled_ = true;
-    }
-    void switchOff() {
-        boost::unique_lock<boost::shared_mutex> lock(mutex());
-        enabled_ = false;
-    }
+    bool enabled() const { return enabled_; }
+    void switchOn() { enabled_ = true; }
+    void switchOff() { enabled_ = false; }
 
     bool writeSuppressedMessagesHint() {
         boost::shared_lock<boost::shared_mutex> lock(mutex());
@@ -499,13 +509,36 @@ public:
 private:
     Log();
 
+    //! a message queued in asynchronous mode
+    struct Record {
+        std::size_t seq;
+        unsigned mask;
+        const char* filename;
+        int lineNo;
+        boost::posix_time::ptime time;
+        std::string text;
+    };
+    //! per thread message buffer, the lock is only contended when the writer thread collects the messages
+    struct Buffer {
+        std::mutex mutex;
+        std::vector<Record> records;
+    };
+
     // not thread safe
     std::string source(const char* filename, int lineNo) const;
+    // not thread safe
+    void header(unsigned m, const char* filename, int lineNo, const boost::posix_time::ptime& time);
+
+    Buffer& threadBuffer();
+    void collect(std::vector<Record>& records);
+    void dispatch(std::vector<Record>& records, bool all);
+    void writerLoop();
+    void stopWriter();
 
     std::map<std::string, QuantLib::ext::shared_ptr<Logger>> loggers_;
     std::map<std::string, QuantLib::ext::shared_ptr<IndependentLogger>> independentLoggers_;
-    bool enabled_;
-    unsigned mask_;
+    std::atomic<bool> enabled_;
+    std::atomic<unsigned> mask_;
     boost::filesystem::path rootPath_;
     std::ostringstream ls_;
 
@@ -521,22 +554,41 @@ private:
     mutable boost::shared_mutex mutex_;
 
     std::map<std::string, std::function<bool(const std::string&)>> excludeFilters_;
+    std::atomic<bool> hasExcludeFilters_ = false;
+
+    // asynchronous mode
+    std::atomic<bool> async_ = false;
+    std::atomic<std::size_t> seq_ = 0;
+    std::vector<std::shared_ptr<Buffer>> buffers_;
+    std::mutex buffersMutex_;
+    std::thread writer_;
+    std::mutex writerMutex_;
+    std::condition_variable writerCv_, flushedCv_;
+    bool writerRunning_ = false, stopRequested_ = false;
+    // all records with a smaller sequence number are written, a flush waits until written_ reaches flushTarget_
+    std::size_t written_ = 0, flushTarget_ = 0;
+    // owned by the writer: collected records waiting for a missing sequence number and the next one to write
+    std::vector<Record> pending_;
+    std::size_t nextSeq_ = 0;
 };
 
+//! true if messages with the given mask are logged, this is a compile time constant false if the mask is excluded
+//! by ORE_LOG_COMPILE_MASK
+#define ORE_LOG_ENABLED(mask)                                                                                          \
+    (0 != ((mask)&ORE_LOG_COMPILE_MASK) && ore::data::Log::instance().enabled() &&                                     \
+     ore::data::Log::instance().filter(mask))
+
 /*!
   Main Logging macro, do not use this directly, use on of the below 6 macros instead
  */                               
 #define MLOG(mask, text)                                                                                               \
     {                                                                                                                  \
-        if (ore::data::Log::instance().enabled() && ore::data::Log::instance().filter(mask)) {                         \
+        if (ORE_LOG_ENABLED(mask)) {                                                                                   \
             std::ostringstream __ore_mlog_tmp_stringstream__;                                                          \
             __ore_mlog_tmp_stringstream__ << text;                                                                     \
-            if (!ore::data::Log::instance().checkExcludeFilters(__ore_mlog_tmp_stringstream__.str())) {                \
-                boost::unique_lock<boost::shared_mutex> lock(ore::data::Log::instance().mutex());                      \
-                ore::data::Log::instance().header(mask, __FILE__, __LINE__);                                           \
-                ore::data::Log::instance().logStream() << __ore_mlog_tmp_stringstream__.str();                         \
-                ore::data::Log::instance().log(mask);                                                                  \
-            }                                                                                                          \
+            std::string __ore_mlog_tmp_string__ = __ore_mlog_tmp_stringstream__.str();                                 \
+            if (!ore::data::Log::instance().checkExcludeFilters(__ore_mlog_tmp_string__))                              \
+                ore::data::Log::instance().log(mask, __FILE__, __LINE__, __ore_mlog_tmp_string__);                     \
         }                                                                                                              \
     }
 
@@ -560,12 +612,10 @@ private:
 
 #define MEM_LOG_USING_LEVEL(LEVEL)                                                                                      \
     {                                                                                                                   \
-        if (ore::data::Log::instance().enabled() && ore::data::Log::instance().filter(LEVEL)) {                         \
-            boost::unique_lock<boost::shared_mutex> lock(ore::data::Log::instance().mutex());                           \
-            ore::data::Log::instance().header(LEVEL, __FILE__, __LINE__);                                               \
-            ore::data::Log::instance().logStream() << std::to_string(ore::data::os::getPeakMemoryUsageBytes()) << "|";  \
-            ore::data::Log::instance().logStream() << std::to_string(ore::data::os::getMemoryUsageBytes());             \
-            ore::data::Log::instance().log(LEVEL);                                                                      \
+        if (ORE_LOG_ENABLED(LEVEL)) {                                                                                   \
+            ore::data::Log::instance().log(LEVEL, __FILE__, __LINE__,                                                   \
+                                           std::to_string(ore::data::os::getPeakMemoryUsageBytes()) + "|" +             \
+                                               std::to_string(ore::data::os::getMemoryUsageBytes()));                   \
         }                                                                                                               \
     }
 
@@ -620,7 +670,7 @@ private:
 };
 
 #define CHECKED_LOGGERSTREAM(LEVEL, text)                                                       \
-    if (ore::data::Log::instance().enabled() && ore::data::Log::instance().filter(LEVEL)) {     \
+    if (ORE_LOG_ENABLED(LEVEL)) {                                                               \
         (std::ostream&)ore::data::LoggerStream(LEVEL, __FILE__, __LINE__) << text;              \
     }
 
@@ -0,0 +1,218 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <ored/utilities/profiler.hpp>
+
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <tuple>
+
+namespace ore {
+namespace data {
+
+namespace {
+// escape a string for use in a JSON string literal
+std::string jsonEscape(const std::string& s) {
+    std::string result;
+    result.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            result += ' ';
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+} // namespace
+
+bool operator<(const ProfileKey& lhs, const ProfileKey& rhs) {
+    return std::tie(lhs.analytic, lhs.phase, lhs.tradeType, lhs.engine) <
+           std::tie(rhs.analytic, rhs.phase, rhs.tradeType, rhs.engine);
+}
+
+std::size_t Profiler::KeyViewHash::operator()(const KeyView& k) const {
+    std::size_t seed = 0;
+    boost::hash_combine(seed, std::hash<std::string_view>()(std::get<0>(k)));
+    boost::hash_combine(seed, std::hash<std::string_view>()(std::get<1>(k)));
+    boost::hash_combine(seed, std::hash<std::string_view>()(std::get<2>(k)));
+    return seed;
+}
+
+Profiler::Profiler()
+    : enabled_(false), analyticVersion_(0), traceSampling_(0), maxTraceEvents_(1000000),
+      epoch_(std::chrono::steady_clock::now().time_since_epoch().count()) {}
+
+void Profiler::setEnabled(const bool b) {
+    if (b && !enabled())
+        epoch_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    enabled_.store(b, std::memory_order_relaxed);
+}
+
+void Profiler::setTraceSampling(const QuantLib::Size n, const QuantLib::Size maxEvents) {
+    maxTraceEvents_.store(maxEvents, std::memory_order_relaxed);
+    traceSampling_.store(n, std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::time_point Profiler::epoch() const {
+    return std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(epoch_.load(std::memory_order_relaxed)));
+}
+
+void Profiler::setAnalytic(const std::string& analytic) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    analytic_ = analytic;
+    ++analyticVersion_;
+}
+
+std::string Profiler::analytic() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return analytic_;
+}
+
+Profiler::ThreadData& Profiler::threadData() {
+    // the thread data are owned by the profiler and live as long as the profiler, reset() only clears them
+    thread_local ThreadData* data = nullptr;
+    thread_local const Profiler* owner = nullptr;
+    if (data == nullptr || owner != this) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threadData_.push_back(std::make_unique<ThreadData>());
+        threadData_.back()->index = threadData_.size() - 1;
+        data = threadData_.back().get();
+        owner = this;
+    }
+    return *data;
+}
+
+std::pair<QuantLib::Size, const ProfileKey*> Profiler::internKey(ProfileKey key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [k, inserted] = keyIds_.emplace(std::move(key), keys_.size());
+    if (inserted)
+        keys_.push_back(&k->first);
+    return {k->second, &k->first};
+}
+
+void Profiler::record(std::string_view phase, std::string_view tradeType, std::string_view engine,
+                      const std::chrono::steady_clock::time_point& start,
+                      const std::chrono::steady_clock::time_point& end) {
+    double time = std::chrono::duration<double>(end - start).count();
+    ThreadData& data = threadData();
+    // refresh the thread's copy of the analytic only when it was changed, the key ids depend on the analytic
+    if (QuantLib::Size version = analyticVersion_.load(std::memory_order_acquire); version != data.analyticVersion) {
+        data.analytic = analytic();
+        data.analyticVersion = version;
+        data.keyIds.clear();
+    }
+    QuantLib::Size id;
+    if (auto k = data.keyIds.find(KeyView(phase, tradeType, engine)); k != data.keyIds.end()) {
+        id = k->second;
+    } else {
+        auto [newId, key] = internKey({data.analytic, std::string(phase), std::string(tradeType), std::string(engine)});
+        data.keyIds.emplace(KeyView(key->phase, key->tradeType, key->engine), newId);
+        id = newId;
+    }
+    std::lock_guard<std::mutex> lock(data.mutex);
+    if (id >= data.stats.size())
+        data.stats.resize(id + 1);
+    ProfileStats& s = data.stats[id];
+    if (s.count == 0) {
+        s.minTime = s.maxTime = time;
+    } else {
+        s.minTime = std::min(s.minTime, time);
+        s.maxTime = std::max(s.maxTime, time);
+    }
+    ++s.count;
+    s.totalTime += time;
+    QuantLib::Size sampling = traceSampling_.load(std::memory_order_relaxed);
+    if (sampling > 0 && data.counter++ % sampling == 0 &&
+        data.events.size() < maxTraceEvents_.load(std::memory_order_relaxed)) {
+        std::string name(phase);
+        if (!tradeType.empty()) {
+            name += ' ';
+            name += tradeType;
+        }
+        data.events.push_back({name, data.analytic, data.index,
+                               std::chrono::duration<double, std::micro>(start - epoch()).count(),
+                               std::chrono::duration<double, std::micro>(end - start).count()});
+    }
+}
+
+std::map<ProfileKey, ProfileStats> Profiler::stats() const {
+    std::map<ProfileKey, ProfileStats> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto const& data : threadData_) {
+        std::lock_guard<std::mutex> dataLock(data->mutex);
+        for (QuantLib::Size id = 0; id < data->stats.size(); ++id) {
+            const ProfileStats& s = data->stats[id];
+            if (s.count == 0)
+                continue;
+            ProfileStats& r = result[*keys_[id]];
+            if (r.count == 0) {
+                r = s;
+            } else {
+                r.count += s.count;
+                r.totalTime += s.totalTime;
+                r.minTime = std::min(r.minTime, s.minTime);
+                r.maxTime = std::max(r.maxTime, s.maxTime);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<ProfileTraceEvent> Profiler::traceEvents() const {
+    std::vector<ProfileTraceEvent> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto const& data : threadData_) {
+        std::lock_guard<std::mutex> dataLock(data->mutex);
+        result.insert(result.end(), data->events.begin(), data->events.end());
+    }
+    std::sort(result.begin(), result.end(),
+              [](const ProfileTraceEvent& a, const ProfileTraceEvent& b) { return a.start < b.start; });
+    return result;
+}
+
+void Profiler::writeChromeTrace(std::ostream& out) const {
+    auto events = traceEvents();
+    out << "{\"traceEvents\":[";
+    for (auto e = events.begin(); e != events.end(); ++e) {
+        out << (e == events.begin() ? "\n" : ",\n") << "{\"name\":\"" << jsonEscape(e->name) << "\",\"cat\":\""
+            << jsonEscape(e->category) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e->threadIndex
+            << std::fixed << std::setprecision(3) << ",\"ts\":" << e->start << ",\"dur\":" << e->duration << "}";
+    }
+    out << "\n]}\n";
+}
+
+void Profiler::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto const& data : threadData_) {
+        std::lock_guard<std::mutex> dataLock(data->mutex);
+        data->counter = 0;
+        data->stats.clear();
+        data->events.clear();
+    }
+    epoch_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+} // namespace data
+} // namespace ore
@@ -0,0 +1,184 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file ored/utilities/profiler.hpp
+    \brief scoped timers and counters for profiling runs
+    \ingroup utilities
+*/
+
+#pragma once
+
+#include <ql/patterns/singleton.hpp>
+#include <ql/types.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace ore {
+namespace data {
+
+//! What a profile measurement is aggregated by
+struct ProfileKey {
+    //! the analytic being run, as set by Profiler::setAnalytic()
+    std::string analytic;
+    //! e.g. market build, portfolio build, scenario apply, notifications, pricing, post process
+    std::string phase;
+    //! trade type, if the measurement is for a trade
+    std::string tradeType;
+    //! pricing engine or model builder, if applicable
+    std::string engine;
+};
+
+bool operator<(const ProfileKey& lhs, const ProfileKey& rhs);
+
+//! Aggregated measurements for a profile key, times in seconds
+struct ProfileStats {
+    QuantLib::Size count = 0;
+    double totalTime = 0.0;
+    double minTime = 0.0;
+    double maxTime = 0.0;
+};
+
+//! A sampled trace event, times in microseconds since the profiler was enabled
+struct ProfileTraceEvent {
+    std::string name;
+    std::string category;
+    QuantLib::Size threadIndex;
+    double start;
+    double duration;
+};
+
+//! Collects timings of the main phases of a run
+/*! Measurements are recorded with ScopedProfileTimer and aggregated per thread, so that threads only contend on
+    their own buffers. Profile keys are interned, i.e. a thread builds and copies the strings of a key only the first
+    time it records a measurement for it. The aggregate over all threads is built on request. Optionally every n-th
+    measurement is also kept as a trace event, which can be written in Chrome trace event format.
+
+    The profiler is disabled by default, in which case a ScopedProfileTimer only checks a flag.
+
+    \ingroup utilities
+*/
+class Profiler : public QuantLib::Singleton<Profiler, std::integral_constant<bool, true>> {
+    friend class QuantLib::Singleton<Profiler, std::integral_constant<bool, true>>;
+
+public:
+    void setEnabled(const bool b);
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /*! Keep every n-th measurement as a trace event, up to maxEvents events per thread. A zero n switches the trace
+        off. */
+    void setTraceSampling(const QuantLib::Size n, const QuantLib::Size maxEvents = 1000000);
+    QuantLib::Size traceSampling() const { return traceSampling_.load(std::memory_order_relaxed); }
+
+    //! Set the analytic that subsequent measurements are attributed to
+    void setAnalytic(const std::string& analytic);
+    std::string analytic() const;
+
+    //! Record a measurement, usually called via ScopedProfileTimer
+    void record(std::string_view phase, std::string_view tradeType, std::string_view engine,
+                const std::chrono::steady_clock::time_point& start, const std::chrono::steady_clock::time_point& end);
+
+    //! Aggregate over all threads
+    std::map<ProfileKey, ProfileStats> stats() const;
+    //! Sampled trace events of all threads
+    std::vector<ProfileTraceEvent> traceEvents() const;
+    //! Write the sampled trace events in Chrome trace event format (JSON)
+    void writeChromeTrace(std::ostream& out) const;
+
+    //! Clear all measurements
+    void reset();
+
+private:
+    Profiler();
+
+    // phase, trade type and engine of a key, viewing the strings of the interned key
+    using KeyView = std::tuple<std::string_view, std::string_view, std::string_view>;
+    struct KeyViewHash {
+        std::size_t operator()(const KeyView& k) const;
+    };
+
+    struct ThreadData {
+        std::mutex mutex;
+        QuantLib::Size index;
+        QuantLib::Size counter = 0;
+        QuantLib::Size analyticVersion = 0;
+        std::string analytic;
+        // ids of the interned keys for the thread's analytic, only used by the owning thread
+        std::unordered_map<KeyView, QuantLib::Size, KeyViewHash> keyIds;
+        // stats by interned key id
+        std::vector<ProfileStats> stats;
+        std::vector<ProfileTraceEvent> events;
+    };
+
+    ThreadData& threadData();
+    std::pair<QuantLib::Size, const ProfileKey*> internKey(ProfileKey key);
+    std::chrono::steady_clock::time_point epoch() const;
+
+    std::atomic<bool> enabled_;
+    std::atomic<QuantLib::Size> analyticVersion_;
+    std::atomic<QuantLib::Size> traceSampling_;
+    std::atomic<QuantLib::Size> maxTraceEvents_;
+    // the time trace events are relative to, in ticks since the steady clock's epoch
+    std::atomic<std::chrono::steady_clock::rep> epoch_;
+
+    mutable std::mutex mutex_;
+    std::string analytic_;
+    std::vector<std::unique_ptr<ThreadData>> threadData_;
+    // the interned keys, keys_ and the threads' key views point into the (stable) nodes of keyIds_
+    std::map<ProfileKey, QuantLib::Size> keyIds_;
+    std::vector<const ProfileKey*> keys_;
+};
+
+//! Records the time between construction and destruction with the Profiler, if the profiler is enabled
+class ScopedProfileTimer {
+public:
+    explicit ScopedProfileTimer(const char* phase, const std::string& tradeType = std::string(),
+                                const std::string& engine = std::string())
+        : active_(Profiler::instance().enabled()) {
+        if (active_) {
+            phase_ = phase;
+            tradeType_ = tradeType;
+            engine_ = engine;
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+    ~ScopedProfileTimer() {
+        if (active_)
+            Profiler::instance().record(phase_, tradeType_, engine_, start_, std::chrono::steady_clock::now());
+    }
+    ScopedProfileTimer(const ScopedProfileTimer&) = delete;
+    ScopedProfileTimer& operator=(const ScopedProfileTimer&) = delete;
+
+private:
+    bool active_;
+    const char* phase_ = nullptr;
+    std::string tradeType_, engine_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace data
+} // namespace ore
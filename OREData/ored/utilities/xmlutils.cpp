@@ -26,7 +26,11 @@
 #include <ored/utilities/to_string.hpp>
 #include <ored/utilities/xmlutils.hpp>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/erase.hpp>
 
@@ -50,6 +54,8 @@
 
 #include <algorithm>
 #include <fstream>
+#include <functional>
+#include <unordered_map>
 
 using namespace std;
 using namespace rapidxml;
@@ -172,6 +178,129 @@ string XMLSerializable::toXMLString() const {
     return doc.toString();
 }
 
+XMLSnapshot::XMLSnapshot(XMLNode* node) {
+    QL_REQUIRE(node, "XMLSnapshot: XML Node is NULL");
+    std::unordered_map<std::string, unsigned int> index;
+    auto intern = [this, &index](const char* str, Size size) {
+        auto r = index.emplace(std::string(str, size), static_cast<unsigned int>(strings_.size()));
+        if (r.second)
+            strings_.push_back(r.first->first);
+        return r.first->second;
+    };
+    std::function<void(XMLNode*)> add = [this, &intern, &add](XMLNode* n) {
+        data_.push_back(static_cast<unsigned int>(n->type()));
+        data_.push_back(intern(n->name(), n->name_size()));
+        data_.push_back(intern(n->value(), n->value_size()));
+        Size attrPos = data_.size();
+        data_.push_back(0);
+        for (auto a = n->first_attribute(); a; a = a->next_attribute()) {
+            data_.push_back(intern(a->name(), a->name_size()));
+            data_.push_back(intern(a->value(), a->value_size()));
+            ++data_[attrPos];
+        }
+        Size childPos = data_.size();
+        data_.push_back(0);
+        for (auto c = n->first_node(); c; c = c->next_sibling()) {
+            ++data_[childPos];
+            add(c);
+        }
+    };
+    add(node);
+}
+
+XMLNode* XMLSnapshot::toXML(XMLDocument& doc) const {
+    QL_REQUIRE(!empty(), "XMLSnapshot::toXML(): snapshot is empty");
+    // each distinct string is allocated only once in the document
+    std::vector<char*> strings(strings_.size());
+    for (Size i = 0; i < strings_.size(); ++i)
+        strings[i] = doc.allocString(strings_[i]);
+    Size pos = 0;
+    XMLNode* n = restore(doc, strings, pos);
+    QL_REQUIRE(pos == data_.size(), "XMLSnapshot: " << data_.size() - pos << " unexpected entries after root node");
+    return n;
+}
+
+XMLNode* XMLSnapshot::restore(XMLDocument& doc, std::vector<char*>& strings, Size& pos) const {
+    // every read is checked against the data size and every string index against the string table, so that a
+    // corrupted snapshot raises an error instead of reading out of bounds
+    auto checkString = [this](unsigned int i) {
+        QL_REQUIRE(i < strings_.size(), "XMLSnapshot: string index " << i << " out of range, string table has size "
+                                                                     << strings_.size());
+        return i;
+    };
+    QL_REQUIRE(data_.size() - pos >= 5, "XMLSnapshot: unexpected end of data at position " << pos);
+    QL_REQUIRE(data_[pos] <= static_cast<unsigned int>(node_pi), "XMLSnapshot: invalid node type " << data_[pos]);
+    auto type = static_cast<node_type>(data_[pos]);
+    unsigned int name = checkString(data_[pos + 1]), value = checkString(data_[pos + 2]), nAttributes = data_[pos + 3];
+    pos += 4;
+    QL_REQUIRE((data_.size() - pos - 1) / 2 >= nAttributes,
+               "XMLSnapshot: unexpected end of data reading " << nAttributes << " attributes at position " << pos);
+    XMLNode* n = doc.doc()->allocate_node(type, strings[name], strings[value], strings_[name].size(),
+                                          strings_[value].size());
+    for (unsigned int i = 0; i < nAttributes; ++i, pos += 2) {
+        unsigned int an = checkString(data_[pos]), av = checkString(data_[pos + 1]);
+        n->append_attribute(
+            doc.doc()->allocate_attribute(strings[an], strings[av], strings_[an].size(), strings_[av].size()));
+    }
+    unsigned int nChildren = data_[pos++];
+    for (unsigned int i = 0; i < nChildren; ++i)
+        n->append_node(restore(doc, strings, pos));
+    return n;
+}
+
+void XMLSnapshot::toBinary(std::ostream& os) const {
+    boost::archive::binary_oarchive oa(os, boost::archive::no_header);
+    unsigned int magic = binaryMagic, version = binaryVersion;
+    oa << magic;
+    oa << version;
+    oa << strings_;
+    oa << data_;
+}
+
+void XMLSnapshot::fromBinary(std::istream& is) {
+    strings_.clear();
+    data_.clear();
+    try {
+        boost::archive::binary_iarchive ia(is, boost::archive::no_header);
+        unsigned int magic, version;
+        ia >> magic;
+        QL_REQUIRE(magic == binaryMagic, "not an XML snapshot (magic number " << std::hex << magic << ")");
+        ia >> version;
+        QL_REQUIRE(version == binaryVersion,
+                   "format version " << version << " not supported, expected " << binaryVersion);
+        ia >> strings_;
+        ia >> data_;
+    } catch (const std::exception& e) {
+        strings_.clear();
+        data_.clear();
+        QL_FAIL("XMLSnapshot::fromBinary(): could not read snapshot: " << e.what());
+    }
+}
+
+void XMLSerializable::fromXMLSnapshot(const XMLSnapshot& snapshot) {
+    XMLDocument doc;
+    fromXML(snapshot.toXML(doc));
+}
+
+XMLSnapshot XMLSerializable::toXMLSnapshot() const {
+    XMLDocument doc;
+    return XMLSnapshot(toXML(doc));
+}
+
+void XMLSerializable::fromBinaryFile(const string& filename) {
+    std::ifstream is(filename.c_str(), std::ios::binary);
+    QL_REQUIRE(is.is_open(), "XMLSerializable::fromBinaryFile(): could not open file '" << filename << "'");
+    XMLSnapshot snapshot;
+    snapshot.fromBinary(is);
+    fromXMLSnapshot(snapshot);
+}
+
+void XMLSerializable::toBinaryFile(const string& filename) const {
+    std::ofstream os(filename.c_str(), std::ios::binary);
+    QL_REQUIRE(os.is_open(), "XMLSerializable::toBinaryFile(): could not open file '" << filename << "'");
+    toXMLSnapshot().toBinary(os);
+}
+
 void XMLUtils::checkNode(XMLNode* node, const string& expectedName) {
     QL_REQUIRE(node, "XML Node is NULL (expected " << expectedName << ")");
     QL_REQUIRE(node->name() == expectedName,
@@ -95,6 +95,38 @@ private:
     char* _buffer;
 };
 
+//! Compact binary snapshot of an XML node and its descendants
+/*! The node tree is stored as a flat list in pre-order, node names, values and attributes are interned in a string
+    table. A snapshot can be restored into a document without printing or parsing XML text and it can be written to
+    and read from a stream in a binary format.
+    \ingroup utilities
+ */
+class XMLSnapshot {
+public:
+    XMLSnapshot() {}
+    //! take a snapshot of the given node
+    explicit XMLSnapshot(XMLNode* node);
+    //! restore the node in the given document, the returned node is not appended to the document
+    XMLNode* toXML(XMLDocument& doc) const;
+
+    //! write the snapshot to a stream in binary format
+    void toBinary(std::ostream& os) const;
+    /*! read the snapshot from a stream in binary format, throws if the stream does not start with the magic number
+        and format version written by toBinary() or cannot be read */
+    void fromBinary(std::istream& is);
+
+    bool empty() const { return data_.empty(); }
+
+private:
+    // leading words of the binary format, the version is increased when the layout of the data changes
+    static constexpr unsigned int binaryMagic = 0x4F524558; // "OREX"
+    static constexpr unsigned int binaryVersion = 1;
+    XMLNode* restore(XMLDocument& doc, std::vector<char*>& strings, Size& pos) const;
+    // per node: type, name, value, number of attributes, (attribute name, value) pairs, number of children
+    std::vector<unsigned int> data_;
+    std::vector<std::string> strings_;
+};
+
 //! Base class for all serializable classes
 /*! \ingroup utilities
  */
@@ -111,6 +143,16 @@ public:
     void fromXMLString(const std::string& xml);
     //! Parse from XML string
     std::string toXMLString() const;
+
+    //! Load from a binary snapshot
+    void fromXMLSnapshot(const XMLSnapshot& snapshot);
+    //! Write to a binary snapshot
+    XMLSnapshot toXMLSnapshot() const;
+
+    //! Load from a file written by toBinaryFile()
+    void fromBinaryFile(const std::string& filename);
+    //! Write a binary snapshot to a file
+    void toBinaryFile(const std::string& filename) const;
 };
 
 //! XML Utilities Class
@@ -34,6 +34,7 @@
 #include <ored/portfolio/enginedata.hpp>
 #include <ored/portfolio/enginefactory.hpp>
 #include <ored/portfolio/portfolio.hpp>
+#include <ored/utilities/xmlutils.hpp>
 #include <oret/datapaths.hpp>
 #include <oret/toplevelfixture.hpp>
 
@@ -44,12 +45,35 @@
 
 #include <iostream>
 #include <iomanip>
+#include <mutex>
+#include <set>
+#include <thread>
 
 using namespace ore::data;
 using namespace QuantExt;
 using namespace QuantLib;
 using namespace boost::unit_test_framework;
 
+namespace {
+// records the threads on which the scripted trades are built
+class ThreadRecordingScriptedTrade : public ScriptedTrade {
+public:
+    ThreadRecordingScriptedTrade(std::set<std::thread::id>& threads, std::mutex& mutex)
+        : threads_(threads), mutex_(mutex) {}
+    void build(const QuantLib::ext::shared_ptr<EngineFactory>& engineFactory) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threads_.insert(std::this_thread::get_id());
+        }
+        ScriptedTrade::build(engineFactory);
+    }
+
+private:
+    std::set<std::thread::id>& threads_;
+    std::mutex& mutex_;
+};
+} // namespace
+
 BOOST_FIXTURE_TEST_SUITE(OREDataTestSuite, ore::test::TopLevelFixture)
 
 BOOST_AUTO_TEST_SUITE(FxAccumulatorTest)
@@ -123,6 +147,89 @@ BOOST_AUTO_TEST_CASE(testNPV) {
                       0.01);
 }
 
+BOOST_AUTO_TEST_CASE(testParallelBuild) {
+    BOOST_TEST_MESSAGE("Testing parallel build of a portfolio with scripted trades...");
+
+    ORE_REGISTER_TRADE_BUILDER("ScriptedTrade", ore::data::ScriptedTrade, true)
+    ORE_REGISTER_ENGINE_BUILDER(ore::data::ScriptedTradeEngineBuilder, true)
+
+    Settings::instance().evaluationDate() = Date(31, Dec, 2018);
+    Date asof = Settings::instance().evaluationDate();
+    auto conventions = QuantLib::ext::make_shared<Conventions>();
+    conventions->fromFile(TEST_INPUT_FILE("conventions.xml"));
+    InstrumentConventions::instance().setConventions(conventions);
+
+    auto todaysMarketParams = QuantLib::ext::make_shared<TodaysMarketParameters>();
+    todaysMarketParams->fromFile(TEST_INPUT_FILE("todaysmarket.xml"));
+    auto curveConfigs = QuantLib::ext::make_shared<CurveConfigurations>();
+    curveConfigs->fromFile(TEST_INPUT_FILE("curveconfig.xml"));
+    QuantLib::ext::shared_ptr<Loader> loader =
+        QuantLib::ext::make_shared<CSVLoader>(TEST_INPUT_FILE("market.txt"), TEST_INPUT_FILE("fixings.txt"), false);
+    // the parallel build requires a market that is not built lazily
+    QuantLib::ext::shared_ptr<TodaysMarket> market =
+        QuantLib::ext::make_shared<TodaysMarket>(asof, todaysMarketParams, loader, curveConfigs, false, true, false);
+
+    QuantLib::ext::shared_ptr<EngineData> engineData = QuantLib::ext::make_shared<EngineData>();
+    engineData->fromFile(TEST_INPUT_FILE("pricingengine.xml"));
+
+    struct cleanup {
+        ~cleanup() { ore::data::ScriptLibraryStorage::instance().clear(); }
+    } cleanup;
+    ore::data::ScriptLibraryData library;
+    library.fromFile(TEST_INPUT_FILE("scriptlibrary.xml"));
+    ore::data::ScriptLibraryStorage::instance().set(std::move(library));
+
+    // copies of the scripted trades in the accumulator portfolio, several copies per trade so that the scripted
+    // trade builder is used concurrently
+    Portfolio input;
+    input.fromFile(TEST_INPUT_FILE("FX_Accumulator.xml"));
+    std::set<std::thread::id> threads;
+    std::mutex mutex;
+    auto copyPortfolio = [&input, &threads, &mutex]() {
+        auto p = QuantLib::ext::make_shared<Portfolio>();
+        for (Size i = 0; i < 4; ++i) {
+            for (auto const& [id, t] : input.trades()) {
+                if (t->tradeType() != "ScriptedTrade")
+                    continue;
+                ore::data::XMLDocument doc;
+                auto trade = QuantLib::ext::make_shared<ThreadRecordingScriptedTrade>(threads, mutex);
+                trade->fromXML(t->toXML(doc));
+                trade->id() = id + "_" + std::to_string(i);
+                p->add(trade);
+            }
+        }
+        return p;
+    };
+
+    auto serial = copyPortfolio();
+    serial->build(QuantLib::ext::make_shared<EngineFactory>(engineData, market), "test");
+    BOOST_REQUIRE(threads == std::set<std::thread::id>{std::this_thread::get_id()});
+
+    threads.clear();
+    auto parallel = copyPortfolio();
+    parallel->build(QuantLib::ext::make_shared<EngineFactory>(engineData, market), "test", true, 4);
+
+#if defined(QL_ENABLE_THREAD_SAFE_OBSERVER_PATTERN) && !defined(QL_ENABLE_SESSIONS)
+    // the parallel branch builds all trades on worker threads
+    BOOST_REQUIRE(!threads.empty());
+    BOOST_CHECK(threads.find(std::this_thread::get_id()) == threads.end());
+#else
+    // otherwise the build falls back to a serial build on the calling thread
+    BOOST_TEST_MESSAGE("QuantLib is built without the thread safe observer pattern, parallel build is not tested");
+    BOOST_CHECK(threads == std::set<std::thread::id>{std::this_thread::get_id()});
+#endif
+
+    BOOST_REQUIRE_EQUAL(serial->size(), parallel->size());
+    for (auto const& [id, t] : serial->trades()) {
+        auto p = parallel->get(id);
+        BOOST_REQUIRE(p != nullptr);
+        BOOST_CHECK_EQUAL(t->tradeType(), p->tradeType());
+        BOOST_CHECK_EQUAL(t->npvCurrency(), p->npvCurrency());
+        BOOST_CHECK(t->maturity() == p->maturity());
+        BOOST_CHECK_EQUAL(t->instrument()->NPV(), p->instrument()->NPV());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
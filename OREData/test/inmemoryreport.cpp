@@ -0,0 +1,138 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <ored/report/inmemoryreport.hpp>
+#include <oret/toplevelfixture.hpp>
+
+#include <fstream>
+
+using namespace QuantLib;
+using namespace boost::unit_test_framework;
+using namespace ore::data;
+
+namespace {
+void fill(InMemoryReport& report, Size rows) {
+    report.addColumn("TradeId", string())
+        .addColumn("Index", Size())
+        .addColumn("Value", Real(), 6)
+        .addColumn("Date", Date())
+        .addColumn("Tenor", Period());
+    for (Size i = 0; i < rows; ++i)
+        report.next()
+            .add("Trade_" + std::to_string(i % 3))
+            .add(i)
+            .add(1.5 * i)
+            .add(Date(1, Jan, 2024) + i)
+            .add(Period(i, Months));
+    report.end();
+}
+
+std::string readFile(const std::string& filename) {
+    std::ifstream is(filename);
+    std::stringstream s;
+    s << is.rdbuf();
+    return s.str();
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREDataTestSuite, ore::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(InMemoryReportTests)
+
+BOOST_AUTO_TEST_CASE(testTypedColumns) {
+    InMemoryReport report;
+    fill(report, 10);
+    BOOST_CHECK_EQUAL(report.rows(), 10);
+    BOOST_REQUIRE_EQUAL(report.dataAsReal(2).size(), 10);
+    BOOST_REQUIRE_EQUAL(report.dataAsSize(1).size(), 10);
+    for (Size i = 0; i < 10; ++i) {
+        BOOST_CHECK_EQUAL(report.dataAsString(0, i), "Trade_" + std::to_string(i % 3));
+        BOOST_CHECK_EQUAL(report.dataAsSize(1)[i], i);
+        BOOST_CHECK_EQUAL(report.dataAsReal(2)[i], 1.5 * i);
+        BOOST_CHECK_EQUAL(report.dataAsDate(3)[i], Date(1, Jan, 2024) + i);
+        BOOST_CHECK_EQUAL(report.dataAsPeriod(4)[i], Period(i, Months));
+        // the variant values agree with the typed data
+        BOOST_CHECK_EQUAL(boost::get<string>(report.value(0, i)), report.dataAsString(0, i));
+        BOOST_CHECK_EQUAL(boost::get<Real>(report.value(2, i)), report.dataAsReal(2)[i]);
+    }
+    auto column = report.data(0);
+    BOOST_REQUIRE_EQUAL(column.size(), 10);
+    BOOST_CHECK_EQUAL(boost::get<string>(column[4]), "Trade_1");
+    BOOST_CHECK_THROW(report.dataAsReal(1), std::exception);
+}
+
+BOOST_AUTO_TEST_CASE(testBinaryFileRoundTrip) {
+    auto tmp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    std::string csv1 = tmp.string() + "_1.csv", csv2 = tmp.string() + "_2.csv", bin = tmp.string() + ".bin";
+
+    // use a small buffer size, so that the data is spilled to files
+    InMemoryReport report(4);
+    fill(report, 10);
+    report.toFile(csv1);
+    report.toBinaryFile(bin);
+
+    InMemoryReport loaded;
+    loaded.fromBinaryFile(bin);
+    BOOST_CHECK_EQUAL(loaded.rows(), 10);
+    BOOST_CHECK_EQUAL(loaded.columns(), 5);
+    BOOST_CHECK_EQUAL(loaded.dataAsString(0, 7), "Trade_1");
+    loaded.toFile(csv2);
+    BOOST_CHECK_EQUAL(readFile(csv1), readFile(csv2));
+
+    boost::filesystem::remove(csv1);
+    boost::filesystem::remove(csv2);
+    boost::filesystem::remove(bin);
+}
+
+BOOST_AUTO_TEST_CASE(testSpilledStrings) {
+    auto tmp = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+    std::string csv1 = tmp.string() + "_1.csv", csv2 = tmp.string() + "_2.csv", bin = tmp.string() + ".bin";
+
+    // each row has its own string, the string table is spilled together with the columns
+    auto fillDistinct = [](InMemoryReport& report) {
+        report.addColumn("TradeId", string()).addColumn("Value", Real(), 6);
+        for (Size i = 0; i < 11; ++i)
+            report.next().add("Trade_" + std::to_string(i)).add(1.5 * i);
+        report.end();
+    };
+    InMemoryReport buffered(4), unbuffered(0);
+    fillDistinct(buffered);
+    fillDistinct(unbuffered);
+    BOOST_CHECK_EQUAL(buffered.rows(), 11);
+    buffered.toFile(csv1);
+    unbuffered.toFile(csv2);
+    BOOST_CHECK_EQUAL(readFile(csv1), readFile(csv2));
+
+    // the strings of all chunks are merged into one table when the report is read back
+    buffered.toBinaryFile(bin);
+    InMemoryReport loaded;
+    loaded.fromBinaryFile(bin);
+    BOOST_REQUIRE_EQUAL(loaded.rows(), 11);
+    for (Size i = 0; i < 11; ++i)
+        BOOST_CHECK_EQUAL(loaded.dataAsString(0, i), "Trade_" + std::to_string(i));
+
+    boost::filesystem::remove(csv1);
+    boost::filesystem::remove(csv2);
+    boost::filesystem::remove(bin);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,166 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <oret/toplevelfixture.hpp>
+
+#include <ored/utilities/log.hpp>
+
+#include <future>
+#include <mutex>
+#include <set>
+
+using namespace ore::data;
+using QuantLib::Size;
+
+namespace {
+
+// restores the global log state at the end of a test case
+class LogFixture {
+public:
+    LogFixture() : enabled_(Log::instance().enabled()), mask_(Log::instance().mask()) {
+        Log::instance().removeAllLoggers();
+        logger_ = QuantLib::ext::make_shared<BufferLogger>(ORE_DATA);
+        Log::instance().registerLogger(logger_);
+        Log::instance().setMask(ORE_ALERT | ORE_CRITICAL | ORE_ERROR | ORE_WARNING | ORE_NOTICE);
+        Log::instance().switchOn();
+    }
+    ~LogFixture() {
+        Log::instance().setAsync(false);
+        Log::instance().removeAllLoggers();
+        Log::instance().setMask(mask_);
+        if (!enabled_)
+            Log::instance().switchOff();
+    }
+
+    std::vector<std::string> messages() {
+        Log::instance().flush();
+        auto bl = QuantLib::ext::dynamic_pointer_cast<BufferLogger>(Log::instance().logger(BufferLogger::name));
+        std::vector<std::string> res;
+        while (bl->hasNext())
+            res.push_back(bl->next());
+        return res;
+    }
+
+private:
+    bool enabled_;
+    unsigned mask_;
+    QuantLib::ext::shared_ptr<BufferLogger> logger_;
+};
+
+// the message body after the header "LEVEL [time]  (file:line) : "
+std::string body(const std::string& msg) { return msg.substr(msg.find(" : ") + 3); }
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREDataTestSuite, ore::test::TopLevelFixture)
+
+BOOST_FIXTURE_TEST_SUITE(LogTest, LogFixture)
+
+BOOST_AUTO_TEST_CASE(testLevelFiltering) {
+    BOOST_TEST_MESSAGE("Testing that filtered log levels are not evaluated...");
+
+    Size evaluated = 0;
+    auto count = [&evaluated]() { return ++evaluated; };
+    LOG("notice " << count());
+    DLOG("debug " << count());
+    TLOG("data " << count());
+
+    BOOST_CHECK_EQUAL(evaluated, 1);
+    auto msgs = messages();
+    BOOST_REQUIRE_EQUAL(msgs.size(), 1);
+    BOOST_CHECK_EQUAL(body(msgs[0]), "notice 1");
+}
+
+BOOST_AUTO_TEST_CASE(testAsyncLogging) {
+    BOOST_TEST_MESSAGE("Testing asynchronous logging...");
+
+    Log::instance().setAsync(true);
+    BOOST_CHECK(Log::instance().async());
+
+    // messages from one thread arrive in order
+    for (Size i = 0; i < 100; ++i)
+        LOG("message " << i);
+    auto msgs = messages();
+    BOOST_REQUIRE_EQUAL(msgs.size(), 100);
+    for (Size i = 0; i < 100; ++i)
+        BOOST_CHECK_EQUAL(body(msgs[i]), "message " + std::to_string(i));
+
+    // messages from several threads are all delivered
+    std::vector<std::future<void>> results;
+    for (Size t = 0; t < 8; ++t) {
+        results.push_back(std::async(std::launch::async, [t]() {
+            for (Size i = 0; i < 100; ++i)
+                WLOG("thread " << t << " message " << i);
+        }));
+    }
+    for (auto& r : results)
+        r.get();
+    msgs = messages();
+    BOOST_REQUIRE_EQUAL(msgs.size(), 800);
+    std::set<std::string> bodies;
+    for (auto const& m : msgs) {
+        BOOST_CHECK(boost::starts_with(m, "WARNING"));
+        bodies.insert(body(m));
+    }
+    BOOST_CHECK_EQUAL(bodies.size(), 800);
+
+    // messages from several threads are delivered in the order in which they were logged, the mutex makes the
+    // logging order match the counter order
+    std::mutex m;
+    Size counter = 0;
+    results.clear();
+    for (Size t = 0; t < 8; ++t) {
+        results.push_back(std::async(std::launch::async, [&m, &counter]() {
+            for (Size i = 0; i < 200; ++i) {
+                std::lock_guard<std::mutex> lock(m);
+                LOG(counter++);
+            }
+        }));
+    }
+    for (auto& r : results)
+        r.get();
+    msgs = messages();
+    BOOST_REQUIRE_EQUAL(msgs.size(), 1600);
+    for (Size i = 0; i < msgs.size(); ++i)
+        BOOST_CHECK_EQUAL(body(msgs[i]), std::to_string(i));
+
+    // a flush only returns once the messages logged before it are written
+    for (Size i = 0; i < 10; ++i) {
+        LOG("before flush " << i);
+        Log::instance().flush();
+        auto bl = QuantLib::ext::dynamic_pointer_cast<BufferLogger>(Log::instance().logger(BufferLogger::name));
+        BOOST_REQUIRE(bl->hasNext());
+        BOOST_CHECK_EQUAL(body(bl->next()), "before flush " + std::to_string(i));
+        BOOST_CHECK(!bl->hasNext());
+    }
+
+    // switching back to synchronous mode flushes pending messages
+    LOG("last async message");
+    Log::instance().setAsync(false);
+    BOOST_CHECK(!Log::instance().async());
+    LOG("sync message");
+    msgs = messages();
+    BOOST_REQUIRE_EQUAL(msgs.size(), 2);
+    BOOST_CHECK_EQUAL(body(msgs[0]), "last async message");
+    BOOST_CHECK_EQUAL(body(msgs[1]), "sync message");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,17 +16,82 @@
  FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
 */
 
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
 #include <boost/test/unit_test.hpp>
+#include <ored/portfolio/enginedata.hpp>
+#include <ored/portfolio/enginefactory.hpp>
 #include <ored/portfolio/fxforward.hpp>
 #include <ored/portfolio/portfolio.hpp>
+#include <ored/portfolio/swaption.hpp>
+#include <ored/utilities/to_string.hpp>
+#include <ored/utilities/xmlutils.hpp>
 #include <oret/toplevelfixture.hpp>
+#include <test/oredtestmarket.hpp>
+
+#include <ql/time/calendars/target.hpp>
 
 using namespace QuantLib;
 using namespace boost::unit_test_framework;
 using namespace std;
 using namespace ore::data;
 
+namespace {
+QuantLib::ext::shared_ptr<Portfolio> fxForwardPortfolio() {
+    auto portfolio = QuantLib::ext::make_shared<Portfolio>();
+    std::vector<std::string> ccys = {"USD", "GBP", "CHF", "ABC"};
+    for (Size i = 0; i < 40; ++i) {
+        // every tenth trade refers to an unknown currency and fails to build
+        std::string ccy = i % 10 == 9 ? ccys.back() : ccys[i % 3];
+        auto trade = QuantLib::ext::make_shared<FxForward>(Envelope("CP"), "2017-02-03", "EUR", 1.0E6 + 1000.0 * i, ccy,
+                                                           1.1E6);
+        trade->id() = "Trade_" + std::to_string(i);
+        portfolio->add(trade);
+    }
+    return portfolio;
+}
+
+// european swaptions and bermudan swaptions with a single exercise date, both priced by the same LGM grid builder
+QuantLib::ext::shared_ptr<Trade> lgmSwaption(const Date& asof, const Size i) {
+    Calendar calendar = TARGET();
+    Date start = calendar.adjust(asof + (2 + i % 5) * Years);
+    string startDate = ore::data::to_string(start);
+    string endDate = ore::data::to_string(calendar.adjust(start + 10 * Years));
+    ScheduleData floatSchedule(ScheduleRules(startDate, endDate, "6M", "TARGET", "MF", "MF", "Forward"));
+    ScheduleData fixedSchedule(ScheduleRules(startDate, endDate, "1Y", "TARGET", "MF", "MF", "Forward"));
+    LegData fixedLeg(QuantLib::ext::make_shared<FixedLegData>(std::vector<Real>(1, 0.01 + 0.001 * (i % 5))), true, "EUR",
+                     fixedSchedule, "30/360", std::vector<Real>(1, 10000.0));
+    LegData floatingLeg(QuantLib::ext::make_shared<FloatingLegData>("EUR-EURIBOR-6M", 2, false,
+                                                                    std::vector<Real>(1, 0.0)),
+                        false, "EUR", floatSchedule, "A360", std::vector<Real>(1, 10000.0));
+    OptionData optionData("Long", "Call", i % 2 == 0 ? "European" : "Bermudan", false, {startDate}, "Physical");
+    auto trade = QuantLib::ext::make_shared<ore::data::Swaption>(Envelope("CP"), optionData,
+                                                                 vector<LegData>{fixedLeg, floatingLeg});
+    trade->id() = "Swaption_" + std::to_string(i);
+    return trade;
+}
+
+// the LGM grid builder handles both swaption types, the model parameters differ between the types
+QuantLib::ext::shared_ptr<EngineData> lgmSwaptionEngineData() {
+    auto engineData = QuantLib::ext::make_shared<EngineData>();
+    for (auto const& [tradeType, reversion, vol] :
+         {std::make_tuple("EuropeanSwaption", "0.01", "0.005"), std::make_tuple("BermudanSwaption", "0.03", "0.01")}) {
+        engineData->model(tradeType) = "LGM";
+        engineData->modelParameters(tradeType) = {
+            {"Calibration", "None"}, {"CalibrationStrategy", "None"}, {"Reversion", reversion},
+            {"ReversionType", "HullWhite"}, {"Volatility", vol}, {"VolatilityType", "Hagan"},
+            {"ShiftHorizon", "0.5"}, {"Tolerance", "0.0001"}};
+        engineData->engine(tradeType) = "Grid";
+        engineData->engineParameters(tradeType) = {{"sy", "3.0"}, {"ny", "10"}, {"sx", "3.0"}, {"nx", "10"}};
+    }
+    engineData->model("Swap") = "DiscountedCashflows";
+    engineData->engine("Swap") = "DiscountingSwapEngine";
+    return engineData;
+}
+} // namespace
+
 BOOST_FIXTURE_TEST_SUITE(OREDataTestSuite, ore::test::TopLevelFixture)
 
 BOOST_AUTO_TEST_SUITE(PortfolioTests)
@@ -119,6 +184,146 @@ BOOST_AUTO_TEST_CASE(testIds) {
     BOOST_CHECK(portfolio->ids() == trade_ids);
 }
 
+BOOST_AUTO_TEST_CASE(testParallelBuild) {
+    Date asof(3, Feb, 2016);
+    Settings::instance().evaluationDate() = asof;
+    QuantLib::ext::shared_ptr<Market> market = QuantLib::ext::make_shared<OredTestMarket>(asof);
+    QuantLib::ext::shared_ptr<EngineData> engineData = QuantLib::ext::make_shared<EngineData>();
+    engineData->model("FxForward") = "DiscountedCashflows";
+    engineData->engine("FxForward") = "DiscountingFxForwardEngine";
+
+    auto serial = fxForwardPortfolio();
+    serial->build(QuantLib::ext::make_shared<EngineFactory>(engineData, market), "test");
+    auto parallel = fxForwardPortfolio();
+    parallel->build(QuantLib::ext::make_shared<EngineFactory>(engineData, market), "test", true, 4);
+
+    BOOST_REQUIRE_EQUAL(serial->size(), parallel->size());
+    for (auto const& [id, t] : serial->trades()) {
+        auto p = parallel->get(id);
+        BOOST_REQUIRE(p != nullptr);
+        BOOST_CHECK_EQUAL(t->tradeType(), p->tradeType());
+        BOOST_CHECK_EQUAL(t->instrument()->NPV(), p->instrument()->NPV());
+    }
+    BOOST_CHECK_EQUAL(serial->get("Trade_9")->tradeType(), "Failed");
+}
+
+BOOST_AUTO_TEST_CASE(testBinarySnapshotRoundTrip) {
+    auto portfolio = fxForwardPortfolio();
+    std::string xml = portfolio->toXMLString();
+
+    // in memory snapshot
+    auto p1 = QuantLib::ext::make_shared<Portfolio>();
+    p1->fromXMLSnapshot(portfolio->toXMLSnapshot());
+    BOOST_CHECK_EQUAL(p1->size(), portfolio->size());
+    BOOST_CHECK_EQUAL(p1->toXMLString(), xml);
+
+    // binary stream
+    std::stringstream stream;
+    portfolio->toXMLSnapshot().toBinary(stream);
+    XMLSnapshot snapshot;
+    snapshot.fromBinary(stream);
+    auto p2 = QuantLib::ext::make_shared<Portfolio>();
+    p2->fromXMLSnapshot(snapshot);
+    BOOST_CHECK_EQUAL(p2->toXMLString(), xml);
+
+    // the snapshot also reproduces a parsed document, including attributes and cdata sections
+    std::string parsed = "<Root a=\"1\"><Child b=\"x&amp;y\">value</Child><Code><![CDATA[ x < y ]]></Code><Empty/></Root>";
+    XMLDocument doc;
+    doc.fromXMLString(parsed);
+    XMLSnapshot rootSnapshot(doc.getFirstNode("Root"));
+    XMLDocument restored;
+    restored.appendNode(rootSnapshot.toXML(restored));
+    BOOST_CHECK_EQUAL(restored.toString(), doc.toString());
+}
+
+namespace {
+// write a snapshot stream by hand
+std::stringstream snapshotStream(unsigned int magic, unsigned int version, const std::vector<std::string>& strings,
+                                 const std::vector<unsigned int>& data) {
+    std::stringstream stream;
+    {
+        boost::archive::binary_oarchive oa(stream, boost::archive::no_header);
+        oa << magic << version << strings << data;
+    }
+    return stream;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(testBinarySnapshotCorrupted) {
+    const unsigned int magic = 0x4F524558;
+    std::vector<std::string> strings = {"Root", "", "a"};
+    XMLSnapshot snapshot;
+    XMLDocument doc;
+
+    // a well formed snapshot <Root a=""/>
+    auto stream = snapshotStream(magic, 1, strings, {1, 0, 1, 1, 2, 1, 0});
+    snapshot.fromBinary(stream);
+    XMLNode* root = snapshot.toXML(doc);
+    BOOST_REQUIRE(root);
+    BOOST_CHECK_EQUAL(XMLUtils::getNodeName(root), "Root");
+
+    // not a snapshot at all
+    std::stringstream text("<Root/>");
+    BOOST_CHECK_THROW(snapshot.fromBinary(text), QuantLib::Error);
+    BOOST_CHECK(snapshot.empty());
+
+    // wrong magic number and unsupported version
+    stream = snapshotStream(magic + 1, 1, strings, {1, 0, 1, 0, 0});
+    BOOST_CHECK_THROW(snapshot.fromBinary(stream), QuantLib::Error);
+    stream = snapshotStream(magic, 2, strings, {1, 0, 1, 0, 0});
+    BOOST_CHECK_THROW(snapshot.fromBinary(stream), QuantLib::Error);
+
+    // truncated stream
+    std::string truncated = snapshotStream(magic, 1, strings, {1, 0, 1, 0, 0}).str();
+    std::stringstream truncatedStream(truncated.substr(0, truncated.size() - 3));
+    BOOST_CHECK_THROW(snapshot.fromBinary(truncatedStream), QuantLib::Error);
+
+    // string index out of range in a node name and in an attribute value
+    stream = snapshotStream(magic, 1, strings, {1, 3, 1, 0, 0});
+    snapshot.fromBinary(stream);
+    BOOST_CHECK_THROW(snapshot.toXML(doc), QuantLib::Error);
+    stream = snapshotStream(magic, 1, strings, {1, 0, 1, 1, 2, 7, 0});
+    snapshot.fromBinary(stream);
+    BOOST_CHECK_THROW(snapshot.toXML(doc), QuantLib::Error);
+
+    // invalid node type, more attributes or children than data and trailing data
+    for (auto const& data : std::vector<std::vector<unsigned int>>{
+             {99, 0, 1, 0, 0}, {1, 0, 1, 5, 0}, {1, 0, 1, 0, 1}, {1, 0, 1, 0}, {1, 0, 1, 0, 0, 1}}) {
+        stream = snapshotStream(magic, 1, strings, data);
+        snapshot.fromBinary(stream);
+        BOOST_CHECK_THROW(snapshot.toXML(doc), QuantLib::Error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testParallelBuildSharedBuilder) {
+    Date asof(3, Feb, 2016);
+    Settings::instance().evaluationDate() = asof;
+    QuantLib::ext::shared_ptr<Market> market = QuantLib::ext::make_shared<OredTestMarket>(asof);
+    auto engineData = lgmSwaptionEngineData();
+
+    // reference prices, each trade built on its own
+    std::map<std::string, Real> expected;
+    for (Size i = 0; i < 20; ++i) {
+        auto trade = lgmSwaption(asof, i);
+        trade->build(QuantLib::ext::make_shared<EngineFactory>(engineData, market));
+        expected[trade->id()] = trade->instrument()->NPV();
+    }
+    // the two parameter sets give different prices for the same underlying
+    BOOST_CHECK(std::abs(expected["Swaption_0"] - expected["Swaption_5"]) > 1.0);
+
+    auto portfolio = QuantLib::ext::make_shared<Portfolio>();
+    for (Size i = 0; i < 20; ++i)
+        portfolio->add(lgmSwaption(asof, i));
+    auto engineFactory = QuantLib::ext::make_shared<EngineFactory>(engineData, market);
+    portfolio->build(engineFactory, "test", true, 4);
+
+    BOOST_REQUIRE_EQUAL(portfolio->size(), 20);
+    for (auto const& [id, t] : portfolio->trades())
+        BOOST_CHECK_CLOSE(t->instrument()->NPV(), expected.at(id), 1E-10);
+    // the model builders of the separate builder instance are reported as well
+    BOOST_CHECK_EQUAL(engineFactory->modelBuilders().size(), 20);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,190 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <boost/test/unit_test.hpp>
+#include <oret/toplevelfixture.hpp>
+
+#include <ored/utilities/profiler.hpp>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <future>
+#include <map>
+#include <set>
+#include <sstream>
+
+using namespace ore::data;
+using QuantLib::Size;
+
+namespace {
+
+// enables a clean profiler and disables it at the end of a test case
+class ProfilerFixture {
+public:
+    ProfilerFixture() {
+        Profiler::instance().reset();
+        Profiler::instance().setEnabled(true);
+        Profiler::instance().setAnalytic("TEST");
+    }
+    ~ProfilerFixture() {
+        Profiler::instance().setEnabled(false);
+        Profiler::instance().setTraceSampling(0);
+        Profiler::instance().setAnalytic(std::string());
+        Profiler::instance().reset();
+    }
+};
+
+const Size nThreads = 8;
+const Size nRecords = 500;
+
+// records nRecords measurements taking i + 1 microseconds for each phase / trade type below
+void recordMeasurements(const std::chrono::steady_clock::time_point& t0,
+                        const std::vector<std::pair<std::string, std::string>>& keys) {
+    for (Size i = 0; i < nRecords; ++i) {
+        auto start = t0 + std::chrono::microseconds(i);
+        for (auto const& [phase, tradeType] : keys)
+            Profiler::instance().record(phase, tradeType, std::string(), start,
+                                        start + std::chrono::microseconds(i + 1));
+    }
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(OREDataTestSuite, ore::test::TopLevelFixture)
+
+BOOST_FIXTURE_TEST_SUITE(ProfilerTest, ProfilerFixture)
+
+BOOST_AUTO_TEST_CASE(testMultiThreadedAggregation) {
+    BOOST_TEST_MESSAGE("Testing the aggregation of profile measurements over several threads...");
+
+    std::vector<std::pair<std::string, std::string>> keys = {
+        {"pricing", "Swap"}, {"pricing", "FxOption"}, {"scenario apply", ""}};
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::future<void>> results;
+    for (Size t = 0; t < nThreads; ++t)
+        results.push_back(std::async(std::launch::async, [&t0, &keys]() { recordMeasurements(t0, keys); }));
+    recordMeasurements(t0, keys);
+    for (auto& r : results)
+        r.get();
+
+    // measurements under another analytic are kept apart, also on a thread that has interned the keys before
+    Profiler::instance().setAnalytic("OTHER");
+    recordMeasurements(t0, {{"pricing", "Swap"}});
+    std::async(std::launch::async, [&t0]() { recordMeasurements(t0, {{"pricing", "Swap"}}); }).get();
+
+    auto stats = Profiler::instance().stats();
+    BOOST_REQUIRE_EQUAL(stats.size(), keys.size() + 1);
+    // sum of (i + 1) microseconds over the records
+    double total = 1E-6 * nRecords * (nRecords + 1) / 2.0;
+    for (auto const& [phase, tradeType] : keys) {
+        auto s = stats.find(ProfileKey{"TEST", phase, tradeType, ""});
+        BOOST_REQUIRE_MESSAGE(s != stats.end(), "no stats for " << phase << " " << tradeType);
+        BOOST_CHECK_EQUAL(s->second.count, (nThreads + 1) * nRecords);
+        BOOST_CHECK_CLOSE(s->second.totalTime, (nThreads + 1) * total, 1E-8);
+        BOOST_CHECK_CLOSE(s->second.minTime, 1E-6, 1E-8);
+        BOOST_CHECK_CLOSE(s->second.maxTime, 1E-6 * nRecords, 1E-8);
+    }
+    auto s = stats.find(ProfileKey{"OTHER", "pricing", "Swap", ""});
+    BOOST_REQUIRE(s != stats.end());
+    BOOST_CHECK_EQUAL(s->second.count, 2 * nRecords);
+    BOOST_CHECK_CLOSE(s->second.totalTime, 2 * total, 1E-8);
+
+    // a reset clears the measurements, the interned keys are reused afterwards
+    Profiler::instance().reset();
+    BOOST_CHECK(Profiler::instance().stats().empty());
+    recordMeasurements(t0, {{"pricing", "Swap"}});
+    stats = Profiler::instance().stats();
+    BOOST_REQUIRE_EQUAL(stats.size(), 1);
+    BOOST_CHECK_EQUAL(stats.begin()->second.count, nRecords);
+
+    // nothing is recorded by timers while the profiler is disabled
+    Profiler::instance().reset();
+    Profiler::instance().setEnabled(false);
+    { ScopedProfileTimer timer("pricing", "Swap"); }
+    BOOST_CHECK(Profiler::instance().stats().empty());
+    Profiler::instance().setEnabled(true);
+    { ScopedProfileTimer timer("pricing", "Swap"); }
+    BOOST_CHECK_EQUAL(Profiler::instance().stats().size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testChromeTrace) {
+    BOOST_TEST_MESSAGE("Testing that the profile trace is well formed JSON in Chrome trace event format...");
+
+    // all measurements are sampled, the phase names need escaping
+    Profiler::instance().setTraceSampling(1);
+    std::vector<std::pair<std::string, std::string>> keys = {{"pricing \"quoted\"", "Swap\\Leg"},
+                                                             {"scenario\napply", ""}};
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::future<void>> results;
+    for (Size t = 0; t < nThreads; ++t)
+        results.push_back(std::async(std::launch::async, [&t0, &keys]() { recordMeasurements(t0, keys); }));
+    for (auto& r : results)
+        r.get();
+
+    std::ostringstream out;
+    Profiler::instance().writeChromeTrace(out);
+    boost::property_tree::ptree trace;
+    std::istringstream in(out.str());
+    BOOST_REQUIRE_NO_THROW(boost::property_tree::read_json(in, trace));
+
+    auto const& events = trace.get_child("traceEvents");
+    BOOST_CHECK_EQUAL(events.size(), nThreads * nRecords * keys.size());
+    std::map<std::string, Size> names;
+    std::set<Size> threads;
+    double lastStart = 0.0;
+    for (auto const& [unused, e] : events) {
+        ++names[e.get<std::string>("name")];
+        threads.insert(e.get<Size>("tid"));
+        BOOST_CHECK_EQUAL(e.get<std::string>("ph"), "X");
+        BOOST_CHECK_EQUAL(e.get<std::string>("cat"), "TEST");
+        BOOST_CHECK_EQUAL(e.get<Size>("pid"), 0);
+        double start = e.get<double>("ts");
+        BOOST_CHECK_GE(start, lastStart);
+        BOOST_CHECK_GT(e.get<double>("dur"), 0.0);
+        lastStart = start;
+    }
+    BOOST_CHECK(!threads.empty() && threads.size() <= nThreads);
+    BOOST_REQUIRE_EQUAL(names.size(), keys.size());
+    BOOST_CHECK_EQUAL(names["pricing \"quoted\" Swap\\Leg"], nThreads * nRecords);
+    BOOST_CHECK_EQUAL(names["scenario apply"], nThreads * nRecords);
+
+    // every third measurement is sampled
+    Profiler::instance().reset();
+    Profiler::instance().setTraceSampling(3);
+    recordMeasurements(t0, {{"pricing", "Swap"}});
+    BOOST_CHECK_EQUAL(Profiler::instance().traceEvents().size(), (nRecords + 2) / 3);
+
+    // the number of events per thread is limited
+    Profiler::instance().reset();
+    Profiler::instance().setTraceSampling(1, 10);
+    recordMeasurements(t0, keys);
+    BOOST_CHECK_EQUAL(Profiler::instance().traceEvents().size(), 10);
+
+    // an empty trace is well formed, too
+    Profiler::instance().reset();
+    std::ostringstream emptyOut;
+    Profiler::instance().writeChromeTrace(emptyOut);
+    std::istringstream emptyIn(emptyOut.str());
+    BOOST_REQUIRE_NO_THROW(boost::property_tree::read_json(emptyIn, trace));
+    BOOST_CHECK_EQUAL(trace.get_child("traceEvents").size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
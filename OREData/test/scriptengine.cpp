@@ -24,6 +24,7 @@
 
 #include <ored/scripting/models/blackscholes.hpp>
 #include <ored/scripting/models/dummymodel.hpp>
+#include <ored/scripting/astcompiler.hpp>
 #include <ored/scripting/astprinter.hpp>
 #include <ored/scripting/scriptengine.hpp>
 #include <ored/scripting/scriptparser.hpp>
@@ -137,6 +138,65 @@ BOOST_AUTO_TEST_CASE(testFunctions) {
         1E-10);
 }
 
+BOOST_AUTO_TEST_CASE(testCompiledExpressions) {
+    BOOST_TEST_MESSAGE("Testing compiled expressions...");
+
+    // (x + 1) * 2 compiles to x, 1, +, 2, *
+    auto x = QuantLib::ext::make_shared<VariableNode>("x");
+    auto sum = QuantLib::ext::make_shared<OperatorPlusNode>(
+        std::vector<ASTNodePtr>{x, QuantLib::ext::make_shared<ConstantNumberNode>(1.0)});
+    auto product = QuantLib::ext::make_shared<OperatorMultiplyNode>(
+        std::vector<ASTNodePtr>{sum, QuantLib::ext::make_shared<ConstantNumberNode>(2.0)});
+    BOOST_CHECK(isCompilableExpression(*product));
+    BOOST_CHECK(!isCompilableExpression(*x));
+    auto p = compileExpression(*product);
+    using OpCode = ExpressionProgram::OpCode;
+    BOOST_REQUIRE_EQUAL(p.code.size(), 5);
+    BOOST_CHECK(p.code[0].op == OpCode::Variable);
+    BOOST_CHECK(p.code[1].op == OpCode::Constant);
+    BOOST_CHECK(p.code[2].op == OpCode::Plus);
+    BOOST_CHECK(p.code[3].op == OpCode::Constant);
+    BOOST_CHECK(p.code[4].op == OpCode::Multiply);
+    BOOST_CHECK_EQUAL(p.code[2].left, 0);
+    BOOST_CHECK_EQUAL(p.code[2].right, 1);
+    BOOST_CHECK_EQUAL(p.code[4].left, 2);
+    BOOST_CHECK_EQUAL(p.code[4].right, 3);
+
+    auto c = QuantLib::ext::make_shared<Context>();
+    c->scalars["x"] = RandomVariable(1, 2.0);
+    c->scalars["result"] = RandomVariable(1, 0.0);
+
+    BOOST_CHECK(close_enough_all(executeScript("result = max(x * 3, 7) - abs(-x) / 2;", c), RandomVariable(1, 6.0)));
+
+    // the right hand side of AND / OR must not be evaluated if the left hand side determines the result
+    BOOST_CHECK(close_enough_all(
+        executeScript("IF x == 1 AND undefined == 1 THEN result = 1; ELSE result = 2; END;", c),
+        RandomVariable(1, 2.0)));
+    BOOST_CHECK(close_enough_all(executeScript("IF x == 2 OR undefined == 1 THEN result = 1; END;", c),
+                                 RandomVariable(1, 1.0)));
+}
+
+BOOST_AUTO_TEST_CASE(testCompiledExpressionsCachedOnce) {
+    BOOST_TEST_MESSAGE("Testing that compiled expressions are cached once per AST node...");
+
+    ScriptParser parser("NUMBER x; x = (x + 1) * 2;");
+    BOOST_REQUIRE(parser.success());
+    auto ast = parser.ast();
+    BOOST_REQUIRE(ast->args.size() == 2);
+    auto assignment = QuantLib::ext::dynamic_pointer_cast<AssignmentNode>(ast->args[1]);
+    BOOST_REQUIRE(assignment);
+    auto expression = assignment->args[1];
+    BOOST_CHECK(expression->program == nullptr);
+
+    ScriptEngine(ast, QuantLib::ext::make_shared<Context>()).run();
+    BOOST_REQUIRE(expression->program != nullptr);
+    auto program = expression->program;
+    auto context = QuantLib::ext::make_shared<Context>();
+    ScriptEngine(ast, context).run();
+    BOOST_CHECK(expression->program == program);
+    BOOST_CHECK(close_enough_all(QuantLib::ext::get<RandomVariable>(context->scalars.at("x")), RandomVariable(1, 2.0)));
+}
+
 BOOST_AUTO_TEST_CASE(testDaycounterFunctions) {
     BOOST_TEST_MESSAGE("Testing daycounter functions...");
 
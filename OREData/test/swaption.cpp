@@ -26,6 +26,8 @@
 #include <ored/utilities/indexparser.hpp>
 #include <ored/utilities/to_string.hpp>
 #include <oret/toplevelfixture.hpp>
+#include <qle/models/modelbuilder.hpp>
+#include <ql/quotes/simplequote.hpp>
 #include <ql/termstructures/volatility/swaption/swaptionconstantvol.hpp>
 #include <ql/termstructures/yield/flatforward.hpp>
 #include <ql/time/calendars/target.hpp>
@@ -40,14 +42,15 @@ namespace {
 
 class TestMarket : public MarketImpl {
 public:
-    TestMarket() : MarketImpl(false) {
+    TestMarket(const Handle<Quote>& swaptionVol = Handle<Quote>(QuantLib::ext::make_shared<SimpleQuote>(0.30)))
+        : MarketImpl(false) {
         asof_ = Date(2, January, 2017);
 
         // build discount
         yieldCurves_[make_tuple(Market::defaultConfiguration, YieldCurveType::Discount, "EUR")] = flatRateYts(0.03);
 
         // build swaption vols
-        swaptionCurves_[make_pair(Market::defaultConfiguration, "EUR")] = flatSwaptionVol(0.30);
+        swaptionCurves_[make_pair(Market::defaultConfiguration, "EUR")] = flatSwaptionVol(swaptionVol);
 
         Handle<IborIndex> h(parseIborIndex("EUR-EURIBOR-6M", flatRateYts(0.03)));
         iborIndices_[make_pair(Market::defaultConfiguration, "EUR-EURIBOR-6M")] = h;
@@ -59,7 +62,7 @@ private:
         return Handle<YieldTermStructure>(yts);
     }
     Handle<QuantLib::SwaptionVolatilityStructure>
-    flatSwaptionVol(Volatility forward, VolatilityType type = ShiftedLognormal, Real shift = 0.0) {
+    flatSwaptionVol(const Handle<Quote>& forward, VolatilityType type = ShiftedLognormal, Real shift = 0.0) {
         QuantLib::ext::shared_ptr<QuantLib::SwaptionVolatilityStructure> svs(
             new QuantLib::ConstantSwaptionVolatility(Settings::instance().evaluationDate(), NullCalendar(),
                                                      ModifiedFollowing, forward, ActualActual(ActualActual::ISDA), type, shift));
@@ -144,6 +147,74 @@ BOOST_AUTO_TEST_CASE(testEuropeanSwaptionPrice) {
     BOOST_CHECK_SMALL(npvPremium - expectedNpvPremium, 0.01);
 }
 
+namespace {
+// price a bermudan swaption with a calibrated LGM, shift the swaption vol, recalibrate and reprice
+Real bermudanNpvAfterRecalibration(const bool warmStart) {
+    Settings::instance().evaluationDate() = Date(2, January, 2017);
+    auto vol = QuantLib::ext::make_shared<SimpleQuote>(0.30);
+    QuantLib::ext::shared_ptr<Market> market = QuantLib::ext::make_shared<TestMarket>(Handle<Quote>(vol));
+    Settings::instance().evaluationDate() = market->asofDate();
+
+    Date today = market->asofDate();
+    Calendar calendar = TARGET();
+    Date qlStartDate = calendar.adjust(today + 2 * Years);
+    Date qlEndDate = calendar.adjust(qlStartDate + 10 * Years);
+    string startDate = ore::data::to_string(qlStartDate);
+    string endDate = ore::data::to_string(qlEndDate);
+    ScheduleData floatSchedule(ScheduleRules(startDate, endDate, "6M", "TARGET", "MF", "MF", "Forward"));
+    ScheduleData fixedSchedule(ScheduleRules(startDate, endDate, "1Y", "TARGET", "MF", "MF", "Forward"));
+    LegData fixedLeg(QuantLib::ext::make_shared<FixedLegData>(std::vector<Real>(1, 0.03)), true, "EUR", fixedSchedule,
+                     "30/360", std::vector<Real>(1, 10000.0));
+    LegData floatingLeg(QuantLib::ext::make_shared<FloatingLegData>("EUR-EURIBOR-6M", 2, false,
+                                                                    std::vector<Real>(1, 0.0)),
+                        false, "EUR", floatSchedule, "A360", std::vector<Real>(1, 10000.0));
+    vector<string> exerciseDates;
+    for (Size i = 0; i < 5; ++i)
+        exerciseDates.push_back(ore::data::to_string(calendar.adjust(qlStartDate + (2 * i) * Years)));
+    OptionData optionData("Long", "Call", "Bermudan", false, exerciseDates, "Physical");
+    ore::data::Swaption swaption(Envelope("CP1"), optionData, {fixedLeg, floatingLeg});
+
+    QuantLib::ext::shared_ptr<EngineData> engineData = QuantLib::ext::make_shared<EngineData>();
+    engineData->model("BermudanSwaption") = "LGM";
+    engineData->modelParameters("BermudanSwaption") = {
+        {"Calibration", "Bootstrap"}, {"CalibrationStrategy", "CoterminalATM"}, {"Reversion", "0.03"},
+        {"ReversionType", "HullWhite"}, {"Volatility", "0.01"},   {"VolatilityType", "Hagan"},
+        {"ShiftHorizon", "0.5"},      {"Tolerance", "0.0001"}};
+    engineData->engine("BermudanSwaption") = "Grid";
+    engineData->engineParameters("BermudanSwaption") = {{"sy", "3.0"}, {"ny", "10"}, {"sx", "3.0"}, {"nx", "10"}};
+    engineData->model("Swap") = "DiscountedCashflows";
+    engineData->engine("Swap") = "DiscountingSwapEngine";
+    engineData->globalParameters()["WarmStartCalibration"] = warmStart ? "true" : "false";
+    auto engineFactory = QuantLib::ext::make_shared<EngineFactory>(engineData, market);
+
+    swaption.build(engineFactory);
+    swaption.instrument()->NPV();
+
+    auto modelBuilders = engineFactory->modelBuilders();
+    BOOST_REQUIRE_EQUAL(modelBuilders.size(), 1);
+    for (auto const& b : modelBuilders)
+        BOOST_CHECK_EQUAL(b.second->warmStart(), warmStart);
+
+    vol->setValue(0.35);
+    for (auto const& b : modelBuilders)
+        b.second->recalibrate();
+    return swaption.instrument()->NPV();
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(testWarmStartRecalibration) {
+
+    BOOST_TEST_MESSAGE("Testing warm start LGM recalibration against cold start...");
+
+    Real npvCold = bermudanNpvAfterRecalibration(false);
+    Real npvWarm = bermudanNpvAfterRecalibration(true);
+
+    BOOST_TEST_MESSAGE("NPV after recalibration, cold start = " << npvCold << ", warm start = " << npvWarm);
+
+    // both calibrations meet the bootstrap tolerance, the prices agree up to the calibration error
+    BOOST_CHECK_CLOSE(npvWarm, npvCold, 0.01);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
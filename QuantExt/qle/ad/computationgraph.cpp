@@ -25,6 +25,8 @@
 
 #include <boost/math/distributions/normal.hpp>
 
+#include <algorithm>
+
 namespace QuantExt {
 
 std::size_t ComputationGraph::nan = std::numeric_limits<std::size_t>::max();
@@ -40,6 +42,8 @@ void ComputationGraph::clear() {
     variables_.clear();
     variableVersion_.clear();
     labels_.clear();
+    cse_.clear();
+    commonSubexpressions_ = 0;
 }
 
 std::size_t ComputationGraph::size() const { return predecessors_.size(); }
@@ -57,9 +61,32 @@ std::size_t ComputationGraph::insert(const std::string& label) {
     return node;
 }
 
+std::size_t ComputationGraph::hash(const std::vector<std::size_t>& predecessors, const std::size_t opId) const {
+    std::size_t seed = std::hash<std::size_t>()(opId);
+    for (auto const& p : predecessors)
+        seed ^= std::hash<std::size_t>()(p) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
 std::size_t ComputationGraph::insert(const std::vector<std::size_t>& predecessors, const std::size_t opId,
                                      const std::string& label) {
+    std::size_t h = 0;
+    if (enableCse_ && !predecessors.empty()) {
+        h = hash(predecessors, opId);
+        auto range = cse_.equal_range(h);
+        for (auto c = range.first; c != range.second; ++c) {
+            if (opId_[c->second] == opId && redBlockId_[c->second] == currentRedBlockId_ &&
+                predecessors_[c->second] == predecessors) {
+                ++commonSubexpressions_;
+                if (enableLabels_ && !label.empty())
+                    labels_[c->second].insert(label);
+                return c->second;
+            }
+        }
+    }
     std::size_t node = predecessors_.size();
+    if (enableCse_ && !predecessors.empty())
+        cse_.insert(std::make_pair(h, node));
     predecessors_.push_back(predecessors);
     opId_.push_back(opId);
     for (auto const& p : predecessors) {
@@ -180,6 +207,60 @@ const std::set<std::size_t>& ComputationGraph::redBlockDependencies() const { re
 
 std::size_t ComputationGraph::redBlockId(const std::size_t node) const { return redBlockId_[node]; }
 
+void ComputationGraph::enableCommonSubexpressionElimination(const bool b) {
+    enableCse_ = b;
+    if (!b)
+        cse_.clear();
+}
+
+std::size_t ComputationGraph::commonSubexpressions() const { return commonSubexpressions_; }
+
+std::size_t ComputationGraph::eliminateDeadNodes(const std::vector<std::size_t>& outputs) {
+
+    // mark the nodes the outputs depend on, predecessors always have a smaller index than their successors
+
+    std::vector<bool> live(size(), false);
+    for (auto const& o : outputs) {
+        QL_REQUIRE(o < size(), "ComputationGraph::eliminateDeadNodes(): output node " << o << " out of range, graph size is "
+                                                                                      << size());
+        live[o] = true;
+    }
+    for (std::size_t node = size(); node > 0; --node) {
+        if (live[node - 1]) {
+            for (auto const& p : predecessors_[node - 1])
+                live[p] = true;
+        }
+    }
+
+    // remove the ops of the dead nodes and recompute the max node requiring an arg
+
+    std::size_t eliminated = 0;
+    for (std::size_t node = 0; node < size(); ++node) {
+        if (!live[node] && !predecessors_[node].empty()) {
+            predecessors_[node].clear();
+            opId_[node] = 0;
+            ++eliminated;
+        }
+    }
+
+    std::fill(maxNodeRequiringArg_.begin(), maxNodeRequiringArg_.end(), 0);
+    for (std::size_t node = 0; node < size(); ++node) {
+        for (auto const& p : predecessors_[node])
+            maxNodeRequiringArg_[p] = node;
+    }
+
+    // dead nodes must not be returned by later inserts
+
+    for (auto c = cse_.begin(); c != cse_.end();) {
+        if (predecessors_[c->second].empty())
+            c = cse_.erase(c);
+        else
+            ++c;
+    }
+
+    return eliminated;
+}
+
 bool ComputationGraph::isConstant(const std::size_t node) const { return isConstant_[node]; }
 
 double ComputationGraph::constantValue(const std::size_t node) const { return constantValue_[node]; }
@@ -199,7 +280,7 @@ std::size_t cg_add(ComputationGraph& g, const std::size_t a, const std::size_t b
         return b;
     if (g.isConstant(b) && QuantLib::close_enough(g.constantValue(b), 0.0))
         return a;
-    return g.insert({a, b}, RandomVariableOpCode::Add, label);
+    return g.insert({std::min(a, b), std::max(a, b)}, RandomVariableOpCode::Add, label);
 }
 
 std::size_t cg_add(ComputationGraph& g, const std::vector<std::size_t>& a, const std::string& label) {
@@ -223,6 +304,8 @@ std::size_t cg_subtract(ComputationGraph& g, const std::size_t a, const std::siz
 std::size_t cg_negative(ComputationGraph& g, const std::size_t a, const std::string& label) {
     if (g.isConstant(a))
         return cg_const(g, -g.constantValue(a));
+    if (g.opId(a) == RandomVariableOpCode::Negative && g.predecessors(a).size() == 1)
+        return g.predecessors(a)[0];
     return g.insert({a}, RandomVariableOpCode::Negative, label);
 }
 
@@ -236,7 +319,7 @@ std::size_t cg_mult(ComputationGraph& g, const std::size_t a, const std::size_t
     if ((g.isConstant(a) && QuantLib::close_enough(g.constantValue(a), 0.0)) ||
         (g.isConstant(b) && QuantLib::close_enough(g.constantValue(b), 0.0)))
         return cg_const(g, 0.0);
-    return g.insert({a, b}, RandomVariableOpCode::Mult, label);
+    return g.insert({std::min(a, b), std::max(a, b)}, RandomVariableOpCode::Mult, label);
 }
 
 std::size_t cg_div(ComputationGraph& g, const std::size_t a, const std::size_t b, const std::string& label) {
@@ -266,7 +349,7 @@ std::size_t cg_conditionalExpectation(ComputationGraph& g, const std::size_t reg
 std::size_t cg_indicatorEq(ComputationGraph& g, const std::size_t a, const std::size_t b, const std::string& label) {
     if (g.isConstant(a) && g.isConstant(b))
         return cg_const(g, QuantLib::close_enough(g.constantValue(a), g.constantValue(b)) ? 1.0 : 0.0);
-    return g.insert({a, b}, RandomVariableOpCode::IndicatorEq, label);
+    return g.insert({std::min(a, b), std::max(a, b)}, RandomVariableOpCode::IndicatorEq, label);
 }
 
 std::size_t cg_indicatorGt(ComputationGraph& g, const std::size_t a, const std::size_t b, const std::string& label) {
@@ -27,11 +27,15 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace QuantExt {
 
-/*! - opId = 0 should refer to "no operation" */
+/*! - opId = 0 should refer to "no operation"
+    - ops are assumed to be pure functions of their arguments: if common subexpression elimination is enabled (the
+      default), inserting a node with the same op and predecessors as an existing node in the same red block returns
+      the existing node */
 class ComputationGraph {
 public:
     enum class VarDoesntExist { Nan, Create, Throw };
@@ -66,7 +70,18 @@ public:
     const std::vector<std::pair<std::size_t, std::size_t>>& redBlockRanges() const;
     const std::set<std::size_t>& redBlockDependencies() const;
 
+    void enableCommonSubexpressionElimination(const bool b = true);
+    //! number of inserts that were resolved to an existing node
+    std::size_t commonSubexpressions() const;
+
+    /*! turns all op nodes that do not contribute to one of the given outputs into nodes without predecessors, so
+        that they are skipped in forward evaluation and backward derivatives. The node numbering is not changed.
+        Returns the number of eliminated nodes. */
+    std::size_t eliminateDeadNodes(const std::vector<std::size_t>& outputs);
+
 private:
+    std::size_t hash(const std::vector<std::size_t>& predecessors, const std::size_t opId) const;
+
     std::vector<std::vector<std::size_t>> predecessors_;
     std::vector<std::size_t> opId_;
     std::vector<bool> isConstant_;
@@ -86,6 +101,10 @@ private:
     std::size_t nextRedBlockId_ = 0;
     std::vector<std::pair<std::size_t, std::size_t>> redBlockRange_;
     std::set<std::size_t> redBlockDependencies_;
+
+    bool enableCse_ = true;
+    std::unordered_multimap<std::size_t, std::size_t> cse_;
+    std::size_t commonSubexpressions_ = 0;
 };
 
 // methods to construct cg
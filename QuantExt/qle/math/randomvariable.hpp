@@ -223,6 +223,7 @@ struct RandomVariable {
     void expand();
     // pointer to raw data, this is null for deterministic variables
     double* data();
+    const double* data() const;
 
     static std::function<void(RandomVariable&)> deleter;
 
@@ -372,6 +373,8 @@ inline Real RandomVariable::at(const Size i) const {
 
 inline double* RandomVariable::data() { return data_; }
 
+inline const double* RandomVariable::data() const { return data_; }
+
 /*! helper function that returns a LSM basis system with size restriction: the order is reduced until
   the size of the basis system is not greater than the given bound (if this is not null) or the order is 1 */
 std::vector<std::function<RandomVariable(const std::vector<const RandomVariable*>&)>>
@@ -0,0 +1,108 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include <qle/methods/fdmbatchedbackwardsolver.hpp>
+
+#include <algorithm>
+
+namespace QuantExt {
+
+// operator acting on several arrays stacked into one, block by block with the same underlying operator
+class FdmBatchedBackwardSolver::BlockOp : public FdmLinearOpComposite {
+public:
+    BlockOp(const ext::shared_ptr<FdmLinearOpComposite>& map, const Size blockSize, const Size blocks)
+        : map_(map), blockSize_(blockSize), blocks_(blocks) {}
+
+    Size size() const override { return map_->size(); }
+    void setTime(Time t1, Time t2) override { map_->setTime(t1, t2); }
+
+    Array apply(const Array& r) const override {
+        return forEachBlock(r, [this](const Array& x) { return map_->apply(x); });
+    }
+    Array apply_mixed(const Array& r) const override {
+        return forEachBlock(r, [this](const Array& x) { return map_->apply_mixed(x); });
+    }
+    Array apply_direction(Size direction, const Array& r) const override {
+        return forEachBlock(r, [this, direction](const Array& x) { return map_->apply_direction(direction, x); });
+    }
+    Array solve_splitting(Size direction, const Array& r, Real s) const override {
+        return forEachBlock(r, [this, direction, s](const Array& x) { return map_->solve_splitting(direction, x, s); });
+    }
+    Array preconditioner(const Array& r, Real s) const override {
+        return forEachBlock(r, [this, s](const Array& x) { return map_->preconditioner(x, s); });
+    }
+
+#if !defined(QL_NO_UBLAS_SUPPORT)
+    std::vector<QuantLib::SparseMatrix> toMatrixDecomp() const override {
+        QL_FAIL("FdmBatchedBackwardSolver: matrix representation of batched operator not supported");
+    }
+#endif
+
+private:
+    template <class F> Array forEachBlock(const Array& r, const F& f) const {
+        QL_REQUIRE(r.size() == blockSize_ * blocks_, "FdmBatchedBackwardSolver: array size ("
+                                                         << r.size() << ") does not match " << blocks_
+                                                         << " blocks of size " << blockSize_);
+        Array result(r.size()), x(blockSize_);
+        for (Size b = 0; b < blocks_; ++b) {
+            std::copy(r.begin() + b * blockSize_, r.begin() + (b + 1) * blockSize_, x.begin());
+            Array y = f(x);
+            std::copy(y.begin(), y.end(), result.begin() + b * blockSize_);
+        }
+        return result;
+    }
+
+    ext::shared_ptr<FdmLinearOpComposite> map_;
+    Size blockSize_, blocks_;
+};
+
+FdmBatchedBackwardSolver::FdmBatchedBackwardSolver(const ext::shared_ptr<FdmLinearOpComposite>& map,
+                                                   const FdmSchemeDesc& schemeDesc)
+    : map_(map), schemeDesc_(schemeDesc) {}
+
+void FdmBatchedBackwardSolver::rollback(const std::vector<Array*>& a, Time from, Time to, Size steps,
+                                        Size dampingSteps) const {
+    if (a.empty())
+        return;
+    Size blockSize = a.front()->size();
+    for (auto r : a) {
+        QL_REQUIRE(r->size() == blockSize, "FdmBatchedBackwardSolver::rollback(): array sizes differ ("
+                                               << r->size() << ", " << blockSize << ")");
+    }
+
+    // stack the arrays and roll them back through the block operator, so that the scheme sets up the
+    // operator once per stage of each time step for all arrays
+    Array stacked(blockSize * a.size());
+    for (Size b = 0; b < a.size(); ++b)
+        std::copy(a[b]->begin(), a[b]->end(), stacked.begin() + b * blockSize);
+    FdmBackwardSolver solver(ext::make_shared<BlockOp>(map_, blockSize, a.size()),
+                             std::vector<ext::shared_ptr<BoundaryCondition<FdmLinearOp>>>(), nullptr, schemeDesc_);
+    solver.rollback(stacked, from, to, steps, dampingSteps);
+    for (Size b = 0; b < a.size(); ++b)
+        std::copy(stacked.begin() + b * blockSize, stacked.begin() + (b + 1) * blockSize, a[b]->begin());
+}
+
+void FdmBatchedBackwardSolver::rollback(std::vector<Array>& a, Time from, Time to, Size steps,
+                                        Size dampingSteps) const {
+    std::vector<Array*> p;
+    for (auto& r : a)
+        p.push_back(&r);
+    rollback(p, from, to, steps, dampingSteps);
+}
+
+} // namespace QuantExt
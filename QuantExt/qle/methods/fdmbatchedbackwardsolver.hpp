@@ -0,0 +1,55 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+/*! \file fdmbatchedbackwardsolver.hpp
+    \brief backward solver rolling back several arrays through the same operator
+*/
+
+#pragma once
+
+#include <ql/methods/finitedifferences/operators/fdmlinearopcomposite.hpp>
+#include <ql/methods/finitedifferences/solvers/fdmbackwardsolver.hpp>
+
+#include <vector>
+
+namespace QuantExt {
+using namespace QuantLib;
+
+//! Backward solver rolling back several arrays through the same operator
+/*! The arrays are stacked and rolled back by a single FdmBackwardSolver through an operator applying the given
+    operator block by block. The scheme therefore sets up the operator once per stage of a time step for all
+    arrays, whatever sequence of setTime() calls it makes, instead of once per array as in separate
+    FdmBackwardSolver::rollback() calls. With the direct solvers used by the splitting schemes the result equals
+    that of separate rollbacks, schemes solving iteratively apply their tolerance to the stacked array. No
+    boundary conditions and no step conditions are supported. */
+class FdmBatchedBackwardSolver {
+public:
+    FdmBatchedBackwardSolver(const ext::shared_ptr<FdmLinearOpComposite>& map, const FdmSchemeDesc& schemeDesc);
+
+    /*! roll back all arrays from \p from to \p to, using \p dampingSteps implicit Euler steps followed by \p steps
+        steps of the given scheme, as FdmBackwardSolver::rollback() does */
+    void rollback(const std::vector<Array*>& a, Time from, Time to, Size steps, Size dampingSteps) const;
+    void rollback(std::vector<Array>& a, Time from, Time to, Size steps, Size dampingSteps) const;
+
+private:
+    class BlockOp;
+    ext::shared_ptr<FdmLinearOpComposite> map_;
+    FdmSchemeDesc schemeDesc_;
+};
+
+} // namespace QuantExt
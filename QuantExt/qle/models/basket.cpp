@@ -295,6 +295,15 @@ Real Basket::expectedTrancheLoss(const Date& d, Real recoveryRate) const {
     return cumulatedLoss() + lossModel_->expectedTrancheLoss(d, recoveryRate);
 }
 
+std::vector<Real> Basket::expectedTrancheLosses(const std::vector<Date>& dates, Real recoveryRate) const {
+    calculate();
+    std::vector<Real> result = lossModel_->expectedTrancheLosses(dates, recoveryRate);
+    Real cumLoss = cumulatedLoss();
+    for (auto& l : result)
+        l += cumLoss;
+    return result;
+}
+
 std::vector<Real> Basket::splitVaRLevel(const Date& date, Real loss) const {
     calculate();
     return lossModel_->splitVaRLevel(date, loss);
@@ -228,6 +228,8 @@ public:
     */
     //@{
     Real expectedTrancheLoss(const Date& d, Real recoveryRate = Null<Real>()) const;
+    //! Expected tranche loss for each of the given dates, computed in one call to the loss model
+    std::vector<Real> expectedTrancheLosses(const std::vector<Date>& dates, Real recoveryRate = Null<Real>()) const;
     /*! The lossFraction is the fraction of losses expressed in
         inception (no losses) tranche units (e.g. 'attach level'=0%,
         'detach level'=100%)
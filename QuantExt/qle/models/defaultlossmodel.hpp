@@ -71,6 +71,17 @@ protected:
     virtual Real expectedTrancheLoss(const Date& d, Real recoveryRate = Null<Real>()) const {
         QL_FAIL("expectedTrancheLoss Not implemented for this model.");
     }
+
+    /* Expected tranche losses for a set of dates, e.g. the coupon dates of a tranche. The default implementation
+       calls expectedTrancheLoss(Date) for each date, models can override this to share work across the dates. */
+    virtual std::vector<Real> expectedTrancheLosses(const std::vector<Date>& dates,
+                                                    Real recoveryRate = Null<Real>()) const {
+        std::vector<Real> result;
+        result.reserve(dates.size());
+        for (auto const& d : dates)
+            result.push_back(expectedTrancheLoss(d, recoveryRate));
+        return result;
+    }
     /*! Probability of the tranche losing the same or more than the
         fractional amount given.
 
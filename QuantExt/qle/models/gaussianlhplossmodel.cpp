@@ -23,6 +23,8 @@
 
 #include <boost/make_shared.hpp>
 
+#include <map>
+
 using std::sqrt;
 
 using namespace QuantLib;
@@ -70,26 +72,90 @@ Real GaussianLHPLossModel::expectedTrancheLossImpl(Real remainingNot, // << at t
                                                    Real averageRR,    // << at the given date 'd'
                                                    // these are percentual values:
                                                    Real attachLimit, Real detachLimit) const {
+    return expectedTrancheLossImpl(remainingNot, prob, averageRR, attachLimit, detachLimit, Null<Real>(), nullptr);
+}
+
+Real GaussianLHPLossModel::expectedTrancheLossImpl(Real remainingNot, Real prob, Real averageRR, Real attachLimit,
+                                                   Real detachLimit, Real ip, std::map<Real, Real>* invK) const {
 
     if (attachLimit >= detachLimit)
         return 0.; // or is it an error?
     // expected remaining notional:
     if (remainingNot == 0.)
         return 0.;
+    if (prob <= 0)
+        return 0.0;
+
+    auto inverse = [invK](Real k) {
+        if (invK == nullptr)
+            return InverseCumulativeNormal::standard_value(k);
+        auto it = invK->find(k);
+        if (it == invK->end())
+            it = invK->emplace(k, InverseCumulativeNormal::standard_value(k)).first;
+        return it->second;
+    };
 
     const Real one = 1.0 - 1.0e-12; // FIXME DUE TO THE INV CUMUL AT 1
     const Real k1 = std::min(one, attachLimit / (1.0 - averageRR)) + QL_EPSILON;
     const Real k2 = std::min(one, detachLimit / (1.0 - averageRR)) + QL_EPSILON;
 
-    if (prob > 0) {
+    if (ip == Null<Real>())
+        ip = InverseCumulativeNormal::standard_value(prob);
+    const Real invFlightK1 = (ip - sqrt1minuscorrel_ * inverse(k1)) / beta_;
+    const Real invFlightK2 = (ip - sqrt1minuscorrel_ * inverse(k2)) / beta_;
+
+    return remainingNot * (detachLimit * phi_(invFlightK2) - attachLimit * phi_(invFlightK1) +
+                           (1. - averageRR) * (biphi_(ip, -invFlightK2) - biphi_(ip, -invFlightK1)));
+}
+
+std::vector<std::vector<Real>> GaussianLHPLossModel::expectedTrancheLosses(const std::vector<Date>& dates,
+                                                                           const std::vector<Real>& attachAmounts,
+                                                                           const std::vector<Real>& detachAmounts,
+                                                                           Real recoveryRate) const {
+    QL_REQUIRE(attachAmounts.size() == detachAmounts.size(),
+               "GaussianLHPLossModel::expectedTrancheLosses(): attachment amounts ("
+                   << attachAmounts.size() << ") and detachment amounts (" << detachAmounts.size()
+                   << ") must have the same size");
+
+    std::vector<std::vector<Real>> result(attachAmounts.size(), std::vector<Real>(dates.size(), 0.0));
+
+    // inverse normal values of the attachment / detachment points, these only change with the remaining notional
+    // and the average recovery, so they are typically shared by all dates
+    std::map<Real, Real> invK;
+
+    for (Size j = 0; j < dates.size(); ++j) {
+
+        const Real remainingNot = basket_->remainingNotional(dates[j]);
+        if (remainingNot == 0.)
+            continue;
+
+        // same as averageProb() and averageRecovery(), but reading the basket only once
+        const std::vector<Probability> probs = basket_->remainingProbabilities(dates[j]);
+        const std::vector<Real> notionals = basket_->remainingNotionals(dates[j]);
+        const Probability prob = std::inner_product(probs.begin(), probs.end(), notionals.begin(), 0.) / remainingNot;
+        if (prob <= 0)
+            continue;
+
+        Real averageRR = recoveryRate;
+        if (averageRR == Null<Real>()) {
+            Real denominator = std::inner_product(notionals.begin(), notionals.end(), probs.begin(), 0.);
+            averageRR = 0.0;
+            if (denominator != 0.) {
+                for (Size i = 0; i < basket_->remainingSize(); ++i)
+                    averageRR += rrQuotes_[i]->value() * (notionals[i] * probs[i]);
+                averageRR /= denominator;
+            }
+        }
+
         const Real ip = InverseCumulativeNormal::standard_value(prob);
-        const Real invFlightK1 = (ip - sqrt1minuscorrel_ * InverseCumulativeNormal::standard_value(k1)) / beta_;
-        const Real invFlightK2 = (ip - sqrt1minuscorrel_ * InverseCumulativeNormal::standard_value(k2)) / beta_;
 
-        return remainingNot * (detachLimit * phi_(invFlightK2) - attachLimit * phi_(invFlightK1) +
-                               (1. - averageRR) * (biphi_(ip, -invFlightK2) - biphi_(ip, -invFlightK1)));
-    } else
-        return 0.0;
+        for (Size k = 0; k < attachAmounts.size(); ++k) {
+            result[k][j] = expectedTrancheLossImpl(remainingNot, prob, averageRR, attachAmounts[k] / remainingNot,
+                                                   detachAmounts[k] / remainingNot, ip, &invK);
+        }
+    }
+
+    return result;
 }
 
 Real GaussianLHPLossModel::probOverLoss(const Date& d, Real remainingLossFraction) const {
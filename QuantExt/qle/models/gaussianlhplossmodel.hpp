@@ -30,6 +30,7 @@
 #include <qle/models/defaultlossmodel.hpp>
 //#include <ql/experimental/credit/basket.hpp>
 #include <ql/functional.hpp>
+#include <map>
 #include <numeric>
 #include <ql/experimental/math/latentmodel.hpp>
 #include <qle/models/basket.hpp>
@@ -88,6 +89,11 @@ private:
                                  Real prob,         // << at the given date 'd'
                                  Real averageRR,    // << at the given date 'd'
                                  Real attachLimit, Real detachLimit) const;
+    /*! kernel shared by the single and the batched expected tranche loss, \p ip is the inverse normal of \p prob
+        or Null<Real>() to compute it here, the inverse normal values of the attachment and detachment points are
+        looked up in and added to \p invK if given */
+    Real expectedTrancheLossImpl(Real remainingNot, Real prob, Real averageRR, Real attachLimit, Real detachLimit,
+                                 Real ip, std::map<Real, Real>* invK) const;
 
 public:
     // RL: additional flag
@@ -109,6 +115,25 @@ public:
         return expectedTrancheLossImpl(remainingfullNot, prob, averageRR, attach, detach);
     }
 
+    /*! Expected tranche losses for several dates in one pass. The basket probabilities and notionals are read once
+        per date and the inverse normal values of the attachment and detachment points are reused across dates.
+    */
+    std::vector<Real> expectedTrancheLosses(const std::vector<Date>& dates,
+                                            Real recoveryRate = Null<Real>()) const override {
+        return expectedTrancheLosses(dates, {basket_->remainingAttachmentAmount()},
+                                     {basket_->remainingDetachmentAmount()}, recoveryRate)
+            .front();
+    }
+
+    /*! Expected losses of several tranches on the basket's pool, given by their remaining attachment and
+        detachment amounts, for several dates. The result is indexed by tranche, then date. The inversion of the
+        average default probability at each date is shared by all tranches.
+    */
+    std::vector<std::vector<Real>> expectedTrancheLosses(const std::vector<Date>& dates,
+                                                         const std::vector<Real>& attachAmounts,
+                                                         const std::vector<Real>& detachAmounts,
+                                                         Real recoveryRate = Null<Real>()) const;
+
     /*! The passed remainingLossFraction is in live tranche units,
         not portfolio as a fraction of the remaining(live) tranche
         (i.e. a_remaining=0% and det_remaining=100%)
@@ -23,8 +23,8 @@
 namespace QuantExt {
 
 LgmConvolutionSolver2::LgmConvolutionSolver2(const QuantLib::ext::shared_ptr<LinearGaussMarkovModel>& model, const Real sy,
-                                             const Size ny, const Real sx, const Size nx)
-    : model_(model), nx_(static_cast<int>(nx)) {
+                                             const Size ny, const Real sx, const Size nx, const bool cacheStencils)
+    : model_(model), nx_(static_cast<int>(nx)), cacheStencils_(cacheStencils) {
 
     // precompute weights
 
@@ -68,49 +68,138 @@ RandomVariable LgmConvolutionSolver2::stateGrid(const Real t) const {
     return x;
 }
 
-RandomVariable LgmConvolutionSolver2::rollback(const RandomVariable& v, const Real t1, const Real t0, Size) const {
-    if (QuantLib::close_enough(t0, t1) || v.deterministic())
-        return v;
-    QL_REQUIRE(t0 < t1, "LgmConvolutionSolver2::rollback(): t0 (" << t0 << ") < t1 (" << t1 << ") required.");
-    Real sigma = std::sqrt(model_->parametrization()->zeta(t1));
+QuantLib::ext::shared_ptr<const LgmConvolutionSolver2::Stencil>
+LgmConvolutionSolver2::stencil(const Real zeta0, const Real zeta1) const {
+    if (!cacheStencils_)
+        return buildStencil(zeta0, zeta1);
+
+    auto key = std::make_pair(zeta0, zeta1);
+    {
+        boost::shared_lock<boost::shared_mutex> lock(mutex_);
+        if (auto s = stencilCache_.find(key); s != stencilCache_.end())
+            return s->second;
+    }
+
+    // build outside the lock, if another thread inserted the same key meanwhile we keep its stencil
+    auto s = buildStencil(zeta0, zeta1);
+    boost::unique_lock<boost::shared_mutex> lock(mutex_);
+    // keep the cache bounded if the model parameters change often, e.g. under recalibration in scenario runs
+    constexpr Size maxCachedStencils = 256;
+    if (stencilCache_.size() >= maxCachedStencils)
+        stencilCache_.clear();
+    return stencilCache_.insert(std::make_pair(key, s)).first->second;
+}
+
+QuantLib::ext::shared_ptr<const LgmConvolutionSolver2::Stencil>
+LgmConvolutionSolver2::buildStencil(const Real zeta0, const Real zeta1) const {
+    Real sigma = std::sqrt(zeta1);
     Real dx = sigma / static_cast<Real>(nx_);
-    if (QuantLib::close_enough(t0, 0.0)) {
-        // rollback from t1 to t0 = 0
-        Real value = 0.0;
+    Real std = std::sqrt(zeta1 - zeta0);
+    Real dx2 = std::sqrt(zeta0) / static_cast<Real>(nx_);
+    bool toZero = QuantLib::close_enough(zeta0, 0.0);
+    Size rows = toZero ? 1 : 2 * mx_ + 1;
+    Size n = 2 * mx_ + 1;
+
+    // collect the contributions per row, the x indices are non-decreasing in the y index
+
+    std::vector<std::vector<std::pair<Size, Real>>> contributions(rows);
+    for (Size r = 0; r < rows; ++r) {
+        int k = toZero ? mx_ : static_cast<int>(r);
         for (int i = 0; i <= 2 * my_; i++) {
             // Map y index to x index, not integer in general
-            Real kp = y_[i] * sigma / dx + mx_;
+            Real kp = (dx2 * (k - mx_) + y_[i] * std) / dx + mx_;
             // Adjacent integer x index <= k
             int kk = int(floor(kp));
             // Get value at kp by linear interpolation on
             // kk <= kp <= kk + 1 with flat extrapolation
-            value +=
-                w_[i] *
-                (kk < 0 ? v[0] : (kk + 1 > 2 * mx_ ? v[2 * mx_] : (kp - kk) * v[kk + 1] + (1.0 + kk - kp) * v[kk]));
-        }
-        return RandomVariable(2 * mx_ + 1, value);
-    } else {
-        RandomVariable value(2 * mx_ + 1, 0.0);
-        value.expand();
-        // rollback from t1 to t0 > 0
-        Real std = std::sqrt(model_->parametrization()->zeta(t1) - model_->parametrization()->zeta(t0));
-        Real dx2 = std::sqrt(model_->parametrization()->zeta(t0)) / static_cast<Real>(nx_);
-        for (int k = 0; k <= 2 * mx_; k++) {
-            for (int i = 0; i <= 2 * my_; i++) {
-                // Map y index to x index, not integer in generalTo
-                Real kp = (dx2 * (k - mx_) + y_[i] * std) / dx + mx_;
-                // Adjacent integer x index <= k
-                int kk = int(floor(kp));
-                // Get value at kp by linear interpolation on
-                // kk <= kp <= kk + 1 with flat extrapolation
-                value.set(k, value[k] + w_[i] * (kk < 0 ? v[0]
-                                                        : (kk + 1 > 2 * mx_
-                                                               ? v[2 * mx_]
-                                                               : (kp - kk) * v[kk + 1] + (1.0 + kk - kp) * v[kk])));
+            if (kk < 0) {
+                contributions[r].push_back(std::make_pair(0, w_[i]));
+            } else if (kk + 1 > 2 * mx_) {
+                contributions[r].push_back(std::make_pair(2 * mx_, w_[i]));
+            } else {
+                contributions[r].push_back(std::make_pair(kk, w_[i] * (1.0 + kk - kp)));
+                contributions[r].push_back(std::make_pair(kk + 1, w_[i] * (kp - kk)));
             }
         }
-        return value;
     }
+
+    // build the banded representation with a common width for all rows
+
+    auto s = QuantLib::ext::make_shared<Stencil>();
+    s->first.resize(rows);
+    for (Size r = 0; r < rows; ++r) {
+        s->first[r] = contributions[r].front().first;
+        s->width = std::max(s->width, contributions[r].back().first - s->first[r] + 1);
+    }
+    s->weights.resize(rows * s->width, 0.0);
+    for (Size r = 0; r < rows; ++r) {
+        s->first[r] = std::min(s->first[r], n - s->width);
+        for (auto const& [idx, weight] : contributions[r])
+            s->weights[r * s->width + idx - s->first[r]] += weight;
+    }
+
+    return s;
+}
+
+void LgmConvolutionSolver2::apply(const Stencil& s, const std::vector<const RandomVariable*>& v,
+                                  std::vector<RandomVariable>& result) const {
+    Size rows = s.first.size();
+    std::vector<const double*> vd;
+    std::vector<double*> rd;
+    for (Size m = 0; m < v.size(); ++m) {
+        result.push_back(RandomVariable(rows, 0.0));
+        result.back().expand();
+        vd.push_back(v[m]->data());
+    }
+    for (auto& r : result)
+        rd.push_back(r.data());
+    // each row of weights is loaded once and applied to all arrays
+    for (Size r = 0; r < rows; ++r) {
+        const double* w = s.weights.data() + r * s.width;
+        for (Size m = 0; m < vd.size(); ++m) {
+            const double* x = vd[m] + s.first[r];
+            double tmp = 0.0;
+            for (Size j = 0; j < s.width; ++j)
+                tmp += w[j] * x[j];
+            rd[m][r] = tmp;
+        }
+    }
+    // a single row means that we rolled back to a deterministic state
+    if (rows == 1) {
+        for (auto& r : result)
+            r = RandomVariable(gridSize(), r[0]);
+    }
+}
+
+RandomVariable LgmConvolutionSolver2::rollback(const RandomVariable& v, const Real t1, const Real t0, Size) const {
+    if (QuantLib::close_enough(t0, t1) || v.deterministic())
+        return v;
+    return rollback(std::vector<RandomVariable>(1, v), t1, t0).front();
+}
+
+std::vector<RandomVariable> LgmConvolutionSolver2::rollback(const std::vector<RandomVariable>& v, const Real t1,
+                                                            const Real t0, Size) const {
+    if (QuantLib::close_enough(t0, t1))
+        return v;
+    QL_REQUIRE(t0 < t1, "LgmConvolutionSolver2::rollback(): t0 (" << t0 << ") < t1 (" << t1 << ") required.");
+    std::vector<const RandomVariable*> stochastic;
+    for (auto const& r : v) {
+        if (r.deterministic())
+            continue;
+        QL_REQUIRE(r.size() == gridSize(), "LgmConvolutionSolver2::rollback(): v size ("
+                                               << r.size() << ") does not match grid size (" << gridSize() << ")");
+        stochastic.push_back(&r);
+    }
+    std::vector<RandomVariable> values;
+    if (!stochastic.empty()) {
+        Real zeta0 = QuantLib::close_enough(t0, 0.0) ? 0.0 : model_->parametrization()->zeta(t0);
+        apply(*stencil(zeta0, model_->parametrization()->zeta(t1)), stochastic, values);
+    }
+    std::vector<RandomVariable> result;
+    result.reserve(v.size());
+    for (Size m = 0, n = 0; m < v.size(); ++m)
+        result.push_back(v[m].deterministic() ? v[m] : std::move(values[n++]));
+    return result;
 }
 
 } // namespace QuantExt
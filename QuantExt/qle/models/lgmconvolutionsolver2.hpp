@@ -27,29 +27,58 @@
 #include <qle/math/randomvariable.hpp>
 #include <qle/models/lgmbackwardsolver.hpp>
 
+#include <boost/thread/shared_mutex.hpp>
+
+#include <map>
+
 namespace QuantExt {
 
 //! Numerical convolution solver for the LGM model
 /*! Reference: Hagan, Methodology for callable swaps and Bermudan
                exercise into swaptions
+
+
+   The rollback stencils are cached per (zeta(t0), zeta(t1)) unless cacheStencils is false, in which case they are
+   rebuilt on each rollback. The cache is shared by all threads using the solver.
 */
 
 class LgmConvolutionSolver2 : public LgmBackwardSolver {
 public:
     LgmConvolutionSolver2(const QuantLib::ext::shared_ptr<LinearGaussMarkovModel>& model, const Real sy, const Size ny,
-                          const Real sx, const Size nx);
+                          const Real sx, const Size nx, const bool cacheStencils = true);
     Size gridSize() const override { return 2 * mx_ + 1; }
     RandomVariable stateGrid(const Real t) const override;
     // steps are always ignored, since we can take large steps
     RandomVariable rollback(const RandomVariable& v, const Real t1, const Real t0,
                             Size steps = Null<Size>()) const override;
+    // rolls back all arrays with one lookup of the stencil
+    std::vector<RandomVariable> rollback(const std::vector<RandomVariable>& v, const Real t1, const Real t0,
+                                         Size steps = Null<Size>()) const override;
     const QuantLib::ext::shared_ptr<LinearGaussMarkovModel>& model() const override { return model_; }
 
 private:
+    /* The rollback from t1 to t0 is a linear map on the state grid. Row k holds the weights of the values at
+       first[k], ..., first[k] + width - 1 contributing to the rolled back value at grid point k. For t0 = 0
+       there is a single row. */
+    struct Stencil {
+        Size width = 0;
+        std::vector<Size> first;
+        std::vector<Real> weights;
+    };
+    // the stencil only depends on zeta(t0), zeta(t1), we cache it on these values
+    QuantLib::ext::shared_ptr<const Stencil> stencil(const Real zeta0, const Real zeta1) const;
+    QuantLib::ext::shared_ptr<const Stencil> buildStencil(const Real zeta0, const Real zeta1) const;
+    void apply(const Stencil& s, const std::vector<const RandomVariable*>& v,
+               std::vector<RandomVariable>& result) const;
+
     QuantLib::ext::shared_ptr<LinearGaussMarkovModel> model_;
     int mx_, my_, nx_;
     Real h_;
     std::vector<Real> y_, w_;
+    bool cacheStencils_;
+    // stencils are handed out as shared pointers, so that clearing the cache does not invalidate them
+    mutable std::map<std::pair<Real, Real>, QuantLib::ext::shared_ptr<const Stencil>> stencilCache_;
+    mutable boost::shared_mutex mutex_;
 };
 
 } // namespace QuantExt
@@ -38,6 +38,7 @@ LgmFdSolver::LgmFdSolver(const QuantLib::ext::shared_ptr<LinearGaussMarkovModel>
         mesher_, QuantLib::ext::dynamic_pointer_cast<StochasticProcess1D>(model->stateProcess()));
     solver_ = QuantLib::ext::make_shared<FdmBackwardSolver>(
         operator_, std::vector<QuantLib::ext::shared_ptr<BoundaryCondition<FdmLinearOp>>>(), nullptr, scheme_);
+    batchedSolver_ = QuantLib::ext::make_shared<FdmBatchedBackwardSolver>(operator_, scheme_);
 }
 
 Size LgmFdSolver::gridSize() const { return stateGridPoints_; }
@@ -65,4 +66,38 @@ RandomVariable LgmFdSolver::rollback(const RandomVariable& v, const Real t1, con
     }
 }
 
+std::vector<RandomVariable> LgmFdSolver::rollback(const std::vector<RandomVariable>& v, const Real t1, const Real t0,
+                                                  Size steps) const {
+    if (QuantLib::close_enough(t0, t1))
+        return v;
+    QL_REQUIRE(t0 < t1, "LgmCFdSolver::rollback(): t0 (" << t0 << ") < t1 (" << t1 << ") required.");
+    if (steps == Null<Size>())
+        steps = std::max<Size>(1, static_cast<Size>(static_cast<double>(timeStepsPerYear_) * (t1 - t0) + 0.5));
+    std::vector<Array> workingArrays;
+    for (auto const& r : v) {
+        if (r.deterministic())
+            continue;
+        workingArrays.push_back(Array(r.size()));
+        r.copyToArray(workingArrays.back());
+    }
+    if (!workingArrays.empty())
+        batchedSolver_->rollback(workingArrays, t1, t0, steps, 0);
+    std::vector<RandomVariable> result;
+    Size n = 0;
+    for (auto const& r : v) {
+        if (r.deterministic()) {
+            result.push_back(r);
+        } else if (QuantLib::close_enough(t0, 0.0)) {
+            Array x = mesher_->locations(0);
+            MonotonicCubicNaturalSpline interpolation(x.begin(), x.end(), workingArrays[n].begin());
+            interpolation.enableExtrapolation();
+            result.push_back(RandomVariable(gridSize(), interpolation(0.0)));
+            ++n;
+        } else {
+            result.push_back(RandomVariable(workingArrays[n++]));
+        }
+    }
+    return result;
+}
+
 } // namespace QuantExt
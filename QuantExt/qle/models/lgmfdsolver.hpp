@@ -25,6 +25,7 @@
 #pragma once
 
 #include <qle/math/randomvariable.hpp>
+#include <qle/methods/fdmbatchedbackwardsolver.hpp>
 #include <qle/models/lgmbackwardsolver.hpp>
 
 #include <ql/methods/finitedifferences/meshers/fdmmesher.hpp>
@@ -43,6 +44,9 @@ public:
     // if steps are not given, the time steps per year specified in the constructor
     RandomVariable rollback(const RandomVariable& v, const Real t1, const Real t0,
                             Size steps = Null<Size>()) const override;
+    // rolls back all arrays together, setting up the operator once per time step
+    std::vector<RandomVariable> rollback(const std::vector<RandomVariable>& v, const Real t1, const Real t0,
+                                         Size steps = Null<Size>()) const override;
     const QuantLib::ext::shared_ptr<LinearGaussMarkovModel>& model() const override;
 
 private:
@@ -56,6 +60,7 @@ private:
     mutable QuantLib::ext::shared_ptr<FdmMesher> mesher_;              // the mesher for the FD solver
     mutable QuantLib::ext::shared_ptr<FdmLinearOpComposite> operator_; // the operator
     mutable QuantLib::ext::shared_ptr<FdmBackwardSolver> solver_;      // the sovler
+    QuantLib::ext::shared_ptr<FdmBatchedBackwardSolver> batchedSolver_; // the solver for several arrays at once
 
     RandomVariable mesherLocations_;
 };
@@ -37,6 +37,14 @@ public:
 
     //! if false is returned, the model does not require a recalibration
     virtual bool requiresRecalibration() const = 0;
+
+    /*! if true, a recalibration starts from the parameters of the last successful calibration instead of the
+        initial parameters; builders not supporting this ignore the flag */
+    void setWarmStart(const bool warmStart) { warmStart_ = warmStart; }
+    bool warmStart() const { return warmStart_; }
+
+protected:
+    bool warmStart_ = false;
 };
 
 } // namespace QuantExt
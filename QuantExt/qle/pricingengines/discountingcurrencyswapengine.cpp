@@ -17,6 +17,7 @@
 */
 
 #include <qle/pricingengines/discountingcurrencyswapengine.hpp>
+#include <qle/utilities/cashflows.hpp>
 
 #include <ql/cashflows/cashflows.hpp>
 #include <ql/cashflows/floatingratecoupon.hpp>
@@ -149,7 +150,7 @@ void DiscountingCurrencySwapEngine::calculate() const {
             Currency ccy = arguments_.currency[i];
             Handle<YieldTermStructure> yts = fetchTS(ccy);
 
-            std::tie(results_.inCcyLegNPV[i], results_.inCcyLegBPS[i]) = QuantLib::CashFlows::npvbps(
+            std::tie(results_.inCcyLegNPV[i], results_.inCcyLegBPS[i]) = QuantExt::npvbps(
                 arguments_.legs[i], **yts, includeRefDateFlows, settlementDate, results_.valuationDate);
 
             results_.inCcyLegNPV[i] *= arguments_.payer[i];
@@ -17,6 +17,7 @@
 */
 
 #include <qle/instruments/convertiblebond2.hpp>
+#include <qle/methods/fdmbatchedbackwardsolver.hpp>
 #include <qle/methods/fdmdefaultableequityjumpdiffusionop.hpp>
 #include <qle/pricingengines/fdconvertiblebondevents.hpp>
 #include <qle/pricingengines/fddefaultableequityjumpdiffusionconvertiblebondengine.hpp>
@@ -259,6 +260,7 @@ void FdDefaultableEquityJumpDiffusionConvertibleBondEngine::calculate() const {
 
     auto solver = QuantLib::ext::make_shared<FdmBackwardSolver>(
         fdmOp, std::vector<QuantLib::ext::shared_ptr<BoundaryCondition<FdmLinearOp>>>(), nullptr, FdmSchemeDesc::Douglas());
+    FdmBatchedBackwardSolver batchedSolver(fdmOp, FdmSchemeDesc::Douglas());
 
     // 7 prepare event container
 
@@ -595,13 +597,14 @@ void FdDefaultableEquityJumpDiffusionConvertibleBondEngine::calculate() const {
 
             // 11.11 roll back value from time t_i to t_i{-1}
 
-            solver->rollback(value[plane], t_from, t_to, 1, 0);
+            std::vector<Array*> rollbackValues{&value[plane]};
             if (!valueNoConversion.empty())
-                solver->rollback(valueNoConversion[plane], t_from, t_to, 1, 0);
+                rollbackValues.push_back(&valueNoConversion[plane]);
             if (!conversionIndicator.empty())
-                solver->rollback(conversionIndicator[plane], t_from, t_to, 1, 0);
+                rollbackValues.push_back(&conversionIndicator[plane]);
             if (!conversionIndicatorNoConversion.empty())
-                solver->rollback(conversionIndicatorNoConversion[plane], t_from, t_to, 1, 0);
+                rollbackValues.push_back(&conversionIndicatorNoConversion[plane]);
+            batchedSolver.rollback(rollbackValues, t_from, t_to, 1, 0);
 
         } // loop over stochastic conversion ratio planes
 
@@ -87,6 +87,18 @@ void IndexCdsTrancheEngine::calculate() const {
     results_.protectionValue = 0.0;
     Real inceptionTrancheNotional = arguments_.basket->trancheNotional();
 
+    // Expected tranche losses up to the end of the coupon periods that have not occured yet, computed in one call.
+    vector<Date> etlDates;
+    for (const auto& cf : arguments_.normalizedLeg) {
+        if (cf->hasOccurred(today))
+            continue;
+        QuantLib::ext::shared_ptr<Coupon> coupon = QuantLib::ext::dynamic_pointer_cast<Coupon>(cf);
+        QL_REQUIRE(coupon, "IndexCdsTrancheEngine expects leg to have Coupon cashflow type.");
+        etlDates.push_back(coupon->accrualEndDate());
+    }
+    vector<Real> periodEtls = basket->expectedTrancheLosses(etlDates, arguments_.recoveryRate);
+    Size etlIndex = 0;
+
     // Value the premium and protection leg.
     for (Size i = 0; i < arguments_.normalizedLeg.size(); i++) {
 
@@ -98,7 +110,6 @@ void IndexCdsTrancheEngine::calculate() const {
         }
 
         QuantLib::ext::shared_ptr<Coupon> coupon = QuantLib::ext::dynamic_pointer_cast<Coupon>(arguments_.normalizedLeg[i]);
-        QL_REQUIRE(coupon, "IndexCdsTrancheEngine expects leg to have Coupon cashflow type.");
 
         // Relevant dates with assumption that future defaults occur at midpoint of (remaining) coupon period.
         Date paymentDate = coupon->date();
@@ -107,7 +118,7 @@ void IndexCdsTrancheEngine::calculate() const {
         Date defaultDate = startDate + (endDate - startDate) / 2;
 
         // Expected loss on the tranche up to the end of the current period.
-        Real etl = basket->expectedTrancheLoss(endDate, arguments_.recoveryRate);
+        Real etl = periodEtls[etlIndex++];
 
         // Update protection leg value
         results_.protectionValue += discountCurve_->discount(defaultDate) * (etl - etls.back());
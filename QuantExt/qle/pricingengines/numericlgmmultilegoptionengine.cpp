@@ -485,16 +485,28 @@ void NumericLgmMultiLegOptionEngineBase::calculate() const {
         // roll back
 
         if (t_from != t_to) {
-            underlyingNpv = solver_->rollback(underlyingNpv, t_from, t_to);
-            optionNpv = solver_->rollback(optionNpv, t_from, t_to);
+            // roll back all values in one batch
+            // need to roll back provisionalNpv only for the last step t_1 -> t_0 = 0
+            bool rollbackProvisionalNpv = it == std::next(timeGrid.rend(), -1);
+            std::vector<RandomVariable> values;
+            values.push_back(std::move(underlyingNpv));
+            values.push_back(std::move(optionNpv));
             for (auto& c : cache) {
-                if (!c.initialised())
-                    continue;
-                c = solver_->rollback(c, t_from, t_to);
+                if (c.initialised())
+                    values.push_back(std::move(c));
             }
-            // need to roll back provisionalNpv only for the last step t_1 -> t_0 = 0
-            if (it == std::next(timeGrid.rend(), -1))
-                provisionalNpv = solver_->rollback(provisionalNpv, t_from, t_to);
+            if (rollbackProvisionalNpv)
+                values.push_back(std::move(provisionalNpv));
+            values = solver_->rollback(values, t_from, t_to);
+            Size n = 0;
+            underlyingNpv = std::move(values[n++]);
+            optionNpv = std::move(values[n++]);
+            for (auto& c : cache) {
+                if (c.initialised())
+                    c = std::move(values[n++]);
+            }
+            if (rollbackProvisionalNpv)
+                provisionalNpv = std::move(values[n++]);
         }
     }
 
@@ -26,7 +26,12 @@
 
 #include <boost/make_shared.hpp>
 #include <ql/termstructures/yieldtermstructure.hpp>
-#include <qle/quotes/logquote.hpp>
+#include <ql/utilities/null.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
 
 namespace QuantExt {
 using namespace QuantLib;
@@ -36,6 +41,13 @@ using namespace QuantLib;
     flat fwd extrapolation is always enabled, the term structure has always a
     floating reference date
 
+    The logs of the node discount factors are cached. update() only marks the cache dirty, it is refreshed from the
+    quotes at the next lookup, i.e. after the quotes of a new scenario are set. The curve does not observe its
+    quotes, so a cached log is only used while the quote still has the value it was computed for. Otherwise the log is
+    taken on the fly and the cache is marked dirty again. The cache is replaced as a whole, so a curve can be read
+    from several threads concurrently. The vectorised discount() and forwardRates() overloads evaluate a whole
+    schedule of times in one pass.
+
         \ingroup termstructures
     */
 class InterpolatedDiscountCurve : public YieldTermStructure {
@@ -67,18 +79,97 @@ public:
     }
     //@}
 
+    //! \name Bulk evaluation
+    //@{
+    using YieldTermStructure::discount;
+    //! discount factors for a vector of times, times in increasing order are processed in a single sweep
+    std::vector<DiscountFactor> discount(const std::vector<Time>& t, bool extrapolate = false) const {
+        std::vector<DiscountFactor> result(t.size());
+        auto lv = logValues();
+        Size i = 1;
+        for (Size k = 0; k < t.size(); ++k) {
+            checkRange(t[k], extrapolate);
+            // restart the search only if the times are not increasing
+            if (k > 0 && t[k] < t[k - 1])
+                i = 1;
+            while (i < times_.size() - 1 && times_[i] <= t[k])
+                ++i;
+            result[k] = discountImpl(t[k], i, *lv);
+        }
+        return result;
+    }
+    //! continuously compounded forward rates between \p t1[k] and \p t2[k]
+    std::vector<Rate> forwardRates(const std::vector<Time>& t1, const std::vector<Time>& t2,
+                                   bool extrapolate = false) const {
+        QL_REQUIRE(t1.size() == t2.size(), "InterpolatedDiscountCurve::forwardRates(): start times ("
+                                               << t1.size() << ") and end times (" << t2.size()
+                                               << ") must have the same size");
+        std::vector<DiscountFactor> d1 = discount(t1, extrapolate), d2 = discount(t2, extrapolate);
+        std::vector<Rate> result(t1.size());
+        for (Size k = 0; k < t1.size(); ++k) {
+            QL_REQUIRE(t2[k] > t1[k], "InterpolatedDiscountCurve::forwardRates(): end time ("
+                                          << t2[k] << ") must be greater than start time (" << t1[k] << ")");
+            result[k] = std::log(d1[k] / d2[k]) / (t2[k] - t1[k]);
+        }
+        return result;
+    }
+    //@}
+
+    //! \name Observer interface
+    //@{
+    void update() override {
+        logValuesDirty_ = true;
+        YieldTermStructure::update();
+    }
+    //@}
+
 private:
     void initalise(const std::vector<Handle<Quote>>& quotes) {
         QL_REQUIRE(times_.size() > 1, "at least two times required");
         QL_REQUIRE(times_[0] == 0.0, "First time must be 0, got " << times_[0]); // or date=asof
         QL_REQUIRE(times_.size() == quotes.size(), "size of time and quote vectors do not match");
-        for (Size i = 0; i < quotes.size(); ++i) {
-            quotes_.push_back(QuantLib::ext::make_shared<LogQuote>(quotes[i]));
-        }
+        quotes_ = quotes;
+        auto lv = std::make_shared<LogValues>();
+        lv->quoteValues.resize(quotes_.size(), Null<Real>());
+        lv->logValues.resize(quotes_.size(), Null<Real>());
+        logValues_ = lv;
         for (Size i = 0; i < times_.size() - 1; ++i)
             timeDiffs_.push_back(times_[i + 1] - times_[i]);
     }
 
+    // the quote values the logs were computed from, quotes that were not valid are left out (Null)
+    struct LogValues {
+        std::vector<Real> quoteValues, logValues;
+    };
+
+    // returns the current cache, refreshes it first if it is dirty
+    std::shared_ptr<const LogValues> logValues() const {
+        if (logValuesDirty_.exchange(false)) {
+            auto lv = std::make_shared<LogValues>();
+            lv->quoteValues.resize(quotes_.size(), Null<Real>());
+            lv->logValues.resize(quotes_.size(), Null<Real>());
+            for (Size i = 0; i < quotes_.size(); ++i) {
+                Real v = quotes_[i].empty() || !quotes_[i]->isValid() ? Null<Real>() : quotes_[i]->value();
+                if (v != Null<Real>() && v > 0.0) {
+                    lv->quoteValues[i] = v;
+                    lv->logValues[i] = std::log(v);
+                }
+            }
+            std::atomic_store(&logValues_, std::shared_ptr<const LogValues>(lv));
+        }
+        return std::atomic_load(&logValues_);
+    }
+
+    Real logValue(Size i, const LogValues& lv) const {
+        Real v = quotes_[i]->value();
+        if (v == lv.quoteValues[i] && v != Null<Real>())
+            return lv.logValues[i];
+        // the quote changed after the cache was refreshed, without a notification
+        logValuesDirty_ = true;
+        QL_REQUIRE(v > 0.0, "Invalid quote, cannot take log of non-positive number");
+        return std::log(v);
+    }
+
     //! \name TermStructure interface
     //@{
     Date maxDate() const override { return Date::maxDate(); } // flat fwd extrapolation
@@ -86,29 +177,35 @@ private:
 
 protected:
     DiscountFactor discountImpl(Time t) const override {
+        std::vector<Time>::const_iterator it = std::upper_bound(times_.begin(), times_.end(), t);
+        Size i = std::min<Size>(it - times_.begin(), times_.size() - 1);
+        return discountImpl(t, i, *logValues());
+    }
+
+private:
+    // i is the index of the first node time > t, capped at the last node
+    DiscountFactor discountImpl(Time t, Size i, const LogValues& lv) const {
         if (t > this->times_.back() && extrapolation_ == Extrapolation::flatZero) {
             Real tMax = this->times_.back();
-            Real dMax = std::exp(quotes_.back()->value());
+            Real dMax = std::exp(logValue(quotes_.size() - 1, lv));
             return std::pow(dMax, t / tMax);
         }
-        std::vector<Time>::const_iterator it = std::upper_bound(times_.begin(), times_.end(), t);
-        Size i = std::min<Size>(it - times_.begin(), times_.size() - 1);
         Real weight = (times_[i] - t) / timeDiffs_[i - 1];
         if (interpolation_ == Interpolation::logLinear || t > this->times_.back()) {
             // this handles flat fwd extrapolation (t > times.back()) as well
-            Real value = (1.0 - weight) * quotes_[i]->value() + weight * quotes_[i - 1]->value();
+            Real value = (1.0 - weight) * logValue(i, lv) + weight * logValue(i - 1, lv);
             return ::exp(value);
         } else {
-            Real value =
-                (1.0 - weight) * quotes_[i]->value() / times_[i] + weight * quotes_[i - 1]->value() / times_[i - 1];
+            Real value = (1.0 - weight) * logValue(i, lv) / times_[i] + weight * logValue(i - 1, lv) / times_[i - 1];
             return ::exp(t * value);
         }
     }
 
-private:
     std::vector<Time> times_;
     std::vector<Time> timeDiffs_;
-    std::vector<QuantLib::ext::shared_ptr<Quote>> quotes_;
+    std::vector<Handle<Quote>> quotes_;
+    mutable std::shared_ptr<const LogValues> logValues_;
+    mutable std::atomic<bool> logValuesDirty_{true};
     Interpolation interpolation_;
     Extrapolation extrapolation_;
 };
@@ -106,6 +106,36 @@ public:
     Calendar calendar() const override { return NullCalendar(); }
     Natural settlementDays() const override { return 0; }
 
+    //! \name Bulk evaluation
+    //@{
+    using YieldTermStructure::discount;
+    //! discount factors for a vector of times, the curve is calculated once for all times
+    std::vector<DiscountFactor> discount(const std::vector<Time>& t, bool extrapolate = false) const {
+        calculate();
+        std::vector<DiscountFactor> result(t.size());
+        for (Size k = 0; k < t.size(); ++k) {
+            checkRange(t[k], extrapolate);
+            result[k] = discountImpl(t[k]);
+        }
+        return result;
+    }
+    //! continuously compounded forward rates between \p t1[k] and \p t2[k]
+    std::vector<Rate> forwardRates(const std::vector<Time>& t1, const std::vector<Time>& t2,
+                                   bool extrapolate = false) const {
+        QL_REQUIRE(t1.size() == t2.size(), "InterpolatedDiscountCurve2::forwardRates(): start times ("
+                                               << t1.size() << ") and end times (" << t2.size()
+                                               << ") must have the same size");
+        std::vector<DiscountFactor> d1 = discount(t1, extrapolate), d2 = discount(t2, extrapolate);
+        std::vector<Rate> result(t1.size());
+        for (Size k = 0; k < t1.size(); ++k) {
+            QL_REQUIRE(t2[k] > t1[k], "InterpolatedDiscountCurve2::forwardRates(): end time ("
+                                          << t2[k] << ") must be greater than start time (" << t1[k] << ")");
+            result[k] = std::log(d1[k] / d2[k]) / (t2[k] - t1[k]);
+        }
+        return result;
+    }
+    //@}
+
 protected:
     void performCalculations() const override {
         today_ = Settings::instance().evaluationDate();
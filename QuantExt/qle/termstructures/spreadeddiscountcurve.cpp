@@ -55,6 +55,31 @@ Calendar SpreadedDiscountCurve::calendar() const { return referenceCurve_->calen
 
 Natural SpreadedDiscountCurve::settlementDays() const { return referenceCurve_->settlementDays(); }
 
+std::vector<DiscountFactor> SpreadedDiscountCurve::discount(const std::vector<Time>& t, bool extrapolate) const {
+    calculate();
+    std::vector<DiscountFactor> result(t.size());
+    for (Size k = 0; k < t.size(); ++k) {
+        checkRange(t[k], extrapolate);
+        result[k] = discountImpl(t[k]);
+    }
+    return result;
+}
+
+std::vector<Rate> SpreadedDiscountCurve::forwardRates(const std::vector<Time>& t1, const std::vector<Time>& t2,
+                                                      bool extrapolate) const {
+    QL_REQUIRE(t1.size() == t2.size(), "SpreadedDiscountCurve::forwardRates(): start times ("
+                                           << t1.size() << ") and end times (" << t2.size()
+                                           << ") must have the same size");
+    std::vector<DiscountFactor> d1 = discount(t1, extrapolate), d2 = discount(t2, extrapolate);
+    std::vector<Rate> result(t1.size());
+    for (Size k = 0; k < t1.size(); ++k) {
+        QL_REQUIRE(t2[k] > t1[k], "SpreadedDiscountCurve::forwardRates(): end time ("
+                                      << t2[k] << ") must be greater than start time (" << t1[k] << ")");
+        result[k] = std::log(d1[k] / d2[k]) / (t2[k] - t1[k]);
+    }
+    return result;
+}
+
 void SpreadedDiscountCurve::performCalculations() const {
     for (Size i = 0; i < times_.size(); ++i) {
         QL_REQUIRE(!quotes_[i].empty(), "SpreadedDiscountCurve: quote at index " << i << " is empty");
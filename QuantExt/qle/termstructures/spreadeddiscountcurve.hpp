@@ -53,6 +53,16 @@ public:
     Calendar calendar() const override;
     Natural settlementDays() const override;
 
+    //! \name Bulk evaluation
+    //@{
+    using YieldTermStructure::discount;
+    //! discount factors for a vector of times, the spread curve is calculated once for all times
+    std::vector<DiscountFactor> discount(const std::vector<Time>& t, bool extrapolate = false) const;
+    //! continuously compounded forward rates between \p t1[k] and \p t2[k]
+    std::vector<Rate> forwardRates(const std::vector<Time>& t1, const std::vector<Time>& t2,
+                                   bool extrapolate = false) const;
+    //@}
+
 protected:
     void performCalculations() const override;
     DiscountFactor discountImpl(Time t) const override;
@@ -16,7 +16,13 @@
  FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
 */
 
+#include <qle/termstructures/interpolateddiscountcurve.hpp>
+#include <qle/termstructures/interpolateddiscountcurve2.hpp>
+#include <qle/termstructures/spreadeddiscountcurve.hpp>
 #include <qle/utilities/cashflows.hpp>
+
+#include <ql/cashflows/cashflows.hpp>
+#include <ql/cashflows/coupon.hpp>
 #include <iostream>
 
 using QuantLib::Date;
@@ -49,4 +55,54 @@ Real getBMAAtmLevel(const QuantLib::ext::shared_ptr<BMAIndex>& bma, const Date&
     return cpn.rate();
 }
 
+namespace {
+template <class BulkCurve>
+std::pair<Real, Real> npvbpsBulk(const Leg& leg, const BulkCurve& curve, bool includeSettlementDateFlows,
+                                 Date settlementDate, Date npvDate) {
+    std::vector<const CashFlow*> flows;
+    std::vector<Time> times;
+    flows.reserve(leg.size());
+    times.reserve(leg.size() + 1);
+    for (auto const& c : leg) {
+        if (!c->hasOccurred(settlementDate, includeSettlementDateFlows) && !c->tradingExCoupon(settlementDate)) {
+            flows.push_back(c.get());
+            times.push_back(curve.timeFromReference(c->date()));
+        }
+    }
+    times.push_back(curve.timeFromReference(npvDate));
+
+    std::vector<DiscountFactor> dfs = curve.discount(times, curve.allowsExtrapolation());
+
+    Real npv = 0.0, bps = 0.0;
+    for (Size i = 0; i < flows.size(); ++i) {
+        npv += flows[i]->amount() * dfs[i];
+        if (auto cp = dynamic_cast<const Coupon*>(flows[i]))
+            bps += cp->nominal() * cp->accrualPeriod() * dfs[i];
+    }
+    DiscountFactor d = dfs.back();
+    return {npv / d, basisPoint * bps / d};
+}
+} // namespace
+
+std::pair<Real, Real> npvbps(const Leg& leg, const YieldTermStructure& discountCurve, bool includeSettlementDateFlows,
+                             Date settlementDate, Date npvDate) {
+    if (leg.empty())
+        return {0.0, 0.0};
+
+    if (settlementDate == Date())
+        settlementDate = Settings::instance().evaluationDate();
+    if (npvDate == Date())
+        npvDate = settlementDate;
+
+    // the curve types built by the scenario sim market provide a bulk evaluation
+    if (auto c = dynamic_cast<const InterpolatedDiscountCurve*>(&discountCurve))
+        return npvbpsBulk(leg, *c, includeSettlementDateFlows, settlementDate, npvDate);
+    if (auto c = dynamic_cast<const InterpolatedDiscountCurve2*>(&discountCurve))
+        return npvbpsBulk(leg, *c, includeSettlementDateFlows, settlementDate, npvDate);
+    if (auto c = dynamic_cast<const SpreadedDiscountCurve*>(&discountCurve))
+        return npvbpsBulk(leg, *c, includeSettlementDateFlows, settlementDate, npvDate);
+
+    return QuantLib::CashFlows::npvbps(leg, discountCurve, includeSettlementDateFlows, settlementDate, npvDate);
+}
+
 } // namespace QuantExt
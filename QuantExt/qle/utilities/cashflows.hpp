@@ -26,6 +26,7 @@
 #include <qle/utilities/time.hpp>
 
 #include <ql/cashflows/averagebmacoupon.hpp>
+#include <ql/termstructures/yieldtermstructure.hpp>
 
 namespace QuantExt {
 
@@ -46,4 +47,13 @@ Real getOisAtmLevel(const QuantLib::ext::shared_ptr<OvernightIndex>& on, const D
 Real getBMAAtmLevel(const QuantLib::ext::shared_ptr<BMAIndex>& bma, const Date& fixingDate,
                     const Period& rateComputationPeriod);
 
+/*! Utility function equivalent to QuantLib::CashFlows::npvbps(), but evaluating the discount factors for all
+    cashflows of the \p leg in one call if the discount curve provides a bulk evaluation (as
+    QuantExt::InterpolatedDiscountCurve, InterpolatedDiscountCurve2 and SpreadedDiscountCurve do).
+
+\ingroup utilities
+*/
+std::pair<Real, Real> npvbps(const Leg& leg, const YieldTermStructure& discountCurve, bool includeSettlementDateFlows,
+                             Date settlementDate = Date(), Date npvDate = Date());
+
 } // namespace QuantExt
@@ -190,6 +190,41 @@ BOOST_AUTO_TEST_CASE(testIndicatorDerivative) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testGraphOptimisation) {
+
+    BOOST_TEST_MESSAGE("Testing common subexpression and dead node elimination in computation graph...");
+
+    constexpr Real tol = 1E-14;
+
+    ComputationGraph g;
+    auto x = cg_var(g, "x", ComputationGraph::VarDoesntExist::Create);
+    auto y = cg_var(g, "y", ComputationGraph::VarDoesntExist::Create);
+
+    // identical subexpressions are shared, also for commuted arguments of commutative ops
+    auto u = cg_add(g, x, y);
+    BOOST_CHECK_EQUAL(cg_add(g, y, x), u);
+    auto v = cg_exp(g, u);
+    BOOST_CHECK_EQUAL(cg_exp(g, cg_add(g, x, y)), v);
+    BOOST_CHECK_EQUAL(cg_negative(g, cg_negative(g, v)), v);
+    BOOST_CHECK_EQUAL(g.commonSubexpressions(), 3);
+
+    // w does not contribute to the output z
+    auto w = cg_log(g, y);
+    auto z = cg_mult(g, v, x);
+
+    BOOST_CHECK_EQUAL(g.eliminateDeadNodes({z}), 2); // w and the intermediate -v
+    BOOST_CHECK(g.predecessors(w).empty());
+    BOOST_CHECK(!g.predecessors(z).empty());
+
+    std::vector<RandomVariable> values(g.size(), RandomVariable(1, 0.0));
+    values[x] = RandomVariable(1, 2.0);
+    values[y] = RandomVariable(1, 3.0);
+
+    forwardEvaluation(g, values, getRandomVariableOps(1), RandomVariable::deleter, false);
+
+    BOOST_CHECK_CLOSE(values[z][0], std::exp(5.0) * 2.0, tol);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -22,7 +22,17 @@
 #include <ql/termstructures/yield/discountcurve.hpp>
 #include <ql/time/calendars/nullcalendar.hpp>
 #include <ql/time/daycounters/actualactual.hpp>
+#include <ql/cashflows/cashflows.hpp>
+#include <ql/cashflows/fixedratecoupon.hpp>
+#include <ql/time/calendars/target.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+#include <ql/time/schedule.hpp>
+#include <qle/termstructures/interpolateddiscountcurve.hpp>
 #include <qle/termstructures/interpolateddiscountcurve2.hpp>
+#include <qle/termstructures/spreadeddiscountcurve.hpp>
+#include <qle/utilities/cashflows.hpp>
+
+#include <future>
 
 using namespace boost::unit_test_framework;
 using namespace QuantLib;
@@ -81,6 +91,152 @@ BOOST_AUTO_TEST_CASE(testDiscountCurve) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(testInterpolatedDiscountCurveBulkEvaluation) {
+
+    BOOST_TEST_MESSAGE("Testing QuantExt::InterpolatedDiscountCurve bulk discount factor evaluation...");
+
+    SavedSettings backup;
+    Settings::instance().evaluationDate() = Date(1, Dec, 2015);
+
+    vector<Time> times;
+    vector<QuantLib::ext::shared_ptr<SimpleQuote>> simpleQuotes;
+    vector<Handle<Quote>> quotes;
+    for (Size i = 0; i <= 20; ++i) {
+        times.push_back(static_cast<Real>(i));
+        simpleQuotes.push_back(QuantLib::ext::make_shared<SimpleQuote>(std::exp(-(0.01 + i * 0.001) * i)));
+        quotes.push_back(Handle<Quote>(simpleQuotes.back()));
+    }
+
+    vector<Time> lookup;
+    for (Time t = 0.0; t < 25.0; t += 0.37)
+        lookup.push_back(t);
+    // decreasing times must be handled as well
+    lookup.push_back(3.3);
+    lookup.push_back(0.5);
+
+    for (auto interpolation : {QuantExt::InterpolatedDiscountCurve::Interpolation::logLinear,
+                               QuantExt::InterpolatedDiscountCurve::Interpolation::linearZero}) {
+        for (auto extrapolation : {QuantExt::InterpolatedDiscountCurve::Extrapolation::flatFwd,
+                                   QuantExt::InterpolatedDiscountCurve::Extrapolation::flatZero}) {
+            QuantExt::InterpolatedDiscountCurve curve(times, quotes, 0, TARGET(), Actual365Fixed(), interpolation,
+                                                      extrapolation);
+            curve.enableExtrapolation();
+            for (Size pass = 0; pass < 2; ++pass) {
+                // the second pass checks that the cached node logs are refreshed after a quote change
+                if (pass == 1)
+                    simpleQuotes[5]->setValue(simpleQuotes[5]->value() * 0.99);
+                vector<DiscountFactor> bulk = curve.discount(lookup);
+                for (Size k = 0; k < lookup.size(); ++k) {
+                    // linear zero interpolation is not defined on the first interval
+                    if (interpolation == QuantExt::InterpolatedDiscountCurve::Interpolation::linearZero &&
+                        lookup[k] < 1.0)
+                        continue;
+                    BOOST_CHECK_CLOSE(bulk[k], curve.discount(lookup[k]), 1e-12);
+                }
+            }
+        }
+    }
+
+    // the cached node logs are only used while the quotes are unchanged, update() marks them dirty and they are
+    // refreshed at the next lookup, i.e. also if the quotes are set after the notification (scenario sim market)
+    {
+        QuantExt::InterpolatedDiscountCurve curve(times, quotes, 0, TARGET(), Actual365Fixed());
+        BOOST_CHECK_CLOSE(curve.discount(5.0), simpleQuotes[5]->value(), 1e-12);
+        curve.update();
+        simpleQuotes[5]->setValue(simpleQuotes[5]->value() * 0.99);
+        BOOST_CHECK_CLOSE(curve.discount(5.0), simpleQuotes[5]->value(), 1e-12);
+        BOOST_CHECK_CLOSE(curve.discount(vector<Time>(1, 5.0)).front(), simpleQuotes[5]->value(), 1e-12);
+        curve.update();
+        BOOST_CHECK_CLOSE(curve.discount(5.0), simpleQuotes[5]->value(), 1e-12);
+
+        // concurrent lookups on a shared curve give the same results as sequential ones
+        simpleQuotes[7]->setValue(simpleQuotes[7]->value() * 1.01);
+        vector<DiscountFactor> expected = curve.discount(lookup, true);
+        vector<std::future<bool>> results;
+        for (Size thread = 0; thread < 4; ++thread) {
+            results.push_back(std::async(std::launch::async, [&curve, &lookup, &expected]() {
+                bool ok = true;
+                for (Size run = 0; run < 100; ++run) {
+                    ok = ok && curve.discount(lookup, true) == expected;
+                    for (Size k = 0; k < lookup.size(); ++k)
+                        ok = ok && curve.discount(lookup[k], true) == expected[k];
+                }
+                return ok;
+            }));
+        }
+        for (auto& r : results)
+            BOOST_CHECK(r.get());
+    }
+
+    // leg npv and bps through the bulk api against QuantLib::CashFlows::npvbps()
+    QuantExt::InterpolatedDiscountCurve curve(times, quotes, 0, TARGET(), Actual365Fixed());
+    Date today = Settings::instance().evaluationDate();
+    Schedule schedule(today - 1 * Years, today + 10 * Years, 6 * Months, TARGET(), ModifiedFollowing,
+                      ModifiedFollowing, DateGeneration::Forward, false);
+    Leg leg = FixedRateLeg(schedule).withNotionals(1000000.0).withCouponRates(0.02, Actual365Fixed());
+    Date npvDate = today + 2;
+    auto expected = CashFlows::npvbps(leg, curve, false, today, npvDate);
+    auto result = QuantExt::npvbps(leg, curve, false, today, npvDate);
+    BOOST_CHECK_CLOSE(result.first, expected.first, 1e-10);
+    BOOST_CHECK_CLOSE(result.second, expected.second, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(testScenarioCurveBulkEvaluation) {
+
+    BOOST_TEST_MESSAGE("Testing bulk evaluation of InterpolatedDiscountCurve2 and SpreadedDiscountCurve...");
+
+    SavedSettings backup;
+    Settings::instance().evaluationDate() = Date(1, Dec, 2015);
+    Date today = Settings::instance().evaluationDate();
+
+    vector<Time> times;
+    vector<QuantLib::ext::shared_ptr<SimpleQuote>> simpleQuotes, spreadQuotes;
+    vector<Handle<Quote>> quotes, spreads;
+    for (Size i = 0; i <= 20; ++i) {
+        times.push_back(static_cast<Real>(i));
+        simpleQuotes.push_back(QuantLib::ext::make_shared<SimpleQuote>(std::exp(-(0.01 + i * 0.001) * i)));
+        quotes.push_back(Handle<Quote>(simpleQuotes.back()));
+        spreadQuotes.push_back(QuantLib::ext::make_shared<SimpleQuote>(std::exp(-0.0005 * i)));
+        spreads.push_back(Handle<Quote>(spreadQuotes.back()));
+    }
+
+    vector<Time> lookup;
+    for (Time t = 0.0; t < 25.0; t += 0.37)
+        lookup.push_back(t);
+
+    auto curve2 = QuantLib::ext::make_shared<QuantExt::InterpolatedDiscountCurve2>(times, quotes, Actual365Fixed());
+    curve2->enableExtrapolation();
+    QuantExt::SpreadedDiscountCurve spreaded(Handle<YieldTermStructure>(curve2), times, spreads);
+    spreaded.enableExtrapolation();
+
+    Schedule schedule(today - 1 * Years, today + 10 * Years, 6 * Months, TARGET(), ModifiedFollowing,
+                      ModifiedFollowing, DateGeneration::Forward, false);
+    Leg leg = FixedRateLeg(schedule).withNotionals(1000000.0).withCouponRates(0.02, Actual365Fixed());
+    Date npvDate = today + 2;
+
+    for (Size pass = 0; pass < 2; ++pass) {
+        // the second pass checks that the bulk evaluation picks up quote changes
+        if (pass == 1) {
+            simpleQuotes[5]->setValue(simpleQuotes[5]->value() * 0.99);
+            spreadQuotes[3]->setValue(spreadQuotes[3]->value() * 1.01);
+        }
+        vector<DiscountFactor> bulk2 = curve2->discount(lookup);
+        vector<DiscountFactor> bulkSpreaded = spreaded.discount(lookup);
+        for (Size k = 0; k < lookup.size(); ++k) {
+            BOOST_CHECK_CLOSE(bulk2[k], curve2->discount(lookup[k]), 1e-12);
+            BOOST_CHECK_CLOSE(bulkSpreaded[k], spreaded.discount(lookup[k]), 1e-12);
+        }
+
+        for (const YieldTermStructure* curve : {static_cast<const YieldTermStructure*>(curve2.get()),
+                                                static_cast<const YieldTermStructure*>(&spreaded)}) {
+            auto expected = CashFlows::npvbps(leg, *curve, false, today, npvDate);
+            auto result = QuantExt::npvbps(leg, *curve, false, today, npvDate);
+            BOOST_CHECK_CLOSE(result.first, expected.first, 1e-10);
+            BOOST_CHECK_CLOSE(result.second, expected.second, 1e-10);
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE_END()
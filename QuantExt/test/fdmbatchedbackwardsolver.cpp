@@ -0,0 +1,156 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include "toplevelfixture.hpp"
+#include <boost/test/unit_test.hpp>
+#include <qle/methods/fdmbatchedbackwardsolver.hpp>
+#include <qle/methods/fdmlgmop.hpp>
+#include <qle/models/irlgm1fconstantparametrization.hpp>
+#include <qle/models/lgm.hpp>
+#include <qle/models/lgmfdsolver.hpp>
+
+#include <ql/currencies/europe.hpp>
+#include <ql/methods/finitedifferences/meshers/fdmmeshercomposite.hpp>
+#include <ql/methods/finitedifferences/meshers/fdmsimpleprocess1dmesher.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/time/calendars/nullcalendar.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+
+using namespace QuantLib;
+using namespace QuantExt;
+
+namespace {
+
+QuantLib::ext::shared_ptr<LinearGaussMarkovModel> lgmModel() {
+    Handle<YieldTermStructure> curve(
+        QuantLib::ext::make_shared<FlatForward>(0, NullCalendar(), 0.02, Actual365Fixed()));
+    return QuantLib::ext::make_shared<LinearGaussMarkovModel>(
+        QuantLib::ext::make_shared<IrLgm1fConstantParametrization>(EURCurrency(), curve, 0.01, 0.01));
+}
+
+// counts the operator set ups, otherwise forwards to the wrapped operator
+class CountingOp : public FdmLinearOpComposite {
+public:
+    explicit CountingOp(const QuantLib::ext::shared_ptr<FdmLinearOpComposite>& map) : map_(map) {}
+    Size size() const override { return map_->size(); }
+    void setTime(Time t1, Time t2) override {
+        ++count;
+        map_->setTime(t1, t2);
+    }
+    Array apply(const Array& r) const override { return map_->apply(r); }
+    Array apply_mixed(const Array& r) const override { return map_->apply_mixed(r); }
+    Array apply_direction(Size direction, const Array& r) const override {
+        return map_->apply_direction(direction, r);
+    }
+    Array solve_splitting(Size direction, const Array& r, Real s) const override {
+        return map_->solve_splitting(direction, r, s);
+    }
+    Array preconditioner(const Array& r, Real s) const override { return map_->preconditioner(r, s); }
+#if !defined(QL_NO_UBLAS_SUPPORT)
+    std::vector<QuantLib::SparseMatrix> toMatrixDecomp() const override { return map_->toMatrixDecomp(); }
+#endif
+    Size count = 0;
+
+private:
+    QuantLib::ext::shared_ptr<FdmLinearOpComposite> map_;
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(QuantExtTestSuite, qle::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(FdmBatchedBackwardSolverTest)
+
+BOOST_AUTO_TEST_CASE(testBatchedEqualsSingleRollbacks) {
+
+    BOOST_TEST_MESSAGE("Testing that a batched FD rollback equals single rollbacks of each array...");
+
+    auto model = lgmModel();
+    auto process = QuantLib::ext::dynamic_pointer_cast<StochasticProcess1D>(model->stateProcess());
+    auto mesher = QuantLib::ext::make_shared<FdmMesherComposite>(
+        QuantLib::ext::make_shared<FdmSimpleProcess1dMesher>(64, process, 10.0, 24, 1E-4));
+    Array x = mesher->locations(0);
+
+    std::vector<Array> payoffs(3, Array(x.size()));
+    for (Size k = 0; k < x.size(); ++k) {
+        payoffs[0][k] = std::max(x[k] - 0.002, 0.0);
+        payoffs[1][k] = std::exp(-x[k]);
+        payoffs[2][k] = x[k] > 0.0 ? 1.0 : 0.0;
+    }
+
+    std::vector<std::pair<std::string, FdmSchemeDesc>> schemes = {
+        {"Douglas", FdmSchemeDesc::Douglas()},           {"CrankNicolson", FdmSchemeDesc::CrankNicolson()},
+        {"ImplicitEuler", FdmSchemeDesc::ImplicitEuler()}, {"Hundsdorfer", FdmSchemeDesc::Hundsdorfer()},
+        {"TrBDF2", FdmSchemeDesc::TrBDF2()}};
+
+    for (auto const& [name, scheme] : schemes) {
+        for (Size dampingSteps : {0, 2}) {
+            auto singleOp =
+                QuantLib::ext::make_shared<CountingOp>(QuantLib::ext::make_shared<FdmLgmOp>(mesher, process));
+            FdmBackwardSolver single(singleOp, std::vector<QuantLib::ext::shared_ptr<BoundaryCondition<FdmLinearOp>>>(),
+                                     nullptr, scheme);
+            std::vector<Array> expected = payoffs;
+            for (auto& a : expected)
+                single.rollback(a, 5.0, 1.0, 10, dampingSteps);
+
+            auto batchedOp =
+                QuantLib::ext::make_shared<CountingOp>(QuantLib::ext::make_shared<FdmLgmOp>(mesher, process));
+            FdmBatchedBackwardSolver batched(batchedOp, scheme);
+            std::vector<Array> result = payoffs;
+            batched.rollback(result, 5.0, 1.0, 10, dampingSteps);
+
+            for (Size m = 0; m < payoffs.size(); ++m) {
+                for (Size k = 0; k < x.size(); ++k) {
+                    BOOST_CHECK_MESSAGE(std::abs(result[m][k] - expected[m][k]) < 1E-12,
+                                        name << ", damping steps " << dampingSteps << ", array " << m << ", point " << k
+                                             << ": batched " << result[m][k] << ", single " << expected[m][k]);
+                }
+            }
+
+            // the operator is set up for all arrays at once, i.e. as often as for one single rollback
+            BOOST_CHECK_EQUAL(batchedOp->count * payoffs.size(), singleOp->count);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testLgmFdSolverBatchedRollback) {
+
+    BOOST_TEST_MESSAGE("Testing that the batched LGM FD rollback equals single rollbacks...");
+
+    LgmFdSolver solver(lgmModel(), 10.0, FdmSchemeDesc::CrankNicolson(), 64, 24);
+    RandomVariable x = solver.stateGrid(5.0);
+    std::vector<RandomVariable> v = {max(x, RandomVariable(x.size(), 0.0)), exp(-x), RandomVariable(x.size(), 2.0)};
+
+    for (Real t0 : {1.0, 0.0}) {
+        auto batched = solver.rollback(v, 5.0, t0);
+        BOOST_REQUIRE_EQUAL(batched.size(), v.size());
+        for (Size m = 0; m < v.size(); ++m) {
+            RandomVariable single = solver.rollback(v[m], 5.0, t0);
+            BOOST_REQUIRE_EQUAL(batched[m].size(), single.size());
+            for (Size k = 0; k < single.size(); ++k) {
+                BOOST_CHECK_MESSAGE(std::abs(batched[m][k] - single[k]) < 1E-12,
+                                    "t0 " << t0 << ", array " << m << ", point " << k << ": batched " << batched[m][k]
+                                          << ", single " << single[k]);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
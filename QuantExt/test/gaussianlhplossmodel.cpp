@@ -0,0 +1,131 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include "toplevelfixture.hpp"
+#include <boost/test/unit_test.hpp>
+#include <qle/models/basket.hpp>
+#include <qle/models/gaussianlhplossmodel.hpp>
+
+#include <ql/currencies/europe.hpp>
+#include <ql/termstructures/credit/flathazardrate.hpp>
+#include <ql/time/calendars/nullcalendar.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+
+using namespace QuantLib;
+using namespace QuantExt;
+
+namespace {
+
+QuantLib::ext::shared_ptr<Pool> buildPool(const std::vector<std::string>& names, const std::vector<Real>& hazardRates) {
+    auto pool = QuantLib::ext::make_shared<Pool>();
+    for (Size i = 0; i < names.size(); ++i) {
+        DefaultProbKey key = NorthAmericaCorpDefaultKey(EURCurrency(), SeniorSec, Period(), 1.0);
+        Handle<DefaultProbabilityTermStructure> curve(
+            QuantLib::ext::make_shared<FlatHazardRate>(0, NullCalendar(), hazardRates[i], Actual365Fixed()));
+        Issuer issuer(std::vector<Issuer::key_curve_pair>(1, std::make_pair(key, curve)), DefaultEventSet());
+        pool->add(names[i], issuer, key);
+    }
+    return pool;
+}
+
+QuantLib::ext::shared_ptr<Basket> buildBasket(const Date& refDate, const std::vector<std::string>& names,
+                                              const std::vector<Real>& notionals,
+                                              const QuantLib::ext::shared_ptr<Pool>& pool, Real attachment,
+                                              Real detachment, const std::vector<Real>& recoveries) {
+    auto basket = QuantLib::ext::make_shared<Basket>(refDate, names, notionals, pool, attachment, detachment);
+    basket->setLossModel(QuantLib::ext::make_shared<GaussianLHPLossModel>(0.3, recoveries));
+    return basket;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(QuantExtTestSuite, qle::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(GaussianLHPLossModelTest)
+
+BOOST_AUTO_TEST_CASE(testBatchedExpectedTrancheLosses) {
+
+    BOOST_TEST_MESSAGE("Testing batched expected tranche losses of the Gaussian LHP loss model...");
+
+    SavedSettings backup;
+    Date today(15, January, 2024);
+    Settings::instance().evaluationDate() = today;
+
+    std::vector<std::string> names = {"A", "B", "C"};
+    std::vector<Real> recoveries = {0.4, 0.35, 0.25};
+    auto pool = buildPool(names, {0.01, 0.02, 0.0});
+
+    // the first date has a zero default probability, the tranches cover an equity, a mezzanine and a senior tranche
+    // whose detachment point exceeds the maximum loss, i.e. the inverse normal at 1 is avoided by clamping
+    std::vector<Date> dates = {today, today + 3 * Months, today + 1 * Years, today + 5 * Years, today + 10 * Years};
+    std::vector<std::pair<Real, Real>> tranches = {{0.0, 0.03}, {0.03, 0.07}, {0.3, 1.0}};
+
+    std::vector<Real> attachAmounts, detachAmounts;
+    std::vector<std::vector<Real>> singleLosses;
+    for (auto const& [attach, detach] : tranches) {
+        for (const std::vector<Real>& notionals :
+             {std::vector<Real>{100.0, 200.0, 300.0}, std::vector<Real>{0.0, 0.0, 0.0}}) {
+            auto basket = buildBasket(today, names, notionals, pool, attach, detach, recoveries);
+            for (Real recoveryRate : {Null<Real>(), 0.4}) {
+                auto batched = basket->expectedTrancheLosses(dates, recoveryRate);
+                BOOST_REQUIRE_EQUAL(batched.size(), dates.size());
+                for (Size j = 0; j < dates.size(); ++j) {
+                    Real single = basket->expectedTrancheLoss(dates[j], recoveryRate);
+                    BOOST_CHECK_MESSAGE(std::abs(batched[j] - single) < 1E-12,
+                                        "tranche " << attach << "-" << detach << ", notional " << notionals[0]
+                                                   << ", date " << dates[j] << ": batched " << batched[j]
+                                                   << ", single " << single);
+                }
+                // a zero remaining notional or default probability gives no loss
+                BOOST_CHECK_EQUAL(batched[0], 0.0);
+                if (notionals[0] == 0.0) {
+                    for (Size j = 0; j < dates.size(); ++j)
+                        BOOST_CHECK_EQUAL(batched[j], 0.0);
+                }
+            }
+            if (notionals[0] > 0.0) {
+                attachAmounts.push_back(basket->remainingAttachmentAmount());
+                detachAmounts.push_back(basket->remainingDetachmentAmount());
+                singleLosses.push_back(std::vector<Real>());
+                for (auto const& d : dates)
+                    singleLosses.back().push_back(basket->expectedTrancheLoss(d));
+            }
+        }
+    }
+
+    // several tranches on the same pool in one call
+    auto basket = buildBasket(today, names, {100.0, 200.0, 300.0}, pool, 0.0, 1.0, recoveries);
+    auto model = QuantLib::ext::make_shared<GaussianLHPLossModel>(0.3, recoveries);
+    basket->setLossModel(model);
+    // the basket assigns itself to the model when it is calculated
+    BOOST_REQUIRE_CLOSE(basket->basketNotional(), 600.0, 1E-12);
+    auto losses = model->expectedTrancheLosses(dates, attachAmounts, detachAmounts);
+    BOOST_REQUIRE_EQUAL(losses.size(), tranches.size());
+    for (Size k = 0; k < tranches.size(); ++k) {
+        BOOST_REQUIRE_EQUAL(losses[k].size(), dates.size());
+        for (Size j = 0; j < dates.size(); ++j) {
+            BOOST_CHECK_MESSAGE(std::abs(losses[k][j] - singleLosses[k][j]) < 1E-12,
+                                "tranche " << k << ", date " << dates[j] << ": batched " << losses[k][j]
+                                           << ", single " << singleLosses[k][j]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
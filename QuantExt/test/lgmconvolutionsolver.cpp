@@ -0,0 +1,118 @@
+/*
+ Copyright (C) 2024 Quaternion Risk Management Ltd
+ All rights reserved.
+
+ This file is part of ORE, a free-software/open-source library
+ for transparent pricing and risk analysis - http://opensourcerisk.org
+
+ ORE is free software: you can redistribute it and/or modify it
+ under the terms of the Modified BSD License.  You should have received a
+ copy of the license along with this program.
+ The license is also available online at <http://opensourcerisk.org>
+
+ This program is distributed on the basis that it will form a useful
+ contribution to risk analytics and model standardisation, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE. See the license for more details.
+*/
+
+#include "toplevelfixture.hpp"
+#include <boost/test/unit_test.hpp>
+#include <qle/models/irlgm1fconstantparametrization.hpp>
+#include <qle/models/lgm.hpp>
+#include <qle/models/lgmconvolutionsolver2.hpp>
+
+#include <ql/currencies/europe.hpp>
+#include <ql/termstructures/yield/flatforward.hpp>
+#include <ql/time/calendars/nullcalendar.hpp>
+#include <ql/time/daycounters/actual365fixed.hpp>
+
+using namespace QuantLib;
+using namespace QuantExt;
+
+namespace {
+
+QuantLib::ext::shared_ptr<LinearGaussMarkovModel> lgmModel() {
+    Handle<YieldTermStructure> curve(
+        QuantLib::ext::make_shared<FlatForward>(0, NullCalendar(), 0.02, Actual365Fixed()));
+    return QuantLib::ext::make_shared<LinearGaussMarkovModel>(
+        QuantLib::ext::make_shared<IrLgm1fConstantParametrization>(EURCurrency(), curve, 0.01, 0.01));
+}
+
+// a non-linear payoff on the state grid at time t
+RandomVariable payoff(const LgmConvolutionSolver2& solver, const Real t) {
+    RandomVariable x = solver.stateGrid(t);
+    return max(x - RandomVariable(x.size(), 0.002), RandomVariable(x.size(), 0.0)) +
+           RandomVariable(x.size(), 0.5) * x;
+}
+
+void checkEqual(const RandomVariable& a, const RandomVariable& b, const std::string& label) {
+    BOOST_REQUIRE_EQUAL(a.size(), b.size());
+    for (Size k = 0; k < a.size(); ++k) {
+        BOOST_CHECK_MESSAGE(std::abs(a[k] - b[k]) < 1E-14,
+                            label << ": value at grid point " << k << " is " << a[k] << ", expected " << b[k]);
+    }
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(QuantExtTestSuite, qle::test::TopLevelFixture)
+
+BOOST_AUTO_TEST_SUITE(LgmConvolutionSolverTest)
+
+BOOST_AUTO_TEST_CASE(testCachedAndUncachedRollbackAgree) {
+
+    BOOST_TEST_MESSAGE("Testing that cached and uncached LGM convolution rollbacks agree...");
+
+    auto model = lgmModel();
+    LgmConvolutionSolver2 cached(model, 5.0, 10, 5.0, 10);
+    LgmConvolutionSolver2 uncached(model, 5.0, 10, 5.0, 10, false);
+
+    std::vector<Real> times = {0.0, 0.5, 1.0, 2.0, 5.0};
+    for (Size pass = 0; pass < 2; ++pass) {
+        // the second pass hits the stencils cached in the first one
+        for (Size i = times.size() - 1; i > 0; --i) {
+            Real t1 = times[i], t0 = times[i - 1];
+            RandomVariable v = payoff(cached, t1);
+            std::ostringstream label;
+            label << "pass " << pass << ", rollback " << t1 << " -> " << t0;
+            RandomVariable c = cached.rollback(v, t1, t0);
+            checkEqual(c, uncached.rollback(v, t1, t0), label.str());
+
+            // the batched rollback agrees with the single one, also for deterministic arrays in the batch
+            std::vector<RandomVariable> batch = {v, RandomVariable(v.size(), 1.0), RandomVariable(v.size(), 2.0) * v};
+            auto cb = cached.rollback(batch, t1, t0);
+            auto ub = uncached.rollback(batch, t1, t0);
+            BOOST_REQUIRE_EQUAL(cb.size(), batch.size());
+            BOOST_REQUIRE_EQUAL(ub.size(), batch.size());
+            for (Size m = 0; m < batch.size(); ++m) {
+                checkEqual(cb[m], ub[m], label.str() + ", batch");
+                checkEqual(cb[m], cached.rollback(batch[m], t1, t0), label.str() + ", batch vs single");
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testRollbackOfStateIsMartingale) {
+
+    BOOST_TEST_MESSAGE("Testing that the LGM convolution rollback preserves the state in the interior of the grid...");
+
+    auto model = lgmModel();
+    LgmConvolutionSolver2 solver(model, 5.0, 20, 5.0, 20);
+
+    // x is a martingale, away from the grid boundaries the flat extrapolation does not matter
+    Real t1 = 5.0, t0 = 2.0;
+    RandomVariable x1 = solver.stateGrid(t1), x0 = solver.stateGrid(t0);
+    RandomVariable r = solver.rollback(x1, t1, t0);
+    Size mid = solver.gridSize() / 2;
+    for (Size k = mid - 10; k <= mid + 10; ++k) {
+        BOOST_CHECK_MESSAGE(std::abs(r[k] - x0[k]) < 1E-6,
+                            "rolled back state at grid point " << k << " is " << r[k] << ", expected " << x0[k]);
+    }
+    // rolling back to zero gives the expectation of x(t1), i.e. zero
+    BOOST_CHECK_SMALL(solver.rollback(x1, t1, 0.0)[0], 1E-10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()